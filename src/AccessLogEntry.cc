@@ -112,13 +112,6 @@ AccessLogEntry::AccessLogEntry() {}
 
 AccessLogEntry::~AccessLogEntry()
 {
-    safe_free(headers.request);
-
-#if USE_ADAPTATION
-    safe_free(adapt.last_meta);
-#endif
-
-    safe_free(headers.adapted_request);
     HTTPMSGUNLOCK(adapted_request);
 
     HTTPMSGUNLOCK(request);
@@ -128,6 +121,16 @@ AccessLogEntry::~AccessLogEntry()
 #endif
 }
 
+char *
+AccessLogEntry::keepHeaderImage(const MemBuf &mb, const MasterXaction::Pointer &mx)
+{
+    assert(mx);
+    // the first transaction arena keeps all our images; it lives as long as we do
+    if (!arenaOwner_)
+        arenaOwner_ = mx;
+    return arenaOwner_->arena.dup(mb.content(), mb.contentSize());
+}
+
 ScopedId
 AccessLogEntry::codeContextGist() const
 {
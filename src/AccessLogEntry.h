@@ -20,6 +20,7 @@
 #include "icp_opcode.h"
 #include "ip/Address.h"
 #include "LogTags.h"
+#include "MasterXaction.h"
 #include "MessageSizes.h"
 #include "Notes.h"
 #include "proxyp/forward.h"
@@ -36,6 +37,7 @@
 class HttpReply;
 class HttpRequest;
 class CustomLog;
+class MemBuf;
 
 class AccessLogEntry: public CodeContext
 {
@@ -168,6 +170,7 @@ public:
     class Headers
     {
     public:
+        /* header images are stored by keepHeaderImage() */
         char *request = nullptr; //< virgin HTTP request headers
         char *adapted_request = nullptr; //< HTTP request headers after adaptation and redirection
     } headers;
@@ -180,6 +183,7 @@ public:
     {
     public:
         /// image of the last ICAP response header or eCAP meta received
+        /// (stored by keepHeaderImage())
         char *last_meta = nullptr;
     } adapt;
 #endif
@@ -269,6 +273,10 @@ public:
     /// sets (or updates the already stored) transaction error as needed
     void updateError(const Error &);
 
+    /// \returns a 0-terminated copy of the given header image that lives as
+    /// long as this entry, stored in the arena of the given transaction
+    char *keepHeaderImage(const MemBuf &, const MasterXaction::Pointer &);
+
 private:
     /// transaction problem
     /// if set, overrides (and should eventually replace) request->error
@@ -277,6 +285,9 @@ private:
     /// Client URI (or equivalent) for effectiveVirginUrl() when HttpRequest is
     /// missing. This member is ignored unless the request member is nil.
     SBuf virginUrlForMissingRequest_;
+
+    /// the transaction whose arena stores keepHeaderImage() copies
+    MasterXaction::Pointer arenaOwner_;
 };
 
 class ACLChecklist;
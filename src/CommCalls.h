@@ -279,6 +279,8 @@ public:
 template <class Dialer>
 class CommCbFunPtrCallT: public AsyncCall
 {
+    MEMPROXY_CLASS_TEMPLATE(CommCbFunPtrCallT<Dialer>);
+
 public:
     typedef RefCount<CommCbFunPtrCallT<Dialer> > Pointer;
     typedef typename Dialer::Params Params;
@@ -64,3 +64,10 @@ CpuAffinityCheck()
     }
 }
 
+int
+CpuAffinityDedicatedCpu()
+{
+    if (!TheCpuAffinitySet || !TheCpuAffinitySet->applied())
+        return -1;
+    return TheCpuAffinitySet->soleCpu();
+}
@@ -18,5 +18,9 @@ void CpuAffinityReconfigure();
 /// check CPU affinity configuration and print warnings if needed
 void CpuAffinityCheck();
 
+/// the CPU that cpu_affinity_map successfully bound this process to or, if
+/// this process is not bound to exactly one CPU, -1
+int CpuAffinityDedicatedCpu();
+
 #endif /* SQUID_SRC_CPUAFFINITY_H */
 
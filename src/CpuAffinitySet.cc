@@ -83,3 +83,19 @@ CpuAffinitySet::set(const cpu_set_t &aCpuSet)
     memcpy(&theCpuSet, &aCpuSet, sizeof(theCpuSet));
 }
 
+int
+CpuAffinitySet::soleCpu() const
+{
+    // CPU_COUNT() may expect a non-const argument; see applied()
+    cpu_set_t cpuSet;
+    memcpy(&cpuSet, &theCpuSet, sizeof(cpuSet));
+    if (CPU_COUNT(&cpuSet) != 1)
+        return -1;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuSet))
+            return cpu;
+    }
+    return -1;
+}
+
@@ -29,6 +29,10 @@ public:
     /// set CPU affinity mask
     void set(const cpu_set_t &aCpuSet);
 
+    /// the only CPU in the configured affinity mask or, if the mask has
+    /// several (or no) CPUs, -1
+    int soleCpu() const;
+
 private:
     cpu_set_t theCpuSet; ///< configured CPU affinity for this process
     cpu_set_t theOrigCpuSet; ///< CPU affinity for this process before apply()
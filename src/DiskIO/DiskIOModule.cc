@@ -9,6 +9,7 @@
 /* DEBUG: section 92    Storage File System */
 
 #include "squid.h"
+#include "debug/Stream.h"
 #include "DiskIOModule.h"
 #if HAVE_DISKIO_MODULE_AIO
 #include "DiskIO/AIO/AIODiskIOModule.h"
@@ -22,6 +23,9 @@
 #if HAVE_DISKIO_MODULE_DISKTHREADS
 #include "DiskIO/DiskThreads/DiskThreadsDiskIOModule.h"
 #endif
+#if HAVE_DISKIO_MODULE_IOURING
+#include "DiskIO/IoUring/IoUringDiskIOModule.h"
+#endif
 #if HAVE_DISKIO_MODULE_IPCIO
 #include "DiskIO/IpcIo/IpcIoDiskIOModule.h"
 #endif
@@ -56,6 +60,9 @@ DiskIOModule::SetupAllModules()
 #if HAVE_DISKIO_MODULE_DISKTHREADS
     DiskThreadsDiskIOModule::GetInstance();
 #endif
+#if HAVE_DISKIO_MODULE_IOURING
+    IoUringDiskIOModule::GetInstance();
+#endif
 #if HAVE_DISKIO_MODULE_IPCIO
     IpcIoDiskIOModule::GetInstance();
 #endif
@@ -120,6 +127,18 @@ DiskIOModule::Find(char const *type)
     return nullptr;
 }
 
+DiskIOModule *
+DiskIOModule::FindUsable(char const *type, char const *fallbackType)
+{
+    const auto module = Find(type);
+    if (!module || module->usable())
+        return module;
+
+    debugs(92, DBG_IMPORTANT, "WARNING: This system does not support IOEngine=" << module->type() <<
+           "; using IOEngine=" << fallbackType << " instead");
+    return Find(fallbackType);
+}
+
 DiskIOModule *
 DiskIOModule::FindDefault()
 {
@@ -28,6 +28,11 @@ public:
 
     static DiskIOModule *Find(char const *type);
 
+    /** Find() for configuration parsers. If this system cannot use the
+     * named module, warns and returns the fallbackType module instead.
+     */
+    static DiskIOModule *FindUsable(char const *type, char const *fallbackType);
+
     /** Find *any* usable disk module. This will look for the 'best'
      * available module for this system.
      */
@@ -44,6 +49,10 @@ public:
     virtual DiskIOStrategy *createStrategy() = 0;
 
     virtual char const *type () const = 0;
+
+    /// whether this system supports the module; configurations that ask
+    /// for an unusable module keep using their current module instead
+    virtual bool usable() const { return true; }
     // Not implemented
     DiskIOModule(DiskIOModule const &);
     DiskIOModule &operator=(DiskIOModule const&);
@@ -15,6 +15,7 @@
 #include "squid.h"
 #include "DiskIO/DiskThreads/CommIO.h"
 #include "DiskThreads.h"
+#include "fatal.h"
 #include "SquidConfig.h"
 #include "Store.h"
 
@@ -12,6 +12,7 @@
 #include "compat/win32_maperror.h"
 #include "DiskIO/DiskThreads/CommIO.h"
 #include "DiskThreads.h"
+#include "fatal.h"
 #include "fd.h"
 #include "mem/Allocator.h"
 #include "mem/Pool.h"
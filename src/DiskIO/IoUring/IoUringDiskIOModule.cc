@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "IoUringDiskIOModule.h"
+#include "IoUringIOStrategy.h"
+#include "IoUringRing.h"
+
+IoUringDiskIOModule IoUringDiskIOModule::Instance;
+
+IoUringDiskIOModule &
+IoUringDiskIOModule::GetInstance()
+{
+    return Instance;
+}
+
+IoUringDiskIOModule::IoUringDiskIOModule()
+{
+    ModuleAdd(*this);
+}
+
+void
+IoUringDiskIOModule::init()
+{
+    // the ring is created when the first cache_dir initializes its strategy
+}
+
+void
+IoUringDiskIOModule::gracefulShutdown()
+{
+    IoUringIOStrategy::Instance.done();
+}
+
+DiskIOStrategy *
+IoUringDiskIOModule::createStrategy()
+{
+    return new SingletonIOStrategy(&IoUringIOStrategy::Instance);
+}
+
+bool
+IoUringDiskIOModule::usable() const
+{
+    return IoUringRing::Supported();
+}
+
+char const *
+IoUringDiskIOModule::type () const
+{
+    return "IoUring";
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGDISKIOMODULE_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGDISKIOMODULE_H
+
+#include "DiskIO/DiskIOModule.h"
+
+class IoUringDiskIOModule : public DiskIOModule
+{
+
+public:
+    static IoUringDiskIOModule &GetInstance();
+    IoUringDiskIOModule();
+    void init() override;
+    void gracefulShutdown() override;
+    char const *type () const override;
+    DiskIOStrategy* createStrategy() override;
+    bool usable() const override;
+
+private:
+    static IoUringDiskIOModule Instance;
+};
+
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGDISKIOMODULE_H */
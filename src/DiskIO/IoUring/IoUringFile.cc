@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "debug/Stream.h"
+#include "DiskIO/IoUring/IoUringFile.h"
+#include "DiskIO/IoUring/IoUringIOStrategy.h"
+#include "fd.h"
+#include "fs_io.h"
+#include "globals.h"
+#include "StatCounters.h"
+
+#include <cerrno>
+
+CBDATA_CLASS_INIT(IoUringFile);
+
+IoUringFile::IoUringFile(char const *aPath, IoUringIOStrategy &aStrategy):
+    strategy(aStrategy)
+{
+    assert(aPath);
+    debugs(79, 3, aPath);
+    path_ = xstrdup(aPath);
+}
+
+IoUringFile::~IoUringFile()
+{
+    safe_free(path_);
+    doClose();
+}
+
+void
+IoUringFile::open(int flags, mode_t, RefCount<IORequestor> callback)
+{
+    // opening is rare and rarely blocks for long; only reads and writes
+    // are worth the ring round trip
+    fd = file_open(path_, flags);
+    ioRequestor = callback;
+
+    if (fd < 0) {
+        const auto xerrno = errno;
+        debugs(79, 3, "open error: " << xstrerr(xerrno));
+        error_ = true;
+    } else {
+        ++store_open_disk_fd;
+        debugs(79, 3, "opened FD " << fd);
+    }
+
+    callback->ioCompletedNotification();
+}
+
+void
+IoUringFile::create(int flags, mode_t mode, RefCount<IORequestor> callback)
+{
+    /* We use the same logic path for open */
+    open(flags, mode, callback);
+}
+
+void
+IoUringFile::doClose()
+{
+    if (fd > -1) {
+        file_close(fd);
+        --store_open_disk_fd;
+        fd = -1;
+    }
+}
+
+void
+IoUringFile::close()
+{
+    debugs(79, 3, this << " closing for " << ioRequestor.getRaw());
+
+    if (ioInProgress()) {
+        // the kernel may still be using our descriptor and buffers
+        debugs(79, 2, "did NOT close because " << inProgressIOs << " I/Os are in progress");
+        return;
+    }
+
+    doClose();
+    assert(ioRequestor != nullptr);
+    ioRequestor->closeCompleted();
+}
+
+bool
+IoUringFile::canRead() const
+{
+    return fd > -1;
+}
+
+bool
+IoUringFile::canWrite() const
+{
+    return fd > -1;
+}
+
+void
+IoUringFile::read(ReadRequest *aRequest)
+{
+    assert(fd > -1);
+    assert(ioRequestor != nullptr);
+    debugs(79, 3, aRequest->len << " for FD " << fd << " at " << aRequest->offset);
+    ++statCounter.syscalls.disk.reads;
+    ++inProgressIOs;
+    strategy.queue(new IoUringRequest(this, ReadRequest::Pointer(aRequest)));
+}
+
+void
+IoUringFile::write(WriteRequest *aRequest)
+{
+    assert(fd > -1);
+    assert(ioRequestor != nullptr);
+    debugs(79, 3, aRequest->len << " for FD " << fd << " at " << aRequest->offset);
+    ++statCounter.syscalls.disk.writes;
+    ++inProgressIOs;
+    strategy.queue(new IoUringRequest(this, WriteRequest::Pointer(aRequest)));
+}
+
+void
+IoUringFile::noteCompletion(IoUringRequest *request, const int result)
+{
+    assert(request);
+    assert(request->file == this);
+    if (request->readRequest)
+        readDone(*request, result);
+    else
+        writeDone(*request, result);
+}
+
+void
+IoUringFile::readDone(IoUringRequest &request, const int result)
+{
+    const auto readRequest = request.readRequest;
+    delete &request;
+    --inProgressIOs;
+
+    if (result < 0) {
+        debugs(79, 3, "FD " << fd << " read error: " << xstrerr(-result));
+        ioRequestor->readCompleted(readRequest->buf, -1, DISK_ERROR, readRequest);
+        return;
+    }
+
+    debugs(79, 5, "FD " << fd << " read " << result << " of " << readRequest->len);
+    fd_bytes(fd, result, IoDirection::Read);
+    ioRequestor->readCompleted(readRequest->buf, result, DISK_OK, readRequest);
+}
+
+void
+IoUringFile::writeDone(IoUringRequest &request, const int result)
+{
+    const auto writeRequest = request.writeRequest;
+
+    if (result > 0) {
+        fd_bytes(fd, result, IoDirection::Write);
+        request.written += result;
+        if (request.written < writeRequest->len) {
+            // partial writes are rare but possible; finish the job
+            debugs(79, 3, "FD " << fd << " wrote just " << request.written << " of " << writeRequest->len);
+            strategy.queue(&request);
+            return;
+        }
+    }
+
+    const auto written = request.written;
+    delete &request;
+    --inProgressIOs;
+
+    int errflag = DISK_OK;
+    if (result < 0) {
+        debugs(79, DBG_IMPORTANT, "ERROR: io_uring write failure on FD " << fd << ": " << xstrerr(-result));
+        errflag = result == -ENOSPC ? DISK_NO_SPACE_LEFT : DISK_ERROR;
+        error_ = true;
+    } else if (written < writeRequest->len) {
+        debugs(79, DBG_IMPORTANT, "ERROR: io_uring wrote just " << written << " of " << writeRequest->len << " bytes to FD " << fd);
+        errflag = DISK_ERROR;
+        error_ = true;
+    }
+
+    if (writeRequest->free_func)
+        (writeRequest->free_func)(const_cast<char*>(writeRequest->buf)); // broken API?
+
+    ioRequestor->writeCompleted(errflag, written, writeRequest);
+}
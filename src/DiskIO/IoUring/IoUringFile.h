@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGFILE_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGFILE_H
+
+#include "cbdata.h"
+#include "DiskIO/DiskFile.h"
+#include "DiskIO/IORequestor.h"
+#include "DiskIO/ReadRequest.h"
+#include "DiskIO/WriteRequest.h"
+
+class IoUringFile;
+class IoUringIOStrategy;
+
+/// a read or write request handed to the kernel on behalf of an IoUringFile
+class IoUringRequest
+{
+public:
+    IoUringRequest(const RefCount<IoUringFile> &aFile, const ReadRequest::Pointer &aRead):
+        file(aFile), readRequest(aRead) {}
+    IoUringRequest(const RefCount<IoUringFile> &aFile, const WriteRequest::Pointer &aWrite):
+        file(aFile), writeRequest(aWrite) {}
+
+    RefCount<IoUringFile> file; ///< keeps the file alive while I/O is pending
+    ReadRequest::Pointer readRequest; ///< set for reads
+    WriteRequest::Pointer writeRequest; ///< set for writes
+    size_t written = 0; ///< bytes written by earlier (partial) writes
+};
+
+/// DiskFile that performs reads and writes using Linux io_uring
+class IoUringFile : public DiskFile
+{
+    CBDATA_CLASS(IoUringFile);
+
+public:
+    IoUringFile(char const *path, IoUringIOStrategy &);
+    ~IoUringFile() override;
+
+    /* DiskFile API */
+    void open(int flags, mode_t mode, RefCount<IORequestor> callback) override;
+    void create(int flags, mode_t mode, RefCount<IORequestor> callback) override;
+    void read(ReadRequest *) override;
+    void write(WriteRequest *) override;
+    void close() override;
+    bool error() const override { return error_; }
+    int getFD() const override { return fd; }
+    bool canRead() const override;
+    bool canWrite() const override;
+    bool ioInProgress() const override { return inProgressIOs > 0; }
+
+    /// handles the kernel response to our request; called by IoUringIOStrategy
+    void noteCompletion(IoUringRequest *, int result);
+
+private:
+    void readDone(IoUringRequest &, int result);
+    void writeDone(IoUringRequest &, int result);
+    void doClose();
+
+    char const *path_ = nullptr;
+    IoUringIOStrategy &strategy;
+    RefCount<IORequestor> ioRequestor;
+    int fd = -1;
+    size_t inProgressIOs = 0;
+    bool error_ = false;
+};
+
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGFILE_H */
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "comm/Loops.h"
+#include "debug/Stream.h"
+#include "DiskIO/IoUring/IoUringFile.h"
+#include "DiskIO/IoUring/IoUringIOStrategy.h"
+#include "DiskIO/IoUring/IoUringRing.h"
+#include "Store.h"
+#include "unlinkd.h"
+
+IoUringIOStrategy IoUringIOStrategy::Instance;
+
+void
+IoUringIOStrategy::init()
+{
+    // called once per cache_dir using this module
+    if (ring)
+        return;
+
+    ring = new IoUringRing(RingEntries);
+    Comm::SetSelect(ring->eventFd(), COMM_SELECT_READ, NoteCompletions, this, 0);
+}
+
+void
+IoUringIOStrategy::done()
+{
+    if (!ring)
+        return;
+
+    sync();
+    Comm::SetSelect(ring->eventFd(), COMM_SELECT_READ, nullptr, nullptr, 0);
+    delete ring;
+    ring = nullptr;
+}
+
+/// wakes up the main loop when the kernel posts completions;
+/// the completions themselves are reaped by callback()
+void
+IoUringIOStrategy::NoteCompletions(const int fd, void *data)
+{
+    const auto strategy = static_cast<IoUringIOStrategy *>(data);
+    assert(strategy->ring);
+    strategy->ring->drainEventFd();
+    Comm::SetSelect(fd, COMM_SELECT_READ, NoteCompletions, data, 0);
+}
+
+bool
+IoUringIOStrategy::shedLoad()
+{
+    // the backlog is unbounded, but a non-empty one means the device lags
+    return !backlog.empty();
+}
+
+int
+IoUringIOStrategy::load()
+{
+    if (!ring)
+        return 0;
+    const auto pending = ring->queued() + ring->inFlight() + backlog.size();
+    return pending * 1000 / ring->capacity();
+}
+
+RefCount<DiskFile>
+IoUringIOStrategy::newFile(char const *path)
+{
+    return new IoUringFile(path, *this);
+}
+
+bool
+IoUringIOStrategy::unlinkdUseful() const
+{
+    return true;
+}
+
+void
+IoUringIOStrategy::unlinkFile(char const *path)
+{
+    unlinkdUnlink(path);
+}
+
+void
+IoUringIOStrategy::queue(IoUringRequest *request)
+{
+    assert(ring);
+    ++stats.requests;
+
+    if (!backlog.empty() || !ring->canQueue()) {
+        ++stats.backlogged;
+        backlog.push_back(request);
+        return;
+    }
+
+    const auto file = request->file;
+    const auto userData = reinterpret_cast<uintptr_t>(request);
+    if (const auto &readRequest = request->readRequest) {
+        ring->queueRead(file->getFD(), readRequest->buf, readRequest->len, readRequest->offset, userData);
+    } else {
+        const auto &writeRequest = request->writeRequest;
+        ring->queueWrite(file->getFD(),
+                         writeRequest->buf + request->written,
+                         writeRequest->len - request->written,
+                         writeRequest->offset + request->written,
+                         userData);
+    }
+}
+
+/// moves backlogged requests into the ring as space permits
+void
+IoUringIOStrategy::feedRing()
+{
+    while (!backlog.empty() && ring->canQueue()) {
+        const auto request = backlog.front();
+        backlog.pop_front();
+        --stats.requests; // queue() counts it again
+        queue(request);
+    }
+}
+
+/// delivers posted completions to their files
+/// \returns the number of delivered completions
+int
+IoUringIOStrategy::reapCompletions()
+{
+    int reaped = 0;
+    uint64_t userData = 0;
+    int result = 0;
+    while (ring->reap(userData, result)) {
+        ++reaped;
+        ++stats.completed;
+        const auto request = reinterpret_cast<IoUringRequest *>(userData);
+        // the request may be the last reference to the file
+        const auto file = request->file;
+        file->noteCompletion(request, result);
+    }
+    return reaped;
+}
+
+int
+IoUringIOStrategy::callback()
+{
+    if (!ring)
+        return 0;
+
+    const auto reaped = reapCompletions();
+
+    // completion handlers often queue more I/O; submit it all together
+    feedRing();
+    if (const auto submitted = ring->submit()) {
+        ++stats.submitCalls;
+        stats.submitted += submitted;
+        stats.maxBatch = std::max(stats.maxBatch, submitted);
+    }
+
+    return reaped > 0 ? 1 : 0;
+}
+
+void
+IoUringIOStrategy::sync()
+{
+    if (!ring)
+        return;
+
+    while (!backlog.empty() || ring->queued() || ring->inFlight()) {
+        feedRing();
+        ring->wait();
+        (void)reapCompletions();
+    }
+}
+
+void
+IoUringIOStrategy::statfs(StoreEntry &sentry) const
+{
+    if (!ring)
+        return;
+
+    storeAppendPrintf(&sentry, "io_uring requests: %" PRIu64 " queued, %u in flight, %zu backlogged now\n",
+                      stats.requests, ring->inFlight(), backlog.size());
+    storeAppendPrintf(&sentry, "io_uring submissions: %" PRIu64 " requests in %" PRIu64 " calls (%.2f per call, %u max)\n",
+                      stats.submitted, stats.submitCalls,
+                      stats.submitCalls ? static_cast<double>(stats.submitted) / stats.submitCalls : 0.0,
+                      stats.maxBatch);
+    storeAppendPrintf(&sentry, "io_uring completions: %" PRIu64 "; backlogged requests: %" PRIu64 "\n",
+                      stats.completed, stats.backlogged);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGIOSTRATEGY_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGIOSTRATEGY_H
+
+#include "DiskIO/DiskIOStrategy.h"
+
+#include <deque>
+
+class IoUringRing;
+class IoUringRequest;
+
+/// Submits disk reads and writes through a single per-process io_uring.
+/// Requests are queued as they arrive and handed to the kernel with one
+/// system call per main loop iteration; completions are reaped in the same
+/// callback() without helper threads or locking.
+class IoUringIOStrategy : public DiskIOStrategy
+{
+
+public:
+    /// maximum number of requests in the ring; excess requests wait in backlog
+    static const unsigned int RingEntries = 256;
+
+    static IoUringIOStrategy Instance;
+
+    /* DiskIOStrategy API */
+    bool shedLoad() override;
+    int load() override;
+    RefCount<DiskFile> newFile(char const *path) override;
+    void sync() override;
+    bool unlinkdUseful() const override;
+    void unlinkFile(char const *) override;
+    int callback() override;
+    void init() override;
+    void statfs(StoreEntry &) const override;
+
+    /// hands the request to the kernel during the next callback()
+    void queue(IoUringRequest *);
+
+    /// waits for all pending requests and releases the ring
+    void done();
+
+private:
+    static void NoteCompletions(int fd, void *);
+
+    void feedRing();
+    int reapCompletions();
+
+    IoUringRing *ring = nullptr;
+
+    /// requests that did not fit into the ring
+    std::deque<IoUringRequest *> backlog;
+
+    /// statistics reported by statfs()
+    struct {
+        uint64_t requests = 0; ///< queue() calls
+        uint64_t submitCalls = 0; ///< io_uring_enter(2) calls that submitted requests
+        uint64_t submitted = 0; ///< requests accepted by the kernel
+        uint64_t completed = 0; ///< reaped completions
+        uint64_t backlogged = 0; ///< requests that had to wait in backlog
+        unsigned int maxBatch = 0; ///< largest number of requests submitted at once
+    } stats;
+};
+
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGIOSTRATEGY_H */
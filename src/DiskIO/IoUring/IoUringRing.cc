@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "debug/Stream.h"
+#include "DiskIO/IoUring/IoUringRing.h"
+#include "fd.h"
+#include "fde.h"
+#include "sbuf/Stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/// mmaps a ring region shared with the kernel or throws
+static void *
+MapRing(const int ringFd, const size_t size, const off_t offset, const char *description)
+{
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+    if (mem == MAP_FAILED) {
+        const auto xerrno = errno;
+        throw TexcHere(ToSBuf("cannot mmap io_uring ", description, ": ", xstrerr(xerrno)));
+    }
+    return mem;
+}
+
+/// Returns a pointer to an object at the given offset of a mmapped ring.
+template <class T>
+static T *
+RingMember(void *ring, const unsigned int offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+bool
+IoUringRing::Supported()
+{
+    static const auto supported = [] {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        const auto ringFd = syscall(__NR_io_uring_setup, 1, &params);
+        if (ringFd < 0) {
+            const auto xerrno = errno;
+            debugs(79, 2, "io_uring is not supported: " << xstrerr(xerrno));
+            return false;
+        }
+        close(ringFd);
+        return true;
+    }();
+    return supported;
+}
+
+IoUringRing::IoUringRing(const unsigned int entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ringFd_ = syscall(__NR_io_uring_setup, entries, &params);
+    if (ringFd_ < 0) {
+        const auto xerrno = errno;
+        throw TexcHere(ToSBuf("io_uring_setup(", entries, ") failure: ", xstrerr(xerrno)));
+    }
+
+    try {
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const auto singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap)
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+        sqRing_ = MapRing(ringFd_, sqRingSize_, IORING_OFF_SQ_RING, "submission ring");
+        cqRing_ = singleMap ? sqRing_ : MapRing(ringFd_, cqRingSize_, IORING_OFF_CQ_RING, "completion ring");
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe *>(MapRing(ringFd_, sqesSize_, IORING_OFF_SQES, "submission entries"));
+
+        sqHead_ = RingMember<unsigned int>(sqRing_, params.sq_off.head);
+        sqTail_ = RingMember<unsigned int>(sqRing_, params.sq_off.tail);
+        sqArray_ = RingMember<unsigned int>(sqRing_, params.sq_off.array);
+        sqMask_ = *RingMember<unsigned int>(sqRing_, params.sq_off.ring_mask);
+        sqEntries_ = params.sq_entries;
+
+        cqHead_ = RingMember<unsigned int>(cqRing_, params.cq_off.head);
+        cqTail_ = RingMember<unsigned int>(cqRing_, params.cq_off.tail);
+        cqes_ = RingMember<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+        cqMask_ = *RingMember<unsigned int>(cqRing_, params.cq_off.ring_mask);
+
+        // never let in-flight requests overflow the completion ring
+        capacity_ = std::min(params.sq_entries, params.cq_entries);
+
+        eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd_ < 0) {
+            const auto xerrno = errno;
+            throw TexcHere(ToSBuf("cannot create io_uring eventfd: ", xstrerr(xerrno)));
+        }
+        fd_open(eventFd_, FD_PIPE, "io_uring completion event");
+
+        if (syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_EVENTFD, &eventFd_, 1) < 0) {
+            const auto xerrno = errno;
+            throw TexcHere(ToSBuf("cannot register io_uring eventfd: ", xstrerr(xerrno)));
+        }
+    } catch (...) {
+        cleanup();
+        throw;
+    }
+
+    debugs(79, 2, "io_uring FD " << ringFd_ << " with " << sqEntries_ << " entries; eventfd FD " << eventFd_);
+}
+
+IoUringRing::~IoUringRing()
+{
+    if (inFlight_)
+        debugs(79, DBG_IMPORTANT, "WARNING: abandoning " << inFlight_ << " in-flight io_uring requests");
+    cleanup();
+}
+
+/// releases all resources acquired by the constructor
+void
+IoUringRing::cleanup()
+{
+    if (eventFd_ >= 0) {
+        fd_close(eventFd_);
+        close(eventFd_);
+        eventFd_ = -1;
+    }
+
+    if (sqes_)
+        munmap(sqes_, sqesSize_);
+    if (cqRing_ && cqRing_ != sqRing_)
+        munmap(cqRing_, cqRingSize_);
+    if (sqRing_)
+        munmap(sqRing_, sqRingSize_);
+    sqes_ = nullptr;
+    cqRing_ = sqRing_ = nullptr;
+
+    if (ringFd_ >= 0) {
+        close(ringFd_);
+        ringFd_ = -1;
+    }
+}
+
+bool
+IoUringRing::canQueue() const
+{
+    return queued_ + inFlight_ < capacity_;
+}
+
+/// returns a cleared submission entry to fill; the caller must publish it
+io_uring_sqe *
+IoUringRing::nextSqe()
+{
+    assert(canQueue());
+    // we are the only producer, so our tail cannot change under us
+    const auto tail = *sqTail_;
+    assert(tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) < sqEntries_);
+    const auto index = tail & sqMask_;
+    sqArray_[index] = index;
+    const auto sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void
+IoUringRing::queueRead(const int fd, void *buf, const size_t len, const off_t offset, const uint64_t userData)
+{
+    const auto sqe = nextSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    __atomic_store_n(sqTail_, *sqTail_ + 1, __ATOMIC_RELEASE);
+    ++queued_;
+}
+
+void
+IoUringRing::queueWrite(const int fd, const void *buf, const size_t len, const off_t offset, const uint64_t userData)
+{
+    const auto sqe = nextSqe();
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    __atomic_store_n(sqTail_, *sqTail_ + 1, __ATOMIC_RELEASE);
+    ++queued_;
+}
+
+/// io_uring_enter(2) wrapper; returns the number of consumed submissions
+int
+IoUringRing::enter(const unsigned int toSubmit, const unsigned int minComplete, const unsigned int flags)
+{
+    for (;;) {
+        const auto result = syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, nullptr, 0);
+        if (result >= 0) {
+            const auto submitted = static_cast<unsigned int>(result);
+            assert(submitted <= queued_);
+            queued_ -= submitted;
+            inFlight_ += submitted;
+            return submitted;
+        }
+
+        const auto xerrno = errno;
+        if (xerrno == EINTR)
+            continue;
+        // the kernel is short on resources or has too many completions
+        // pending; keep the requests queued and try again later
+        if (xerrno == EAGAIN || xerrno == EBUSY) {
+            debugs(79, 3, "io_uring_enter postponed: " << xstrerr(xerrno));
+            return 0;
+        }
+        throw TexcHere(ToSBuf("io_uring_enter failure: ", xstrerr(xerrno)));
+    }
+}
+
+unsigned int
+IoUringRing::submit()
+{
+    if (!queued_)
+        return 0;
+    const auto submitted = enter(queued_, 0, 0);
+    debugs(79, 7, "submitted " << submitted << " requests; " << queued_ << " remain queued");
+    return submitted;
+}
+
+void
+IoUringRing::wait()
+{
+    if (!queued_ && !inFlight_)
+        return;
+    (void)enter(queued_, 1, IORING_ENTER_GETEVENTS);
+}
+
+bool
+IoUringRing::reap(uint64_t &userData, int &result)
+{
+    // we are the only consumer, so our head cannot change under us
+    const auto head = *cqHead_;
+    if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+        return false;
+
+    const auto &cqe = cqes_[head & cqMask_];
+    userData = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+
+    assert(inFlight_ > 0);
+    --inFlight_;
+    return true;
+}
+
+void
+IoUringRing::drainEventFd()
+{
+    eventfd_t ignored;
+    (void)eventfd_read(eventFd_, &ignored);
+}
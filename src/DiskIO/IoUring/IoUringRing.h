@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DISKIO_IOURING_IOURINGRING_H
+#define SQUID_SRC_DISKIO_IOURING_IOURINGRING_H
+
+#include <cstdint>
+#include <sys/types.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/// A Linux io_uring submission/completion queue pair used by the main loop.
+/// Requests are queued without system calls and handed to the kernel in
+/// batches by submit(). Completions are reaped directly from the shared
+/// completion ring. An eventfd is signalled whenever a completion is posted
+/// so that callers can wake their select loop without helper threads.
+/// Not thread-safe: owned and used by a single (main) thread.
+class IoUringRing
+{
+public:
+    /// whether the kernel lets us set up rings; probes the kernel once
+    static bool Supported();
+
+    /// sets up a ring with at least the given number of submission entries;
+    /// throws if the kernel does not support io_uring
+    explicit IoUringRing(unsigned int entries);
+    ~IoUringRing();
+
+    IoUringRing(const IoUringRing &) = delete;
+    IoUringRing &operator =(const IoUringRing &) = delete;
+
+    /// whether another request may be queued now
+    bool canQueue() const;
+
+    /// queues a pread(2)-like request; requires canQueue()
+    void queueRead(int fd, void *buf, size_t len, off_t offset, uint64_t userData);
+
+    /// queues a pwrite(2)-like request; requires canQueue()
+    void queueWrite(int fd, const void *buf, size_t len, off_t offset, uint64_t userData);
+
+    /// hands all queued requests to the kernel using (at most) one system call
+    /// \returns the number of requests accepted by the kernel
+    unsigned int submit();
+
+    /// extracts the oldest posted completion, if any
+    /// \param result is the pread(2)/pwrite(2) return value or -errno
+    /// \returns false if there are no completions to reap
+    bool reap(uint64_t &userData, int &result);
+
+    /// submits queued requests and blocks until at least one completion
+    /// is posted (or until there is nothing left to wait for)
+    void wait();
+
+    /// a non-blocking descriptor that becomes readable when completions are posted
+    int eventFd() const { return eventFd_; }
+
+    /// resets eventFd() readability after its notification has been noticed
+    void drainEventFd();
+
+    /// the number of queued but not yet submitted requests
+    unsigned int queued() const { return queued_; }
+
+    /// the number of requests submitted but not yet reaped
+    unsigned int inFlight() const { return inFlight_; }
+
+    /// queue capacity (i.e. the maximum of queued() plus inFlight())
+    unsigned int capacity() const { return capacity_; }
+
+private:
+    void cleanup();
+    io_uring_sqe *nextSqe();
+    int enter(unsigned int toSubmit, unsigned int minComplete, unsigned int flags);
+
+    int ringFd_ = -1; ///< io_uring_setup(2) descriptor
+    int eventFd_ = -1; ///< eventfd(2) registered with the ring
+
+    void *sqRing_ = nullptr; ///< mmapped submission ring
+    size_t sqRingSize_ = 0;
+    void *cqRing_ = nullptr; ///< mmapped completion ring (may be sqRing_)
+    size_t cqRingSize_ = 0;
+    io_uring_sqe *sqes_ = nullptr; ///< mmapped submission entries array
+    size_t sqesSize_ = 0;
+
+    // pointers into the shared submission ring
+    unsigned int *sqHead_ = nullptr;
+    unsigned int *sqTail_ = nullptr;
+    unsigned int *sqArray_ = nullptr;
+    unsigned int sqMask_ = 0;
+    unsigned int sqEntries_ = 0;
+
+    // pointers into the shared completion ring
+    unsigned int *cqHead_ = nullptr;
+    unsigned int *cqTail_ = nullptr;
+    io_uring_cqe *cqes_ = nullptr;
+    unsigned int cqMask_ = 0;
+
+    unsigned int capacity_ = 0;
+    unsigned int queued_ = 0;
+    unsigned int inFlight_ = 0;
+};
+
+#endif /* SQUID_SRC_DISKIO_IOURING_IOURINGRING_H */
@@ -31,6 +31,10 @@
 #include "SquidConfig.h"
 #include "StatCounters.h"
 #include "tools.h"
+#if HAVE_DISKIO_MODULE_IOURING
+#include "comm/Loops.h"
+#include "DiskIO/IoUring/IoUringRing.h"
+#endif
 
 #include <cerrno>
 
@@ -140,6 +144,9 @@ IpcIoFile::open(int flags, mode_t mode, RefCount<IORequestor> callback)
         error_ = !DiskerOpen(SBuf(dbName.termedBuf()), flags, mode);
         if (error_)
             return;
+#if HAVE_DISKIO_MODULE_IOURING
+        DiskerOpenRing();
+#endif
 
         diskId = KidIdentifier;
         const bool inserted =
@@ -207,8 +214,12 @@ IpcIoFile::close()
 {
     assert(ioRequestor != nullptr);
 
-    if (IamDiskProcess())
+    if (IamDiskProcess()) {
+#if HAVE_DISKIO_MODULE_IOURING
+        DiskerCloseRing();
+#endif
         DiskerClose(SBuf(dbName.termedBuf()));
+    }
     // XXX: else nothing to do?
 
     ioRequestor->closeCompleted();
@@ -822,6 +833,180 @@ diskerWrite(IpcIoMsg &ipcIo)
     Ipc::Mem::PutPage(ipcIo.page);
 }
 
+#if HAVE_DISKIO_MODULE_IOURING
+
+/// Submits disker reads and writes in batches, without blocking the disker
+/// on each pread(2)/pwrite(2). Nil if the kernel lacks io_uring support.
+static IoUringRing *DiskerRing = nullptr;
+
+/// an I/O request handed to the kernel by the disker
+class DiskerIo
+{
+public:
+    DiskerIo(const int aWorkerId, const IpcIoMsg &anIpcIo): workerId(aWorkerId), ipcIo(anIpcIo) {}
+
+    const int workerId; ///< the kid that sent us the request
+    IpcIoMsg ipcIo; ///< the request and, eventually, the response
+    size_t wroteSoFar = 0; ///< bytes written by earlier (partial) writes
+    int attempts = 0; ///< the number of write(2) requests made so far
+};
+
+/// queues the (remainder of) the request for writing
+static void
+diskerQueueWrite(DiskerIo &io)
+{
+    const char *buf = Ipc::Mem::PagePointer(io.ipcIo.page);
+    const size_t toWrite = min(io.ipcIo.len, Ipc::Mem::PageSize());
+    ++io.attempts;
+    ++statCounter.syscalls.disk.writes;
+    DiskerRing->queueWrite(TheFile, buf + io.wroteSoFar, toWrite - io.wroteSoFar,
+                           io.ipcIo.offset + io.wroteSoFar, reinterpret_cast<uintptr_t>(&io));
+}
+
+/// Queues an I/O request for batched submission, if possible.
+/// \returns false if the request must be handled synchronously instead
+static bool
+diskerQueue(const int workerId, IpcIoMsg &ipcIo)
+{
+    if (!DiskerRing || !DiskerRing->canQueue())
+        return false;
+
+    if (ipcIo.command == IpcIo::cmdRead) {
+        if (!Ipc::Mem::GetPage(Ipc::Mem::PageId::ioPage, ipcIo.page))
+            return false; // let diskerRead() report the problem
+        const auto io = new DiskerIo(workerId, ipcIo);
+        ++statCounter.syscalls.disk.reads;
+        DiskerRing->queueRead(TheFile, Ipc::Mem::PagePointer(ipcIo.page),
+                              min(ipcIo.len, Ipc::Mem::PageSize()), ipcIo.offset,
+                              reinterpret_cast<uintptr_t>(io));
+        return true;
+    }
+
+    diskerQueueWrite(*new DiskerIo(workerId, ipcIo));
+    return true;
+}
+
+/// Applies the kernel response to a queued request, mimicking diskerRead()
+/// and diskerWriteAttempts() results.
+/// \returns false if the request was resubmitted to write leftovers
+static bool
+diskerIoCompleted(DiskerIo &io, const int result)
+{
+    auto &ipcIo = io.ipcIo;
+
+    if (ipcIo.command == IpcIo::cmdRead) {
+        fd_bytes(TheFile, result, IoDirection::Read);
+        if (result >= 0) {
+            ipcIo.xerrno = 0;
+            const size_t len = static_cast<size_t>(result); // safe because result >= 0
+            debugs(47,8, "disker" << KidIdentifier << " read " <<
+                   (len == ipcIo.len ? "all " : "just ") << result);
+            ipcIo.len = len;
+        } else {
+            ipcIo.xerrno = -result;
+            ipcIo.len = 0;
+            debugs(47,5, "disker" << KidIdentifier << " read error: " <<
+                   ipcIo.xerrno);
+        }
+        return true;
+    }
+
+    const size_t toWrite = min(ipcIo.len, Ipc::Mem::PageSize());
+    fd_bytes(TheFile, result, IoDirection::Write);
+    if (result < 0) {
+        ipcIo.xerrno = -result;
+        debugs(47, DBG_IMPORTANT, "ERROR: " << DbName << " failure" <<
+               " writing " << (toWrite - io.wroteSoFar) << '/' << ipcIo.len <<
+               " at " << ipcIo.offset << '+' << io.wroteSoFar <<
+               " on " << io.attempts << " try: " << xstrerr(ipcIo.xerrno));
+    } else {
+        ipcIo.xerrno = 0;
+        io.wroteSoFar += static_cast<size_t>(result); // result >= 0
+        debugs(47,3, "disker" << KidIdentifier << " wrote " <<
+               (io.wroteSoFar >= toWrite ? "all " : "just ") << result <<
+               " out of " << toWrite << '/' << ipcIo.len << " at " <<
+               ipcIo.offset << " on " << io.attempts << " try");
+
+        const int attemptLimit = 10; // see diskerWriteAttempts()
+        if (io.wroteSoFar < toWrite) {
+            if (io.attempts < attemptLimit) {
+                diskerQueueWrite(io); // reaping freed a ring slot for us
+                return false;
+            }
+            debugs(47, DBG_IMPORTANT, "ERROR: " << DbName << " exhausted all " <<
+                   attemptLimit << " attempts while writing " <<
+                   (toWrite - io.wroteSoFar) << '/' << ipcIo.len << " at " <<
+                   ipcIo.offset << '+' << io.wroteSoFar);
+        }
+    }
+
+    ipcIo.len = io.wroteSoFar;
+    Ipc::Mem::PutPage(ipcIo.page);
+    return true;
+}
+
+/// starts using io_uring for disker I/O if the kernel supports it
+void
+IpcIoFile::DiskerOpenRing()
+{
+    assert(!DiskerRing);
+    try {
+        DiskerRing = new IoUringRing(QueueCapacity);
+    } catch (...) {
+        debugs(47, DBG_IMPORTANT, "WARNING: " << DbName << " disker will use " <<
+               "blocking I/O because io_uring is not available: " << CurrentException);
+        return;
+    }
+    Comm::SetSelect(DiskerRing->eventFd(), COMM_SELECT_READ, &IpcIoFile::DiskerNoteCompletions, nullptr, 0);
+    debugs(47, 2, "disker" << KidIdentifier << " uses io_uring for " << DbName);
+}
+
+/// waits for all in-flight I/O requests and stops using io_uring
+void
+IpcIoFile::DiskerCloseRing()
+{
+    if (!DiskerRing)
+        return;
+
+    while (DiskerRing->queued() || DiskerRing->inFlight()) {
+        DiskerRing->wait();
+        DiskerReapCompletions();
+    }
+
+    Comm::SetSelect(DiskerRing->eventFd(), COMM_SELECT_READ, nullptr, nullptr, 0);
+    delete DiskerRing;
+    DiskerRing = nullptr;
+}
+
+/// the kernel has posted some completions of our I/O requests
+void
+IpcIoFile::DiskerNoteCompletions(const int fd, void *)
+{
+    assert(DiskerRing);
+    DiskerRing->drainEventFd();
+    Comm::SetSelect(fd, COMM_SELECT_READ, &IpcIoFile::DiskerNoteCompletions, nullptr, 0);
+
+    DiskerReapCompletions();
+    DiskerRing->submit(); // write leftovers, if any
+}
+
+/// sends responses to all completed I/O requests
+void
+IpcIoFile::DiskerReapCompletions()
+{
+    uint64_t userData = 0;
+    int result = 0;
+    while (DiskerRing->reap(userData, result)) {
+        const auto io = reinterpret_cast<DiskerIo *>(userData);
+        if (diskerIoCompleted(*io, result)) {
+            DiskerRespond(io->workerId, io->ipcIo);
+            delete io;
+        }
+    }
+}
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+
 void
 IpcIoFile::DiskerHandleMoreRequests(void *source)
 {
@@ -928,6 +1113,12 @@ IpcIoFile::DiskerHandleRequests()
         }
     }
 
+#if HAVE_DISKIO_MODULE_IOURING
+    // hand all requests popped above to the kernel at once
+    if (DiskerRing)
+        DiskerRing->submit();
+#endif
+
     // TODO: consider using O_DIRECT with "elevator" optimization where we pop
     // requests first, then reorder the popped requests to optimize seek time,
     // then do I/O, then take a break, and come back for the next set of I/O
@@ -953,6 +1144,11 @@ IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo)
     const auto workerPid = ipcIo.workerPid;
     assert(workerPid >= 0);
 
+#if HAVE_DISKIO_MODULE_IOURING
+    if (diskerQueue(workerId, ipcIo))
+        return; // DiskerReapCompletions() will respond
+#endif
+
     if (ipcIo.command == IpcIo::cmdRead)
         diskerRead(ipcIo);
     else // ipcIo.command == IpcIo::cmdWrite
@@ -960,6 +1156,13 @@ IpcIoFile::DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo)
 
     assert(ipcIo.workerPid == workerPid);
 
+    DiskerRespond(workerId, ipcIo);
+}
+
+/// sends I/O results back to the worker that requested that I/O
+void
+IpcIoFile::DiskerRespond(const int workerId, IpcIoMsg &ipcIo)
+{
     debugs(47, 7, "pushing " << SipcIo(workerId, ipcIo, KidIdentifier));
 
     try {
@@ -126,8 +126,16 @@ private:
     static void DiskerHandleMoreRequests(void*);
     static void DiskerHandleRequests();
     static void DiskerHandleRequest(const int workerId, IpcIoMsg &ipcIo);
+    static void DiskerRespond(const int workerId, IpcIoMsg &ipcIo);
     static bool WaitBeforePop();
 
+#if HAVE_DISKIO_MODULE_IOURING
+    static void DiskerOpenRing();
+    static void DiskerCloseRing();
+    static void DiskerNoteCompletions(int fd, void *);
+    static void DiskerReapCompletions();
+#endif
+
     static void HandleMessagesAtStart();
 
 private:
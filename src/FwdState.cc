@@ -28,6 +28,7 @@
 #include "CommCalls.h"
 #include "errorpage.h"
 #include "event.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "FwdState.h"
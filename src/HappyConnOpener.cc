@@ -29,18 +29,11 @@ CBDATA_CLASS_INIT(HappyConnOpener);
 // concurrent events to the Squid event queue in many busy configurations, one
 // concurrent event per concurrent HappyConnOpener job.
 //
-// EventScheduler::schedule() uses linear search to find the right place for a
-// new event; having hundreds of concurrent events is prohibitively expensive.
-// Both alternatives may have comparable high rate of eventAdd() calls, but
-// HappyOrderEnforcer usually schedules the first or second event (as opposed to
-// events that would be fired after hundreds of already scheduled events, making
-// that linear search a lot longer).
-//
-// EventScheduler::cancel() also uses linear search. HappyOrderEnforcer does not
-// need to cancel scheduled events, while its inefficient alternative may cancel
-// events at a rate comparable to the high eventAdd() rate -- many events would
-// be scheduled in vain because external factors would speed up (or make
-// unnecessary) spare connection attempts, canceling the wait.
+// EventScheduler::schedule() and cancel() do not search the event queue, but
+// HappyOrderEnforcer still avoids hundreds of concurrent events and the
+// eventAdd() and eventDelete() calls that its alternative would make -- many
+// events would be scheduled in vain because external factors would speed up
+// (or make unnecessary) spare connection attempts, canceling the wait.
 //
 // This optimization is possible only where each job needs to pause for the same
 // amount of time, creating a naturally ordered list of jobs waiting to be
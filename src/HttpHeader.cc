@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 
 /* XXX: the whole set of API managing the entries vector should be rethought
  *      after the parse4r-ng effort is complete.
@@ -92,6 +93,13 @@ static std::array<HttpHeaderStat, hoEnd> HttpHeaderStats = {{
 
 static int HeaderEntryParsedCount = 0;
 
+/// parsed registered field names stored without copying them
+static uint64_t HeaderFieldNamesShared = 0;
+static uint64_t HeaderFieldNameBytesShared = 0;
+/// parsed unknown field names copied into a per-header names buffer
+static uint64_t HeaderFieldNamesCopied = 0;
+static uint64_t HeaderFieldNameBytesCopied = 0;
+
 /*
  * forward declarations and local routines
  */
@@ -220,6 +228,9 @@ HttpHeader::clean()
     }
 
     entries.clear();
+    links_.clear();
+    idChains_.fill(FieldChain());
+    namedChains_.clear();
     httpHeaderMaskInit(&mask, 0);
     len = 0;
     conflictingContentLength_ = false;
@@ -364,6 +375,9 @@ HttpHeader::parse(const char *header_start, size_t hdrLen, Http::ContentLengthIn
         return 0;
     }
 
+    // copies of unknown field names, shared by the parsed entries
+    SBuf names;
+
     /* common format headers are "<name>:[ws]<value>" lines delimited by <CRLF>.
      * continuation lines start with a (single) space or tab */
     while (field_ptr < header_end) {
@@ -444,7 +458,7 @@ HttpHeader::parse(const char *header_start, size_t hdrLen, Http::ContentLengthIn
             break;      /* terminating blank line */
         }
 
-        const auto e = HttpHeaderEntry::parse(field_start, field_end, owner);
+        const auto e = HttpHeaderEntry::parse(field_start, field_end, owner, names);
         if (!e) {
             debugs(55, warnOnError, "WARNING: unparsable HTTP header field {" <<
                    getStringPrefix(field_start, field_end-field_start) << "}");
@@ -609,15 +623,9 @@ HttpHeader::findEntry(Http::HdrType id) const
     if (!CBIT_TEST(mask, id))
         return nullptr;
 
-    /* looks like we must have it, do linear search */
-    for (auto e : entries) {
-        if (e && e->id == id)
-            return e;
-    }
-
-    /* hm.. we thought it was there, but it was not found */
-    assert(false);
-    return nullptr;        /* not reached */
+    const auto &chain = chainOf(id);
+    assert(!chain.empty());
+    return entries[chain.first];
 }
 
 /*
@@ -633,30 +641,72 @@ HttpHeader::findLastEntry(Http::HdrType id) const
     if (!CBIT_TEST(mask, id))
         return nullptr;
 
-    for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
-        if (*e && (*e)->id == id)
-            return *e;
-    }
+    const auto &chain = chainOf(id);
+    assert(!chain.empty());
+    return entries[chain.last];
+}
+
+/// the given field name, without copying it
+static std::string_view
+NameView(const SBuf &name)
+{
+    return std::string_view(name.rawContent(), name.length());
+}
+
+std::size_t
+HttpHeader::NameHash::operator()(const std::string_view name) const noexcept
+{
+    // same as CaseInsensitiveSBufHash
+    size_t rv = 0;
+    for (const auto c: name)
+        rv ^= 271 * xtolower(c);
+    return rv ^ (name.length() * 271);
+}
+
+bool
+HttpHeader::NameEqual::operator()(const std::string_view lhs, const std::string_view rhs) const noexcept
+{
+    return lhs.length() == rhs.length() && strncasecmp(lhs.data(), rhs.data(), lhs.length()) == 0;
+}
 
-    /* hm.. we thought it was there, but it was not found */
-    assert(false);
-    return nullptr; /* not reached */
+/// the chain of Http::HdrType::OTHER entries with the given name (or nil)
+const HttpHeader::FieldChain *
+HttpHeader::findNamedChain(const std::string_view name) const
+{
+    const auto found = namedChains_.find(name);
+    return found == namedChains_.end() ? nullptr : &found->second;
+}
+
+/// Deletes chain entries, starting at the given position. If a name is
+/// given, deletes only entries with that (case-insensitive) name.
+/// \returns the number of deleted entries
+int
+HttpHeader::delChain(IndexPos pos, const SBuf * const name)
+{
+    int count = 0;
+    while (pos >= 0) {
+        const auto next = links_[pos].next; // delAt() unlinks pos
+        if (!name || !entries[pos]->name.caseCmp(*name))
+            delAt(pos, count);
+        pos = next;
+    }
+    return count;
 }
 
 int
 HttpHeader::delByName(const SBuf &name)
 {
     int count = 0;
-    HttpHeaderPos pos = HttpHeaderInitPos;
-    httpHeaderMaskInit(&mask, 0);   /* temporal inconsistency */
     debugs(55, 9, "deleting '" << name << "' fields in hdr " << this);
 
-    while (const HttpHeaderEntry *e = getEntry(&pos)) {
-        if (!e->name.caseCmp(name))
-            delAt(pos, count);
-        else
-            CBIT_SET(mask, e->id);
-    }
+    // entries with registered names usually have the corresponding ID, but
+    // Http::HdrType::OTHER and BAD_HDR entries may have any name
+    const auto id = Http::HeaderLookupTable.lookup(name).id;
+    if (any_registered_header(id))
+        count += delChain(chainOf(id).first, &name);
+    if (const auto chain = findNamedChain(NameView(name)))
+        count += delChain(chain->first);
+    count += delChain(chainOf(Http::HdrType::BAD_HDR).first, &name);
 
     return count;
 }
@@ -671,31 +721,19 @@ HttpHeader::delById(Http::HdrType id)
     if (!CBIT_TEST(mask, id))
         return 0;
 
-    int count = 0;
-
-    HttpHeaderPos pos = HttpHeaderInitPos;
-    while (HttpHeaderEntry *e = getEntry(&pos)) {
-        if (e->id == id)
-            delAt(pos, count); // deletes e
-    }
-
-    CBIT_CLR(mask, id);
+    const auto count = delChain(chainOf(id).first);
     assert(count);
+    assert(!CBIT_TEST(mask, id));
     return count;
 }
 
-/*
- * deletes an entry at pos and leaves a gap; leaving a gap makes it
- * possible to iterate(search) and delete fields at the same time
- * NOTE: Does not update the header mask. Caller must follow up with
- * a call to refreshMask() if headers_deleted was incremented.
- */
 void
 HttpHeader::delAt(HttpHeaderPos pos, int &headers_deleted)
 {
     HttpHeaderEntry *e;
     assert(pos >= HttpHeaderInitPos && pos < static_cast<ssize_t>(entries.size()));
     e = static_cast<HttpHeaderEntry*>(entries[pos]);
+    unindexAt(pos);
     entries[pos] = nullptr;
     /* decrement header length, allow for ": " and crlf */
     len -= e->name.length() + 2 + e->value.size() + 2;
@@ -713,19 +751,100 @@ HttpHeader::compact()
     // TODO: optimize removal, or possibly make it so that's not needed.
     entries.erase( std::remove(entries.begin(), entries.end(), nullptr),
                    entries.end());
+    reindex();
 }
 
-/*
- * Refreshes the header mask. Required after delAt() calls.
- */
 void
 HttpHeader::refreshMask()
 {
     httpHeaderMaskInit(&mask, 0);
     debugs(55, 7, "refreshing the mask in hdr " << this);
-    for (auto e : entries) {
-        if (e)
-            CBIT_SET(mask, e->id);
+    for (const auto id: WholeEnum<Http::HdrType>()) {
+        if (id != Http::HdrType::BAD_HDR && !chainOf(id).empty())
+            CBIT_SET(mask, id);
+    }
+    if (!namedChains_.empty())
+        CBIT_SET(mask, Http::HdrType::OTHER);
+}
+
+/// the chain of Http::HdrType::OTHER entries with the given name, creating
+/// an empty chain if there were no such entries
+HttpHeader::FieldChain &
+HttpHeader::namedChainFor(const SBuf &name)
+{
+    const auto found = namedChains_.find(NameView(name));
+    if (found != namedChains_.end())
+        return found->second;
+
+    // The key must view the name stored in the chain because the entry name
+    // may change or go away while other same-name entries remain indexed.
+    NamedChain chain(name);
+    const auto key = NameView(chain.name);
+    // SBuf copies share (and moves keep) the bytes viewed by the key
+    return namedChains_.emplace(key, std::move(chain)).first->second;
+}
+
+/// adds the entry at the given position to the end of its same-key chain
+void
+HttpHeader::indexAt(const HttpHeaderPos pos)
+{
+    const auto e = entries[pos];
+    auto &chain = (e->id == Http::HdrType::OTHER) ? namedChainFor(e->name) : idChains_[static_cast<size_t>(e->id)];
+    Assure(chain.last < pos);
+
+    auto &link = links_[pos];
+    link.prev = chain.last;
+    link.next = -1;
+    if (chain.empty())
+        chain.first = pos;
+    else
+        links_[chain.last].next = pos;
+    chain.last = pos;
+}
+
+/// removes the entry at the given position from its same-key chain,
+/// updating the mask if no entries with the same key remain
+void
+HttpHeader::unindexAt(const HttpHeaderPos pos)
+{
+    const auto e = entries[pos];
+    const auto named = (e->id == Http::HdrType::OTHER) ? namedChains_.find(NameView(e->name)) : namedChains_.end();
+    Assure(e->id != Http::HdrType::OTHER || named != namedChains_.end());
+    auto &chain = (e->id == Http::HdrType::OTHER) ? named->second : idChains_[static_cast<size_t>(e->id)];
+
+    auto &link = links_[pos];
+    if (link.prev >= 0)
+        links_[link.prev].next = link.next;
+    else
+        chain.first = link.next;
+    if (link.next >= 0)
+        links_[link.next].prev = link.prev;
+    else
+        chain.last = link.prev;
+    link = FieldLink();
+
+    if (!chain.empty())
+        return;
+
+    if (e->id == Http::HdrType::OTHER) {
+        namedChains_.erase(named);
+        if (namedChains_.empty())
+            CBIT_CLR(mask, Http::HdrType::OTHER);
+    } else if (e->id != Http::HdrType::BAD_HDR) {
+        CBIT_CLR(mask, e->id);
+    }
+}
+
+/// rebuilds the index after entries were moved
+void
+HttpHeader::reindex()
+{
+    idChains_.fill(FieldChain());
+    namedChains_.clear();
+    links_.assign(entries.size(), FieldLink());
+    for (size_t pos = 0; pos < entries.size(); ++pos) {
+        if (entries[pos])
+            indexAt(pos);
     }
 }
 
@@ -749,7 +868,11 @@ HttpHeader::addEntry(HttpHeaderEntry * e)
         }
     }
 
+    // IndexPos limits the number of entries
+    Assure(entries.size() < static_cast<size_t>(std::numeric_limits<IndexPos>::max()));
     entries.push_back(e);
+    links_.emplace_back();
+    indexAt(entries.size() - 1);
 
     len += e->length();
 }
@@ -764,10 +887,8 @@ HttpHeader::getList(Http::HdrType id, String *s) const
     if (!CBIT_TEST(mask, id))
         return false;
 
-    for (auto e: entries) {
-        if (e && e->id == id)
-            strListAdd(s, e->value.termedBuf(), ',');
-    }
+    for (auto pos = chainOf(id).first; pos >= 0; pos = links_[pos].next)
+        strListAdd(s, entries[pos]->value.termedBuf(), ',');
 
     /*
      * note: we might get an empty (size==0) string if there was an "empty"
@@ -787,8 +908,6 @@ HttpHeader::getList(Http::HdrType id, String *s) const
 String
 HttpHeader::getList(Http::HdrType id) const
 {
-    HttpHeaderEntry *e;
-    HttpHeaderPos pos = HttpHeaderInitPos;
     debugs(55, 9, this << "joining for id " << id);
     /* only fields from ListHeaders array can be "listed" */
     assert(Http::HeaderLookupTable.lookup(id).list);
@@ -798,10 +917,8 @@ HttpHeader::getList(Http::HdrType id) const
 
     String s;
 
-    while ((e = getEntry(&pos))) {
-        if (e->id == id)
-            strListAdd(&s, e->value.termedBuf(), ',');
-    }
+    for (auto pos = chainOf(id).first; pos >= 0; pos = links_[pos].next)
+        strListAdd(&s, entries[pos]->value.termedBuf(), ',');
 
     /*
      * note: we might get an empty (size==0) string if there was an "empty"
@@ -882,32 +999,26 @@ HttpHeader::getByIdIfPresent(Http::HdrType id, String *result) const
 bool
 HttpHeader::hasNamed(const char *name, unsigned int namelen, String *result) const
 {
-    Http::HdrType id;
-    HttpHeaderPos pos = HttpHeaderInitPos;
-    HttpHeaderEntry *e;
-
     assert(name);
 
     /* First try the quick path */
-    id = Http::HeaderLookupTable.lookup(name,namelen).id;
+    const auto id = Http::HeaderLookupTable.lookup(name, namelen).id;
 
     if (id != Http::HdrType::BAD_HDR) {
         if (getByIdIfPresent(id, result))
             return true;
     }
 
-    /* Sorry, an unknown header name. Do linear search */
-    bool found = false;
-    while ((e = getEntry(&pos))) {
-        if (e->id == Http::HdrType::OTHER && e->name.length() == namelen && e->name.caseCmp(name, namelen) == 0) {
-            found = true;
-            if (!result)
-                break;
-            strListAdd(result, e->value.termedBuf(), ',');
-        }
-    }
+    /* Sorry, an unknown header name. Use the names index */
+    const auto chain = findNamedChain(std::string_view(name, namelen));
+    if (!chain)
+        return false;
 
-    return found;
+    if (result) {
+        for (auto pos = chain->first; pos >= 0; pos = links_[pos].next)
+            strListAdd(result, entries[pos]->value.termedBuf(), ',');
+    }
+    return true;
 }
 
 /*
@@ -1094,25 +1205,17 @@ HttpHeader::updateOrAddStr(const Http::HdrType id, const SBuf &newValue)
         return;
     }
 
-    auto foundSameName = false;
-    for (auto &e: entries) {
-        if (!e || e->id != id)
-            continue;
-
-        if (foundSameName) {
-            // get rid of this repeated same-name entry
-            delete e;
-            e = nullptr;
-            continue;
-        }
-
-        if (newValue.cmp(e->value.termedBuf()) != 0)
-            e->value.assign(newValue.rawContent(), newValue.plength());
-
-        foundSameName = true;
-        // continue to delete any repeated same-name entries
+    const auto first = chainOf(id).first;
+    assert(first >= 0);
+    const auto e = entries[first];
+    if (newValue.cmp(e->value.termedBuf()) != 0) {
+        len -= e->value.size();
+        e->value.assign(newValue.rawContent(), newValue.plength());
+        len += e->value.size();
     }
-    assert(foundSameName);
+
+    // get rid of any repeated same-name entries
+    (void)delChain(links_[first].next);
     debugs(55, 5, "synced: " << Http::HeaderLookupTable.lookup(id).name << ": " << newValue);
 }
 
@@ -1357,17 +1460,37 @@ HttpHeader::getTimeOrTag(Http::HdrType id) const
  * HttpHeaderEntry
  */
 
-HttpHeaderEntry::HttpHeaderEntry(Http::HdrType anId, const SBuf &aName, const char *aValue)
+/// the registered name of the given header field, sharing storage among
+/// all entries with that name
+static const SBuf &
+RegisteredName(const Http::HdrType id)
+{
+    static const auto names = [] {
+        std::vector<SBuf> result;
+        for (const auto i: WholeEnum<Http::HdrType>())
+            result.emplace_back(Http::HeaderLookupTable.lookup(i).name);
+        return result;
+    }();
+    return names.at(static_cast<size_t>(id));
+}
+
+HttpHeaderEntry::HttpHeaderEntry(Http::HdrType anId, const SBuf &aName, const char *aValue):
+    HttpHeaderEntry(anId, aName, aValue, aValue ? strlen(aValue) : 0)
+{
+}
+
+HttpHeaderEntry::HttpHeaderEntry(Http::HdrType anId, const SBuf &aName, const char *aValue, const size_t aValueLength)
 {
     assert(any_HdrType_enum_value(anId));
     id = anId;
 
     if (id != Http::HdrType::OTHER)
-        name = Http::HeaderLookupTable.lookup(id).name;
+        name = RegisteredName(id);
     else
         name = aName;
 
-    value = aValue;
+    if (aValue)
+        value.assign(aValue, aValueLength);
 
     if (id != Http::HdrType::BAD_HDR)
         ++ headerStatsTable[id].aliveCount;
@@ -1389,7 +1512,7 @@ HttpHeaderEntry::~HttpHeaderEntry()
 
 /* parses and inits header entry, returns true/false */
 HttpHeaderEntry *
-HttpHeaderEntry::parse(const char *field_start, const char *field_end, const http_hdr_owner_type msgType)
+HttpHeaderEntry::parse(const char *field_start, const char *field_end, const http_hdr_owner_type msgType, SBuf &names)
 {
     /* note: name_start == field_start */
     const char *name_end = (const char *)memchr(field_start, ':', field_end - field_start);
@@ -1465,18 +1588,22 @@ HttpHeaderEntry::parse(const char *field_start, const char *field_end, const htt
     Http::HdrType id = Http::HeaderLookupTable.lookup(field_start,name_len).id;
     debugs(55, 9, "got hdr-id=" << id);
 
-    SBuf theName;
-
-    String value;
-
     if (id == Http::HdrType::BAD_HDR)
         id = Http::HdrType::OTHER;
 
     /* set field name */
-    if (id == Http::HdrType::OTHER)
-        theName.append(field_start, name_len);
-    else
-        theName = Http::HeaderLookupTable.lookup(id).name;
+    SBuf theName;
+    if (id == Http::HdrType::OTHER) {
+        // appending to names does not move bytes that earlier names share
+        names.append(field_start, name_len);
+        theName = names.substr(names.length() - name_len);
+        ++HeaderFieldNamesCopied;
+        HeaderFieldNameBytesCopied += name_len;
+    } else {
+        theName = RegisteredName(id);
+        ++HeaderFieldNamesShared;
+        HeaderFieldNameBytesShared += name_len;
+    }
 
     /* trim field value */
     while (value_start < field_end && xisspace(*value_start))
@@ -1491,21 +1618,18 @@ HttpHeaderEntry::parse(const char *field_start, const char *field_end, const htt
         return nullptr;
     }
 
-    /* set field value */
-    value.assign(value_start, field_end - value_start);
-
     if (id != Http::HdrType::BAD_HDR)
         ++ headerStatsTable[id].seenCount;
 
-    debugs(55, 9, "parsed HttpHeaderEntry: '" << theName << ": " << value << "'");
-
-    return new HttpHeaderEntry(id, theName, value.termedBuf());
+    const auto e = new HttpHeaderEntry(id, theName, value_start, field_end - value_start);
+    debugs(55, 9, "parsed HttpHeaderEntry: '" << e->name << ": " << e->value << "'");
+    return e;
 }
 
 HttpHeaderEntry *
 HttpHeaderEntry::clone() const
 {
-    return new HttpHeaderEntry(id, name, value.termedBuf());
+    return new HttpHeaderEntry(id, name, value.rawBuf(), value.size());
 }
 
 void
@@ -1656,6 +1780,10 @@ httpHeaderStoreReport(StoreEntry * e)
                       HttpHeaderStats[hoReply].parsedCount,
                       HttpHeaderStats[0].parsedCount);
     storeAppendPrintf(e, "Hdr Fields Parsed: %d\n", HeaderEntryParsedCount);
+    storeAppendPrintf(e, "Hdr Field Names Shared: %" PRIu64 " (%" PRIu64 " bytes not copied)\n",
+                      HeaderFieldNamesShared, HeaderFieldNameBytesShared);
+    storeAppendPrintf(e, "Hdr Field Names Copied: %" PRIu64 " (%" PRIu64 " bytes)\n",
+                      HeaderFieldNamesCopied, HeaderFieldNameBytesCopied);
 }
 
 int
@@ -1716,10 +1844,8 @@ HttpHeader::removeHopByHopEntries()
     int headers_deleted = 0;
     while ((e = getEntry(&pos))) {
         Http::HdrType id = e->id;
-        if (Http::HeaderLookupTable.lookup(id).hopbyhop) {
+        if (Http::HeaderLookupTable.lookup(id).hopbyhop)
             delAt(pos, headers_deleted);
-            CBIT_CLR(mask, id);
-        }
     }
 }
 
@@ -15,9 +15,12 @@
 /* because we pass a spec by value */
 #include "HttpHeaderMask.h"
 #include "mem/PoolingAllocator.h"
-#include "sbuf/forward.h"
+#include "sbuf/SBuf.h"
 #include "SquidString.h"
 
+#include <array>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 /* class forward declarations */
@@ -53,8 +56,12 @@ class HttpHeaderEntry
 
 public:
     HttpHeaderEntry(Http::HdrType id, const SBuf &name, const char *value);
+    HttpHeaderEntry(Http::HdrType id, const SBuf &name, const char *value, size_t valueLength);
     ~HttpHeaderEntry();
-    static HttpHeaderEntry *parse(const char *field_start, const char *field_end, const http_hdr_owner_type msgType);
+    /// Parses the [field_start, field_end) field. An unknown field name is
+    /// appended to the given names buffer, and the parsed entry shares that
+    /// buffer storage, so the names of one header share one allocation.
+    static HttpHeaderEntry *parse(const char *field_start, const char *field_end, const http_hdr_owner_type msgType, SBuf &names);
     HttpHeaderEntry *clone() const;
     void packInto(Packable *p) const;
     int getInt() const;
@@ -105,7 +112,10 @@ public:
     /// \deprecated use SBuf method instead. performance regression: reallocates
     int delByName(const char *name) { return delByName(SBuf(name)); }
     int delById(Http::HdrType id);
+    /// Deletes the entry at the given position, leaving a gap: Iteration
+    /// (and further deletions) may continue after this call.
     void delAt(HttpHeaderPos pos, int &headers_deleted);
+    /// Recomputes the mask. Unnecessary since delAt() keeps the mask current.
     void refreshMask();
     void addEntry(HttpHeaderEntry * e);
     String getList(Http::HdrType id) const;
@@ -190,11 +200,77 @@ protected:
     bool skipUpdateHeader(const Http::HdrType id) const;
 
 private:
+    /// entries positions stored in the index
+    using IndexPos = int32_t;
+
+    /// the first and the last position of same-key entries (or -1)
+    class FieldChain
+    {
+    public:
+        bool empty() const { return first < 0; }
+
+        IndexPos first = -1;
+        IndexPos last = -1;
+    };
+
+    /// positions of the previous and the next same-key entries (or -1)
+    class FieldLink
+    {
+    public:
+        IndexPos prev = -1;
+        IndexPos next = -1;
+    };
+
+    /// a chain of Http::HdrType::OTHER entries with the same field name
+    class NamedChain: public FieldChain
+    {
+    public:
+        explicit NamedChain(const SBuf &aName): name(aName) {}
+
+        /// the field name of the chain entries, viewed by the NamedChains key
+        const SBuf name;
+    };
+
+    /// case-insensitive hash functor for field names
+    class NameHash
+    {
+    public:
+        std::size_t operator()(std::string_view) const noexcept;
+    };
+
+    /// case-insensitive equality functor for field names
+    class NameEqual
+    {
+    public:
+        bool operator()(std::string_view, std::string_view) const noexcept;
+    };
+
+    /// Chains of Http::HdrType::OTHER entries, indexed by their field names.
+    /// Keys view the name stored in the chain so that lookups by a raw
+    /// field name do not have to copy that name into an SBuf.
+    using NamedChains = std::unordered_map<std::string_view, NamedChain, NameHash, NameEqual, PoolingAllocator<std::pair<const std::string_view, NamedChain> > >;
+
     HttpHeaderEntry *findLastEntry(Http::HdrType id) const;
+    const FieldChain &chainOf(Http::HdrType id) const { return idChains_[static_cast<size_t>(id)]; }
+    const FieldChain *findNamedChain(std::string_view name) const;
+    FieldChain &namedChainFor(const SBuf &name);
+    int delChain(IndexPos first, const SBuf *name = nullptr);
+    void indexAt(HttpHeaderPos);
+    void unindexAt(HttpHeaderPos);
+    void reindex();
+
     bool conflictingContentLength_; ///< found different Content-Length fields
     /// unsupported encoding, unnecessary syntax characters, and/or
     /// invalid field-value found in Transfer-Encoding header
     bool teUnsupported_ = false;
+
+    /// Same-key entries chains, indexed by entry ID, for O(1) lookups and
+    /// deletions. Http::HdrType::OTHER entries are in namedChains_ instead.
+    std::array<FieldChain, static_cast<size_t>(Http::HdrType::enumEnd_)> idChains_;
+    /// Http::HdrType::OTHER entries, indexed by their names
+    NamedChains namedChains_;
+    /// same-key chain links, indexed by entries position (like entries)
+    std::vector<FieldLink, PoolingAllocator<FieldLink> > links_;
 };
 
 int httpHeaderParseQuotedString(const char *start, const int len, String *val);
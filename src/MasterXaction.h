@@ -15,6 +15,7 @@
 #include "base/Lock.h"
 #include "base/RefCount.h"
 #include "comm/forward.h"
+#include "mem/Arena.h"
 #include "XactionInitiator.h"
 
 /** Master transaction details.
@@ -71,6 +72,10 @@ public:
     /// whether we are currently creating a CONNECT header (to be sent to peer)
     bool generatingConnect = false;
 
+    /// Storage for short-lived data that does not outlive this transaction.
+    /// Users must keep a MasterXaction::Pointer while using arena memory.
+    Mem::Arena arena;
+
     // TODO: add state from other Jobs in the transaction
 
 private:
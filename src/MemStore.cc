@@ -10,10 +10,15 @@
 
 #include "squid.h"
 #include "base/RunnersRegistry.h"
+#include "base/TextException.h"
 #include "CollapsedForwarding.h"
+#include "event.h"
+#include "fatal.h"
+#include "globals.h"
 #include "HttpReply.h"
 #include "ipc/mem/Page.h"
 #include "ipc/mem/Pages.h"
+#include "md5.h"
 #include "MemObject.h"
 #include "MemStore.h"
 #include "mime_header.h"
@@ -23,8 +28,18 @@
 #include "SquidMath.h"
 #include "store/forward.h"
 #include "StoreStats.h"
+#include "time/gadgets.h"
 #include "tools.h"
 
+#include <cerrno>
+#include <cstring>
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 /// shared memory segment path to use for MemStore maps
 static const auto MapLabel = "cache_mem_map";
 /// shared memory segment path to use for the free slices index
@@ -167,6 +182,12 @@ MemStore::MemStore(): map(nullptr), lastWritingSlice(-1)
 
 MemStore::~MemStore()
 {
+    if (eventFind(&MemStore::SaveSnapshotSteps, this))
+        eventDelete(&MemStore::SaveSnapshotSteps, this);
+    if (eventFind(&MemStore::LoadSnapshotSteps, this))
+        eventDelete(&MemStore::LoadSnapshotSteps, this);
+    delete snapshotWriter; // removes unfinished snapshots
+    delete snapshotReader;
     delete map;
 }
 
@@ -199,6 +220,9 @@ MemStore::init()
     Must(!map);
     map = new MemStoreMap(SBuf(MapLabel));
     map->cleaner = this;
+
+    if (KeepsSnapshots())
+        startLoadingSnapshot();
 }
 
 void
@@ -243,6 +267,9 @@ MemStore::stat(StoreEntry &e) const
                                   usedSlots, (100.0 * usedSlots / slotLimit));
             }
 
+            storeAppendPrintf(&e, "Hits loaded without locking: %" PRIu64 "\n", optimisticHits);
+            storeAppendPrintf(&e, "Lock-free loads ruined by writers: %" PRIu64 "\n", optimisticConflicts);
+
             if (slotLimit < 100) { // XXX: otherwise too expensive to count
                 Ipc::ReadWriteLockStats stats;
                 map->updateStats(stats);
@@ -306,6 +333,9 @@ MemStore::get(const cache_key *key)
     if (!map)
         return nullptr;
 
+    if (const auto e = getWithoutLocking(key))
+        return e;
+
     sfileno index;
     const Ipc::StoreMapAnchor *const slot = map->openForReading(key, index);
     if (!slot)
@@ -338,6 +368,84 @@ MemStore::get(const cache_key *key)
     return nullptr;
 }
 
+/// Loads a complete entry without locking its map anchor: Copies entry
+/// metadata and slices into local memory and then checks that no writer has
+/// touched the entry in the meantime. Shared lock counters are not modified,
+/// so hot entries read by many workers do not bounce between CPU caches.
+/// \returns nil if the entry is missing, incomplete, or was changed while we
+/// were copying it; the caller should then use the locking get() code path
+StoreEntry *
+MemStore::getWithoutLocking(const cache_key *key)
+{
+    sfileno index;
+    uint32_t version;
+    const auto anchor = map->openForOptimisticReading(key, index, version);
+    if (!anchor)
+        return nullptr;
+
+    // Everything we read below may be garbage until the map validates version.
+    // Bound all loops and check all IDs so that garbage cannot hurt us.
+    const uint64_t expectedSize = anchor->basics.swap_file_sz;
+    if (!expectedSize || expectedSize > static_cast<uint64_t>(maxObjectSize()))
+        return nullptr;
+
+    const auto e = new StoreEntry();
+    e->createMemObject();
+    anchor->exportUnlockedInto(*e);
+
+    static SBuf content; // reused to avoid per-hit memory allocations
+    content.clear();
+    auto copied = true;
+    try {
+        const auto sliceCapacity = Ipc::Mem::PageSize();
+        auto sid = anchor->start.load();
+        while (sid >= 0 && content.length() < expectedSize) {
+            const auto slice = map->optimisticSlice(sid);
+            const Ipc::StoreMapSlice::Size size = slice ? slice->size.load() : 0;
+            if (!slice || !extras->items[sid].page || size > sliceCapacity || content.length() + size > expectedSize) {
+                copied = false;
+                break;
+            }
+            content.append(static_cast<const char *>(PagePointer(extras->items[sid].page)), size);
+            sid = slice->next;
+        }
+        copied = copied && sid < 0 && content.length() == expectedSize;
+    } catch (...) {
+        copied = false; // e.g., PagePointer() rejected a garbage page ID
+    }
+
+    if (!map->closeForOptimisticReading(index, version)) {
+        ++optimisticConflicts;
+        destroyStoreEntry(static_cast<hash_link *>(e));
+        return nullptr;
+    }
+
+    // the copy is consistent, but may still be unusable (e.g., corrupted)
+    try {
+        if (copied) {
+            copyFromShmSlice(*e, StoreIOBuffer(content.length(), 0, const_cast<char *>(content.rawContent())));
+            auto &reply = e->mem().adjustableBaseReply();
+            if (reply.parseTerminatedPrefix(content.c_str(), content.length())) {
+                // from anchorEntry() and copyFromShm() for complete entries
+                e->store_status = STORE_OK;
+                e->mem_obj->object_sz = e->mem_obj->endOffset();
+                e->setMemStatus(IN_MEMORY);
+                EBIT_SET(e->flags, ENTRY_VALIDATED);
+                e->mem_obj->memCache.io = Store::ioDone; // we hold no locks
+                ++optimisticHits;
+                debugs(20, 5, "mem-loaded all " << content.length() << " bytes of " << *e << " without locking");
+                return e;
+            }
+        }
+    } catch (...) {
+        debugs(20, 3, "cannot use " << *e << ": " << CurrentException);
+    }
+
+    // let the locking code path deal with (and report) problematic entries
+    destroyStoreEntry(static_cast<hash_link *>(e));
+    return nullptr;
+}
+
 void
 MemStore::updateHeaders(StoreEntry *updatedE)
 {
@@ -641,6 +749,11 @@ MemStore::shouldCache(StoreEntry &e) const
         return false;
     }
 
+    if (!Store::Root().admits(e)) {
+        debugs(20, 5, "not popular enough to mem-cache: " << e);
+        return false;
+    }
+
     return true;
 }
 
@@ -947,6 +1060,304 @@ MemStore::disconnect(StoreEntry &e)
     }
 }
 
+bool
+MemStore::KeepsSnapshots()
+{
+    if (!Config.memCacheSnapshot || strcmp(Config.memCacheSnapshot, "none") == 0)
+        return false;
+    // all workers share the same memory cache; one of them is enough
+    return IamWorkerProcess() && KidIdentifier <= 1;
+}
+
+/// saves the given entry if it is readable and complete
+/// \returns whether the entry was saved
+bool
+MemStore::saveSnapshotEntry(MemStoreSnapshot::Writer &snapshot, const sfileno index)
+{
+    // openForReadingAt() checks the peeked key again after locking the entry
+    cache_key key[SQUID_MD5_DIGEST_LENGTH];
+    memcpy(key, map->peekAtEntry(index).key, sizeof(key));
+    const auto anchor = map->openForReadingAt(index, key);
+    if (!anchor)
+        return false; // empty, busy, or marked for deletion
+
+    try {
+        auto saving = anchor->complete() && !anchor->writerHalted;
+        const uint64_t entrySize = anchor->basics.swap_file_sz;
+
+        // the slice chain must hold exactly the advertised number of bytes
+        uint64_t chainSize = 0;
+        auto slices = 0;
+        for (auto sliceId = anchor->start.load(); saving && sliceId >= 0;) {
+            const auto &slice = map->readableSlice(index, sliceId);
+            chainSize += slice.size;
+            sliceId = slice.next;
+            saving = ++slices <= map->sliceLimit(); // no endless loops
+        }
+        saving = saving && entrySize > 0 && chainSize == entrySize;
+
+        if (saving) {
+            MemStoreSnapshot::Entry entry;
+            memcpy(entry.key, anchor->key, sizeof(entry.key));
+            entry.timestamp = anchor->basics.timestamp;
+            entry.lastref = anchor->basics.lastref;
+            entry.expires = anchor->basics.expires;
+            entry.lastmod = anchor->basics.lastmod;
+            entry.size = entrySize;
+            entry.refcount = anchor->basics.refcount;
+            entry.flags = anchor->basics.flags;
+            snapshot.addEntry(entry);
+
+            for (auto sliceId = anchor->start.load(); sliceId >= 0;) {
+                const auto &slice = map->readableSlice(index, sliceId);
+                snapshot.addContent(PagePointer(pageForSlice(sliceId)), slice.size);
+                sliceId = slice.next;
+            }
+        }
+
+        map->closeForReading(index);
+        return saving;
+    } catch (...) {
+        map->closeForReading(index);
+        throw;
+    }
+}
+
+/// opens a new memory_cache_snapshot file for saveSnapshotEntries()
+/// \returns false on errors
+bool
+MemStore::createSnapshot()
+{
+    assert(!snapshotWriter);
+    const SBuf snapshotPath(Config.memCacheSnapshot);
+    try {
+        snapshotWriter = new MemStoreSnapshot::Writer(snapshotPath);
+        snapshotSavingPos = 0;
+        snapshotSaved = 0;
+        return true;
+    } catch (...) {
+        debugs(20, DBG_IMPORTANT, "ERROR: Cannot save memory cache snapshot" <<
+               Debug::Extra << "snapshot: " << snapshotPath <<
+               Debug::Extra << "problem: " << CurrentException);
+        return false;
+    }
+}
+
+bool
+MemStore::startSavingSnapshot()
+{
+    if (!map || !KeepsSnapshots())
+        return false;
+
+    if (snapshotWriter) {
+        debugs(20, 2, "already saving; " << snapshotSaved << " entries saved so far");
+        return true;
+    }
+
+    if (createSnapshot())
+        eventAdd("MemStore::SaveSnapshotSteps", &MemStore::SaveSnapshotSteps, this, 0.0, 1, false);
+    return true;
+}
+
+bool
+MemStore::saveSnapshot()
+{
+    if (!map || !KeepsSnapshots())
+        return false;
+
+    if (eventFind(&MemStore::SaveSnapshotSteps, this))
+        eventDelete(&MemStore::SaveSnapshotSteps, this);
+
+    if (snapshotWriter || createSnapshot())
+        saveSnapshotEntries(false);
+    return true;
+}
+
+/// startSavingSnapshot() event handler
+void
+MemStore::SaveSnapshotSteps(void *data)
+{
+    const auto store = static_cast<MemStore*>(data);
+    store->saveSnapshotEntries(true);
+    if (store->snapshotWriter)
+        eventAdd("MemStore::SaveSnapshotSteps", &MemStore::SaveSnapshotSteps, store, 0.0, 1, false);
+}
+
+/// saves the next portion of entries (or all remaining entries if not paced)
+/// and finishes the snapshot after the last entry
+void
+MemStore::saveSnapshotEntries(const bool paced)
+{
+    assert(snapshotWriter);
+
+    // see Rock::Rebuild::loadingSteps() for the rationale
+    const int maxSpentMsec = 50; // keep small: most RAM-hits are under 1ms
+    const timeval loopStart = current_time;
+
+    try {
+        while (snapshotSavingPos < map->entryLimit()) {
+            if (saveSnapshotEntry(*snapshotWriter, snapshotSavingPos++))
+                ++snapshotSaved;
+
+            if (paced) {
+                getCurrentTime();
+                const double elapsedMsec = tvSubMsec(loopStart, current_time);
+                if (elapsedMsec > maxSpentMsec || elapsedMsec < 0)
+                    return; // save more after handling other events
+            }
+        }
+        snapshotWriter->finish();
+        debugs(20, DBG_IMPORTANT, "Saved " << snapshotSaved << " memory cache entries to " << Config.memCacheSnapshot);
+    } catch (...) {
+        debugs(20, DBG_IMPORTANT, "ERROR: Cannot save memory cache snapshot" <<
+               Debug::Extra << "snapshot: " << Config.memCacheSnapshot <<
+               Debug::Extra << "problem: " << CurrentException);
+    }
+    delete snapshotWriter;
+    snapshotWriter = nullptr;
+}
+
+/// adds one saved entry to the memory cache
+/// \returns whether the entry was added
+bool
+MemStore::loadSnapshotEntry(const MemStoreSnapshot::Entry &entry, const char * const content)
+{
+    if (entry.size > static_cast<uint64_t>(maxObjectSize())) {
+        debugs(20, 5, "skipping a " << entry.size << "-byte entry exceeding maximum_object_size_in_memory");
+        return false;
+    }
+
+    // do not load entries that copyFromShm() would reject when serving a hit
+    try {
+        HttpReply reply;
+        SBuf prefix(content, std::min(entry.size, static_cast<uint64_t>(Config.maxReplyHeaderSize)));
+        if (!reply.parseTerminatedPrefix(prefix.c_str(), prefix.length())) {
+            debugs(20, 5, "skipping an entry with truncated HTTP headers");
+            return false;
+        }
+    } catch (...) {
+        debugs(20, 5, "skipping an entry with malformed HTTP headers: " << CurrentException);
+        return false;
+    }
+
+    const auto key = reinterpret_cast<const cache_key *>(entry.key);
+    sfileno index = 0;
+    const auto anchor = map->openForWriting(key, index);
+    if (!anchor) {
+        debugs(20, 5, "no room in mem-cache map for " << storeKeyText(key));
+        return false;
+    }
+
+    try {
+        anchor->setKey(key);
+        anchor->basics.timestamp = entry.timestamp;
+        anchor->basics.lastref = entry.lastref;
+        anchor->basics.expires = entry.expires;
+        anchor->basics.lastmod = entry.lastmod;
+        anchor->basics.swap_file_sz = entry.size;
+        anchor->basics.refcount = entry.refcount;
+        anchor->basics.flags = entry.flags;
+
+        // each nextAppendableSlice() call returns a fresh, empty slice
+        const uint64_t pageSize = Ipc::Mem::PageSize();
+        sfileno sliceId = -1;
+        for (uint64_t copied = 0; copied < entry.size;) {
+            auto &slice = nextAppendableSlice(index, sliceId);
+            const auto copySize = std::min(pageSize, entry.size - copied);
+            memcpy(PagePointer(pageForSlice(sliceId)), content + copied, copySize);
+            slice.size = copySize;
+            copied += copySize;
+        }
+
+        map->closeForWriting(index);
+        return true;
+    } catch (...) {
+        debugs(20, 2, "cannot load " << storeKeyText(key) << ": " << CurrentException);
+        map->abortWriting(index);
+        return false;
+    }
+}
+
+/// starts filling the memory cache using entries saved by the previous Squid
+/// instance; the entries are loaded a few at a time, in the background of
+/// other main loop events
+void
+MemStore::startLoadingSnapshot()
+{
+    const auto snapshotPath = Config.memCacheSnapshot;
+    struct stat st;
+    if (::stat(snapshotPath, &st) != 0 && errno == ENOENT) {
+        debugs(20, 2, "no memory cache snapshot at " << snapshotPath);
+        return;
+    }
+
+    snapshotReader = new MemStoreSnapshot::Reader();
+    try {
+        snapshotReader->open(SBuf(snapshotPath));
+    } catch (...) {
+        debugs(20, DBG_IMPORTANT, "WARNING: Ignoring unusable memory cache snapshot" <<
+               Debug::Extra << "snapshot: " << snapshotPath <<
+               Debug::Extra << "problem: " << CurrentException);
+        delete snapshotReader;
+        snapshotReader = nullptr;
+        (void)unlink(snapshotPath);
+        return;
+    }
+
+    // the mapping survives; a restarted worker must not load the same entries
+    (void)unlink(snapshotPath);
+
+    snapshotLoaded = 0;
+    debugs(20, DBG_IMPORTANT, "Loading " << snapshotReader->entries() << " memory cache entries from " << snapshotPath);
+    eventAdd("MemStore::LoadSnapshotSteps", &MemStore::LoadSnapshotSteps, this, 0.0, 1, false);
+}
+
+/// startLoadingSnapshot() event handler
+void
+MemStore::LoadSnapshotSteps(void *data)
+{
+    const auto store = static_cast<MemStore*>(data);
+    store->loadSnapshotEntries();
+    if (store->snapshotReader)
+        eventAdd("MemStore::LoadSnapshotSteps", &MemStore::LoadSnapshotSteps, store, 0.0, 1, false);
+}
+
+/// loads the next portion of saved entries, checking each entry just before
+/// loading it, and forgets the snapshot after the last entry
+void
+MemStore::loadSnapshotEntries()
+{
+    assert(snapshotReader);
+
+    // see Rock::Rebuild::loadingSteps() for the rationale
+    const int maxSpentMsec = 50; // keep small: most RAM-hits are under 1ms
+    const timeval loopStart = current_time;
+
+    try {
+        const MemStoreSnapshot::Entry *entry = nullptr;
+        const char *content = nullptr;
+        while (snapshotReader->nextEntry(entry, content)) {
+            if (loadSnapshotEntry(*entry, content))
+                ++snapshotLoaded;
+
+            getCurrentTime();
+            const double elapsedMsec = tvSubMsec(loopStart, current_time);
+            if (elapsedMsec > maxSpentMsec || elapsedMsec < 0)
+                return; // load more after handling other events
+        }
+        debugs(20, DBG_IMPORTANT, "Loaded " << snapshotLoaded << " out of " << snapshotReader->entries() <<
+               " memory cache entries from " << Config.memCacheSnapshot);
+    } catch (...) {
+        // entries loaded so far have passed their integrity checks
+        debugs(20, DBG_IMPORTANT, "WARNING: Stopped loading damaged memory cache snapshot" <<
+               Debug::Extra << "snapshot: " << Config.memCacheSnapshot <<
+               Debug::Extra << "loaded entries: " << snapshotLoaded << " out of " << snapshotReader->visited() <<
+               Debug::Extra << "problem: " << CurrentException);
+    }
+    delete snapshotReader;
+    snapshotReader = nullptr;
+}
+
 bool
 MemStore::Requested()
 {
@@ -976,6 +1387,7 @@ public:
     void finalizeConfig() override;
     void claimMemoryNeeds() override;
     void useConfig() override;
+    void startShutdown() override;
     ~MemStoreRr() override;
 
 protected:
@@ -1024,6 +1436,14 @@ MemStoreRr::useConfig()
     Ipc::Mem::RegisteredRunner::useConfig();
 }
 
+void
+MemStoreRr::startShutdown()
+{
+    // use the shutdown_lifetime delay; SquidShutdown() saves the rest
+    if (MemStore::KeepsSnapshots())
+        (void)Store::Root().startSavingMemoryCacheSnapshot();
+}
+
 void
 MemStoreRr::create()
 {
@@ -12,6 +12,7 @@
 #include "ipc/mem/Page.h"
 #include "ipc/mem/PageStack.h"
 #include "ipc/StoreMap.h"
+#include "MemStoreSnapshot.h"
 #include "Store.h"
 #include "store/Controlled.h"
 
@@ -44,6 +45,19 @@ public:
     /// called when the entry is about to forget its association with mem cache
     void disconnect(StoreEntry &e);
 
+    /// starts saving readable entries to the memory_cache_snapshot file (if
+    /// any), a few at a time, in the background of other main loop events
+    /// \returns whether this process is responsible for saving snapshots
+    bool startSavingSnapshot();
+
+    /// saves readable entries to the memory_cache_snapshot file (if any)
+    /// without further delays, continuing startSavingSnapshot() work (if any)
+    /// \returns whether this process is responsible for saving snapshots
+    bool saveSnapshot();
+
+    /// whether this process saves and loads memory_cache_snapshot files
+    static bool KeepsSnapshots();
+
     /* Storage API */
     void create() override {}
     void init() override;
@@ -79,6 +93,7 @@ protected:
 
     void copyToShm(StoreEntry &e);
     void copyToShmSlice(StoreEntry &e, Ipc::StoreMapAnchor &anchor, Ipc::StoreMap::Slice &slice);
+    StoreEntry *getWithoutLocking(const cache_key *);
     bool copyFromShm(StoreEntry &e, const sfileno index, const Ipc::StoreMapAnchor &anchor);
     void copyFromShmSlice(StoreEntry &, const StoreIOBuffer &);
 
@@ -94,6 +109,15 @@ protected:
     // Ipc::StoreMapCleaner API
     void noteFreeMapSlice(const Ipc::StoreMapSliceId sliceId) override;
 
+    bool createSnapshot();
+    static void SaveSnapshotSteps(void *);
+    void saveSnapshotEntries(bool paced);
+    bool saveSnapshotEntry(MemStoreSnapshot::Writer &, const sfileno index);
+    void startLoadingSnapshot();
+    static void LoadSnapshotSteps(void *);
+    void loadSnapshotEntries();
+    bool loadSnapshotEntry(const MemStoreSnapshot::Entry &, const char *content);
+
 private:
     // TODO: move freeSlots into map
     Ipc::Mem::Pointer<Ipc::Mem::PageStack> freeSlots; ///< unused map slot IDs
@@ -115,6 +139,20 @@ private:
         Ipc::Mem::PageId *page; ///< local page variable, waiting to be filled
     };
     SlotAndPage waitingFor; ///< a cache for a single "hot" free slot and page
+
+    /// get() hits served by getWithoutLocking()
+    uint64_t optimisticHits = 0;
+    /// getWithoutLocking() attempts ruined by concurrent entry changes
+    uint64_t optimisticConflicts = 0;
+
+    /// the memory_cache_snapshot being saved (if any)
+    MemStoreSnapshot::Writer *snapshotWriter = nullptr;
+    sfileno snapshotSavingPos = 0; ///< the next map entry to save
+    uint64_t snapshotSaved = 0; ///< the number of entries saved so far
+
+    /// the memory_cache_snapshot being loaded (if any)
+    MemStoreSnapshot::Reader *snapshotReader = nullptr;
+    uint64_t snapshotLoaded = 0; ///< the number of entries loaded so far
 };
 
 // Why use Store as a base? MemStore and SwapDir are both "caches".
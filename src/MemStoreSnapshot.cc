@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Memory Cache */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "MemStoreSnapshot.h"
+#include "sbuf/Stream.h"
+
+/// the beginning of a snapshot file
+class MemStoreSnapshotHeader
+{
+public:
+    uint64_t magic = 0; ///< MemStoreSnapshotMagic
+    uint32_t version = 0; ///< MemStoreSnapshotVersion
+    uint32_t headerSize = 0; ///< sizeof(MemStoreSnapshotHeader)
+    uint64_t entries = 0; ///< the number of saved entries
+    uint64_t bodySize = 0; ///< the number of bytes after the header
+};
+
+/// follows the (padded) content of every saved entry
+class MemStoreSnapshotEntryEnd
+{
+public:
+    uint32_t checksum = 0; ///< SnapshotChecksum() of the Entry and its (unpadded) content
+    uint32_t reserved = 0; ///< explicit padding; always zero
+};
+
+/// identifies memory cache snapshots (and their byte order)
+static const uint64_t MemStoreSnapshotMagic = 0x70616e536d654d53; // "SMemSnap" on little-endian hosts
+
+/// incremented whenever the snapshot format changes
+static const uint32_t MemStoreSnapshotVersion = 2;
+
+// the format must not depend on compiler-specific padding
+static_assert(sizeof(MemStoreSnapshotHeader) == 32, "no MemStoreSnapshotHeader padding");
+static_assert(sizeof(MemStoreSnapshot::Entry) == 64, "no MemStoreSnapshot::Entry padding");
+static_assert(sizeof(MemStoreSnapshotEntryEnd) == 8, "no MemStoreSnapshotEntryEnd padding");
+
+/// the number of bytes occupied by entry content of the given size
+static uint64_t
+PaddedContentSize(const uint64_t size)
+{
+    return (size + 7) / 8 * 8;
+}
+
+/* MemStoreSnapshot::Writer */
+
+MemStoreSnapshot::Writer::Writer(const SBuf &path):
+    file_(path, sizeof(MemStoreSnapshotHeader))
+{
+}
+
+/// pads the current entry content (if any) and adds its checksum
+void
+MemStoreSnapshot::Writer::finishEntry()
+{
+    if (!addingEntry_)
+        return;
+
+    Must(!contentDebt_);
+    file_.alignBody();
+
+    MemStoreSnapshotEntryEnd entryEnd;
+    entryEnd.checksum = entryChecksum_;
+    file_.append(&entryEnd, sizeof(entryEnd));
+
+    addingEntry_ = false;
+}
+
+void
+MemStoreSnapshot::Writer::addEntry(const Entry &entry)
+{
+    finishEntry();
+    Must(entry.size > 0);
+    Must(!entry.reserved);
+    file_.append(&entry, sizeof(entry));
+    entryChecksum_ = SnapshotChecksum(0, &entry, sizeof(entry));
+    ++entries_;
+    addingEntry_ = true;
+    contentDebt_ = entry.size;
+}
+
+void
+MemStoreSnapshot::Writer::addContent(const void * const buf, const size_t size)
+{
+    Must(size <= contentDebt_);
+    file_.append(buf, size);
+    entryChecksum_ = SnapshotChecksum(entryChecksum_, buf, size);
+    contentDebt_ -= size;
+}
+
+void
+MemStoreSnapshot::Writer::finish()
+{
+    finishEntry();
+
+    MemStoreSnapshotHeader header;
+    header.magic = MemStoreSnapshotMagic;
+    header.version = MemStoreSnapshotVersion;
+    header.headerSize = sizeof(header);
+    header.entries = entries_;
+    header.bodySize = file_.bodySize();
+    file_.finish(&header);
+}
+
+/* MemStoreSnapshot::Reader */
+
+void
+MemStoreSnapshot::Reader::open(const SBuf &path)
+{
+    file_.open(path, sizeof(MemStoreSnapshotHeader));
+
+    const auto &header = *reinterpret_cast<const MemStoreSnapshotHeader *>(file_.header());
+    if (header.magic != MemStoreSnapshotMagic)
+        throw TextException(SBuf("not a memory cache snapshot"), Here());
+    if (header.version != MemStoreSnapshotVersion || header.headerSize != sizeof(header))
+        throw TextException(ToSBuf("unsupported snapshot version ", header.version), Here());
+    if (header.bodySize != file_.bodySize())
+        throw TextException(SBuf("truncated snapshot"), Here());
+
+    nextPos_ = file_.body();
+}
+
+uint64_t
+MemStoreSnapshot::Reader::entries() const
+{
+    return reinterpret_cast<const MemStoreSnapshotHeader *>(file_.header())->entries;
+}
+
+bool
+MemStoreSnapshot::Reader::nextEntry(const Entry *&entry, const char *&content)
+{
+    const char * const end = file_.end();
+    if (nextPos_ == end) {
+        if (visited_ != entries())
+            throw TextException(SBuf("saved entry count mismatch"), Here());
+        return false;
+    }
+
+    if (static_cast<size_t>(end - nextPos_) < sizeof(Entry))
+        throw TextException(ToSBuf("truncated entry #", visited_), Here());
+    const auto &saved = *reinterpret_cast<const Entry *>(nextPos_);
+    const auto savedContent = nextPos_ + sizeof(Entry);
+
+    if (!saved.size || saved.reserved)
+        throw TextException(ToSBuf("malformed entry #", visited_), Here());
+    const auto available = static_cast<uint64_t>(end - savedContent);
+    if (saved.size > available ||
+            PaddedContentSize(saved.size) + sizeof(MemStoreSnapshotEntryEnd) > available)
+        throw TextException(ToSBuf("truncated entry #", visited_, " content"), Here());
+
+    const auto &entryEnd = *reinterpret_cast<const MemStoreSnapshotEntryEnd *>(savedContent + PaddedContentSize(saved.size));
+    const auto checksum = SnapshotChecksum(SnapshotChecksum(0, &saved, sizeof(saved)), savedContent, saved.size);
+    if (entryEnd.checksum != checksum || entryEnd.reserved)
+        throw TextException(ToSBuf("entry #", visited_, " checksum mismatch"), Here());
+
+    entry = &saved;
+    content = savedContent;
+    nextPos_ = reinterpret_cast<const char *>(&entryEnd + 1);
+    ++visited_;
+    return true;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_MEMSTORESNAPSHOT_H
+#define SQUID_SRC_MEMSTORESNAPSHOT_H
+
+#include "base/SnapshotFile.h"
+#include "sbuf/SBuf.h"
+
+#include <cstdint>
+
+/// A copy of readable shared memory cache entries (their basics and content)
+/// saved so that the next Squid instance can start with a warm memory cache.
+/// This class manages the snapshot file format and knows nothing about
+/// MemStore, StoreMap, or shared memory pages.
+///
+/// The snapshot file starts with a header followed by the body: one Entry for
+/// every saved entry, each followed by Entry::size content bytes (padded to 8
+/// bytes) and a SnapshotChecksum() of the Entry and its content. Per-entry
+/// checksums let the reader check each entry just before using it, without
+/// reading the whole snapshot first.
+class MemStoreSnapshot
+{
+public:
+    /// saved basics of one readable entry
+    class Entry
+    {
+    public:
+        uint64_t key[2] = {0, 0};
+        int64_t timestamp = 0;
+        int64_t lastref = 0;
+        int64_t expires = 0;
+        int64_t lastmod = 0;
+        uint64_t size = 0; ///< the number of content bytes that follow
+        uint16_t refcount = 0;
+        uint16_t flags = 0;
+        uint32_t reserved = 0; ///< explicit padding; always zero
+    };
+
+    /// writes a new snapshot (see SnapshotFileWriter)
+    class Writer
+    {
+    public:
+        explicit Writer(const SBuf &path);
+
+        /// starts saving the given entry; the caller must then supply exactly
+        /// entry.size content bytes using one or more addContent() calls
+        void addEntry(const Entry &);
+
+        /// saves the next portion of the current entry content
+        void addContent(const void *buf, size_t size);
+
+        /// writes the header and puts the snapshot into place
+        void finish();
+
+    private:
+        void finishEntry();
+
+        SnapshotFileWriter file_;
+
+        uint64_t entries_ = 0; ///< the number of addEntry() calls
+        bool addingEntry_ = false; ///< whether the last entry needs finishEntry()
+        uint32_t entryChecksum_ = 0; ///< current entry checksum state
+        uint64_t contentDebt_ = 0; ///< current entry bytes still to be added
+    };
+
+    /// maps an existing snapshot into memory and validates it
+    class Reader
+    {
+    public:
+        /// maps the snapshot and checks its header; throws on failures
+        void open(const SBuf &path);
+
+        uint64_t entries() const; ///< the number of saved entries
+
+        /// gets the next saved entry (in saving order) and its content after
+        /// checking that they are intact; throws if they are not
+        /// \returns false after the last entry
+        bool nextEntry(const Entry *&, const char *&content);
+
+        /// the number of entries returned by nextEntry() so far
+        uint64_t visited() const { return visited_; }
+
+    private:
+        SnapshotFileReader file_;
+        const char *nextPos_ = nullptr; ///< where the next Entry starts
+        uint64_t visited_ = 0;
+    };
+};
+
+#endif /* SQUID_SRC_MEMSTORESNAPSHOT_H */
+
@@ -87,6 +87,7 @@ public:
     } Swap;
 
     YesNoNone memShared; ///< whether the memory cache is shared among workers
+    char *memCacheSnapshot; ///< memory_cache_snapshot file name (or nil)
     YesNoNone shmLocking; ///< shared_memory_locking
     size_t memMaxSize;
 
@@ -266,6 +267,7 @@ public:
         int64_t maxObjectSize;
         int64_t minObjectSize;
         size_t maxInMemObjSize;
+        int admissionMinFrequency; ///< cache_admission_min_frequency
     } Store;
 
     struct {
@@ -337,6 +339,11 @@ public:
         int hostStrictVerify;
         int client_dst_passthru;
         int dns_mdns;
+        int tunnel_splice;
+        int acl_regex_automaton;
+#if USE_EPOLL
+        int epoll_edge_triggered;
+#endif
 #if USE_OPENSSL
         bool logTlsServerHelloDetails;
 #endif
@@ -34,6 +34,9 @@ class RequestFlags;
 
 extern StoreIoStats store_io_stats;
 
+/// locally cached entries, indexed by their keys
+extern Store::EntryIndex *store_table;
+
 class StoreEntry : public hash_link, public Packable
 {
 
@@ -11,21 +11,19 @@
 
 #include "acl/Acl.h"
 #include "acl/Data.h"
-#include "splay.h"
+#include "acl/DomainIndex.h"
 
 class ACLDomainData : public ACLData<char const *>
 {
     MEMPROXY_CLASS(ACLDomainData);
 
 public:
-    ACLDomainData() : domains(nullptr) {}
-    ~ACLDomainData() override;
     bool match(char const *) override;
     SBufList dump() const override;
     void parse() override;
     bool empty() const override;
 
-    Splay<char *> *domains;
+    Acl::DomainIndex domains;
 };
 
 #endif /* SQUID_SRC_ACL_DOMAINDATA_H */
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 28    Access Control */
+
+#include "squid.h"
+#include "acl/DomainIndex.h"
+#include "base/Assure.h"
+#include "debug/Stream.h"
+#include "globals.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+/// a reversed domain name stored in DomainIndex::keys_
+class Acl::DomainIndex::Key
+{
+public:
+    Key(const char *chars, const size_t length): chars_(chars), length_(length) {}
+
+    size_t length() const { return length_; }
+    char operator [](const size_t i) const { return chars_[i]; }
+
+private:
+    const char *chars_;
+    size_t length_;
+};
+
+/// a lowercase reversed view of a host name with its leading dots removed
+class Acl::DomainIndex::HostKey
+{
+public:
+    explicit HostKey(const char *host)
+    {
+        while (*host == '.')
+            ++host;
+        host_ = host;
+        length_ = strlen(host);
+    }
+
+    size_t length() const { return length_; }
+    char operator [](const size_t i) const { return xtolower(host_[length_ - 1 - i]); }
+
+private:
+    const char *host_;
+    size_t length_;
+};
+
+/// Orders characters so that a domain name set is immediately followed by its
+/// subdomains: In reversed names, a dot must sort before any other character.
+static inline int
+Rank(const char c)
+{
+    return c == '.' ? 0 : static_cast<unsigned char>(c) + 1;
+}
+
+/// compares the first aLength characters of `a` with the first bLength characters of `b`
+template <class A, class B>
+static int
+Compare(const A &a, const size_t aLength, const B &b, const size_t bLength)
+{
+    const auto common = std::min(aLength, bLength);
+    for (size_t i = 0; i < common; ++i) {
+        if (const auto diff = Rank(a[i]) - Rank(b[i]))
+            return diff;
+    }
+    return (aLength > bLength) - (aLength < bLength);
+}
+
+void
+Acl::DomainIndex::add(const char *domain)
+{
+    Assure(domain);
+
+    Entry entry;
+    entry.isSet = (*domain == '.');
+    if (entry.isSet)
+        ++domain;
+
+    const auto length = strlen(domain);
+    Assure(length <= (std::numeric_limits<uint32_t>::max() >> 1));
+    Assure(keys_.size() + length <= std::numeric_limits<uint32_t>::max());
+    entry.offset = keys_.size();
+    entry.length = length;
+    keys_.append(std::make_reverse_iterator(domain + length), std::make_reverse_iterator(domain));
+
+    added_.push_back(entry);
+}
+
+Acl::DomainIndex::Key
+Acl::DomainIndex::keyOf(const Entry &entry) const
+{
+    return Key(keys_.data() + entry.offset, entry.length);
+}
+
+/// the configured domain represented by the given entry
+SBuf
+Acl::DomainIndex::domainOf(const Entry &entry) const
+{
+    SBuf domain;
+    domain.reserveCapacity(entry.length + 1);
+    if (entry.isSet)
+        domain.append('.');
+    const auto key = keyOf(entry);
+    for (size_t i = key.length(); i > 0; --i)
+        domain.append(key[i - 1]);
+    return domain;
+}
+
+void
+Acl::DomainIndex::commit()
+{
+    if (added_.empty())
+        return;
+
+    // a domain and its configuration order (zero for committed domains)
+    using Candidate = std::pair<Entry, size_t>;
+
+    const auto candidateLess = [this](const Candidate &a, const Candidate &b) {
+        const auto aKey = keyOf(a.first);
+        const auto bKey = keyOf(b.first);
+        if (const auto diff = Compare(aKey, aKey.length(), bKey, bKey.length()))
+            return diff < 0;
+        // a set goes first so that it covers the same-name domain
+        if (a.first.isSet != b.first.isSet)
+            return a.first.isSet > b.first.isSet;
+        return a.second < b.second;
+    };
+
+    std::vector<Candidate> newcomers;
+    newcomers.reserve(added_.size());
+    for (const auto &entry: added_)
+        newcomers.emplace_back(entry, newcomers.size() + 1);
+    added_.clear();
+    added_.shrink_to_fit();
+    std::sort(newcomers.begin(), newcomers.end(), candidateLess);
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(entries_.size() + newcomers.size());
+    for (const auto &entry: entries_)
+        candidates.emplace_back(entry, 0);
+    const auto middle = candidates.size();
+    candidates.insert(candidates.end(), newcomers.begin(), newcomers.end());
+    decltype(newcomers)().swap(newcomers);
+    std::inplace_merge(candidates.begin(), candidates.begin() + middle, candidates.end(), candidateLess);
+
+    const auto reportCovered = [this](const Candidate &covered, const Candidate &cover) {
+        const auto coveredDomain = domainOf(covered.first);
+        const auto coverDomain = domainOf(cover.first);
+        if (covered.second > cover.second) {
+            debugs(28, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: Ignoring " << coveredDomain << " because it is already covered by " << coverDomain <<
+                   Debug::Extra << "advice: Remove value " << coveredDomain << " from the ACL");
+        } else {
+            debugs(28, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: Ignoring earlier " << coveredDomain << " because it is covered by " << coverDomain <<
+                   Debug::Extra << "advice: Remove value " << coveredDomain << " from the ACL");
+        }
+    };
+
+    // Remove duplicates and domains covered by sets. Thanks to sorting, only
+    // the last kept domain may have the same name, and only the last kept set
+    // may cover the current domain.
+    std::vector<Entry> kept;
+    kept.reserve(candidates.size());
+    std::string keptKeys;
+    keptKeys.reserve(keys_.size());
+    const Candidate *lastKept = nullptr;
+    const Candidate *lastSet = nullptr;
+    for (const auto &candidate: candidates) {
+        const auto key = keyOf(candidate.first);
+
+        if (lastKept) {
+            const auto lastKey = keyOf(lastKept->first);
+            if (Compare(key, key.length(), lastKey, lastKey.length()) == 0) {
+                reportCovered(candidate, *lastKept);
+                continue;
+            }
+        }
+
+        if (lastSet) {
+            const auto setKey = keyOf(lastSet->first);
+            if (key.length() > setKey.length() && key[setKey.length()] == '.' &&
+                    Compare(key, setKey.length(), setKey, setKey.length()) == 0) {
+                reportCovered(candidate, *lastSet);
+                continue;
+            }
+        }
+
+        auto entry = candidate.first;
+        entry.offset = keptKeys.size();
+        keptKeys.append(keys_, candidate.first.offset, candidate.first.length);
+        kept.push_back(entry);
+
+        lastKept = &candidate;
+        if (candidate.first.isSet)
+            lastSet = &candidate;
+    }
+
+    entries_.swap(kept);
+    keys_.swap(keptKeys);
+    keys_.shrink_to_fit();
+    entries_.shrink_to_fit();
+    debugs(28, 3, "indexed " << entries_.size() << " domains using " << keys_.size() << " bytes");
+}
+
+/// the entry with the reversed name equal to the first `length` host characters (or nil)
+const Acl::DomainIndex::Entry *
+Acl::DomainIndex::findExact(const HostKey &host, const size_t length) const
+{
+    const auto pos = std::lower_bound(entries_.begin(), entries_.end(), length,
+    [this, &host](const Entry &entry, const size_t len) {
+        const auto key = keyOf(entry);
+        return Compare(key, key.length(), host, len) < 0;
+    });
+    if (pos == entries_.end())
+        return nullptr;
+    const auto key = keyOf(*pos);
+    return Compare(key, key.length(), host, length) == 0 ? &*pos : nullptr;
+}
+
+/// the number of entries with reversed names starting with the first `length` host characters
+size_t
+Acl::DomainIndex::countWithPrefix(const HostKey &host, const size_t length) const
+{
+    const auto first = std::lower_bound(entries_.begin(), entries_.end(), length,
+    [this, &host](const Entry &entry, const size_t len) {
+        const auto key = keyOf(entry);
+        return Compare(key, key.length(), host, len) < 0;
+    });
+    const auto last = std::upper_bound(first, entries_.end(), length,
+    [this, &host](const size_t len, const Entry &entry) {
+        const auto key = keyOf(entry);
+        return Compare(key, std::min(key.length(), len), host, len) > 0;
+    });
+    return last - first;
+}
+
+/// Whether a host name like *.example.com matches a configured domain inside
+/// example.com, as matchDomainName() does with mdnHonorWildcards. Such a
+/// match happens when a domain name differs from the host name (compared
+/// from the end) at the host "*" position preceded by a dot.
+bool
+Acl::DomainIndex::matchWildcards(const HostKey &host) const
+{
+    for (size_t i = 1; i < host.length(); ++i) {
+        if (host[i] != '*' || host[i - 1] != '.')
+            continue;
+
+        // domains under the host name suffix, excluding the suffix itself and
+        // domains that do not differ from the host name at the "*" position
+        auto inside = countWithPrefix(host, i);
+        if (findExact(host, i))
+            --inside;
+        inside -= countWithPrefix(host, i + 1);
+        if (inside > 0)
+            return true;
+    }
+    return false;
+}
+
+bool
+Acl::DomainIndex::match(const char * const hostName, const bool honorWildcards) const
+{
+    if (!hostName)
+        return false;
+
+    const HostKey host(hostName);
+    if (!host.length())
+        return false;
+
+    // the whole host name matches an individual domain name or a set root
+    if (findExact(host, host.length()))
+        return true;
+
+    // a host name suffix that starts at a label boundary matches a set
+    for (size_t i = 0; i < host.length(); ++i) {
+        if (host[i] == '.') {
+            const auto entry = findExact(host, i);
+            if (entry && entry->isSet)
+                return true;
+        }
+    }
+
+    return honorWildcards && matchWildcards(host);
+}
+
+SBufList
+Acl::DomainIndex::dump() const
+{
+    SBufList contents;
+    for (const auto &entry: entries_)
+        contents.push_back(domainOf(entry));
+    return contents;
+}
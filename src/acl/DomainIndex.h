@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_ACL_DOMAININDEX_H
+#define SQUID_SRC_ACL_DOMAININDEX_H
+
+#include "sbuf/List.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Acl
+{
+
+/// Configured domain names (e.g., example.com) and domain name sets (e.g.,
+/// .example.com) that can be matched against host names without modifying
+/// the index. Domains are stored as a flat array of reversed names sorted so
+/// that each set is immediately followed by its subdomains. A lookup performs
+/// one binary search per host name label. Matching follows matchDomainName()
+/// rules, but letter case of configured names is not ignored; callers are
+/// expected to add lowercase names.
+class DomainIndex
+{
+public:
+    /// Remembers a configured domain name or set.
+    /// The domain becomes matchable after the next commit() call.
+    void add(const char *domain);
+
+    /// Merges domains given to add() since the last commit() call into the
+    /// index. Reports and removes domains covered by other domains.
+    void commit();
+
+    /// whether the given host name belongs to one of the committed domains
+    /// \param honorWildcards whether to support mdnHonorWildcards host names
+    bool match(const char *host, bool honorWildcards = false) const;
+
+    /// whether there are no committed domains
+    bool empty() const { return entries_.empty(); }
+
+    /// the number of committed domains
+    size_t size() const { return entries_.size(); }
+
+    /// all committed domains, in index order
+    SBufList dump() const;
+
+private:
+    /// a domain name or set in keys_
+    class Entry
+    {
+    public:
+        uint32_t offset; ///< the start of our reversed domain name in keys_
+        uint32_t length: 31; ///< the number of characters in our reversed name
+        uint32_t isSet: 1; ///< whether subdomains of our name also match
+    };
+
+    class Key;
+    class HostKey;
+
+    Key keyOf(const Entry &) const;
+    SBuf domainOf(const Entry &) const;
+    const Entry *findExact(const HostKey &, size_t length) const;
+    size_t countWithPrefix(const HostKey &, size_t length) const;
+    bool matchWildcards(const HostKey &) const;
+
+    /// reversed domain names (without set-marking dots) of all entries
+    std::string keys_;
+
+    /// committed domains, sorted by their reversed names
+    std::vector<Entry> entries_;
+
+    /// domains added after the last commit() call, in configuration order
+    std::vector<Entry> added_;
+};
+
+} // namespace Acl
+
+#endif /* SQUID_SRC_ACL_DOMAININDEX_H */
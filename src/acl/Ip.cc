@@ -11,16 +11,14 @@
 #include "squid.h"
 #include "acl/Checklist.h"
 #include "acl/Ip.h"
-#include "acl/SplayInserter.h"
 #include "cache_cf.h"
 #include "ConfigParser.h"
 #include "debug/Stream.h"
+#include "fatal.h"
 #include "ip/tools.h"
 #include "MemBuf.h"
 #include "wordlist.h"
 
-#include <algorithm>
-
 void *
 ACLIP::operator new (size_t)
 {
@@ -98,75 +96,6 @@ acl_ip_data::lastAddress() const
     return ip;
 }
 
-template <>
-int
-Acl::SplayInserter<acl_ip_data*>::Compare(const Value &a, const Value &b)
-{
-    if (a->lastAddress() < b->firstAddress())
-        return -1; // the entire range a is to the left of range b
-
-    if (a->firstAddress() > b->lastAddress())
-        return +1; // the entire range a is to the right of range b
-
-    return 0; // equal or partially overlapping ranges
-}
-
-template <>
-bool
-Acl::SplayInserter<acl_ip_data*>::IsSubset(const Value &a, const Value &b)
-{
-    return b->firstAddress() <= a->firstAddress() && a->lastAddress() <= b->lastAddress();
-}
-
-template <>
-Acl::SplayInserter<acl_ip_data*>::Value
-Acl::SplayInserter<acl_ip_data*>::MakeCombinedValue(const Value &a, const Value &b)
-{
-    const auto minLeft = std::min(a->firstAddress(), b->firstAddress());
-    const auto maxRight = std::max(a->lastAddress(), b->lastAddress());
-    return new acl_ip_data(minLeft, maxRight, Ip::Address::NoAddr(), nullptr);
-}
-
-/// reports acl_ip_data using squid.conf ACL value format
-static std::ostream &
-operator <<(std::ostream &os, acl_ip_data *value)
-{
-    if (value)
-        os << value->toSBuf();
-    return os;
-}
-
-/*
- * aclIpAddrNetworkCompare - The guts of the comparison for IP ACLs
- * matching checks.  The first argument (p) is a "host" address,
- * i.e.  the IP address of a cache client.  The second argument (q)
- * is an entry in some address-based access control element.  This
- * function is called via ACLIP::match() and the splay library.
- */
-static int
-aclIpAddrNetworkCompare(acl_ip_data * const &p, acl_ip_data * const &q)
-{
-    Ip::Address A = p->addr1;
-
-    /* apply netmask */
-    A.applyMask(q->mask);
-
-    debugs(28,9, "aclIpAddrNetworkCompare: compare: " << p->addr1 << "/" << q->mask << " (" << A << ")  vs " <<
-           q->addr1 << "-" << q->addr2 << "/" << q->mask);
-
-    if (q->addr2.isAnyAddr()) {       /* single address check */
-
-        return A.matchIPAddr( q->addr1 );
-
-    } else {                   /* range address check */
-
-        if ( (A >= q->addr1) && (A <= q->addr2) )
-            return 0; /* valid. inside range. */
-        else
-            return A.matchIPAddr( q->addr1 ); /* outside of range, 'less than' */
-    }
-}
-
 /**
  * Decode an ascii representation (asc) of a IP netmask address or CIDR,
  * and place resulting information in mask.
@@ -387,20 +316,6 @@ acl_ip_data::FactoryParse(const char *t)
     if (changed)
         debugs(28, DBG_CRITICAL, "WARNING: aclIpParseIpData: Netmask masks away part of the specified IP in '" << t << "'");
 
-    // TODO: Either switch match() to Acl::SplayInserter<acl_ip_data*>::Compare()
-    // range logic (that does not have these problems) OR warn that some (or
-    // even all) addresses will never match this configured ACL value when
-    // `q->addr1.applyMask()` above is positive:
-    //
-    // * A single configured IP value will never match:
-    //   A.matchIPAddr(q->addr1) in aclIpAddrNetworkCompare() will not return 0.
-    //   For example, `acl x src 127.0.0.1/24` does not match any address.
-    //
-    // * A configured IP range will not match any q->addr1/mask IPs:
-    //   (A >= q->addr1) in aclIpAddrNetworkCompare() is false and
-    //   A.matchIPAddr(q->addr1) will not return 0.
-    //   For example, `acl y src 10.0.0.1-10.0.0.255/24` does not match 10.0.0.1.
-
     debugs(28,9, "Parsed: " << q->addr1 << "-" << q->addr2 << "/" << q->mask << "(/" << q->mask.cidr() <<")");
 
     /* 1.2.3.4/255.255.255.0  --> 1.2.3.0 */
@@ -459,9 +374,6 @@ ACLIP::parseGlobal(const char * const token)
 void
 ACLIP::parse()
 {
-    if (data == nullptr)
-        data = new IPSplay();
-
     while (char *t = ConfigParser::strtokFile()) {
         if (parseGlobal(t))
             continue;
@@ -469,50 +381,36 @@ ACLIP::parse()
         acl_ip_data *q = acl_ip_data::FactoryParse(t);
 
         while (q != nullptr) {
-            /* pop each result off the list and add it to the data tree individually */
+            /* pop each result off the list and add it to the index individually */
             acl_ip_data *next_node = q->next;
             q->next = nullptr;
-            Acl::SplayInserter<acl_ip_data*>::Merge(*data, std::move(q));
+            data.add(q);
             q = next_node;
         }
     }
+    data.commit();
 }
 
-ACLIP::~ACLIP()
-{
-    if (data) {
-        data->destroy();
-        delete data;
-    }
-}
-
-struct IpAclDumpVisitor {
-    SBufList contents;
-    void operator() (acl_ip_data * const & ip) {
-        contents.push_back(ip->toSBuf());
-    }
-};
-
 SBufList
 ACLIP::dump() const
 {
-    IpAclDumpVisitor visitor;
+    SBufList contents;
 
     if (matchAnyIpv4 && matchAnyIpv6)
-        visitor.contents.push_back(SBuf("all"));
+        contents.push_back(SBuf("all"));
     else if (matchAnyIpv4)
-        visitor.contents.push_back(SBuf("ipv4"));
+        contents.push_back(SBuf("ipv4"));
     else if (matchAnyIpv6)
-        visitor.contents.push_back(SBuf("ipv6"));
+        contents.push_back(SBuf("ipv6"));
 
-    data->visit(visitor);
-    return visitor.contents;
+    contents.splice(contents.end(), data.dump());
+    return contents;
 }
 
 bool
 ACLIP::empty() const
 {
-    return data->empty() && !matchAnyIpv4 && !matchAnyIpv6;
+    return data.empty() && !matchAnyIpv4 && !matchAnyIpv6;
 }
 
 int
@@ -536,20 +434,9 @@ ACLIP::match(const Ip::Address &clientip)
         // fall through to look for an IPv4 match among IP parameters
     }
 
-    static acl_ip_data ClientAddress;
-    /*
-     * aclIpAddrNetworkCompare() takes two acl_ip_data pointers as
-     * arguments, so we must create a fake one for the client's IP
-     * address. Since we are scanning for a single IP mask and addr2
-     * MUST be set to empty.
-     */
-    ClientAddress.addr1 = clientip;
-    ClientAddress.addr2.setEmpty();
-    ClientAddress.mask.setEmpty();
-
-    const acl_ip_data * const * result =  data->find(&ClientAddress, aclIpAddrNetworkCompare);
+    const auto result = data.match(clientip);
     debugs(28, 3, "aclIpMatchIp: '" << clientip << "' " << (result ? "found" : "NOT found"));
-    return (result != nullptr);
+    return result;
 }
 
 acl_ip_data::acl_ip_data() :addr1(), addr2(), mask(), next (nullptr) {}
@@ -10,9 +10,9 @@
 #define SQUID_SRC_ACL_IP_H
 
 #include "acl/Data.h"
+#include "acl/IpIndex.h"
 #include "acl/Node.h"
 #include "ip/Address.h"
-#include "splay.h"
 
 class acl_ip_data
 {
@@ -52,10 +52,7 @@ public:
     void *operator new(size_t);
     void operator delete(void *);
 
-    ACLIP() : data(nullptr) {}
-    ~ACLIP() override;
-
-    typedef Splay<acl_ip_data *> IPSplay;
+    ACLIP() = default;
 
     char const *typeString() const override = 0;
     void parse() override;
@@ -67,7 +64,7 @@ public:
 protected:
 
     int match(const Ip::Address &);
-    IPSplay *data;
+    Acl::IpIndex data;
 
 private:
     bool parseGlobal(const char *);
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 28    Access Control */
+
+#include "squid.h"
+#include "acl/Ip.h"
+#include "acl/IpIndex.h"
+#include "base/Assure.h"
+#include "debug/Stream.h"
+#include "globals.h"
+
+#include <algorithm>
+
+/// reports acl_ip_data using squid.conf ACL value format
+static std::ostream &
+operator <<(std::ostream &os, acl_ip_data *value)
+{
+    if (value)
+        os << value->toSBuf();
+    return os;
+}
+
+Acl::IpIndex::Key::Key(const Ip::Address &ip)
+{
+    struct in6_addr raw;
+    ip.getInAddr(raw);
+    hi = 0;
+    lo = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        hi = (hi << 8) | raw.s6_addr[i];
+        lo = (lo << 8) | raw.s6_addr[i + 8];
+    }
+}
+
+Acl::IpIndex::~IpIndex()
+{
+    for (const auto value: values_)
+        delete value;
+    for (const auto value: added_)
+        delete value;
+}
+
+void
+Acl::IpIndex::add(acl_ip_data * const value)
+{
+    Assure(value);
+    added_.push_back(value);
+}
+
+void
+Acl::IpIndex::commit()
+{
+    if (added_.empty())
+        return;
+
+    /// a value with its configuration order (zero for committed values)
+    class Candidate
+    {
+    public:
+        Candidate(acl_ip_data * const aValue, const size_t anOrder):
+            value(aValue),
+            first(aValue->firstAddress()),
+            last(aValue->lastAddress()),
+            order(anOrder)
+        {}
+
+        acl_ip_data *value;
+        Key first;
+        Key last;
+        size_t order;
+    };
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(values_.size() + added_.size());
+    for (const auto value: values_)
+        candidates.emplace_back(value, 0);
+    values_.clear();
+
+    for (const auto value: added_) {
+        Candidate candidate(value, candidates.size() + 1);
+        if (candidate.last < candidate.first) {
+            debugs(28, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: Ignoring " << value << " because it does not contain any addresses" <<
+                   Debug::Extra << "advice: Remove value " << value << " from the ACL");
+            delete value;
+            continue;
+        }
+        candidates.push_back(candidate);
+    }
+    added_.clear();
+    added_.shrink_to_fit();
+
+    // a covering value goes before the values it covers
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        if (a.first < b.first || b.first < a.first)
+            return a.first < b.first;
+        if (a.last < b.last || b.last < a.last)
+            return b.last < a.last;
+        return a.order < b.order;
+    });
+
+    // Combine overlapping values. Thanks to sorting, only the last kept value
+    // may overlap the current one.
+    std::vector<Candidate> kept;
+    kept.reserve(candidates.size());
+    for (auto &candidate: candidates) {
+        if (kept.empty() || kept.back().last < candidate.first) {
+            kept.push_back(candidate);
+            continue;
+        }
+
+        auto &previous = kept.back();
+        if (candidate.last <= previous.last) {
+            if (candidate.order > previous.order) {
+                debugs(28, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: Ignoring " << candidate.value << " because it is already covered by " << previous.value <<
+                       Debug::Extra << "advice: Remove value " << candidate.value << " from the ACL");
+            } else {
+                debugs(28, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: Ignoring earlier " << candidate.value << " because it is covered by " << previous.value <<
+                       Debug::Extra << "advice: Remove value " << candidate.value << " from the ACL");
+            }
+            delete candidate.value;
+            continue;
+        }
+
+        const auto combined = new acl_ip_data(previous.value->firstAddress(), candidate.value->lastAddress(), Ip::Address::NoAddr(), nullptr);
+        debugs(28, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: Merging overlapping " << candidate.value << " and " << previous.value << " into " << combined <<
+               Debug::Extra << "advice: Replace values " << candidate.value << " and " << previous.value << " with " << combined << " in the ACL");
+        delete previous.value;
+        delete candidate.value;
+        previous.value = combined;
+        previous.last = candidate.last;
+        previous.order = std::max(previous.order, candidate.order);
+    }
+    decltype(candidates)().swap(candidates);
+
+    lasts_.clear();
+    firsts_.clear();
+    lasts_.reserve(kept.size());
+    firsts_.reserve(kept.size());
+    values_.reserve(kept.size());
+    for (const auto &candidate: kept) {
+        lasts_.push_back(candidate.last);
+        firsts_.push_back(candidate.first);
+        values_.push_back(candidate.value);
+    }
+    lasts_.shrink_to_fit();
+    firsts_.shrink_to_fit();
+    values_.shrink_to_fit();
+    debugs(28, 3, "indexed " << values_.size() << " address ranges");
+}
+
+bool
+Acl::IpIndex::match(const Ip::Address &ip) const
+{
+    const Key key(ip);
+    const auto pos = std::lower_bound(lasts_.begin(), lasts_.end(), key);
+    return pos != lasts_.end() && firsts_[pos - lasts_.begin()] <= key;
+}
+
+SBufList
+Acl::IpIndex::dump() const
+{
+    SBufList contents;
+    for (const auto value: values_)
+        contents.push_back(value->toSBuf());
+    return contents;
+}
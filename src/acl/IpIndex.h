@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_ACL_IPINDEX_H
+#define SQUID_SRC_ACL_IPINDEX_H
+
+#include "ip/forward.h"
+#include "sbuf/List.h"
+
+#include <cstdint>
+#include <vector>
+
+class acl_ip_data;
+
+namespace Acl
+{
+
+/// Configured IP addresses, address ranges, and subnets that can be matched
+/// against an IP address without modifying the index. Overlapping values are
+/// combined when committed, leaving a flat array of disjoint address ranges
+/// sorted by their last address. A lookup is a single binary search over
+/// 128-bit keys (IPv4 addresses use their IPv4-mapped IPv6 form).
+class IpIndex
+{
+public:
+    IpIndex() = default;
+    IpIndex(IpIndex &&) = delete; // no copying or moving of any kind
+    ~IpIndex();
+
+    /// Remembers a configured value, taking ownership of it.
+    /// The value becomes matchable after the next commit() call.
+    void add(acl_ip_data *);
+
+    /// Merges values given to add() since the last commit() call into the
+    /// index. Reports and removes values covered by other values. Reports and
+    /// combines partially overlapping values.
+    void commit();
+
+    /// whether the given address belongs to one of the committed values
+    bool match(const Ip::Address &) const;
+
+    /// whether there are no committed values
+    bool empty() const { return values_.empty(); }
+
+    /// the number of committed (and possibly combined) values
+    size_t size() const { return values_.size(); }
+
+    /// all committed values, in address order
+    SBufList dump() const;
+
+private:
+    /// an IP address as a 128-bit number
+    class Key
+    {
+    public:
+        explicit Key(const Ip::Address &);
+
+        bool operator <(const Key &other) const { return hi < other.hi || (hi == other.hi && lo < other.lo); }
+        bool operator <=(const Key &other) const { return !(other < *this); }
+
+        uint64_t hi; ///< the most significant address bits
+        uint64_t lo; ///< the least significant address bits
+    };
+
+    /// the last address of each committed value (for searching)
+    std::vector<Key> lasts_;
+
+    /// the first address of each committed value (for matching)
+    std::vector<Key> firsts_;
+
+    /// committed values, sorted by address
+    std::vector<acl_ip_data *> values_;
+
+    /// values added after the last commit() call, in configuration order
+    std::vector<acl_ip_data *> added_;
+};
+
+} // namespace Acl
+
+#endif /* SQUID_SRC_ACL_IPINDEX_H */
@@ -19,15 +19,19 @@
 #include "acl/Checklist.h"
 #include "acl/RegexData.h"
 #include "base/RegexPattern.h"
+#include "base/RegexSet.h"
 #include "cache_cf.h"
 #include "ConfigParser.h"
 #include "debug/Stream.h"
 #include "sbuf/Algorithms.h"
 #include "sbuf/List.h"
 #include "sbuf/Stream.h"
+#include "SquidConfig.h"
 
 Acl::BooleanOptionValue ACLRegexData::CaseInsensitive_;
 
+ACLRegexData::ACLRegexData() = default;
+
 ACLRegexData::~ACLRegexData()
 {
 }
@@ -49,6 +53,13 @@ ACLRegexData::match(char const *word)
 
     debugs(28, 3, "checking '" << word << "'");
 
+    if (automaton) {
+        if (const auto pattern = automaton->match(word)) {
+            debugs(28, 2, '\'' << *pattern << "' found in '" << word << '\'');
+            return 1;
+        }
+    }
+
     // walk the list of patterns to see if one matches
     for (auto &i : data) {
         if (i.match(word)) {
@@ -67,6 +78,25 @@ ACLRegexData::dump() const
 {
     SBufStream os;
 
+    if (automaton) {
+        // mimic RegexPattern::print() for individual configured regexes
+        const int *previousFlags = nullptr;
+        for (const auto &patternAndFlags: configured) {
+            const auto caseSensitive = !(patternAndFlags.second & REG_ICASE);
+            if (!previousFlags) {
+                if (!caseSensitive)
+                    os << "-i ";
+            } else {
+                os << ' ';
+                if (*previousFlags != patternAndFlags.second)
+                    os << (caseSensitive ? "+i " : "-i ");
+            }
+            os << patternAndFlags.first;
+            previousFlags = &patternAndFlags.second;
+        }
+        return SBufList(1, os.buf());
+    }
+
     const RegexPattern *previous = nullptr;
     for (const auto &i: data) {
         i.print(os, previous); // skip flags implied by the previous entry
@@ -227,10 +257,19 @@ ACLRegexData::parse()
         flagsAtLineStart |= REG_ICASE;
 
     SBufList sl;
+    auto flags = flagsAtLineStart;
+    static const SBuf minus_i("-i"), plus_i("+i");
     while (char *t = ConfigParser::RegexStrtokFile()) {
         const char *clean = removeUnnecessaryWildcards(t);
         debugs(28, 3, "buffering RE '" << clean << "'");
         sl.emplace_back(clean);
+
+        if (sl.back() == minus_i)
+            flags |= REG_ICASE;
+        else if (sl.back() == plus_i)
+            flags &= ~REG_ICASE;
+        else
+            configured.emplace_back(sl.back(), flags);
     }
 
     try {
@@ -249,9 +288,66 @@ ACLRegexData::parse()
     }
 }
 
+void
+ACLRegexData::prepareForUse()
+{
+    if (Config.onoff.acl_regex_automaton && !automaton) {
+        try {
+            buildAutomaton();
+        } catch (...) {
+            debugs(28, DBG_IMPORTANT, "WARNING: Failed to build acl_regex_automaton; will check regular expressions one by one instead" <<
+                   Debug::Extra << "error: " << CurrentException);
+        }
+    }
+
+    if (!automaton) {
+        configured.clear();
+        configured.shrink_to_fit();
+    }
+}
+
+/// Replaces the list of regexes with an automaton covering all regexes that
+/// have a required literal and a list of the remaining regexes.
+void
+ACLRegexData::buildAutomaton()
+{
+    auto newAutomaton = std::make_unique<RegexSet>();
+
+    // regexes not covered by the automaton, optimized as in parse()
+    SBufList residual;
+    const auto residualFlagsAtStart = REG_EXTENDED | REG_NOSUB;
+    auto residualFlags = residualFlagsAtStart;
+    for (const auto &patternAndFlags: configured) {
+        if (newAutomaton->add(patternAndFlags.first, patternAndFlags.second))
+            continue;
+
+        if ((patternAndFlags.second & REG_ICASE) != (residualFlags & REG_ICASE))
+            residual.emplace_back((patternAndFlags.second & REG_ICASE) ? "-i" : "+i");
+        residual.push_back(patternAndFlags.first);
+        residualFlags = patternAndFlags.second;
+    }
+    newAutomaton->compile();
+
+    std::list<RegexPattern> newData;
+    if (!residual.empty()) {
+        try {
+            compileOptimisedREs(newData, residual, residualFlagsAtStart);
+        } catch (...) {
+            newData.clear();
+            compileUnoptimisedREs(newData, residual, residualFlagsAtStart);
+        }
+    }
+
+    debugs(28, 2, "automaton covers " << newAutomaton->size() << " out of " << configured.size() << " regexes" <<
+           "; " << newAutomaton->literalPatterns() << " of them are plain strings");
+
+    automaton = std::move(newAutomaton);
+    data.swap(newData);
+}
+
 bool
 ACLRegexData::empty() const
 {
-    return data.empty();
+    return data.empty() && (!automaton || automaton->empty());
 }
 
@@ -12,18 +12,24 @@
 #include "acl/Data.h"
 
 #include <list>
+#include <memory>
+#include <utility>
+#include <vector>
 
 class RegexPattern;
+class RegexSet;
 
 class ACLRegexData : public ACLData<char const *>
 {
     MEMPROXY_CLASS(ACLRegexData);
 
 public:
+    ACLRegexData();
     ~ACLRegexData() override;
     bool match(char const *user) override;
     SBufList dump() const override;
     void parse() override;
+    void prepareForUse() override;
     bool empty() const override;
 
 private:
@@ -33,7 +39,18 @@ private:
     /* ACLData API */
     const Acl::Options &lineOptions() override;
 
+    void buildAutomaton();
+
+    /// Regexes checked one by one. With the acl_regex_automaton engine,
+    /// only regexes that the automaton does not cover.
     std::list<RegexPattern> data;
+
+    /// configured regexes and their regcomp(3) flags, in configuration order;
+    /// kept for buildAutomaton() and for dump() when the automaton is used
+    std::vector<std::pair<SBuf, int>> configured;
+
+    /// the acl_regex_automaton engine (or nil)
+    std::unique_ptr<RegexSet> automaton;
 };
 
 #endif /* SQUID_SRC_ACL_REGEXDATA_H */
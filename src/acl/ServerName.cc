@@ -20,16 +20,6 @@
 #include "ssl/ServerBump.h"
 #include "ssl/support.h"
 
-// Compare function for tree search algorithms
-static int
-aclHostDomainCompare( char *const &a, char * const &b)
-{
-    const char *h = static_cast<const char *>(a);
-    const char *d = static_cast<const char *>(b);
-    debugs(28, 7, "Match:" << h << " <>  " << d);
-    return matchDomainName(h, d, mdnHonorWildcards);
-}
-
 bool
 ACLServerNameData::match(const char *host)
 {
@@ -38,13 +28,12 @@ ACLServerNameData::match(const char *host)
 
     debugs(28, 3, "checking '" << host << "'");
 
-    char *h = const_cast<char *>(host);
-    char const * const * result = domains->find(h, aclHostDomainCompare);
+    // certificate names may use wildcards (e.g., *.example.com)
+    const auto result = domains.match(host, true);
 
     debugs(28, 3, "'" << host << "' " << (result ? "found" : "NOT found"));
 
-    return (result != nullptr);
-
+    return result;
 }
 
 namespace Acl {
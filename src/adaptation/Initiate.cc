@@ -22,6 +22,8 @@ typedef UnaryMemFunT<Initiator, Answer, const Answer &> AnswerDialer;
 /// scheduled but never fired (e.g., because the HTTP transaction aborts).
 class AnswerCall: public AsyncCallT<AnswerDialer>
 {
+    MEMPROXY_CLASS(AnswerCall);
+
 public:
     AnswerCall(const char *aName, const AnswerDialer &aDialer) :
         AsyncCallT<AnswerDialer>(93, 5, aName, aDialer), fired(false) {}
@@ -40,7 +40,6 @@ AnyP::PortCfg::PortCfg() :
     ftp_track_dirs(false),
     vport(0),
     disable_pmtu_discovery(0),
-    workerQueues(false),
     listenConn()
 {
 }
@@ -55,7 +55,7 @@ public:
 
     int vport;               ///< virtual port support. -1 if dynamic, >0 static
     int disable_pmtu_discovery;
-    bool workerQueues; ///< whether listening queues should be worker-specific
+    Comm::WorkerQueues workerQueues;
 
     Comm::TcpKeepAlive tcp_keepalive;
 
@@ -21,6 +21,7 @@
 #include "auth/State.h"
 #include "cache_cf.h"
 #include "client_side.h"
+#include "fatal.h"
 #include "helper.h"
 #include "http/Stream.h"
 #include "HttpHeaderTools.h"
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/AhoCorasick.h"
+#include "base/Assure.h"
+
+#include <algorithm>
+#include <queue>
+
+AhoCorasick::Id
+AhoCorasick::add(const SBuf &needle)
+{
+    Assure(!compiled_);
+    Assure(!needle.isEmpty());
+
+    if (building_.empty()) {
+        building_.emplace_back(); // root
+        states_.emplace_back();
+    }
+
+    uint32_t state = 0;
+    for (const auto c: needle) {
+        const auto label = AhoCorasickFold(c);
+        auto &children = building_[state];
+        const auto pos = std::find_if(children.begin(), children.end(),
+        [label](const Edge &e) { return e.label == label; });
+        if (pos != children.end()) {
+            state = pos->target;
+            continue;
+        }
+        const auto created = static_cast<uint32_t>(states_.size());
+        children.push_back(Edge{label, created});
+        building_.emplace_back();
+        states_.emplace_back();
+        state = created;
+    }
+
+    auto &end = states_[state];
+    if (end.needle == NoNeedle)
+        end.needle = needles_++;
+    return end.needle;
+}
+
+/// the trie child of the given state (or None); valid after compile()
+uint32_t
+AhoCorasick::child(const uint32_t state, const uint8_t label) const
+{
+    const auto &s = states_[state];
+    const auto begin = edges_.begin() + s.firstEdge;
+    const auto end = begin + s.edgeCount;
+    const auto pos = std::lower_bound(begin, end, label,
+    [](const Edge &e, const uint8_t l) { return e.label < l; });
+    return (pos != end && pos->label == label) ? pos->target : None;
+}
+
+/// automaton transition from a non-root state
+uint32_t
+AhoCorasick::next(uint32_t state, const uint8_t label) const
+{
+    while (state) {
+        const auto target = child(state, label);
+        if (target != None)
+            return target;
+        state = states_[state].failure;
+    }
+    return rootNext_[label];
+}
+
+void
+AhoCorasick::compile()
+{
+    Assure(!compiled_);
+    compiled_ = true;
+
+    rootNext_.fill(0);
+    if (states_.empty())
+        return;
+
+    // flatten the trie, keeping edges of each state sorted for lower_bound()
+    size_t edgeCount = 0;
+    for (const auto &children: building_)
+        edgeCount += children.size();
+    edges_.reserve(edgeCount);
+    for (uint32_t s = 0; s < building_.size(); ++s) {
+        auto &children = building_[s];
+        std::sort(children.begin(), children.end(),
+        [](const Edge &a, const Edge &b) { return a.label < b.label; });
+        states_[s].firstEdge = edges_.size();
+        states_[s].edgeCount = children.size();
+        edges_.insert(edges_.end(), children.begin(), children.end());
+    }
+    decltype(building_)().swap(building_);
+
+    // compute failure and output links in breadth-first order
+    auto &root = states_[0];
+    root.output = (root.needle != NoNeedle) ? 0 : None;
+    std::queue<uint32_t> todo;
+    for (uint32_t e = root.firstEdge; e < root.firstEdge + root.edgeCount; ++e) {
+        const auto &edge = edges_[e];
+        rootNext_[edge.label] = edge.target;
+        states_[edge.target].failure = 0;
+        todo.push(edge.target);
+    }
+
+    while (!todo.empty()) {
+        const auto parent = todo.front();
+        todo.pop();
+
+        auto &p = states_[parent];
+        p.output = (p.needle != NoNeedle) ? parent : states_[p.failure].output;
+
+        for (uint32_t e = p.firstEdge; e < p.firstEdge + p.edgeCount; ++e) {
+            const auto &edge = edges_[e];
+            // failure states are shallower and, hence, already processed
+            states_[edge.target].failure = p.failure ? next(p.failure, edge.label) : rootNext_[edge.label];
+            todo.push(edge.target);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_BASE_AHOCORASICK_H
+#define SQUID_SRC_BASE_AHOCORASICK_H
+
+#include "sbuf/SBuf.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/// Finds all occurrences of many literal strings ("needles") in a given text
+/// using a single pass over that text (Aho-Corasick algorithm). Needles are
+/// matched case-insensitively (ASCII only). Root transitions use a dense
+/// table; other states keep sorted sparse edges to bound memory usage for
+/// large needle sets.
+class AhoCorasick
+{
+public:
+    /// needle identifier; ids are assigned sequentially starting with zero
+    using Id = uint32_t;
+
+    /// Adds a needle (if needed) and returns its id. Duplicate needles
+    /// (ignoring case) share the same id. Needles must not be empty.
+    /// Cannot be called after compile().
+    Id add(const SBuf &needle);
+
+    /// prepares for find() calls; must be called after the last add()
+    void compile();
+
+    /// whether no needles were added
+    bool empty() const { return needles_ == 0; }
+
+    /// the number of unique needles
+    size_t size() const { return needles_; }
+
+    /// Calls visitor(id, end) for every needle occurrence in the given text,
+    /// in the order of occurrence end positions. The end position is the
+    /// text offset right after the last needle character.
+    /// If the visitor returns false, the search stops.
+    template <class Visitor>
+    void find(const char *text, size_t length, Visitor visitor) const;
+
+private:
+    /// an automaton state; represents the longest needle prefix read so far
+    class State
+    {
+    public:
+        uint32_t firstEdge = 0; ///< index of our first outgoing edge in edges_
+        uint32_t edgeCount = 0; ///< the number of outgoing trie edges
+        uint32_t failure = 0; ///< the longest proper suffix state
+        uint32_t output = None; ///< the nearest state (us or a failure ancestor) ending a needle
+        Id needle = NoNeedle; ///< the needle ending at this state, if any
+    };
+
+    /// a labeled trie edge
+    class Edge
+    {
+    public:
+        uint8_t label;
+        uint32_t target;
+    };
+
+    static const uint32_t None = UINT32_MAX;
+    static const Id NoNeedle = UINT32_MAX;
+
+    uint32_t child(uint32_t state, uint8_t label) const;
+    uint32_t next(uint32_t state, uint8_t label) const;
+
+    /// trie under construction: per-state labeled children (emptied by compile())
+    std::vector<std::vector<Edge>> building_;
+
+    std::vector<State> states_;
+    std::vector<Edge> edges_; ///< all trie edges, sorted by label within each state
+    std::array<uint32_t, 256> rootNext_; ///< dense transitions from the root state
+    size_t needles_ = 0;
+    bool compiled_ = false;
+};
+
+/// ASCII-lowercased character, used for case-insensitive automaton transitions
+inline uint8_t
+AhoCorasickFold(const char c)
+{
+    const auto u = static_cast<uint8_t>(c);
+    return (u >= 'A' && u <= 'Z') ? u + ('a' - 'A') : u;
+}
+
+template <class Visitor>
+void
+AhoCorasick::find(const char *text, const size_t length, Visitor visitor) const
+{
+    if (!compiled_ || !needles_)
+        return;
+
+    uint32_t state = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const auto label = AhoCorasickFold(text[i]);
+        state = state ? next(state, label) : rootNext_[label];
+        for (auto out = states_[state].output; out != None; out = states_[states_[out].failure].output) {
+            if (!visitor(states_[out].needle, i + 1))
+                return;
+        }
+    }
+}
+
+#endif /* SQUID_SRC_BASE_AHOCORASICK_H */
@@ -13,8 +13,11 @@
 #include "base/forward.h"
 #include "base/InstanceId.h"
 #include "event.h"
+#include "mem/AllocatorProxy.h"
 #include "RefCount.h"
 
+#include <chrono>
+
 /**
  \defgroup AsynCallsAPI Async-Calls API
  \par
@@ -77,6 +80,10 @@ public:
     const int debugLevel;
     const InstanceId<AsyncCall> id;
 
+    /// when AsyncCallQueue::schedule() queued this call
+    /// (or the clock epoch if AsyncCallQueue::CollectStats was off)
+    std::chrono::steady_clock::time_point scheduledAt;
+
 protected:
     virtual bool canFire();
 
@@ -123,6 +130,9 @@ public:
 template <class DialerClass>
 class AsyncCallT: public AsyncCall
 {
+    // each instantiation gets its own pool of same-size calls
+    MEMPROXY_CLASS_TEMPLATE(AsyncCallT<DialerClass>);
+
 public:
     using Dialer = DialerClass;
 
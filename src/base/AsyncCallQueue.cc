@@ -13,23 +13,135 @@
 #include "base/AsyncCallQueue.h"
 #include "debug/Stream.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+
 AsyncCallQueue *AsyncCallQueue::TheInstance = nullptr;
 
+int AsyncCallQueue::CollectStats = 0;
+
+/// the maximum number of calls fired by one fireBatch() call
+static const size_t BatchSizeMax = 64;
+
+void
+AsyncCallQueue::CallStats::note(const Clock::duration delay)
+{
+    ++fired;
+    totalDelay += delay;
+    maxDelay = std::max(maxDelay, delay);
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+    size_t bin = 0;
+    while (micros > 0 && bin + 1 < delays.size()) {
+        micros >>= 1;
+        ++bin;
+    }
+    ++delays[bin];
+}
+
+void
+AsyncCallQueue::schedule(const AsyncCallPointer &call)
+{
+    if (CollectStats)
+        call->scheduledAt = Clock::now();
+    scheduled.add(call);
+}
+
 // Fire all scheduled calls; returns true if at least one call was fired.
 // The calls may be added while the current call is in progress.
 bool
 AsyncCallQueue::fire()
 {
     const auto made = scheduled.size() > 0;
-    while (const auto call = scheduled.extract()) {
-        CodeContext::Reset(call->codeContext);
+    while (scheduled.size() > 0)
+        fireBatch();
+    if (made)
+        CodeContext::Reset();
+    return made;
+}
+
+/// Fires the earliest scheduled calls, up to BatchSizeMax of them. Batch
+/// calls share one clock reading for their schedule-to-fire delay statistics.
+/// Consecutive calls with the same CodeContext do not switch contexts.
+void
+AsyncCallQueue::fireBatch()
+{
+    ++batches;
+    const auto batchStart = CollectStats ? Clock::now() : Clock::time_point();
+    for (auto budget = BatchSizeMax; budget > 0; --budget) {
+        const auto call = scheduled.extract();
+        if (!call)
+            break;
+
+        ++fired;
+        // skip calls scheduled before statistics collection was enabled
+        if (CollectStats && call->scheduledAt != Clock::time_point()) {
+            // calls scheduled during this batch may have "negative" delays
+            stats[call->name].note(std::max(batchStart - call->scheduledAt, Clock::duration::zero()));
+        }
+
+        if (call->codeContext != CodeContext::Current())
+            CodeContext::Reset(call->codeContext);
         debugs(call->debugSection, call->debugLevel, "entering " << *call);
         call->make();
         debugs(call->debugSection, call->debugLevel, "leaving " << *call);
     }
-    if (made)
-        CodeContext::Reset();
-    return made;
+}
+
+void
+AsyncCallQueue::reportStats(std::ostream &os) const
+{
+    // merge stats of same-name calls with different AsyncCall::name pointers
+    std::map<std::string, CallStats> byName;
+    for (const auto &i: stats) {
+        auto &merged = byName[i.first];
+        const auto &callStats = i.second;
+        merged.fired += callStats.fired;
+        merged.totalDelay += callStats.totalDelay;
+        merged.maxDelay = std::max(merged.maxDelay, callStats.maxDelay);
+        for (size_t bin = 0; bin < merged.delays.size(); ++bin)
+            merged.delays[bin] += callStats.delays[bin];
+    }
+
+    os << "Fired calls: " << fired << "\n";
+    os << "Dispatch batches: " << batches << "\n";
+    os << "Scheduled calls: " << scheduled.size() << "\n";
+    os << "\n";
+
+    if (!CollectStats && byName.empty()) {
+        os << "Per-call statistics are not collected; see async_call_stats in squid.conf.\n";
+        return;
+    }
+
+    using Micros = std::chrono::duration<double, std::micro>;
+    os << std::setw(10) << "fired" << ' ' <<
+       std::setw(12) << "mean_delay" << ' ' <<
+       std::setw(12) << "max_delay" << ' ' <<
+       "call (delay histogram: upper bound in us: count)\n";
+    for (const auto &i: byName) {
+        const auto &callStats = i.second;
+        os << std::setw(10) << callStats.fired << ' ' <<
+           std::fixed << std::setprecision(1) <<
+           std::setw(10) << (Micros(callStats.totalDelay).count() / std::max(callStats.fired, uint64_t(1))) << "us " <<
+           std::setw(10) << Micros(callStats.maxDelay).count() << "us " <<
+           i.first << " (";
+        auto separator = "";
+        for (size_t bin = 0; bin < callStats.delays.size(); ++bin) {
+            if (!callStats.delays[bin])
+                continue;
+            os << separator;
+            if (bin + 1 < callStats.delays.size())
+                os << (uint64_t(1) << bin);
+            else
+                os << "inf";
+            os << ": " << callStats.delays[bin];
+            separator = ", ";
+        }
+        os << ")\n";
+    }
 }
 
 AsyncCallQueue &
@@ -41,4 +153,3 @@ AsyncCallQueue::Instance()
 
     return *TheInstance;
 }
-
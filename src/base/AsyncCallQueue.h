@@ -12,25 +12,62 @@
 #include "base/AsyncCallList.h"
 #include "base/forward.h"
 
+#include <array>
+#include <chrono>
+#include <iosfwd>
+#include <unordered_map>
+
 // The queue of asynchronous calls. All calls are fired during a single main
 // loop iteration until the queue is exhausted
 class AsyncCallQueue
 {
 public:
+    using Clock = std::chrono::steady_clock;
+
     // there is only one queue
     static AsyncCallQueue &Instance();
 
     // make this async call when we get a chance
-    void schedule(const AsyncCallPointer &call) { scheduled.add(call); }
+    void schedule(const AsyncCallPointer &call);
 
     // fire all scheduled calls; returns true if at least one was fired
     bool fire();
 
+    /// reports the number of fired calls and, if CollectStats is on, their
+    /// schedule-to-fire delays, grouped by call name
+    void reportStats(std::ostream &) const;
+
+    /// Whether to collect per-call dispatch statistics (async_call_stats).
+    /// Collecting them costs two clock readings and a hash lookup per call.
+    static int CollectStats;
+
 private:
+    /// dispatch statistics for same-name calls
+    class CallStats
+    {
+    public:
+        void note(Clock::duration delay);
+
+        uint64_t fired = 0; ///< the number of fired calls
+        Clock::duration totalDelay = Clock::duration::zero();
+        Clock::duration maxDelay = Clock::duration::zero();
+        /// Fired call counts by their schedule-to-fire delay: [0, 1us),
+        /// [1us, 2us), [2us, 4us), etc. The last bin has all longer delays.
+        std::array<uint64_t, 24> delays = {};
+    };
+
     AsyncCallQueue() = default;
 
+    void fireBatch();
+
     AsyncCallList scheduled; ///< calls waiting to be fire()d, in FIFO order
 
+    /// call dispatch statistics, indexed by AsyncCall::name
+    std::unordered_map<const char *, CallStats> stats;
+
+    uint64_t fired = 0; ///< the number of fired calls
+    uint64_t batches = 0; ///< the number of fireBatch() calls
+
     static AsyncCallQueue *TheInstance;
 };
 
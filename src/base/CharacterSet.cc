@@ -9,21 +9,22 @@
 #include "squid.h"
 #include "base/CharacterSet.h"
 
-#include <algorithm>
 #include <iostream>
-#include <functional>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_VECTORIZED_CHARACTERSET_SCANS 1
+#include <immintrin.h>
+#else
+#define HAVE_VECTORIZED_CHARACTERSET_SCANS 0
+#endif
 
 CharacterSet &
 CharacterSet::operator +=(const CharacterSet &src)
 {
-    Storage::const_iterator s = src.chars_.begin();
-    const Storage::const_iterator e = src.chars_.end();
-    Storage::iterator d = chars_.begin();
-    while (s != e) {
-        if (*s)
-            *d = 1;
-        ++s;
-        ++d;
+    for (size_t c = 0; c < chars_.size(); ++c) {
+        if (src.chars_[c])
+            setMembership(c, true);
     }
     return *this;
 }
@@ -31,14 +32,9 @@ CharacterSet::operator +=(const CharacterSet &src)
 CharacterSet &
 CharacterSet::operator -=(const CharacterSet &src)
 {
-    Storage::const_iterator s = src.chars_.begin();
-    const Storage::const_iterator e = src.chars_.end();
-    Storage::iterator d = chars_.begin();
-    while (s != e) {
-        if (*s)
-            *d = 0;
-        ++s;
-        ++d;
+    for (size_t c = 0; c < chars_.size(); ++c) {
+        if (src.chars_[c])
+            setMembership(c, false);
     }
     return *this;
 }
@@ -46,14 +42,14 @@ CharacterSet::operator -=(const CharacterSet &src)
 CharacterSet &
 CharacterSet::add(const unsigned char c)
 {
-    chars_[static_cast<uint8_t>(c)] = 1;
+    setMembership(c, true);
     return *this;
 }
 
 CharacterSet &
 CharacterSet::remove(const unsigned char c)
 {
-    chars_[static_cast<uint8_t>(c)] = 0;
+    setMembership(c, false);
     return *this;
 }
 
@@ -63,10 +59,10 @@ CharacterSet::addRange(unsigned char low, unsigned char high)
     //manual loop splitting is needed to cover case where high is 255
     // otherwise low will wrap, resulting in infinite loop
     while (low < high) {
-        chars_[static_cast<uint8_t>(low)] = 1;
+        setMembership(low, true);
         ++low;
     }
-    chars_[static_cast<uint8_t>(high)] = 1;
+    setMembership(high, true);
     return *this;
 }
 
@@ -75,11 +71,136 @@ CharacterSet::complement(const char *label) const
 {
     CharacterSet result((label ? label : "complement_of_some_other_set"), "");
     // negate each of our elements and add them to the result storage
-    std::transform(chars_.begin(), chars_.end(), result.chars_.begin(),
-                   std::logical_not<Storage::value_type>());
+    for (size_t c = 0; c < chars_.size(); ++c)
+        result.setMembership(c, !chars_[c]);
     return result;
 }
 
+void
+CharacterSet::setMembership(const uint8_t c, const bool member)
+{
+    chars_[c] = member ? 1 : 0;
+    auto &bitmap = nibbles_[c >> 7][c & 0xF];
+    const uint8_t bit = 1 << ((c >> 4) & 7);
+    if (member)
+        bitmap |= bit;
+    else
+        bitmap &= ~bit;
+}
+
+const char *
+CharacterSet::findFirstIn(const char * const begin, const char * const end) const
+{
+    return scan(begin, end, true);
+}
+
+const char *
+CharacterSet::findFirstNotIn(const char * const begin, const char * const end) const
+{
+    return scan(begin, end, false);
+}
+
+#if HAVE_VECTORIZED_CHARACTERSET_SCANS
+
+// Each kernel looks up set membership of 16 (or 32) characters at once: The
+// low nibble of a character selects a nibbles_ bitmap (via a byte shuffle),
+// and the high nibble selects a bit in that bitmap. The kernels only process
+// whole vectors; scan() handles the remaining characters.
+
+/// \returns the number of leading whole 16-byte blocks without wanted characters
+__attribute__((target("ssse3")))
+static size_t
+ScanSsse3(const uint8_t nibbles[2][16], const char * const begin, const size_t blocks, const bool member)
+{
+    const auto lowerHalf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[0]));
+    const auto upperHalf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[1]));
+    const auto bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const auto lowNibble = _mm_set1_epi8(0x0F);
+    const auto upperHighNibbles = _mm_set1_epi8(7);
+    const int unwanted = member ? 0 : 0xFFFF;
+
+    for (size_t block = 0; block < blocks; ++block) {
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin) + block);
+        const auto low = _mm_and_si128(chars, lowNibble);
+        const auto high = _mm_and_si128(_mm_srli_epi16(chars, 4), lowNibble);
+        const auto inUpperHalf = _mm_cmpgt_epi8(high, upperHighNibbles);
+        const auto bitmaps = _mm_or_si128(
+                                 _mm_andnot_si128(inUpperHalf, _mm_shuffle_epi8(lowerHalf, low)),
+                                 _mm_and_si128(inUpperHalf, _mm_shuffle_epi8(upperHalf, low)));
+        const auto bit = _mm_shuffle_epi8(bits, high);
+        const auto found = _mm_cmpeq_epi8(_mm_and_si128(bitmaps, bit), bit);
+        if (_mm_movemask_epi8(found) ^ unwanted)
+            return block;
+    }
+    return blocks;
+}
+
+/// \returns the number of leading whole 32-byte blocks without wanted characters
+__attribute__((target("avx2")))
+static size_t
+ScanAvx2(const uint8_t nibbles[2][16], const char * const begin, const size_t blocks, const bool member)
+{
+    const auto lowerHalf = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[0])));
+    const auto upperHalf = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[1])));
+    const auto bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const auto lowNibble = _mm256_set1_epi8(0x0F);
+    const auto upperHighNibbles = _mm256_set1_epi8(7);
+    const uint32_t unwanted = member ? 0 : 0xFFFFFFFF;
+
+    for (size_t block = 0; block < blocks; ++block) {
+        const auto chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin) + block);
+        const auto low = _mm256_and_si256(chars, lowNibble);
+        const auto high = _mm256_and_si256(_mm256_srli_epi16(chars, 4), lowNibble);
+        const auto inUpperHalf = _mm256_cmpgt_epi8(high, upperHighNibbles);
+        const auto bitmaps = _mm256_blendv_epi8(
+                                 _mm256_shuffle_epi8(lowerHalf, low),
+                                 _mm256_shuffle_epi8(upperHalf, low),
+                                 inUpperHalf);
+        const auto bit = _mm256_shuffle_epi8(bits, high);
+        const auto found = _mm256_cmpeq_epi8(_mm256_and_si256(bitmaps, bit), bit);
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(found)) ^ unwanted)
+            return block;
+    }
+    return blocks;
+}
+
+/// the best vectorized kernel supported by the CPU we are running on
+static auto
+ChooseScanner()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return std::make_pair(&ScanAvx2, size_t(32));
+    if (__builtin_cpu_supports("ssse3"))
+        return std::make_pair(&ScanSsse3, size_t(16));
+    return std::make_pair<decltype(&ScanSsse3), size_t>(nullptr, 0);
+}
+
+#endif /* HAVE_VECTORIZED_CHARACTERSET_SCANS */
+
+/// the first character in [begin, end) with the given set membership (or end)
+const char *
+CharacterSet::scan(const char *begin, const char * const end, const bool member) const
+{
+#if HAVE_VECTORIZED_CHARACTERSET_SCANS
+    // short inputs (e.g., a method name or a tiny header value) are not worth it
+    static const auto scanner = ChooseScanner();
+    const auto blockSize = scanner.second;
+    if (blockSize && size_t(end - begin) >= blockSize) {
+        const size_t blocks = (end - begin) / blockSize;
+        const auto skipped = scanner.first(nibbles_, begin, blocks, member);
+        begin += skipped * blockSize; // the wanted character, if any, is in the next block
+    }
+#endif
+
+    for (; begin < end; ++begin) {
+        if ((chars_[static_cast<uint8_t>(*begin)] != 0) == member)
+            return begin;
+    }
+    return end;
+}
+
 CharacterSet::CharacterSet(const char *label, const char * const c) :
     name(label ? label: "anonymous"),
     chars_(Storage(256,0))
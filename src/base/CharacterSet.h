@@ -9,6 +9,7 @@
 #ifndef SQUID_SRC_BASE_CHARACTERSET_H
 #define SQUID_SRC_BASE_CHARACTERSET_H
 
+#include <cstdint>
 #include <initializer_list>
 #include <iosfwd>
 #include <vector>
@@ -38,6 +39,12 @@ public:
     /// whether a given character exists in the set
     bool operator[](unsigned char c) const {return chars_[static_cast<uint8_t>(c)] != 0;}
 
+    /// the first character in [begin, end) that is in the set (or end)
+    const char *findFirstIn(const char *begin, const char *end) const;
+
+    /// the first character in [begin, end) that is not in the set (or end)
+    const char *findFirstNotIn(const char *begin, const char *end) const;
+
     /// add a given character to the character set
     CharacterSet & add(const unsigned char c);
 
@@ -122,12 +129,20 @@ public:
     static const CharacterSet &RFC3986_UNRESERVED();
 
 private:
+    void setMembership(uint8_t c, bool member);
+    const char *scan(const char *begin, const char *end, bool member) const;
+
     /** index of characters in this set
      *
      * \note guaranteed to be always 256 slots big, as forced in the
      *  constructor. This assumption is relied upon in various methods
      */
     Storage chars_;
+
+    /// Set membership in a form suitable for vectorized scans: Bit (h % 8)
+    /// of nibbles_[h / 8][l] is set if and only if the character with the
+    /// high nibble h and the low nibble l is in the set.
+    uint8_t nibbles_[2][16] = {};
 };
 
 /** CharacterSet addition
@@ -57,3 +57,175 @@ RegexPattern::print(std::ostream &os, const RegexPattern * const previous) const
     os << pattern;
 }
 
+
+/// Skips a bracket expression starting at (and including) the opening '['.
+/// \returns the position after the closing ']' or npos if there is none
+static SBuf::size_type
+SkipBracketExpression(const SBuf &re, SBuf::size_type pos)
+{
+    ++pos; // '['
+    if (pos < re.length() && re[pos] == '^')
+        ++pos;
+    if (pos < re.length() && re[pos] == ']')
+        ++pos; // a leading ']' is a literal
+    while (pos < re.length()) {
+        const auto c = re[pos];
+        if (c == ']')
+            return pos + 1;
+        if (c == '[' && pos + 1 < re.length() && (re[pos+1] == ':' || re[pos+1] == '.' || re[pos+1] == '=')) {
+            // [:class:], [.coll.], or [=equiv=]
+            const char terminator[] = { re[pos+1], ']', '\0' };
+            const auto end = re.find(SBuf(terminator), pos + 2);
+            if (end == SBuf::npos)
+                return SBuf::npos;
+            pos = end + 2;
+            continue;
+        }
+        ++pos;
+    }
+    return SBuf::npos;
+}
+
+SBuf
+RegexPattern::RequiredLiteral(const SBuf &re, const int flags, bool &exact)
+{
+    // Only the top-level concatenation of ordinary characters is examined:
+    // groups, bracket expressions, and other special atoms just end the
+    // current literal run. Any top-level alternation defeats the analysis.
+    exact = false;
+    if (!(flags & REG_EXTENDED))
+        return SBuf();
+
+    SBuf best;
+    SBuf current;
+    // whether the regex has anything but ordinary characters
+    auto special = false;
+    const auto finishRun = [&best, &current, &special]() {
+        special = true;
+        if (current.length() > best.length())
+            best = current;
+        current.clear();
+    };
+
+    // a trailing ".*" does not affect what the regex matches
+    auto end = re.length();
+    if (end >= 2 && re[end-2] == '.' && re[end-1] == '*' && (end == 2 || re[end-3] != '\\'))
+        end -= 2;
+
+    // whether the last atom was a literal character appended to current
+    auto lastAtomIsCurrent = false;
+    SBuf::size_type pos = 0;
+    while (pos < end) {
+        const auto c = re[pos];
+        switch (c) {
+        case '|':
+            return SBuf();
+
+        case '(': {
+            finishRun();
+            lastAtomIsCurrent = false;
+            int depth = 0;
+            while (pos < end) {
+                const auto g = re[pos];
+                if (g == '\\') {
+                    pos += 2;
+                    continue;
+                }
+                if (g == '[') {
+                    pos = SkipBracketExpression(re, pos);
+                    if (pos == SBuf::npos)
+                        return SBuf();
+                    continue;
+                }
+                ++pos;
+                if (g == '(')
+                    ++depth;
+                else if (g == ')' && --depth == 0)
+                    break;
+            }
+            if (depth)
+                return SBuf(); // unbalanced
+            continue;
+        }
+
+        case '[':
+            finishRun();
+            lastAtomIsCurrent = false;
+            pos = SkipBracketExpression(re, pos);
+            if (pos == SBuf::npos)
+                return SBuf();
+            continue;
+
+        case '*':
+        case '?':
+        case '{':
+            // the quantified atom may be absent
+            if (lastAtomIsCurrent)
+                current.chop(0, current.length() - 1);
+            finishRun();
+            lastAtomIsCurrent = false;
+            if (c == '{') {
+                pos = re.find('}', pos);
+                if (pos == SBuf::npos)
+                    return SBuf();
+            }
+            ++pos;
+            continue;
+
+        case '+':
+            // the quantified atom is present, but may be followed by its copies
+            finishRun();
+            lastAtomIsCurrent = false;
+            ++pos;
+            continue;
+
+        case '.':
+        case '^':
+        case '$':
+            finishRun();
+            lastAtomIsCurrent = false;
+            ++pos;
+            continue;
+
+        case '\\': {
+            if (pos + 1 >= end)
+                return SBuf();
+            const auto escaped = re[pos+1];
+            // back-references and library-specific escapes like \w or \<
+            if (xisalnum(escaped) || escaped == '<' || escaped == '>' || escaped == '`' || escaped == '\'') {
+                finishRun();
+                lastAtomIsCurrent = false;
+            } else {
+                current.append(escaped);
+                lastAtomIsCurrent = true;
+            }
+            pos += 2;
+            continue;
+        }
+
+        default:
+            current.append(c);
+            lastAtomIsCurrent = true;
+            ++pos;
+            continue;
+        }
+    }
+
+    if (!special && !current.isEmpty())
+        exact = true;
+
+    finishRun();
+
+    // regcomp(3) letter case rules for non-ASCII characters are
+    // locale-specific, but literal matching only folds ASCII letters
+    if (flags & REG_ICASE) {
+        for (const auto c: best) {
+            if (static_cast<unsigned char>(c) >= 0x80) {
+                exact = false;
+                return SBuf();
+            }
+        }
+    }
+
+    return best;
+}
@@ -39,6 +39,19 @@ public:
 
     bool match(const char *str) const {return regexec(&regex,str,0,nullptr,0)==0;}
 
+    /// The longest literal string that every match() must contain, ignoring
+    /// letter case, or an empty SBuf if no such string could be identified.
+    /// Useful for quickly rejecting subjects before running regexec(3).
+    /// Case-insensitive regexes get no literal with non-ASCII characters
+    /// because their case folding depends on the regcomp(3) locale.
+    SBuf requiredLiteral() const { auto exact = false; return RequiredLiteral(pattern, flags, exact); }
+
+    /// requiredLiteral() for the given regcomp(3) pattern and flags, without
+    /// compiling the pattern. Sets `exact` to whether finding the returned
+    /// literal (in the letter case implied by the flags) is equivalent to
+    /// matching the whole regex.
+    static SBuf RequiredLiteral(const SBuf &pattern, int flags, bool &exact);
+
     /// Attempts to reproduce this regex (context-sensitive) configuration.
     /// If the previous regex is nil, may not report default flags.
     /// Otherwise, may not report same-as-previous flags (and prepends a space).
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/Assure.h"
+#include "base/RegexSet.h"
+#include "debug/Stream.h"
+
+#include <cstring>
+
+bool
+RegexSet::add(const SBuf &pattern, const int flags)
+{
+    auto exact = false;
+    const auto literal = RegexPattern::RequiredLiteral(pattern, flags, exact);
+    if (literal.isEmpty())
+        return false;
+
+    rules_.emplace_back();
+    auto &rule = rules_.back();
+    rule.pattern = pattern;
+    rule.literal = literal;
+    rule.literalId = literals_.add(literal);
+    rule.caseSensitive = !(flags & REG_ICASE);
+    if (exact)
+        ++literalPatterns_;
+    else
+        rule.regex.reset(new RegexPattern(pattern, flags));
+    return true;
+}
+
+void
+RegexSet::compile()
+{
+    literals_.compile();
+
+    // group rule indexes by literal (counting sort preserves the rule order)
+    firstRule_.assign(literals_.size() + 1, 0);
+    for (const auto &rule: rules_)
+        ++firstRule_[rule.literalId + 1];
+    for (size_t i = 1; i < firstRule_.size(); ++i)
+        firstRule_[i] += firstRule_[i-1];
+
+    rulesByLiteral_.resize(rules_.size());
+    auto next = firstRule_;
+    for (uint32_t r = 0; r < rules_.size(); ++r)
+        rulesByLiteral_[next[rules_[r].literalId]++] = r;
+
+    debugs(28, 2, rules_.size() << " patterns with " << literals_.size() << " literals; " <<
+           literalPatterns_ << " patterns need no regex matching");
+}
+
+/// whether the given rule matches the subject with the rule literal ending at the given position
+bool
+RegexSet::matchesAt(Rule &rule, const char * const subject, const size_t end)
+{
+    if (!rule.regex) {
+        // the automaton ignores letter case
+        if (!rule.caseSensitive)
+            return true;
+        const auto length = rule.literal.length();
+        return memcmp(subject + end - length, rule.literal.rawContent(), length) == 0;
+    }
+
+    if (rule.checked == generation_)
+        return false; // the literal occurred earlier, and regexec(3) failed then
+    rule.checked = generation_;
+    return rule.regex->match(subject);
+}
+
+const SBuf *
+RegexSet::match(const char * const subject)
+{
+    Assure(subject);
+    ++generation_;
+
+    const SBuf *found = nullptr;
+    literals_.find(subject, strlen(subject), [this, subject, &found](const AhoCorasick::Id id, const size_t end) {
+        for (auto i = firstRule_[id]; i < firstRule_[id + 1]; ++i) {
+            auto &rule = rules_[rulesByLiteral_[i]];
+            if (matchesAt(rule, subject, end)) {
+                found = &rule.pattern;
+                return false;
+            }
+        }
+        return true;
+    });
+    return found;
+}
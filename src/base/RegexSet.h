@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_BASE_REGEXSET_H
+#define SQUID_SRC_BASE_REGEXSET_H
+
+#include "base/AhoCorasick.h"
+#include "base/RegexPattern.h"
+#include "sbuf/SBuf.h"
+
+#include <memory>
+#include <vector>
+
+/// Answers whether any of the given regular expressions matches a string,
+/// scanning that string once with an automaton built from literal strings
+/// required by those regular expressions. Regular expressions that are
+/// equivalent to a literal string search are answered by the automaton
+/// alone. Others are given to regexec(3) only if the automaton finds their
+/// literal. Regular expressions without a required literal are not accepted.
+class RegexSet
+{
+public:
+    /// Adds a regcomp(3) pattern if it has a required literal.
+    /// \returns whether the pattern was added
+    /// \throws TextException for an invalid pattern that needs compilation
+    bool add(const SBuf &pattern, int flags);
+
+    /// prepares for match() calls; must be called after the last add()
+    void compile();
+
+    /// whether no patterns were added
+    bool empty() const { return rules_.empty(); }
+
+    /// the number of added patterns
+    size_t size() const { return rules_.size(); }
+
+    /// the number of added patterns that need no regexec(3) calls
+    size_t literalPatterns() const { return literalPatterns_; }
+
+    /// \returns one of the added patterns matching the given string or nil
+    const SBuf *match(const char *subject);
+
+private:
+    /// an added pattern
+    class Rule
+    {
+    public:
+        SBuf pattern; ///< the regex as given to add()
+        SBuf literal; ///< the required literal string
+        AhoCorasick::Id literalId = 0; ///< literal identifier in literals_
+        bool caseSensitive = true; ///< whether the regex differentiates letter case
+        /// compiled regex for patterns not equivalent to a literal search
+        std::unique_ptr<RegexPattern> regex;
+        /// the last match() generation that called regexec(3) for this rule
+        uint64_t checked = 0;
+    };
+
+    bool matchesAt(Rule &, const char *subject, size_t end);
+
+    AhoCorasick literals_;
+    std::vector<Rule> rules_;
+
+    /// rule indexes for each literal, flattened by compile()
+    std::vector<uint32_t> rulesByLiteral_;
+    /// for each literal, the position of its first rule in rulesByLiteral_,
+    /// followed by a sentinel
+    std::vector<uint32_t> firstRule_;
+
+    size_t literalPatterns_ = 0;
+
+    /// the number of match() calls, used to avoid repeating regexec(3) calls
+    uint64_t generation_ = 0;
+};
+
+#endif /* SQUID_SRC_BASE_REGEXSET_H */
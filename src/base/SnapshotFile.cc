@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/SnapshotFile.h"
+#include "base/TextException.h"
+#include "compat/xstrerror.h"
+#include "sbuf/Stream.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/// uses the table-driven "slicing-by-8" algorithm
+uint32_t
+SnapshotChecksum(uint32_t checksum, const void * const buf, size_t size)
+{
+    using Tables = std::array<std::array<uint32_t, 256>, 8>;
+    static const auto t = [] {
+        Tables tables;
+        for (uint32_t i = 0; i < 256; ++i) {
+            auto crc = i;
+            for (auto bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1))); // reversed polynomial
+            tables[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < tables.size(); ++k)
+                tables[k][i] = (tables[k-1][i] >> 8) ^ tables[0][tables[k-1][i] & 0xFF];
+        }
+        return tables;
+    }();
+
+    auto pos = static_cast<const uint8_t *>(buf);
+    checksum = ~checksum;
+    for (; size >= 8; size -= 8, pos += 8) {
+        const uint32_t low = checksum ^ (pos[0] | pos[1] << 8 | pos[2] << 16 | uint32_t(pos[3]) << 24);
+        const uint32_t high = pos[4] | pos[5] << 8 | pos[6] << 16 | uint32_t(pos[7]) << 24;
+        checksum = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                   t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+    for (; size > 0; --size, ++pos)
+        checksum = (checksum >> 8) ^ t[0][(checksum ^ *pos) & 0xFF];
+    return ~checksum;
+}
+
+/* SnapshotFileWriter */
+
+SnapshotFileWriter::SnapshotFileWriter(const SBuf &path, const size_t headerSize):
+    path_(path),
+    tmpPath_(ToSBuf(path, ".new")),
+    headerSize_(headerSize)
+{
+    file_ = fopen(tmpPath_.c_str(), "wb");
+    if (!file_)
+        throw TextException(ToSBuf("cannot create ", tmpPath_, ": ", xstrerr(errno)), Here());
+
+    // finish() overwrites this placeholder
+    static const char placeholder[256] = {};
+    for (auto left = headerSize_; left > 0;) {
+        const auto size = std::min(left, sizeof(placeholder));
+        writeOrThrow(placeholder, size);
+        left -= size;
+    }
+}
+
+SnapshotFileWriter::~SnapshotFileWriter()
+{
+    if (file_) {
+        // not finished; do not leave partial snapshots behind
+        fclose(file_);
+        (void)unlink(tmpPath_.c_str());
+    }
+}
+
+void
+SnapshotFileWriter::writeOrThrow(const void * const buf, const size_t size)
+{
+    Must(file_);
+    if (fwrite(buf, size, 1, file_) != 1)
+        throw TextException(ToSBuf("cannot write ", tmpPath_, ": ", xstrerr(errno)), Here());
+}
+
+void
+SnapshotFileWriter::append(const void * const buf, const size_t size)
+{
+    if (!size)
+        return;
+    writeOrThrow(buf, size);
+    bodySize_ += size;
+}
+
+void
+SnapshotFileWriter::alignBody()
+{
+    static const char padding[8] = {};
+    append(padding, (sizeof(padding) - bodySize_ % sizeof(padding)) % sizeof(padding));
+}
+
+void
+SnapshotFileWriter::finish(const void * const header)
+{
+    Must(file_);
+    if (fseek(file_, 0, SEEK_SET) != 0)
+        throw TextException(ToSBuf("cannot rewind ", tmpPath_, ": ", xstrerr(errno)), Here());
+    writeOrThrow(header, headerSize_);
+
+    if (fflush(file_) != 0 || fsync(fileno(file_)) != 0)
+        throw TextException(ToSBuf("cannot sync ", tmpPath_, ": ", xstrerr(errno)), Here());
+
+    const auto closed = fclose(file_);
+    file_ = nullptr;
+    if (closed != 0 || rename(tmpPath_.c_str(), path_.c_str()) != 0) {
+        const auto xerrno = errno;
+        (void)unlink(tmpPath_.c_str());
+        throw TextException(ToSBuf("cannot save ", path_, ": ", xstrerr(xerrno)), Here());
+    }
+}
+
+/* SnapshotFileReader */
+
+SnapshotFileReader::~SnapshotFileReader()
+{
+#if HAVE_SYS_MMAN_H
+    if (mapped_)
+        munmap(const_cast<char *>(mapped_), mappedSize_);
+#endif
+}
+
+void
+SnapshotFileReader::open(SBuf path, const size_t headerSize)
+{
+    Must(!mapped_);
+
+#if HAVE_SYS_MMAN_H
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0)
+        throw TextException(ToSBuf("cannot open ", path, ": ", xstrerr(errno)), Here());
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const auto xerrno = errno;
+        close(fd);
+        throw TextException(ToSBuf("cannot get the size of ", path, ": ", xstrerr(xerrno)), Here());
+    }
+    if (static_cast<size_t>(st.st_size) < headerSize) {
+        close(fd);
+        throw TextException(SBuf("truncated snapshot header"), Here());
+    }
+
+    const auto size = static_cast<size_t>(st.st_size);
+    const auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const auto xerrno = errno;
+    close(fd);
+    if (mapped == MAP_FAILED)
+        throw TextException(ToSBuf("cannot map ", path, ": ", xstrerr(xerrno)), Here());
+    mapped_ = static_cast<const char *>(mapped);
+    mappedSize_ = size;
+    headerSize_ = headerSize;
+
+#if defined(MADV_SEQUENTIAL)
+    (void)madvise(mapped, size, MADV_SEQUENTIAL);
+#endif
+#else
+    (void)path;
+    (void)headerSize;
+    throw TextException(SBuf("memory mapping is not supported"), Here());
+#endif
+}
+
+const char *
+SnapshotFileReader::header() const
+{
+    Must(mapped_);
+    return mapped_;
+}
+
+const char *
+SnapshotFileReader::body() const
+{
+    return header() + headerSize_;
+}
+
+const char *
+SnapshotFileReader::end() const
+{
+    return header() + mappedSize_;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_BASE_SNAPSHOTFILE_H
+#define SQUID_SRC_BASE_SNAPSHOTFILE_H
+
+#include "sbuf/SBuf.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/// Adds the given bytes to a CRC32C (Castagnoli) checksum of earlier bytes.
+/// Start with a zero checksum. Used by all snapshot formats.
+uint32_t SnapshotChecksum(uint32_t checksum, const void *buf, size_t size);
+
+/// Writes a snapshot file: a fixed-size header followed by a body. Callers
+/// define the format of both; the header is written last. The file replaces
+/// the old snapshot (if any) only after finish() succeeds, so readers never
+/// see partial snapshots. Methods throw on failures.
+class SnapshotFileWriter
+{
+public:
+    SnapshotFileWriter(const SBuf &path, size_t headerSize);
+    ~SnapshotFileWriter();
+
+    SnapshotFileWriter(SnapshotFileWriter &&) = delete; // no copying or moving
+
+    /// appends the given bytes to the body
+    void append(const void *buf, size_t size);
+
+    /// appends zero bytes until the body size is a multiple of 8, keeping the
+    /// following records aligned in memory-mapped snapshots
+    void alignBody();
+
+    /// the number of bytes appended so far
+    uint64_t bodySize() const { return bodySize_; }
+
+    /// writes the given headerSize-byte header, syncs, and renames the
+    /// snapshot into place
+    void finish(const void *header);
+
+private:
+    void writeOrThrow(const void *buf, size_t size);
+
+    SBuf path_; ///< the final snapshot location
+    SBuf tmpPath_; ///< where the snapshot is written to
+    size_t headerSize_; ///< the number of bytes reserved for the header
+    FILE *file_ = nullptr; ///< tmpPath_ (or nil after finish())
+    uint64_t bodySize_ = 0;
+};
+
+/// maps an existing snapshot file into memory
+class SnapshotFileReader
+{
+public:
+    SnapshotFileReader() = default;
+    ~SnapshotFileReader();
+
+    SnapshotFileReader(SnapshotFileReader &&) = delete; // no copying or moving
+
+    /// maps the whole snapshot file; throws on failures, including files too
+    /// short to have a headerSize-byte header
+    void open(SBuf path, size_t headerSize);
+
+    /// whether open() has succeeded
+    bool isOpen() const { return mapped_; }
+
+    /// the beginning of the mapped file
+    const char *header() const;
+
+    /// the first byte after the header
+    const char *body() const;
+
+    /// the first byte after the mapped file
+    const char *end() const;
+
+    /// the number of bytes after the header
+    size_t bodySize() const { return mappedSize_ - headerSize_; }
+
+private:
+    const char *mapped_ = nullptr; ///< the whole snapshot file
+    size_t mappedSize_ = 0;
+    size_t headerSize_ = 0;
+};
+
+#endif /* SQUID_SRC_BASE_SNAPSHOTFILE_H */
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/Assure.h"
+#include "base/TimerWheel.h"
+
+#include <limits>
+
+/// the position of the lowest set bit
+static int
+LowestBit(uint64_t bits)
+{
+    int position = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        ++position;
+    }
+    return position;
+}
+
+TimerWheel::TimerWheel(const Tick now):
+    now_(now)
+{
+}
+
+void
+TimerWheel::schedule(Timer &timer, const Tick due)
+{
+    cancel(timer);
+    timer.due_ = due;
+    place(timer);
+    ++size_;
+    if (earliest_ && due < earliest_->due_)
+        earliest_ = &timer;
+}
+
+void
+TimerWheel::cancel(Timer &timer)
+{
+    if (timer.scheduled())
+        unlink(timer);
+}
+
+/// adds an unlinked timer to the slot matching its due tick
+void
+TimerWheel::place(Timer &timer)
+{
+    if (timer.due_ <= now_) {
+        timer.level_ = ExpiredLevel;
+        timer.slot_ = 0;
+        link(timer, expired_);
+        return;
+    }
+
+    // the level is determined by the most significant bit that differs
+    const auto difference = timer.due_ ^ now_;
+    int level = 0;
+    while (level + 1 < LevelCount && (difference >> (SlotBits * (level + 1))))
+        ++level;
+
+    const auto slot = (timer.due_ >> (SlotBits * level)) & (SlotCount - 1);
+    timer.level_ = level;
+    timer.slot_ = slot;
+    link(timer, slots_[level][slot]);
+    occupied_[level] |= uint64_t(1) << slot;
+}
+
+void
+TimerWheel::link(Timer &timer, Timer *&head)
+{
+    timer.next_ = head;
+    if (head)
+        head->pprev_ = &timer.next_;
+    head = &timer;
+    timer.pprev_ = &head;
+}
+
+void
+TimerWheel::unlink(Timer &timer)
+{
+    Assure(timer.pprev_);
+    *timer.pprev_ = timer.next_;
+    if (timer.next_)
+        timer.next_->pprev_ = timer.pprev_;
+    timer.next_ = nullptr;
+    timer.pprev_ = nullptr;
+
+    if (timer.level_ != ExpiredLevel && !slots_[timer.level_][timer.slot_])
+        occupied_[timer.level_] &= ~(uint64_t(1) << timer.slot_);
+
+    Assure(size_ > 0);
+    --size_;
+    if (earliest_ == &timer)
+        earliest_ = nullptr;
+}
+
+/// The earliest tick at which advance() has work to do: Either some timers
+/// become due or some timers must move to a lower level. Timers at a given
+/// level share the now_ bits above that level, so the first occupied slot of
+/// the lowest occupied level holds the earliest timers.
+TimerWheel::Tick
+TimerWheel::nextTick() const
+{
+    if (expired_)
+        return now_;
+
+    for (int level = 0; level < LevelCount; ++level) {
+        const auto shift = SlotBits * level;
+        const auto current = (now_ >> shift) & (SlotCount - 1);
+        const auto later = current + 1 < SlotCount ? ~uint64_t(0) << (current + 1) : 0;
+        if (const auto candidates = occupied_[level] & later) {
+            const auto upperShift = shift + SlotBits;
+            const Tick base = upperShift < 64 ? (now_ >> upperShift) << upperShift : 0;
+            return base | (Tick(LowestBit(candidates)) << shift);
+        }
+    }
+
+    return std::numeric_limits<Tick>::max();
+}
+
+/// moves the clock to the given tick, moving timers down the wheel levels
+void
+TimerWheel::enter(const Tick tick)
+{
+    now_ = tick;
+    for (int level = LevelCount - 1; level >= 0; --level) {
+        const auto slot = (now_ >> (SlotBits * level)) & (SlotCount - 1);
+        if (!(occupied_[level] & (uint64_t(1) << slot)))
+            continue;
+
+        auto timer = slots_[level][slot];
+        slots_[level][slot] = nullptr;
+        occupied_[level] &= ~(uint64_t(1) << slot);
+        while (timer) {
+            const auto next = timer->next_;
+            timer->next_ = nullptr;
+            timer->pprev_ = nullptr;
+            place(*timer);
+            timer = next;
+        }
+    }
+}
+
+const TimerWheel::Timer *
+TimerWheel::earliest() const
+{
+    if (earliest_ || !size_)
+        return earliest_;
+
+    const Timer *list = expired_;
+    if (!list) {
+        const auto tick = nextTick();
+        for (int level = 0; level < LevelCount && !list; ++level) {
+            const auto slot = (tick >> (SlotBits * level)) & (SlotCount - 1);
+            if (occupied_[level] & (uint64_t(1) << slot))
+                list = slots_[level][slot];
+        }
+    }
+    Assure(list);
+
+    earliest_ = list;
+    for (auto timer = list->next_; timer; timer = timer->next_) {
+        if (timer->due_ < earliest_->due_)
+            earliest_ = timer;
+    }
+    return earliest_;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_BASE_TIMERWHEEL_H
+#define SQUID_SRC_BASE_TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/// A hierarchical timing wheel: Tracks timers (owned by the caller) that are
+/// due at a given tick and reports timers that became due as time advances.
+/// Scheduling and canceling a timer take constant time. Each wheel level
+/// has 64 slots, and each level slot spans 64 slots of the level below it.
+/// Timers are moved to lower levels as their due tick approaches.
+///
+/// The wheel does not interpret ticks; callers decide what a tick means
+/// (e.g., a millisecond or a second) and when to advance(). The wheel does
+/// not own timers, and destroying the wheel does not update them.
+class TimerWheel
+{
+public:
+    using Tick = uint64_t;
+
+    /// a scheduling record embedded in (or associated with) a timed object
+    class Timer
+    {
+    public:
+        Timer() = default;
+        Timer(Timer &&) = delete; // no copying or moving of any kind
+
+        /// whether this timer is waiting to become due
+        bool scheduled() const { return pprev_; }
+
+        /// the tick given to the last TimerWheel::schedule() call
+        Tick due() const { return due_; }
+
+    private:
+        friend class TimerWheel;
+
+        Timer *next_ = nullptr; ///< the next timer in our slot
+        Timer **pprev_ = nullptr; ///< the pointer to us in our slot (or nil)
+        Tick due_ = 0;
+        uint8_t level_ = 0; ///< our wheel level or ExpiredLevel
+        uint8_t slot_ = 0; ///< our slot at level_
+    };
+
+    explicit TimerWheel(Tick now = 0);
+    TimerWheel(TimerWheel &&) = delete; // no copying or moving of any kind
+
+    /// Makes the timer due at the given tick, rescheduling it if needed.
+    /// A timer due at or before now() becomes due during the next advance().
+    void schedule(Timer &, Tick due);
+
+    /// forgets the given timer (if it is scheduled)
+    void cancel(Timer &);
+
+    /// Moves the wheel clock forward to the given tick (or keeps the current
+    /// tick if the given one is not in the future) and calls
+    /// visitor(Timer &) for every timer due at or before the new now(). Each
+    /// timer is forgotten before the call. Visitors may (re)schedule timers.
+    template <class Visitor>
+    void advance(Tick, Visitor &&);
+
+    /// the earliest scheduled timer (or nil)
+    const Timer *earliest() const;
+
+    /// the current wheel clock tick
+    Tick now() const { return now_; }
+
+    /// the number of scheduled timers
+    size_t size() const { return size_; }
+
+    bool empty() const { return !size_; }
+
+private:
+    static constexpr int SlotBits = 6;
+    static constexpr int SlotCount = 1 << SlotBits;
+    /// enough levels to place any Tick, regardless of its distance from now_
+    static constexpr int LevelCount = (64 + SlotBits - 1) / SlotBits;
+    /// Timer::level_ for timers that are already due
+    static constexpr uint8_t ExpiredLevel = LevelCount;
+
+    void place(Timer &);
+    void link(Timer &, Timer *&head);
+    void unlink(Timer &);
+    Tick nextTick() const;
+    void enter(Tick);
+
+    /// timer lists, indexed by level and slot
+    Timer *slots_[LevelCount][SlotCount] = {};
+
+    /// non-empty slots_ bitmaps, indexed by level
+    uint64_t occupied_[LevelCount] = {};
+
+    /// timers due at or before now_
+    Timer *expired_ = nullptr;
+
+    /// a cached earliest() result (or nil if it must be recomputed)
+    mutable const Timer *earliest_ = nullptr;
+
+    Tick now_;
+    size_t size_ = 0;
+};
+
+template <class Visitor>
+void
+TimerWheel::advance(const Tick target, Visitor &&visitor)
+{
+    for (;;) {
+        while (const auto timer = expired_) {
+            unlink(*timer);
+            visitor(*timer);
+        }
+
+        if (target <= now_)
+            return;
+
+        const auto next = nextTick();
+        if (next > target) {
+            now_ = target;
+            return;
+        }
+        enter(next);
+    }
+}
+
+#endif /* SQUID_SRC_BASE_TIMERWHEEL_H */
@@ -22,6 +22,7 @@
 #include "auth/Config.h"
 #include "auth/Scheme.h"
 #include "AuthReg.h"
+#include "base/AsyncCallQueue.h"
 #include "base/CharacterSet.h"
 #include "base/PackableStream.h"
 #include "base/RunnersRegistry.h"
@@ -35,6 +36,7 @@
 #include "DiskIO/DiskIOModule.h"
 #include "eui/Config.h"
 #include "ExternalACL.h"
+#include "fatal.h"
 #include "format/Format.h"
 #include "fqdncache.h"
 #include "ftp/Elements.h"
@@ -3693,13 +3695,9 @@ parse_port_option(AnyP::PortCfgPointer &s, char *token)
     } else if (strcmp(token, "ftp-track-dirs") == 0) {
         s->ftp_track_dirs = true;
     } else if (strcmp(token, "worker-queues") == 0) {
-#if !defined(SO_REUSEADDR)
-#error missing system #include that #defines SO_* constants
-#endif
-#if !defined(SO_REUSEPORT)
-        throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires building Squid where SO_REUSEPORT is supported by the TCP stack"));
-#endif
-        s->workerQueues = true;
+        s->workerQueues.parse(nullptr);
+    } else if (strncmp(token, "worker-queues=", 14) == 0) {
+        s->workerQueues.parse(token + 14);
     } else {
         debugs(3, DBG_CRITICAL, "FATAL: Unknown " << cfg_directive << " option '" << token << "'.");
         self_destruct();
@@ -3882,6 +3880,11 @@ dump_generic_port(StoreEntry * e, const char *n, const AnyP::PortCfgPointer &s)
     if (s->s.isAnyAddr() && !s->s.isIPv6())
         storeAppendPrintf(e, " ipv4");
 
+    if (s->workerQueues.byCpu)
+        storeAppendPrintf(e, " worker-queues=cpu-affinity");
+    else if (s->workerQueues.enabled)
+        storeAppendPrintf(e, " worker-queues");
+
     if (s->tcp_keepalive.enabled) {
         if (s->tcp_keepalive.idle || s->tcp_keepalive.interval || s->tcp_keepalive.timeout) {
             storeAppendPrintf(e, " tcpkeepalive=%d,%d,%d", s->tcp_keepalive.idle, s->tcp_keepalive.interval, s->tcp_keepalive.timeout);
@@ -78,9 +78,11 @@
 #include "comm/TcpAcceptor.h"
 #include "comm/Write.h"
 #include "CommCalls.h"
+#include "CpuAffinity.h"
 #include "debug/Messages.h"
 #include "error/ExceptionErrorDetail.h"
 #include "errorpage.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "fqdncache.h"
@@ -329,13 +331,13 @@ prepareLogWithRequestDetails(HttpRequest *request, const AccessLogEntryPointer &
         mb.init();
         request->header.packInto(&mb);
         //This is the request after adaptation or redirection
-        aLogEntry->headers.adapted_request = xstrdup(mb.buf);
+        aLogEntry->headers.adapted_request = aLogEntry->keepHeaderImage(mb, request->masterXaction);
 
         // the virgin request is saved to aLogEntry->request
         if (aLogEntry->request) {
             mb.reset();
             aLogEntry->request->header.packInto(&mb);
-            aLogEntry->headers.request = xstrdup(mb.buf);
+            aLogEntry->headers.request = aLogEntry->keepHeaderImage(mb, request->masterXaction);
         }
 
 #if USE_ADAPTATION
@@ -343,7 +345,7 @@ prepareLogWithRequestDetails(HttpRequest *request, const AccessLogEntryPointer &
         if (ah != nullptr) {
             mb.reset();
             ah->lastMeta.packInto(&mb);
-            aLogEntry->adapt.last_meta = xstrdup(mb.buf);
+            aLogEntry->adapt.last_meta = aLogEntry->keepHeaderImage(mb, request->masterXaction);
         }
 #endif
 
@@ -3228,6 +3230,29 @@ OpenedHttpSocket(const Comm::ConnectionPointer &c, const Ipc::FdNoteId portType)
     return true;
 }
 
+/// Asks the TCP stack to prefer our SO_REUSEPORT listening queue for
+/// connections handled by the CPU dedicated to this worker. Failures are not
+/// fatal because plain worker-specific queues still work.
+static void
+SteerToWorkerCpu(const AnyP::PortCfgPointer &s)
+{
+    const auto cpu = CpuAffinityDedicatedCpu();
+    if (cpu < 0) {
+        debugs(1, DBG_IMPORTANT, "WARNING: Not steering connections to " << s->listenConn << " by CPU" <<
+               Debug::Extra << "problem: cpu_affinity_map does not bind this kid to a single CPU" <<
+               Debug::Extra << "advice: Bind each worker to one CPU or use plain worker-queues");
+        return;
+    }
+
+    if (!Comm::ApplyIncomingCpu(s->listenConn->fd, cpu)) {
+        debugs(1, DBG_IMPORTANT, "WARNING: Not steering connections to " << s->listenConn << " by CPU" <<
+               Debug::Extra << "problem: The TCP stack rejected SO_INCOMING_CPU " << cpu);
+        return;
+    }
+
+    debugs(1, 2, "steering connections handled by CPU " << cpu << " to " << s->listenConn);
+}
+
 /// find any unused HttpSockets[] slot and store fd there or return false
 static bool
 AddOpenedHttpSocket(const Comm::ConnectionPointer &conn)
@@ -3299,7 +3324,7 @@ clientStartListeningOn(AnyP::PortCfgPointer &port, const RefCount< CommCbFunPtrC
         COMM_NONBLOCKING |
         (port->flags.tproxyIntercept ? COMM_TRANSPARENT : 0) |
         (port->flags.natIntercept ? COMM_INTERCEPTION : 0) |
-        (port->workerQueues ? COMM_REUSEPORT : 0);
+        (port->workerQueues.enabled ? COMM_REUSEPORT : 0);
 
     // route new connections to subCall
     typedef CommCbFunPtrCallT<CommAcceptCbPtrFun> AcceptCall;
@@ -3327,6 +3352,9 @@ clientListenerConnectionOpened(AnyP::PortCfgPointer &s, const Ipc::FdNoteId port
 
     Must(Comm::IsConnOpen(s->listenConn));
 
+    if (s->workerQueues.byCpu)
+        SteerToWorkerCpu(s);
+
     // TCP: setup a job to handle accept() with subscribed handler
     AsyncJob::Start(new Comm::TcpAcceptor(s, FdNote(portTypeNote), sub));
 
@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "base/AsyncFunCalls.h"
 #include "base/OnOff.h"
+#include "base/TimerWheel.h"
 #include "ClientInfo.h"
 #include "comm/AcceptLimiter.h"
 #include "comm/comm_internal.h"
@@ -23,6 +24,7 @@
 #include "compat/cmsg.h"
 #include "DescriptorSet.h"
 #include "event.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "globals.h"
@@ -30,11 +32,13 @@
 #include "ip/Intercept.h"
 #include "ip/QosConfig.h"
 #include "ip/tools.h"
+#include "mgr/Registration.h"
 #include "pconn.h"
 #include "sbuf/SBuf.h"
 #include "sbuf/Stream.h"
 #include "SquidConfig.h"
 #include "StatCounters.h"
+#include "Store.h"
 #include "StoreIOBuffer.h"
 #include "tools.h"
 
@@ -42,6 +46,7 @@
 #include "ssl/support.h"
 #endif
 
+#include <algorithm>
 #include <cerrno>
 #include <cmath>
 #if _SQUID_CYGWIN_
@@ -76,6 +81,19 @@ static bool WillCheckHalfClosed = false; /// true if check is scheduled
 static EVH commHalfClosedCheck;
 static void commPlanHalfClosedCheck();
 
+/// FDs that checkTimeouts() should examine, keyed by squid_curtime seconds
+static TimerWheel *TimeoutWheel = nullptr;
+/// TimeoutWheel timers, indexed by FD
+static TimerWheel::Timer *TimeoutTimers = nullptr;
+static OBJH commTimeoutStats;
+
+/// checkTimeouts() statistics for cache manager reports
+static struct {
+    uint64_t checks = 0; ///< FD examinations
+    uint64_t expired = 0; ///< timeouts reached
+    time_t maxLateness = 0; ///< the longest delay between a due check and the check
+} TimeoutStats;
+
 static Comm::Flag commBind(int s, struct addrinfo &);
 static void commSetBindAddressNoPort(int);
 static void commSetReuseAddr(int);
@@ -609,6 +627,7 @@ commSetConnTimeout(const Comm::ConnectionPointer &conn, time_t timeout, AsyncCal
         }
 
         F->timeout = squid_curtime + timeout;
+        commScheduleTimeoutCheck(conn->fd);
     }
 }
 
@@ -1147,6 +1166,12 @@ comm_init(void)
 
     TheHalfClosed = new DescriptorSet;
 
+    TimeoutWheel = new TimerWheel(squid_curtime);
+    TimeoutTimers = new TimerWheel::Timer[Squid_MaxFD];
+    Mgr::RegisterAction("comm_timeouts",
+                        "Connection timeout checks",
+                        commTimeoutStats, 0, 1);
+
     /* setup the select loop module */
     Comm::SelectLoopInit();
 }
@@ -1156,6 +1181,11 @@ comm_exit(void)
 {
     delete TheHalfClosed;
     TheHalfClosed = nullptr;
+
+    delete TimeoutWheel;
+    TimeoutWheel = nullptr;
+    delete[] TimeoutTimers;
+    TimeoutTimers = nullptr;
 }
 
 #if USE_DELAY_POOLS
@@ -1487,56 +1517,140 @@ writeTimedOut(int fd)
     return true;
 }
 
+/// the time when checkTimeouts() should examine the given FD (or zero)
+static time_t
+NextTimeoutCheck(const int fd)
+{
+    const auto F = &fd_table[fd];
+    time_t next = 0;
+    const auto consider = [&next](const time_t when) {
+        if (!next || when < next)
+            next = when;
+    };
+
+    if (COMMIO_FD_WRITECB(fd)->active())
+        consider(F->writeStart + Config.Timeout.write);
+
+#if USE_DELAY_POOLS
+    // writes waiting for quota are re-examined every second
+    if (F->writeQuotaHandler != nullptr && COMMIO_FD_WRITECB(fd)->conn != nullptr)
+        consider(squid_curtime + 1);
+#endif
+
+    if (F->flags.open && F->timeout)
+        consider(F->timeout);
+
+    return next;
+}
+
+/// (re)schedules the next checkTimeouts() visit to the given FD, if needed
+static void
+ScheduleTimeoutCheck(const int fd, const time_t notBefore)
+{
+    auto when = NextTimeoutCheck(fd);
+    if (!when)
+        return;
+    when = std::max(when, notBefore);
+
+    // An earlier check is harmless: The FD will be rescheduled after it.
+    auto &timer = TimeoutTimers[fd];
+    if (!timer.scheduled() || TimerWheel::Tick(when) < timer.due())
+        TimeoutWheel->schedule(timer, when);
+}
+
 void
-checkTimeouts(void)
+commScheduleTimeoutCheck(const int fd)
 {
-    int fd;
-    fde *F = nullptr;
-    AsyncCall::Pointer callback;
+    if (!TimeoutWheel)
+        return; // comm_init() has not been called yet
 
-    for (fd = 0; fd <= Biggest_FD; ++fd) {
-        F = &fd_table[fd];
+    ScheduleTimeoutCheck(fd, 0);
+}
 
-        if (writeTimedOut(fd)) {
-            // We have an active write callback and we are timed out
+/// handles a single FD that may have reached one of its timeouts
+static void
+checkTimeout(const int fd)
+{
+    const auto F = &fd_table[fd];
+
+    if (writeTimedOut(fd)) {
+        // We have an active write callback and we are timed out
+        ++TimeoutStats.expired;
+        CodeContext::Reset(F->codeContext);
+        debugs(5, 5, "checkTimeouts: FD " << fd << " auto write timeout");
+        Comm::SetSelect(fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
+        COMMIO_FD_WRITECB(fd)->finish(Comm::COMM_ERROR, ETIMEDOUT);
+        CodeContext::Reset();
+        return;
+#if USE_DELAY_POOLS
+    } else if (F->writeQuotaHandler != nullptr && COMMIO_FD_WRITECB(fd)->conn != nullptr) {
+        // TODO: Move and extract quota() call to place it inside F->codeContext.
+        if (!F->writeQuotaHandler->selectWaiting && F->writeQuotaHandler->quota() && !F->closing()) {
             CodeContext::Reset(F->codeContext);
-            debugs(5, 5, "checkTimeouts: FD " << fd << " auto write timeout");
-            Comm::SetSelect(fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
-            COMMIO_FD_WRITECB(fd)->finish(Comm::COMM_ERROR, ETIMEDOUT);
+            F->writeQuotaHandler->selectWaiting = true;
+            Comm::SetSelect(fd, COMM_SELECT_WRITE, Comm::HandleWrite, COMMIO_FD_WRITECB(fd), 0);
             CodeContext::Reset();
-            continue;
-#if USE_DELAY_POOLS
-        } else if (F->writeQuotaHandler != nullptr && COMMIO_FD_WRITECB(fd)->conn != nullptr) {
-            // TODO: Move and extract quota() call to place it inside F->codeContext.
-            if (!F->writeQuotaHandler->selectWaiting && F->writeQuotaHandler->quota() && !F->closing()) {
-                CodeContext::Reset(F->codeContext);
-                F->writeQuotaHandler->selectWaiting = true;
-                Comm::SetSelect(fd, COMM_SELECT_WRITE, Comm::HandleWrite, COMMIO_FD_WRITECB(fd), 0);
-                CodeContext::Reset();
-            }
-            continue;
-#endif
         }
-        else if (AlreadyTimedOut(F))
-            continue;
+        return;
+#endif
+    }
+    else if (AlreadyTimedOut(F))
+        return;
 
-        CodeContext::Reset(F->codeContext);
-        debugs(5, 5, "checkTimeouts: FD " << fd << " Expired");
+    ++TimeoutStats.expired;
+    CodeContext::Reset(F->codeContext);
+    debugs(5, 5, "checkTimeouts: FD " << fd << " Expired");
 
-        if (F->timeoutHandler != nullptr) {
-            debugs(5, 5, "checkTimeouts: FD " << fd << ": Call timeout handler");
-            callback = F->timeoutHandler;
-            F->timeoutHandler = nullptr;
-            ScheduleCallHere(callback);
-        } else {
-            debugs(5, 5, "checkTimeouts: FD " << fd << ": Forcing comm_close()");
-            comm_close(fd);
-        }
+    if (F->timeoutHandler != nullptr) {
+        debugs(5, 5, "checkTimeouts: FD " << fd << ": Call timeout handler");
+        AsyncCall::Pointer callback = F->timeoutHandler;
+        F->timeoutHandler = nullptr;
+        ScheduleCallHere(callback);
+    } else {
+        debugs(5, 5, "checkTimeouts: FD " << fd << ": Forcing comm_close()");
+        comm_close(fd);
+    }
 
-        CodeContext::Reset();
+    CodeContext::Reset();
+}
+
+/// Examines FDs that may have reached their timeouts. Instead of scanning the
+/// whole fd_table, visits FDs with due TimeoutTimers. FDs with timeouts that
+/// were extended since they were scheduled are rescheduled after the check.
+void
+checkTimeouts(void)
+{
+    if (!TimeoutWheel)
+        return;
+
+    static std::vector<int> dueFds;
+    dueFds.clear();
+    TimeoutWheel->advance(squid_curtime, [](TimerWheel::Timer &timer) {
+        const auto fd = static_cast<int>(&timer - TimeoutTimers);
+        dueFds.push_back(fd);
+        const auto lateness = squid_curtime - static_cast<time_t>(timer.due());
+        TimeoutStats.maxLateness = std::max(TimeoutStats.maxLateness, lateness);
+    });
+
+    // preserve the historical FD examination order
+    std::sort(dueFds.begin(), dueFds.end());
+    for (const auto fd: dueFds) {
+        ++TimeoutStats.checks;
+        checkTimeout(fd);
+        ScheduleTimeoutCheck(fd, squid_curtime + 1);
     }
 }
 
+/// reports checkTimeouts() statistics
+static void
+commTimeoutStats(StoreEntry *sentry)
+{
+    storeAppendPrintf(sentry, "Scheduled timeout checks: %zu\n", TimeoutWheel ? TimeoutWheel->size() : 0);
+    storeAppendPrintf(sentry, "Timeout checks: %" PRIu64 "\n", TimeoutStats.checks);
+    storeAppendPrintf(sentry, "Expired timeouts: %" PRIu64 "\n", TimeoutStats.expired);
+    storeAppendPrintf(sentry, "Max check lateness: %ld sec\n", static_cast<long>(TimeoutStats.maxLateness));
+}
+
 /// Start waiting for a possibly half-closed connection to close
 // by scheduling a read callback to a monitoring handler that
 // will close the connection on read errors.
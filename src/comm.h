@@ -78,6 +78,10 @@ void commUnsetFdTimeout(int fd);
 void commSetConnTimeout(const Comm::ConnectionPointer &, time_t seconds, AsyncCall::Pointer &);
 void commUnsetConnTimeout(const Comm::ConnectionPointer &);
 
+/// Makes sure checkTimeouts() examines the given FD by its earliest pending
+/// timeout. Must be called after setting fde::timeout or starting a write.
+void commScheduleTimeoutCheck(int fd);
+
 int ignoreErrno(int);
 void commCloseAllSockets(void);
 void checkTimeouts(void);
@@ -319,6 +319,7 @@ Comm::ConnOpener::createFd()
     params.conn = conn_;
     fd_table[temporaryFd_].timeoutHandler = calls_.timeout_;
     fd_table[temporaryFd_].timeout = deadline_;
+    commScheduleTimeoutCheck(temporaryFd_);
 
     return true;
 }
@@ -68,6 +68,59 @@ Comm::IoCallback::setCallback(Comm::iocb_type t, AsyncCall::Pointer &cb, char *b
     freefunc = f;
     size = sz;
     offset = 0;
+    tailCount = 0;
+}
+
+void
+Comm::IoCallback::setTail(const struct iovec *iov, const int iovcnt)
+{
+    assert(active());
+    assert(type == IOCB_WRITE);
+    assert(iovcnt >= 0);
+    assert(tailCount + iovcnt <= WriteVectorMax);
+
+    for (int i = 0; i < iovcnt; ++i) {
+        if (!iov[i].iov_len)
+            continue;
+        tail[tailCount] = iov[i];
+        ++tailCount;
+        size += iov[i].iov_len;
+    }
+}
+
+int
+Comm::IoCallback::pendingIoVector(struct iovec *iov, const int maxBytes) const
+{
+    auto tailBytes = 0;
+    for (int i = 0; i < tailCount; ++i)
+        tailBytes += tail[i].iov_len;
+
+    int count = 0;
+    auto skip = offset; // bytes written earlier
+    auto wanted = maxBytes;
+
+    const auto addPiece = [&](char *base, int length) {
+        if (skip >= length) {
+            skip -= length;
+            return;
+        }
+        base += skip;
+        length -= skip;
+        skip = 0;
+        if (wanted <= 0 || length <= 0)
+            return;
+        const auto pieceSize = min(length, wanted);
+        iov[count].iov_base = base;
+        iov[count].iov_len = pieceSize;
+        ++count;
+        wanted -= pieceSize;
+    };
+
+    addPiece(buf, size - tailBytes);
+    for (int i = 0; i < tailCount; ++i)
+        addPiece(static_cast<char*>(tail[i].iov_base), tail[i].iov_len);
+
+    return count;
 }
 
 void
@@ -104,6 +157,7 @@ Comm::IoCallback::reset()
         freefunc = nullptr;
     }
     xerrno = 0;
+    tailCount = 0;
 
 #if USE_DELAY_POOLS
     quotaQueueReserv = 0;
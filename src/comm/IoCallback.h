@@ -12,6 +12,7 @@
 #include "base/AsyncCall.h"
 #include "comm/Flag.h"
 #include "comm/forward.h"
+#include "comm/Write.h"
 #include "mem/forward.h"
 #include "sbuf/forward.h"
 
@@ -34,8 +35,13 @@ public:
     AsyncCall::Pointer callback;
     char *buf;
     FREE *freefunc;
-    int size;
+    int size; ///< total number of bytes to read or write, including tail bytes
     int offset;
+
+    /// caller-owned buffers written after buf bytes (gathered writes only)
+    struct iovec tail[WriteVectorMax];
+    int tailCount; ///< the number of used tail[] entries
+
     Comm::Flag errcode;
     int xerrno;
 #if USE_DELAY_POOLS
@@ -45,6 +51,14 @@ public:
     bool active() const { return callback != nullptr; }
     void setCallback(iocb_type type, AsyncCall::Pointer &cb, char *buf, FREE *func, int sz);
 
+    /// adds caller-owned buffers to be written after buf (in setCallback() order)
+    void setTail(const struct iovec *iov, int iovcnt);
+
+    /// Describes up to maxBytes of not yet written bytes in iov[], starting
+    /// at offset. iov must have room for 1+WriteVectorMax entries.
+    /// \returns the number of iov[] entries used
+    int pendingIoVector(struct iovec *iov, int maxBytes) const;
+
     /// called when fd needs to write but may need to wait in line for its quota
     void selectOrQueueWrite();
 
@@ -39,6 +39,13 @@ Comm::Flag DoSelect(int);
 
 void QuickPollRequired(void);
 
+/// Informs the loop about the outcome of an I/O attempt on the given FD in
+/// the given direction (COMM_SELECT_READ or COMM_SELECT_WRITE). Loops that
+/// track FD readiness in userspace use these hints to avoid system calls.
+/// \param mayHaveMore whether another attempt may succeed without waiting;
+/// false if the attempt would block or has consumed all available input
+void NoteIoReadiness(int fd, unsigned int type, bool mayHaveMore);
+
 /**
  * Max number of UDP messages to receive per call to the UDP receive poller.
  * This is a per-port limit for ICP/HTCP ports.
@@ -29,7 +29,9 @@
 #if USE_DEVPOLL
 
 #include "base/IoManip.h"
+#include "comm.h"
 #include "comm/Loops.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "mgr/Registration.h"
@@ -287,8 +289,10 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
         devpoll_state[fd].state = state_new;
     }
 
-    if (timeout)
+    if (timeout) {
         F->timeout = squid_curtime + timeout;
+        commScheduleTimeoutCheck(fd);
+    }
 }
 
 /** \brief Do poll and trigger callback functions as appropriate
@@ -416,5 +420,11 @@ Comm::QuickPollRequired(void)
     max_poll_time = 10;
 }
 
+void
+Comm::NoteIoReadiness(int, unsigned int, bool)
+{
+    // this loop asks the kernel about readiness every time
+}
+
 #endif /* USE_DEVPOLL */
 
@@ -34,10 +34,13 @@
 
 #include "base/CodeContext.h"
 #include "base/IoManip.h"
+#include "comm.h"
 #include "comm/Loops.h"
+#include "fatal.h"
 #include "fde.h"
 #include "globals.h"
 #include "mgr/Registration.h"
+#include "SquidConfig.h"
 #include "StatCounters.h"
 #include "StatHist.h"
 #include "Store.h"
@@ -45,6 +48,8 @@
 #define DEBUG_EPOLL 0
 
 #include <cerrno>
+#include <chrono>
+#include <vector>
 #if HAVE_SYS_EPOLL_H
 #include <sys/epoll.h>
 #endif
@@ -56,6 +61,50 @@ static struct epoll_event *pevents;
 
 static void commEPollRegisterWithCacheManager(void);
 
+/// whether each FD is registered once, with EPOLLET (see epoll_edge_triggered)
+static bool EdgeTriggered = false;
+
+/// the events that edge-triggered mode registers for every FD
+static const unsigned EdgeTriggeredEvents = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLHUP | EPOLLERR | EPOLLET;
+
+/// What we know about FD readiness for I/O in one direction. The kernel only
+/// reports changes in edge-triggered mode, so we must remember readiness
+/// until an I/O attempt shows that the FD is no longer ready.
+enum class Readiness : uint8_t {
+    drained, ///< I/O would block; the kernel will report when that changes
+    ready, ///< I/O may succeed without waiting
+    unknown ///< a handler did some I/O, but we do not know the outcome
+};
+
+/// userspace readiness state of an edge-triggered FD
+class EdgeState
+{
+public:
+    Readiness read = Readiness::drained;
+    Readiness write = Readiness::drained;
+    bool queued = false; ///< whether the FD is in DispatchQueue
+};
+
+/// edge-triggered mode readiness, indexed by FD
+static std::vector<EdgeState> EdgeStates;
+
+/// FDs that may have handlers ready to be called without waiting for epoll
+static std::vector<int> DispatchQueue;
+
+/// DispatchQueue FDs being processed by the current DoSelect() call
+static std::vector<int> DispatchBatch;
+
+/// I/O loop statistics reported by commIncomingStats()
+static struct {
+    uint64_t ctlCalls[3] = {}; ///< epoll_ctl(2) calls, indexed by CtlIndex()
+    uint64_t handlerCalls = 0; ///< read and write handler calls
+    uint64_t readyRegistrations = 0; ///< handlers queued thanks to known readiness
+    uint64_t rearms = 0; ///< EPOLL_CTL_MOD calls re-checking unknown readiness
+    uint64_t dispatchLoops = 0; ///< DoSelect() calls that had ready FDs
+    uint64_t dispatchTime = 0; ///< total time spent calling handlers (microseconds)
+    uint64_t dispatchTimeMax = 0; ///< the longest DoSelect() handling time (microseconds)
+} EpollStats;
+
 /* XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX */
 /* Public functions */
 
@@ -80,6 +129,15 @@ Comm::SelectLoopInit(void)
         fatalf("comm_select_init: epoll_create(): %s\n", xstrerr(xerrno));
     }
 
+    // the mode cannot change after FDs are registered
+    EdgeTriggered = Config.onoff.epoll_edge_triggered;
+    if (EdgeTriggered) {
+        EdgeStates.resize(SQUID_MAXFD);
+        DispatchQueue.reserve(SQUID_MAXFD);
+        DispatchBatch.reserve(SQUID_MAXFD);
+        debugs(5, 2, "using edge-triggered epoll notifications");
+    }
+
     commEPollRegisterWithCacheManager();
 }
 
@@ -101,30 +159,45 @@ static const char* epolltype_atoi(int x)
     }
 }
 
-/**
- * This is a needed exported function which will be called to register
- * and deregister interest in a pending IO state for a given FD.
- */
-void
-Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time_t timeout)
+/// EpollStats.ctlCalls index for the given epoll_ctl(2) operation
+static int
+CtlIndex(const int op)
 {
-    fde *F = &fd_table[fd];
-    int epoll_ctl_type = 0;
+    return op == EPOLL_CTL_ADD ? 0 : (op == EPOLL_CTL_MOD ? 1 : 2);
+}
 
-    assert(fd >= 0);
-    debugs(5, 5, "FD " << fd << ", type=" << type <<
-           ", handler=" << handler << ", client_data=" << client_data <<
-           ", timeout=" << timeout);
+/// epoll_ctl(2) wrapper that maintains statistics and reports errors
+static void
+CtlEpoll(const int op, const int fd, struct epoll_event &ev)
+{
+    ++EpollStats.ctlCalls[CtlIndex(op)];
+    if (epoll_ctl(kdpfd, op, fd, &ev) < 0) {
+        int xerrno = errno;
+        debugs(5, DEBUG_EPOLL ? 0 : 8, "ERROR: epoll_ctl(," << epolltype_atoi(op) <<
+               ",,): failed on FD " << fd << ": " << xstrerr(xerrno));
+    }
+}
 
+/// makes sure the next DoSelect() looks at the given FD handlers
+static void
+EnqueueDispatch(const int fd)
+{
+    auto &state = EdgeStates[fd];
+    if (!state.queued) {
+        state.queued = true;
+        DispatchQueue.push_back(fd);
+    }
+}
+
+/// Comm::SetSelect() handler registration part for level-triggered mode
+/// \returns whether we are still interested in FD I/O
+static bool
+SetSelectLevelTriggered(const int fd, fde * const F, const unsigned int type, PF * const handler, void * const client_data)
+{
     struct epoll_event ev;
     memset(&ev, 0, sizeof(ev));
     ev.data.fd = fd;
 
-    if (!F->flags.open) {
-        epoll_ctl(kdpfd, EPOLL_CTL_DEL, fd, &ev);
-        return;
-    }
-
     // If read is an interest
 
     if (type & COMM_SELECT_READ) {
@@ -162,6 +235,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
         ev.events |= EPOLLHUP | EPOLLERR;
 
     if (ev.events != F->epoll_state) {
+        int epoll_ctl_type = 0;
         if (F->epoll_state) // already monitoring something.
             epoll_ctl_type = ev.events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
         else
@@ -169,23 +243,136 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
 
         F->epoll_state = ev.events;
 
-        if (epoll_ctl(kdpfd, epoll_ctl_type, fd, &ev) < 0) {
-            int xerrno = errno;
-            debugs(5, DEBUG_EPOLL ? 0 : 8, "ERROR: epoll_ctl(," << epolltype_atoi(epoll_ctl_type) <<
-                   ",,): failed on FD " << fd << ": " << xstrerr(xerrno));
+        CtlEpoll(epoll_ctl_type, fd, ev);
+    }
+    return ev.events;
+}
+
+/// Comm::SetSelect() handler registration part for edge-triggered mode:
+/// Registers the FD once and then relies on userspace readiness tracking,
+/// asking the kernel to re-check readiness only when we lost track of it.
+/// \returns whether we are still interested in FD I/O
+static bool
+SetSelectEdgeTriggered(const int fd, fde * const F, const unsigned int type, PF * const handler, void * const client_data)
+{
+    if (type & COMM_SELECT_READ) {
+        F->read_handler = handler;
+        F->read_data = client_data;
+    }
+
+    if (type & COMM_SELECT_WRITE) {
+        F->write_handler = handler;
+        F->write_data = client_data;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.data.fd = fd;
+
+    auto &state = EdgeStates[fd];
+    if (!F->read_handler && !F->write_handler) {
+        // Keep the registration unless the caller is giving up on this FD.
+        // Closing code uses Comm::ResetSelect().
+        if (F->epoll_state && (type & COMM_SELECT_READ) && (type & COMM_SELECT_WRITE)) {
+            CtlEpoll(EPOLL_CTL_DEL, fd, ev);
+            F->epoll_state = 0;
         }
+        return false;
     }
 
-    if (timeout)
+    if (!handler)
+        return true; // no new interest
+
+    if (!F->epoll_state) {
+        // EPOLL_CTL_ADD reports current readiness, if any
+        state.read = Readiness::drained;
+        state.write = Readiness::drained;
+        ev.events = EdgeTriggeredEvents;
+        F->epoll_state = ev.events;
+        CtlEpoll(EPOLL_CTL_ADD, fd, ev);
+        return true;
+    }
+
+    const auto readReady = (type & COMM_SELECT_READ) && (state.read == Readiness::ready || F->flags.read_pending);
+    const auto writeReady = (type & COMM_SELECT_WRITE) && state.write == Readiness::ready;
+    if (readReady || writeReady) {
+        ++EpollStats.readyRegistrations;
+        EnqueueDispatch(fd);
+        return true;
+    }
+
+    const auto readUnknown = (type & COMM_SELECT_READ) && state.read == Readiness::unknown;
+    const auto writeUnknown = (type & COMM_SELECT_WRITE) && state.write == Readiness::unknown;
+    if (readUnknown || writeUnknown) {
+        // EPOLL_CTL_MOD re-checks readiness, reporting any as a new edge
+        if (state.read == Readiness::unknown)
+            state.read = Readiness::drained;
+        if (state.write == Readiness::unknown)
+            state.write = Readiness::drained;
+        ev.events = F->epoll_state;
+        ++EpollStats.rearms;
+        CtlEpoll(EPOLL_CTL_MOD, fd, ev);
+    }
+    // else wait for the kernel to report readiness
+    return true;
+}
+
+/**
+ * This is a needed exported function which will be called to register
+ * and deregister interest in a pending IO state for a given FD.
+ */
+void
+Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time_t timeout)
+{
+    fde *F = &fd_table[fd];
+
+    assert(fd >= 0);
+    debugs(5, 5, "FD " << fd << ", type=" << type <<
+           ", handler=" << handler << ", client_data=" << client_data <<
+           ", timeout=" << timeout);
+
+    if (!F->flags.open) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.data.fd = fd;
+        CtlEpoll(EPOLL_CTL_DEL, fd, ev);
+        return;
+    }
+
+    const auto interested = EdgeTriggered ?
+                            SetSelectEdgeTriggered(fd, F, type, handler, client_data) :
+                            SetSelectLevelTriggered(fd, F, type, handler, client_data);
+
+    if (timeout) {
         F->timeout = squid_curtime + timeout;
+        commScheduleTimeoutCheck(fd);
+    }
 
     if (timeout || handler) // all non-cleanup requests
         F->codeContext = CodeContext::Current(); // TODO: Avoid clearing if set?
-    else if (!ev.events) // full cleanup: no more FD-associated work expected
+    else if (!interested) // full cleanup: no more FD-associated work expected
         F->codeContext = nullptr;
     // else: direction-specific/timeout cleanup requests preserve F->codeContext
 }
 
+void
+Comm::NoteIoReadiness(const int fd, const unsigned int type, const bool mayHaveMore)
+{
+    if (!EdgeTriggered || !fd_table[fd].epoll_state)
+        return;
+
+    const auto readiness = mayHaveMore ? Readiness::ready : Readiness::drained;
+    auto &state = EdgeStates[fd];
+    if (type & COMM_SELECT_READ)
+        state.read = readiness;
+    if (type & COMM_SELECT_WRITE)
+        state.write = readiness;
+
+    const auto &F = fd_table[fd];
+    if (mayHaveMore && ((F.read_handler && state.read == Readiness::ready) || (F.write_handler && state.write == Readiness::ready)))
+        EnqueueDispatch(fd);
+}
+
 static void commIncomingStats(StoreEntry * sentry);
 
 static void
@@ -201,10 +388,126 @@ commIncomingStats(StoreEntry * sentry)
 {
     StatCounters *f = &statCounter;
     storeAppendPrintf(sentry, "Total number of epoll(2) loops: %ld\n", statCounter.select_loops);
+    storeAppendPrintf(sentry, "Notification mode: %s\n", EdgeTriggered ? "edge-triggered" : "level-triggered");
+
+    const auto &s = EpollStats;
+    const auto ctlCalls = s.ctlCalls[0] + s.ctlCalls[1] + s.ctlCalls[2];
+    storeAppendPrintf(sentry, "epoll_ctl(2) calls: %" PRIu64 " (add: %" PRIu64 ", modify: %" PRIu64 ", delete: %" PRIu64 ")\n",
+                      ctlCalls, s.ctlCalls[0], s.ctlCalls[1], s.ctlCalls[2]);
+    const auto requests = f->client_http.requests;
+    storeAppendPrintf(sentry, "epoll_ctl(2) calls per HTTP request: %.3f\n",
+                      requests ? double(ctlCalls) / requests : 0.0);
+    storeAppendPrintf(sentry, "I/O handler calls: %" PRIu64 "\n", s.handlerCalls);
+    if (EdgeTriggered) {
+        storeAppendPrintf(sentry, "Handlers registered for already ready FDs: %" PRIu64 "\n", s.readyRegistrations);
+        storeAppendPrintf(sentry, "Readiness re-checks: %" PRIu64 "\n", s.rearms);
+    }
+    storeAppendPrintf(sentry, "Loops with ready FDs: %" PRIu64 "\n", s.dispatchLoops);
+    storeAppendPrintf(sentry, "Handling time per loop with ready FDs: %.1f usec average, %" PRIu64 " usec maximum\n",
+                      s.dispatchLoops ? double(s.dispatchTime) / s.dispatchLoops : 0.0, s.dispatchTimeMax);
+
     storeAppendPrintf(sentry, "Histogram of returned filedescriptors\n");
     f->select_fds_hist.dump(sentry, statHistIntDumper);
 }
 
+/// calls handlers of a level-triggered FD that received the given events
+static void
+DispatchLevelTriggered(const struct epoll_event &event)
+{
+    const auto fd = event.data.fd;
+    const auto F = &fd_table[fd];
+    PF *hdl;
+    CodeContext::Reset(F->codeContext);
+    debugs(5, DEBUG_EPOLL ? 0 : 8, "got FD " << fd << " events=" <<
+           asHex(event.events) << " monitoring=" << asHex(F->epoll_state) <<
+           " F->read_handler=" << F->read_handler << " F->write_handler=" << F->write_handler);
+
+    // TODO: add EPOLLPRI??
+
+    if (event.events & (EPOLLIN|EPOLLHUP|EPOLLERR) || F->flags.read_pending) {
+        if ((hdl = F->read_handler) != nullptr) {
+            debugs(5, DEBUG_EPOLL ? 0 : 8, "Calling read handler on FD " << fd);
+            F->read_handler = nullptr;
+            hdl(fd, F->read_data);
+            ++ statCounter.select_fds;
+            ++EpollStats.handlerCalls;
+        } else {
+            debugs(5, DEBUG_EPOLL ? 0 : 8, "no read handler for FD " << fd);
+            // remove interest since no handler exist for this event.
+            Comm::SetSelect(fd, COMM_SELECT_READ, nullptr, nullptr, 0);
+        }
+    }
+
+    if (event.events & (EPOLLOUT|EPOLLHUP|EPOLLERR)) {
+        if ((hdl = F->write_handler) != nullptr) {
+            debugs(5, DEBUG_EPOLL ? 0 : 8, "Calling write handler on FD " << fd);
+            F->write_handler = nullptr;
+            hdl(fd, F->write_data);
+            ++ statCounter.select_fds;
+            ++EpollStats.handlerCalls;
+        } else {
+            debugs(5, DEBUG_EPOLL ? 0 : 8, "no write handler for FD " << fd);
+            // remove interest since no handler exist for this event.
+            Comm::SetSelect(fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
+        }
+    }
+}
+
+/// remembers the readiness reported for an edge-triggered FD
+static void
+NoteEdge(const struct epoll_event &event)
+{
+    const auto fd = event.data.fd;
+    debugs(5, DEBUG_EPOLL ? 0 : 8, "got FD " << fd << " events=" << asHex(event.events));
+    if (!fd_table[fd].epoll_state)
+        return; // a stale event for a closed FD
+
+    auto &state = EdgeStates[fd];
+    if (event.events & (EPOLLIN|EPOLLRDHUP|EPOLLHUP|EPOLLERR))
+        state.read = Readiness::ready;
+    if (event.events & (EPOLLOUT|EPOLLHUP|EPOLLERR))
+        state.write = Readiness::ready;
+    EnqueueDispatch(fd);
+}
+
+/// calls handlers of queued edge-triggered FDs that are ready for them
+static void
+DispatchEdgeTriggered()
+{
+    // handlers may queue more FDs; they will be handled during the next call
+    DispatchBatch.swap(DispatchQueue);
+    for (const auto fd: DispatchBatch) {
+        auto &state = EdgeStates[fd];
+        state.queued = false;
+
+        const auto F = &fd_table[fd];
+        if (!F->flags.open)
+            continue;
+
+        CodeContext::Reset(F->codeContext);
+        PF *hdl;
+
+        if ((state.read == Readiness::ready || F->flags.read_pending) && (hdl = F->read_handler)) {
+            debugs(5, DEBUG_EPOLL ? 0 : 8, "Calling read handler on FD " << fd);
+            state.read = Readiness::unknown;
+            F->read_handler = nullptr;
+            hdl(fd, F->read_data);
+            ++ statCounter.select_fds;
+            ++EpollStats.handlerCalls;
+        }
+
+        if (state.write == Readiness::ready && (hdl = F->write_handler)) {
+            debugs(5, DEBUG_EPOLL ? 0 : 8, "Calling write handler on FD " << fd);
+            state.write = Readiness::unknown;
+            F->write_handler = nullptr;
+            hdl(fd, F->write_data);
+            ++ statCounter.select_fds;
+            ++EpollStats.handlerCalls;
+        }
+    }
+    DispatchBatch.clear();
+}
+
 /**
  * Check all connections for new connections and input data that is to be
  * processed. Also check for connections with data queued and whether we can
@@ -218,15 +521,17 @@ commIncomingStats(StoreEntry * sentry)
 Comm::Flag
 Comm::DoSelect(int msec)
 {
-    int num, i,fd;
-    fde *F;
-    PF *hdl;
+    int num, i;
 
     struct epoll_event *cevents;
 
     if (msec > max_poll_time)
         msec = max_poll_time;
 
+    // do not wait if some handlers can be called right away
+    if (!DispatchQueue.empty())
+        msec = 0;
+
     for (;;) {
         num = epoll_wait(kdpfd, pevents, SQUID_MAXFD, msec);
         ++ statCounter.select_loops;
@@ -246,48 +551,28 @@ Comm::DoSelect(int msec)
 
     statCounter.select_fds_hist.count(num);
 
-    if (num == 0)
+    if (num == 0 && DispatchQueue.empty())
         return Comm::TIMEOUT;       /* No error.. */
 
-    for (i = 0, cevents = pevents; i < num; ++i, ++cevents) {
-        fd = cevents->data.fd;
-        F = &fd_table[fd];
-        CodeContext::Reset(F->codeContext);
-        debugs(5, DEBUG_EPOLL ? 0 : 8, "got FD " << fd << " events=" <<
-               asHex(cevents->events) << " monitoring=" << asHex(F->epoll_state) <<
-               " F->read_handler=" << F->read_handler << " F->write_handler=" << F->write_handler);
-
-        // TODO: add EPOLLPRI??
-
-        if (cevents->events & (EPOLLIN|EPOLLHUP|EPOLLERR) || F->flags.read_pending) {
-            if ((hdl = F->read_handler) != nullptr) {
-                debugs(5, DEBUG_EPOLL ? 0 : 8, "Calling read handler on FD " << fd);
-                F->read_handler = nullptr;
-                hdl(fd, F->read_data);
-                ++ statCounter.select_fds;
-            } else {
-                debugs(5, DEBUG_EPOLL ? 0 : 8, "no read handler for FD " << fd);
-                // remove interest since no handler exist for this event.
-                SetSelect(fd, COMM_SELECT_READ, nullptr, nullptr, 0);
-            }
-        }
+    const auto dispatchStart = std::chrono::steady_clock::now();
 
-        if (cevents->events & (EPOLLOUT|EPOLLHUP|EPOLLERR)) {
-            if ((hdl = F->write_handler) != nullptr) {
-                debugs(5, DEBUG_EPOLL ? 0 : 8, "Calling write handler on FD " << fd);
-                F->write_handler = nullptr;
-                hdl(fd, F->write_data);
-                ++ statCounter.select_fds;
-            } else {
-                debugs(5, DEBUG_EPOLL ? 0 : 8, "no write handler for FD " << fd);
-                // remove interest since no handler exist for this event.
-                SetSelect(fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
-            }
-        }
+    if (EdgeTriggered) {
+        for (i = 0, cevents = pevents; i < num; ++i, ++cevents)
+            NoteEdge(*cevents);
+        DispatchEdgeTriggered();
+    } else {
+        for (i = 0, cevents = pevents; i < num; ++i, ++cevents)
+            DispatchLevelTriggered(*cevents);
     }
 
     CodeContext::Reset();
 
+    const auto dispatchTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - dispatchStart).count();
+    ++EpollStats.dispatchLoops;
+    EpollStats.dispatchTime += dispatchTime;
+    if (uint64_t(dispatchTime) > EpollStats.dispatchTimeMax)
+        EpollStats.dispatchTimeMax = dispatchTime;
+
     return Comm::OK;
 }
 
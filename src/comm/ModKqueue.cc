@@ -32,7 +32,9 @@
 #include "squid.h"
 
 #if USE_KQUEUE
+#include "comm.h"
 #include "comm/Loops.h"
+#include "fatal.h"
 #include "fde.h"
 #include "globals.h"
 #include "StatCounters.h"
@@ -175,8 +177,10 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
         F->write_data = client_data;
     }
 
-    if (timeout)
+    if (timeout) {
         F->timeout = squid_curtime + timeout;
+        commScheduleTimeoutCheck(fd);
+    }
 
 }
 
@@ -274,6 +278,12 @@ Comm::QuickPollRequired(void)
     max_poll_time = 10;
 }
 
+void
+Comm::NoteIoReadiness(int, unsigned int, bool)
+{
+    // this loop asks the kernel about readiness every time
+}
+
 static void
 commKQueueRegisterWithCacheManager(void)
 {
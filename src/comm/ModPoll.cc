@@ -12,6 +12,7 @@
 
 #if USE_POLL
 #include "anyp/PortCfg.h"
+#include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
 #include "fd.h"
@@ -77,8 +78,10 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
         F->write_data = client_data;
     }
 
-    if (timeout)
+    if (timeout) {
         F->timeout = squid_curtime + timeout;
+        commScheduleTimeoutCheck(fd);
+    }
 }
 
 static int
@@ -514,5 +517,11 @@ Comm::QuickPollRequired(void)
     MAX_POLL_TIME = 10;
 }
 
+void
+Comm::NoteIoReadiness(int, unsigned int, bool)
+{
+    // this loop asks the kernel about readiness every time
+}
+
 #endif /* USE_POLL */
 
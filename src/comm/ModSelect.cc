@@ -13,6 +13,7 @@
 #if USE_SELECT
 
 #include "anyp/PortCfg.h"
+#include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
 #include "fde.h"
@@ -79,8 +80,10 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
         commUpdateWriteBits(fd, handler);
     }
 
-    if (timeout)
+    if (timeout) {
         F->timeout = squid_curtime + timeout;
+        commScheduleTimeoutCheck(fd);
+    }
 }
 
 static int
@@ -644,5 +647,11 @@ Comm::QuickPollRequired(void)
     MAX_POLL_TIME = 10;
 }
 
+void
+Comm::NoteIoReadiness(int, unsigned int, bool)
+{
+    // this loop asks the kernel about readiness every time
+}
+
 #endif /* USE_SELECT */
 
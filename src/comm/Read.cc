@@ -77,6 +77,15 @@ comm_read_base(const Comm::ConnectionPointer &conn, char *buf, int size, AsyncCa
     Comm::SetSelect(conn->fd, COMM_SELECT_READ, Comm::HandleRead, ccb, 0);
 }
 
+/// Whether a successful read of the given size may leave more input in the
+/// kernel. A short plain read drains the socket or pipe. TLS reads stop at
+/// record boundaries, so a short TLS read does not tell us anything.
+static bool
+MayHaveMoreInput(const int fd, const int bytesRead, const int bytesRequested)
+{
+    return bytesRead >= bytesRequested || fd_table[fd].ssl;
+}
+
 Comm::Flag
 Comm::ReadNow(CommIoCbParams &params, SBuf &buf)
 {
@@ -97,6 +106,7 @@ Comm::ReadNow(CommIoCbParams &params, SBuf &buf)
         fd_bytes(params.conn->fd, retval, IoDirection::Read);
         params.flag = Comm::OK;
         params.size = retval;
+        Comm::NoteIoReadiness(params.conn->fd, COMM_SELECT_READ, MayHaveMoreInput(params.conn->fd, retval, sz));
 
     } else if (retval == 0) { // remote closure (somewhat less) common
         // Note - read 0 == socket EOF, which is a valid read.
@@ -105,9 +115,10 @@ Comm::ReadNow(CommIoCbParams &params, SBuf &buf)
 
     } else if (retval < 0) { // connection errors are worst-case
         debugs(5, 3, params.conn << " Comm::COMM_ERROR: " << xstrerr(params.xerrno));
-        if (ignoreErrno(params.xerrno))
+        if (ignoreErrno(params.xerrno)) {
+            Comm::NoteIoReadiness(params.conn->fd, COMM_SELECT_READ, false);
             params.flag =  Comm::INPROGRESS;
-        else
+        } else
             params.flag =  Comm::COMM_ERROR;
         params.size = 0;
     }
@@ -150,6 +161,8 @@ Comm::HandleRead(int fd, void *data)
     /* See if we read anything */
     /* Note - read 0 == socket EOF, which is a valid read */
     if (retval >= 0) {
+        if (retval > 0)
+            Comm::NoteIoReadiness(fd, COMM_SELECT_READ, MayHaveMoreInput(fd, retval, ccb->size));
         fd_bytes(fd, retval, IoDirection::Read);
         ccb->offset = retval;
         ccb->finish(Comm::OK, 0);
@@ -162,6 +175,7 @@ Comm::HandleRead(int fd, void *data)
     };
 
     /* Nope, register for some more IO */
+    Comm::NoteIoReadiness(fd, COMM_SELECT_READ, false);
     Comm::SetSelect(fd, COMM_SELECT_READ, Comm::HandleRead, data, 0);
 }
 
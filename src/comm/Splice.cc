@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 05    Socket Functions */
+
+#include "squid.h"
+
+#if HAVE_SPLICE
+
+#include "comm/Splice.h"
+#include "fde.h"
+#if USE_DELAY_POOLS
+#include "BandwidthBucket.h"
+#endif
+
+#include <cerrno>
+#include <fcntl.h>
+
+Comm::SpliceResult
+Comm::Splice(const int from, const int to, const size_t maxBytes)
+{
+    SpliceResult result;
+    errno = 0;
+    const auto spliced = splice(from, nullptr, to, nullptr, maxBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (spliced >= 0) {
+        result.status = SpliceResult::moved;
+        result.size = spliced;
+        return result;
+    }
+
+    result.xerrno = errno;
+    switch (result.xerrno) {
+    case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+    case EWOULDBLOCK:
+#endif
+    case EINTR:
+        result.status = SpliceResult::wait;
+        break;
+
+    // the kernel or one of the descriptor types does not support splice(2)
+    case EINVAL:
+    case ENOSYS:
+        result.status = SpliceResult::unsupported;
+        break;
+
+    default:
+        result.status = SpliceResult::failed;
+    }
+    return result;
+}
+
+bool
+Comm::CanSplice(const fde &from, const fde &to)
+{
+    if (!from.flags.open || !to.flags.open)
+        return false;
+
+    // Squid-terminated TLS needs our userspace encryption or decryption
+    if (from.ssl || to.ssl)
+        return false;
+
+#if USE_DELAY_POOLS
+    // client write quotas are only enforced by Comm::Write()
+    // (SelectBucket() does not modify its argument)
+    if (BandwidthBucket::SelectBucket(const_cast<fde *>(&to)))
+        return false;
+#endif
+
+    return true;
+}
+
+#endif /* HAVE_SPLICE */
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_COMM_SPLICE_H
+#define SQUID_SRC_COMM_SPLICE_H
+
+#if HAVE_SPLICE
+
+#include <cstddef>
+
+class fde;
+
+namespace Comm
+{
+
+/// the outcome of a non-blocking splice(2) call
+class SpliceResult
+{
+public:
+    enum Status {
+        moved, ///< size bytes were moved; zero size means EOF
+        wait, ///< nothing can be moved now; retry when the descriptor is ready
+        unsupported, ///< these descriptors cannot splice; use userspace buffers
+        failed ///< an I/O error, described by xerrno
+    };
+
+    Status status = failed;
+    size_t size = 0; ///< the number of bytes moved
+    int xerrno = 0; ///< errno after an unsuccessful call
+};
+
+/// Moves up to maxBytes from one descriptor to the other, bypassing
+/// userspace. One of the descriptors must be a pipe.
+SpliceResult Splice(int from, int to, size_t maxBytes);
+
+/// Whether bytes received on an open descriptor may be relayed to another
+/// open descriptor by Splice() rather than through Squid buffers. Bytes that
+/// Squid must decrypt, encrypt, or meter on write cannot bypass userspace.
+bool CanSplice(const fde &from, const fde &to);
+
+} // namespace Comm
+
+#endif /* HAVE_SPLICE */
+
+#endif /* SQUID_SRC_COMM_SPLICE_H */
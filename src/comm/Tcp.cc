@@ -9,8 +9,10 @@
 /* DEBUG: section 05    TCP Socket Functions */
 
 #include "squid.h"
+#include "base/TextException.h"
 #include "comm/Tcp.h"
 #include "debug/Stream.h"
+#include "sbuf/Stream.h"
 
 #if HAVE_NETINET_TCP_H
 #include <netinet/tcp.h>
@@ -21,6 +23,7 @@
 #if HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#include <cstring>
 #include <type_traits>
 
 /// setsockopt(2) wrapper
@@ -73,3 +76,42 @@ Comm::ApplyTcpKeepAlive(int fd, const TcpKeepAlive &cfg)
 #endif
     (void)SetBooleanSocketOption(fd, SOL_SOCKET, SO_KEEPALIVE, true);
 }
+
+void
+Comm::WorkerQueues::parse(const char * const value)
+{
+#if !defined(SO_REUSEADDR)
+#error missing system #include that #defines SO_* constants
+#endif
+    if (!value) {
+#if !defined(SO_REUSEPORT)
+        throw TextException(SBuf("worker-queues option requires building Squid where SO_REUSEPORT is supported by the TCP stack"), Here());
+#endif
+        enabled = true;
+        byCpu = false;
+        return;
+    }
+
+    if (strcmp(value, "cpu-affinity") == 0) {
+#if !defined(SO_REUSEPORT) || !defined(SO_INCOMING_CPU)
+        throw TextException(SBuf("worker-queues=cpu-affinity option requires building Squid where SO_REUSEPORT and SO_INCOMING_CPU are supported by the TCP stack"), Here());
+#endif
+        enabled = true;
+        byCpu = true;
+        return;
+    }
+
+    throw TextException(ToSBuf("unsupported worker-queues option value: ", value), Here());
+}
+
+bool
+Comm::ApplyIncomingCpu(const int fd, const int cpu)
+{
+#if defined(SO_INCOMING_CPU)
+    return SetSocketOption(fd, SOL_SOCKET, SO_INCOMING_CPU, cpu);
+#else
+    (void)fd;
+    (void)cpu;
+    return false; // WorkerQueues::parse() rejects worker-queues=cpu-affinity
+#endif
+}
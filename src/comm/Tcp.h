@@ -25,6 +25,25 @@ public:
 /// apply configured TCP keep-alive settings to the given FD socket
 void ApplyTcpKeepAlive(int fd, const TcpKeepAlive &);
 
+/// Configuration settings for worker-specific listening queues
+class WorkerQueues
+{
+public:
+    /// parses the worker-queues listening port option value (nil for a
+    /// plain worker-queues option); throws on unsupported values
+    void parse(const char *value);
+
+    bool enabled = false; ///< whether listening queues should be worker-specific
+    /// whether worker-specific queues should prefer connections handled by
+    /// the CPU that cpu_affinity_map dedicates to the accepting worker
+    bool byCpu = false;
+};
+
+/// Asks the TCP stack to prefer the given SO_REUSEPORT listening socket for
+/// connections handled by the given CPU.
+/// \returns whether the TCP stack accepted the request
+bool ApplyIncomingCpu(int fd, int cpu);
+
 } // namespace Comm
 
 #endif /* SQUID_SRC_COMM_TCP_H */
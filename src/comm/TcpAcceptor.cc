@@ -21,6 +21,7 @@
 #include "comm/TcpAcceptor.h"
 #include "CommCalls.h"
 #include "eui/Config.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "globals.h"
@@ -353,6 +354,8 @@ Comm::TcpAcceptor::acceptInto(Comm::ConnectionPointer &details)
         errcode = errno; // store last accept errno locally.
         if (ignoreErrno(errcode) || errcode == ECONNABORTED) {
             debugs(50, 5, status() << ": " << xstrerr(errcode));
+            if (errcode != ECONNABORTED)
+                NoteIoReadiness(conn->fd, COMM_SELECT_READ, false);
             return false;
         } else {
             throw TextException(ToSBuf("Failed to accept an incoming connection: ", xstrerr(errcode)), Here());
@@ -360,6 +363,7 @@ Comm::TcpAcceptor::acceptInto(Comm::ConnectionPointer &details)
     }
 
     ++incoming_sockets_accepted;
+    NoteIoReadiness(conn->fd, COMM_SELECT_READ, true);
 
     // Sync with Comm ASAP so that abandoned details can properly close().
     // XXX : these are not all HTTP requests. use a note about type and ip:port details->
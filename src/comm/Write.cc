@@ -8,6 +8,7 @@
 
 #include "squid.h"
 #include "cbdata.h"
+#include "comm.h"
 #include "comm/Connection.h"
 #include "comm/IoCallback.h"
 #include "comm/Loops.h"
@@ -44,6 +45,27 @@ Comm::Write(const Comm::ConnectionPointer &conn, const char *buf, int size, Asyn
     ccb->conn = conn;
     /* Queue the write */
     ccb->setCallback(IOCB_WRITE, callback, (char *)buf, free_func, size);
+    commScheduleTimeoutCheck(conn->fd);
+    ccb->selectOrQueueWrite();
+}
+
+void
+Comm::Write(const Comm::ConnectionPointer &conn, MemBuf *mb, const struct iovec *iov, const int iovcnt, AsyncCall::Pointer &callback)
+{
+    debugs(5, 5, conn << ": sz " << mb->size << " + " << iovcnt << " buffers: asynCall " << callback);
+
+    /* Make sure we are open, not closing, and not writing */
+    assert(fd_table[conn->fd].flags.open);
+    assert(!fd_table[conn->fd].closing());
+    Comm::IoCallback *ccb = COMMIO_FD_WRITECB(conn->fd);
+    assert(!ccb->active());
+
+    fd_table[conn->fd].writeStart = squid_curtime;
+    ccb->conn = conn;
+    /* Queue the write */
+    ccb->setCallback(IOCB_WRITE, callback, mb->buf, mb->freeFunc(), mb->size);
+    ccb->setTail(iov, iovcnt);
+    commScheduleTimeoutCheck(conn->fd);
     ccb->selectOrQueueWrite();
 }
 
@@ -80,9 +102,17 @@ Comm::HandleWrite(int fd, void *data)
 
     /* actually WRITE data */
     int xerrno = errno = 0;
-    len = FD_WRITE_METHOD(fd, state->buf + state->offset, nleft);
-    xerrno = errno;
-    debugs(5, 5, "write() returns " << len);
+    if (state->tailCount) {
+        struct iovec iov[1 + WriteVectorMax];
+        const auto iovcnt = state->pendingIoVector(iov, nleft);
+        len = FD_WRITEV_METHOD(fd, iov, iovcnt);
+        xerrno = errno;
+        debugs(5, 5, "writev() of " << iovcnt << " buffers returns " << len);
+    } else {
+        len = FD_WRITE_METHOD(fd, state->buf + state->offset, nleft);
+        xerrno = errno;
+        debugs(5, 5, "write() returns " << len);
+    }
 
 #if USE_DELAY_POOLS
     if (bucket) {
@@ -111,6 +141,7 @@ Comm::HandleWrite(int fd, void *data)
             state->finish(nleft ? Comm::COMM_ERROR : Comm::OK, xerrno);
         } else if (ignoreErrno(xerrno)) {
             debugs(50, 9, "FD " << fd << " write failure: " << xstrerr(xerrno) << ".");
+            NoteIoReadiness(fd, COMM_SELECT_WRITE, false);
             state->selectOrQueueWrite();
         } else {
             debugs(50, 2, "FD " << fd << " write failure: " << xstrerr(xerrno) << ".");
@@ -121,9 +152,13 @@ Comm::HandleWrite(int fd, void *data)
         state->offset += len;
 
         if (state->offset < state->size) {
+            // a partial plain write means that the socket buffer is full,
+            // but TLS writes may stop at a record boundary
+            NoteIoReadiness(fd, COMM_SELECT_WRITE, len >= nleft || fd_table[fd].ssl);
             /* Not done, reinstall the write handler and write some more */
             state->selectOrQueueWrite();
         } else {
+            NoteIoReadiness(fd, COMM_SELECT_WRITE, true);
             state->finish(nleft ? Comm::OK : Comm::COMM_ERROR, 0);
         }
     }
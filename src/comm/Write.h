@@ -11,12 +11,20 @@
 
 #include "base/AsyncCall.h"
 #include "comm/forward.h"
+#include "compat/cmsg.h"
 #include "mem/forward.h"
 
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
 class MemBuf;
 namespace Comm
 {
 
+/// the maximum number of caller-owned buffers in one gathered Comm::Write()
+const int WriteVectorMax = 4;
+
 /**
  * Queue a write. callback is scheduled when the write
  * completes, on error, or on file descriptor close.
@@ -31,6 +39,18 @@ void Write(const Comm::ConnectionPointer &conn, const char *buf, int size, Async
  */
 void Write(const Comm::ConnectionPointer &conn, MemBuf *mb, AsyncCall::Pointer &callback);
 
+/**
+ * Queue a gathered write of mb content followed by iovcnt caller-owned
+ * buffers, without copying those buffers into mb. Where the descriptor I/O
+ * method allows, all pieces are sent with a single writev(2) call.
+ * callback is scheduled when all pieces are written, on error, or on
+ * file descriptor close.
+ *
+ * mb memory is freed when the write has completed. The caller must keep iov
+ * buffers intact until the callback. The iov array itself is copied.
+ */
+void Write(const Comm::ConnectionPointer &conn, MemBuf *mb, const struct iovec *iov, int iovcnt, AsyncCall::Pointer &callback);
+
 /// Cancel the write pending on FD. No action if none pending.
 void WriteCancel(const Comm::ConnectionPointer &conn, const char *reason);
 
@@ -25,6 +25,7 @@
 #include "dns/forward.h"
 #include "dns/rfc3596.h"
 #include "event.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "ip/tools.h"
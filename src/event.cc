@@ -15,7 +15,9 @@
 #include "Store.h"
 #include "tools.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 /* The list of event processes */
 
@@ -92,8 +94,7 @@ ev_entry::ev_entry(char const * aName, EVH * aFunction, void * aArgument, double
     arg(haveArg ? cbdataReference(aArgument) : aArgument),
     when(evWhen),
     weight(aWeight),
-    cbdata(haveArg),
-    next(nullptr)
+    cbdata(haveArg)
 {
 }
 
@@ -149,7 +150,14 @@ eventFind(EVH * func, void *arg)
 
 EventScheduler EventScheduler::_instance;
 
-EventScheduler::EventScheduler(): tasks(nullptr)
+/// the first wheel tick at which an event with the given timestamp is due
+static TimerWheel::Tick
+DueTick(const double timestamp)
+{
+    return timestamp > 0 ? static_cast<TimerWheel::Tick>(ceil(timestamp*1000)) : 0;
+}
+
+EventScheduler::EventScheduler(): wheel(DueTick(current_dtime))
 {}
 
 EventScheduler::~EventScheduler()
@@ -157,40 +165,127 @@ EventScheduler::~EventScheduler()
     clean();
 }
 
-void
-EventScheduler::cancel(EVH * func, void *arg)
+/// adds the event to the front of the list at the given index key
+template <class Lists>
+static void
+LinkEvent(Lists &lists, const typename Lists::key_type &key, ev_entry &event, ev_entry::Links ev_entry::*links)
 {
-    ev_entry **E;
-    ev_entry *event;
-
-    for (E = &tasks; (event = *E) != nullptr; E = &(*E)->next) {
-        if (event->func != func)
-            continue;
+    auto &head = lists[key];
+    (event.*links).prev = nullptr;
+    (event.*links).next = head;
+    if (head)
+        (head->*links).prev = &event;
+    head = &event;
+}
 
-        if (arg && event->arg != arg)
-            continue;
+/// removes the event from the list at the given index key
+template <class Lists>
+static void
+UnlinkEvent(Lists &lists, const typename Lists::key_type &key, ev_entry &event, ev_entry::Links ev_entry::*links)
+{
+    auto &position = event.*links;
+    if (position.next)
+        (position.next->*links).prev = position.prev;
+    if (position.prev)
+        (position.prev->*links).next = position.next;
+    else if (position.next)
+        lists[key] = position.next;
+    else
+        lists.erase(key);
+    position = ev_entry::Links();
+}
 
-        *E = event->next;
+size_t
+EventScheduler::CallHash::operator()(const Call &call) const
+{
+    const auto funcHash = std::hash<EVH *>()(call.first);
+    return funcHash ^ (std::hash<void *>()(call.second) + 0x9e3779b9 + (funcHash << 6) + (funcHash >> 2));
+}
 
-        delete event;
+/// removes the given event from all indexes and destroys it
+void
+EventScheduler::forget(ev_entry * const event)
+{
+    if (event->scheduled()) {
+        wheel.cancel(*event);
+    } else if (due.back() == event) {
+        due.pop_back(); // the event is being fired
+    } else {
+        // the event was canceled while in the (small) batch of due events
+        const auto position = std::find(due.begin(), due.end(), event);
+        assert(position != due.end());
+        due.erase(position);
+    }
+    UnlinkEvent(byHandler, event->func, *event, &ev_entry::sameHandler);
+    UnlinkEvent(byCall, Call(event->func, event->arg), *event, &ev_entry::sameCall);
+    assert(size > 0);
+    --size;
+    delete event;
+}
 
-        if (arg)
+void
+EventScheduler::cancel(EVH * func, void *arg)
+{
+    if (arg) {
+        // cancel the matching event that would have fired first
+        const auto calls = byCall.find(Call(func, arg));
+        if (calls == byCall.end()) {
+            debug_trap("eventDelete: event not found");
             return;
-        /*
-         * DPW 2007-04-12
-         * Since this method may now delete multiple events (when
-         * arg is NULL) it no longer returns after a deletion and
-         * we have a potential NULL pointer problem.  If we just
-         * deleted the last event in the list then *E is now equal
-         * to NULL.  We need to break here or else we'll get a NULL
-         * pointer dereference in the last clause of the for loop.
-         */
-        if (nullptr == *E)
-            break;
+        }
+        // usually, there is just one such event
+        auto victim = calls->second;
+        for (auto event = victim->sameCall.next; event; event = event->sameCall.next) {
+            if (EarlierEvent()(event, victim))
+                victim = event;
+        }
+        forget(victim);
+        return;
+    }
+
+    // cancel all events with the given handler, regardless of their argument
+    const auto handlers = byHandler.find(func);
+    if (handlers == byHandler.end())
+        return;
+    auto event = handlers->second;
+    while (event) {
+        const auto next = event->sameHandler.next;
+        forget(event); // may invalidate the handlers iterator
+        event = next;
     }
+}
 
-    if (arg)
-        debug_trap("eventDelete: event not found");
+/// moves events that may be due from the wheel to the due batch
+void
+EventScheduler::advance()
+{
+    // rounding up cannot make an event fire early: due events are still
+    // checked against their exact timestamps
+    const auto previouslyDue = due.size();
+    wheel.advance(DueTick(current_dtime), [this](TimerWheel::Timer &timer) {
+        due.push_back(&static_cast<ev_entry &>(timer));
+    });
+
+    // only the newly due events need sorting; the rest are already ordered
+    if (due.size() > previouslyDue) {
+        const auto laterEvent = [](const ev_entry *a, const ev_entry *b) { return EarlierEvent()(b, a); };
+        const auto newlyDue = due.begin() + previouslyDue;
+        std::sort(newlyDue, due.end(), laterEvent);
+        std::inplace_merge(due.begin(), newlyDue, due.end(), laterEvent);
+    }
+}
+
+/// the event that should fire first (or nil)
+const ev_entry *
+EventScheduler::earliest() const
+{
+    const ev_entry *event = due.empty() ? nullptr : due.back();
+    if (const auto timer = wheel.earliest()) {
+        const auto &candidate = static_cast<const ev_entry &>(*timer);
+        if (!event || EarlierEvent()(&candidate, event))
+            event = &candidate;
+    }
+    return event;
 }
 
 // The event API does not guarantee exact timing, but guarantees that no event
@@ -198,13 +293,14 @@ EventScheduler::cancel(EVH * func, void *arg)
 int
 EventScheduler::timeRemaining() const
 {
-    if (!tasks)
+    const auto next = earliest();
+    if (!next)
         return EVENT_IDLE;
 
-    if (tasks->when <= current_dtime) // we are on time or late
+    if (next->when <= current_dtime) // we are on time or late
         return 0; // fire the event ASAP
 
-    const double diff = tasks->when - current_dtime; // seconds
+    const double diff = next->when - current_dtime; // seconds
     // Round UP: If we come back a nanosecond earlier, we will wait again!
     const int timeLeft = static_cast<int>(ceil(1000*diff)); // milliseconds
     // Avoid hot idle: A series of rapid select() calls with zero timeout.
@@ -215,13 +311,17 @@ EventScheduler::timeRemaining() const
 int
 EventScheduler::checkEvents(int)
 {
+    advance();
+
     int result = timeRemaining();
     if (result != 0)
         return result;
 
     do {
-        ev_entry *event = tasks;
-        assert(event);
+        // after advance(), all due events are in the due batch
+        assert(!due.empty());
+        ev_entry *event = due.back();
+        assert(event->when <= current_dtime);
 
         /* XXX assumes event->name is static memory! */
         AsyncCall::Pointer call = asyncCall(41,5, event->name,
@@ -232,8 +332,15 @@ EventScheduler::checkEvents(int)
         const bool heavy = event->weight &&
                            (!event->cbdata || cbdataReferenceValid(event->arg));
 
-        tasks = event->next;
-        delete event;
+        ++fired;
+        if (event->when > 0) {
+            const auto lateness = current_dtime - event->when;
+            ++firedDelayed;
+            totalLateness += lateness;
+            maxLateness = max(maxLateness, lateness);
+        }
+
+        forget(event);
 
         result = timeRemaining();
 
@@ -249,12 +356,20 @@ EventScheduler::checkEvents(int)
 void
 EventScheduler::clean()
 {
-    while (ev_entry * event = tasks) {
-        tasks = event->next;
-        delete event;
+    for (const auto &handler: byHandler) {
+        auto event = handler.second;
+        while (event) {
+            const auto next = event->sameHandler.next;
+            wheel.cancel(*event);
+            delete event;
+            event = next;
+        }
     }
 
-    tasks = nullptr;
+    byHandler.clear();
+    byCall.clear();
+    due.clear();
+    size = 0;
 }
 
 void
@@ -269,25 +384,31 @@ EventScheduler::dump(Packable *out)
                  "Weight",
                  "Callback Valid?");
 
-    for (auto *e = tasks; e; e = e->next) {
+    std::vector<const ev_entry *> events;
+    events.reserve(size);
+    for (const auto &handler: byHandler) {
+        for (auto event = handler.second; event; event = event->sameHandler.next)
+            events.push_back(event);
+    }
+    std::sort(events.begin(), events.end(), EarlierEvent());
+
+    for (const auto e: events) {
         out->appendf("%-25s\t%0.3f sec\t%5d\t %s\n",
                      e->name, (e->when ? e->when - current_dtime : 0), e->weight,
                      (e->arg && e->cbdata) ? cbdataReferenceValid(e->arg) ? "yes" : "no" : "N/A");
     }
+
+    out->appendf("\nQueue depth: %zu\n", size);
+    out->appendf("Events scheduled: %" PRIu64 "\n", scheduled);
+    out->appendf("Events fired: %" PRIu64 "\n", fired);
+    out->appendf("Mean lateness: %0.3f sec\n", firedDelayed ? totalLateness/firedDelayed : 0.0);
+    out->appendf("Max lateness: %0.3f sec\n", maxLateness);
 }
 
 bool
 EventScheduler::find(EVH * func, void * arg)
 {
-
-    ev_entry *event;
-
-    for (event = tasks; event != nullptr; event = event->next) {
-        if (event->func == func && event->arg == arg)
-            return true;
-    }
-
-    return false;
+    return byCall.find(Call(func, arg)) != byCall.end();
 }
 
 EventScheduler *
@@ -304,17 +425,13 @@ EventScheduler::schedule(const char *name, EVH * func, void *arg, double when, i
     // because it may decrease if system clock is adjusted backwards.
     const double timestamp = when > 0.0 ? current_dtime + when : 0;
     ev_entry *event = new ev_entry(name, func, arg, timestamp, weight, cbdata);
+    event->sequence = ++scheduled;
+    LinkEvent(byHandler, func, *event, &ev_entry::sameHandler);
+    LinkEvent(byCall, Call(func, arg), *event, &ev_entry::sameCall);
+    ++size;
 
-    ev_entry **E;
     debugs(41, 7, "schedule: Adding '" << name << "', in " << when << " seconds");
-    /* Insert after the last event with the same or earlier time */
 
-    for (E = &tasks; *E; E = &(*E)->next) {
-        if ((*E)->when > event->when)
-            break;
-    }
-
-    event->next = *E;
-    *E = event;
+    // zero-timestamp events are due right away (i.e. at tick zero)
+    wheel.schedule(*event, DueTick(timestamp));
 }
-
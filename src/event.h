@@ -11,8 +11,13 @@
 
 #include "AsyncEngine.h"
 #include "base/Packable.h"
+#include "base/TimerWheel.h"
 #include "mem/forward.h"
 
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 /* event scheduling facilities - run a callback after a given time period. */
 
 typedef void EVH(void *);
@@ -23,11 +28,21 @@ void eventDelete(EVH * func, void *arg);
 void eventInit(void);
 int eventFind(EVH *, void *);
 
-class ev_entry
+/// An event scheduled by EventScheduler. While the event is not due yet, the
+/// inherited timer tracks the event position in the scheduler timing wheel.
+class ev_entry: public TimerWheel::Timer
 {
     MEMPROXY_CLASS(ev_entry);
 
 public:
+    /// a position in an EventScheduler list of events
+    class Links
+    {
+    public:
+        ev_entry *prev = nullptr;
+        ev_entry *next = nullptr;
+    };
+
     ev_entry(char const * name, EVH * func, void *arg, double when, int weight, bool cbdata=true);
     ~ev_entry();
     const char *name;
@@ -38,7 +53,14 @@ public:
     int weight;
     bool cbdata;
 
-    ev_entry *next;
+    /// the scheduling order among events with the same `when` timestamp
+    uint64_t sequence = 0;
+
+    /// this event position among scheduled events with the same func
+    Links sameHandler;
+
+    /// this event position among scheduled events with the same func and arg
+    Links sameCall;
 };
 
 // manages time-based events
@@ -64,8 +86,66 @@ public:
     static EventScheduler *GetInstance();
 
 private:
+    /// orders events by their timestamp and then by their scheduling order
+    class EarlierEvent
+    {
+    public:
+        bool operator()(const ev_entry *a, const ev_entry *b) const {
+            return a->when < b->when || (a->when == b->when && a->sequence < b->sequence);
+        }
+    };
+
+    /// a handler and its argument
+    using Call = std::pair<EVH *, void *>;
+
+    /// a Call hash for the CallLists index
+    class CallHash
+    {
+    public:
+        size_t operator()(const Call &) const;
+    };
+
+    /// the first event (i.e. a list head) of each scheduled handler
+    using HandlerLists = std::unordered_map<EVH *, ev_entry *>;
+
+    /// the first event (i.e. a list head) of each scheduled handler and argument
+    using CallLists = std::unordered_map<Call, ev_entry *, CallHash>;
+
+    void advance();
+    const ev_entry *earliest() const;
+    void forget(ev_entry *);
+
     static EventScheduler _instance;
-    ev_entry * tasks;
+
+    /// events that are not due yet, with one millisecond wheel ticks
+    TimerWheel wheel;
+
+    /// events that the wheel reported as due, in reverse firing order
+    std::vector<ev_entry *> due;
+
+    /// all scheduled events, linked via ev_entry::sameHandler
+    HandlerLists byHandler;
+
+    /// all scheduled events, linked via ev_entry::sameCall
+    CallLists byCall;
+
+    /// the number of scheduled events
+    size_t size = 0;
+
+    /// the number of schedule() calls so far
+    uint64_t scheduled = 0;
+
+    /// the number of events that were given to the async call queue
+    uint64_t fired = 0;
+
+    /// the number of fired events that were scheduled to run after a delay
+    uint64_t firedDelayed = 0;
+
+    /// the sum of firing delays for firedDelayed events (in seconds)
+    double totalLateness = 0;
+
+    /// the maximum firing delay among firedDelayed events (in seconds)
+    double maxLateness = 0;
 };
 
 #endif /* SQUID_SRC_EVENT_H */
@@ -16,6 +16,10 @@
 #include "globals.h"
 #include "Store.h"
 
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
 fde *fde::Table = nullptr;
 
 void
@@ -59,6 +63,19 @@ fde::useBufferedIo(READ_HANDLER *bufferingReader, WRITE_HANDLER *bufferingWriter
     writeMethod_ = bufferingWriter;
 }
 
+int
+fde::writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    assert(iovcnt > 0);
+#if HAVE_WRITEV
+    if (writeMethod_ == default_write_method)
+        return ::writev(fd, iov, iovcnt);
+#endif
+    // buffering and TLS writers accept one buffer at a time; Comm::HandleWrite()
+    // treats the result as a partial write and calls us again for the rest
+    return writeMethod_(fd, static_cast<const char *>(iov[0].iov_base), iov[0].iov_len);
+}
+
 bool
 fde::readPending(int fdNumber) const
 {
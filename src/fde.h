@@ -23,6 +23,7 @@
 class ClientInfo;
 #endif
 class dwrite_q;
+struct iovec;
 
 /**
  * READ_HANDLER functions return < 0 if, and only if, they fail with an error.
@@ -87,6 +88,10 @@ public:
     int read(int fd, char *buf, int len) { return readMethod_(fd, buf, len); }
     int write(int fd, const char *buf, int len) { return writeMethod_(fd, buf, len); }
 
+    /// Writes gathered buffers. Uses writev(2) with default I/O methods.
+    /// Other I/O methods write (some of) the first buffer only.
+    int writev(int fd, const struct iovec *iov, int iovcnt);
+
     /* NOTE: memset is used on fdes today. 20030715 RBC */
     static void DumpStats(StoreEntry *);
 
@@ -202,5 +207,11 @@ FD_WRITE_METHOD(int fd, const char *buf, int len)
     return fd_table[fd].write(fd, buf, len);
 }
 
+inline int
+FD_WRITEV_METHOD(int fd, const struct iovec *iov, int iovcnt)
+{
+    return fd_table[fd].writev(fd, iov, iovcnt);
+}
+
 #endif /* SQUID_SRC_FDE_H */
 
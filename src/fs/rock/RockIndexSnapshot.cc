@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 47    Store Directory Routines */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "fs/rock/RockIndexSnapshot.h"
+#include "sbuf/Stream.h"
+
+#include <cerrno>
+#include <vector>
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+namespace Rock
+{
+
+/// the beginning of a snapshot file
+class IndexSnapshotHeader
+{
+public:
+    uint64_t magic = 0; ///< IndexSnapshotMagic
+    uint32_t version = 0; ///< IndexSnapshotVersion
+    uint32_t headerSize = 0; ///< sizeof(IndexSnapshotHeader)
+    IndexSnapshot::DbState db; ///< the db described by this snapshot
+    uint64_t entries = 0; ///< the number of saved entries
+    uint64_t slices = 0; ///< the number of saved slices
+    uint64_t bodySize = 0; ///< the number of bytes after the header
+    uint32_t checksum = 0; ///< SnapshotChecksum() of the body
+    uint32_t reserved = 0; ///< explicit padding; always zero
+};
+
+} // namespace Rock
+
+/// identifies Rock index snapshots (and their byte order)
+static const uint64_t IndexSnapshotMagic = 0x78496b636f527153; // "SqRockIx" on little-endian hosts
+
+/// incremented whenever the snapshot format changes
+static const uint32_t IndexSnapshotVersion = 2;
+
+// the format must not depend on compiler-specific padding
+static_assert(sizeof(Rock::IndexSnapshotHeader) == 96, "no IndexSnapshotHeader padding");
+static_assert(sizeof(Rock::IndexSnapshot::Entry) == 72, "no IndexSnapshot::Entry padding");
+static_assert(sizeof(Rock::IndexSnapshot::Slice) == 8, "no IndexSnapshot::Slice padding");
+
+/// the size of the fileNos section of the body, including padding
+static size_t
+FileNosSize(const int64_t entryLimit)
+{
+    const auto size = static_cast<size_t>(entryLimit) * sizeof(int32_t);
+    return (size + 7) / 8 * 8;
+}
+
+/* Rock::IndexSnapshot::DbState */
+
+int
+Rock::IndexSnapshot::DbState::stat(const char * const dbPath)
+{
+    struct stat st;
+    if (::stat(dbPath, &st) != 0)
+        return errno;
+    fileSize = st.st_size;
+    inode = st.st_ino;
+    modificationTime = st.st_mtime;
+    return 0;
+}
+
+bool
+Rock::IndexSnapshot::DbState::operator ==(const DbState &other) const
+{
+    return slotSize == other.slotSize &&
+           slotLimit == other.slotLimit &&
+           entryLimit == other.entryLimit &&
+           fileSize == other.fileSize &&
+           inode == other.inode &&
+           modificationTime == other.modificationTime;
+}
+
+/* Rock::IndexSnapshot::Writer */
+
+Rock::IndexSnapshot::Writer::Writer(const SBuf &path, const DbState &db):
+    file_(path, sizeof(IndexSnapshotHeader)),
+    db_(db)
+{
+}
+
+/// writes a part of the snapshot body
+void
+Rock::IndexSnapshot::Writer::append(const void * const buf, const size_t size)
+{
+    file_.append(buf, size);
+    checksum_ = SnapshotChecksum(checksum_, buf, size);
+}
+
+void
+Rock::IndexSnapshot::Writer::addFileNo(const int32_t fileNo)
+{
+    Must(!fileNosFinished_);
+    Must(fileNos_ < db_.entryLimit);
+    append(&fileNo, sizeof(fileNo));
+    ++fileNos_;
+}
+
+/// pads the fileNos section so that entries are aligned in memory-mapped files
+void
+Rock::IndexSnapshot::Writer::finishFileNos()
+{
+    if (fileNosFinished_)
+        return;
+
+    Must(fileNos_ == db_.entryLimit);
+    // padding bytes are not covered by the checksum
+    file_.alignBody();
+    Must(file_.bodySize() == FileNosSize(db_.entryLimit));
+    fileNosFinished_ = true;
+}
+
+void
+Rock::IndexSnapshot::Writer::addEntry(const Entry &entry, const Slice * const slices)
+{
+    finishFileNos();
+    append(&entry, sizeof(entry));
+    append(slices, entry.slices * sizeof(Slice));
+    ++entries_;
+    slices_ += entry.slices;
+}
+
+void
+Rock::IndexSnapshot::Writer::finish()
+{
+    finishFileNos();
+
+    IndexSnapshotHeader header;
+    header.magic = IndexSnapshotMagic;
+    header.version = IndexSnapshotVersion;
+    header.headerSize = sizeof(header);
+    header.db = db_;
+    header.entries = entries_;
+    header.slices = slices_;
+    header.bodySize = file_.bodySize();
+    header.checksum = checksum_;
+    file_.finish(&header);
+}
+
+/* Rock::IndexSnapshot::Reader */
+
+void
+Rock::IndexSnapshot::Reader::open(const SBuf &path, const DbState &db)
+{
+    file_.open(path, sizeof(IndexSnapshotHeader));
+
+    const auto &header = *reinterpret_cast<const IndexSnapshotHeader *>(file_.header());
+    if (header.magic != IndexSnapshotMagic)
+        throw TextException(SBuf("not a Rock index snapshot"), Here());
+    if (header.version != IndexSnapshotVersion || header.headerSize != sizeof(header))
+        throw TextException(ToSBuf("unsupported snapshot version ", header.version), Here());
+    if (header.db != db)
+        throw TextException(SBuf("stale snapshot of a different or modified db"), Here());
+    if (header.bodySize != file_.bodySize())
+        throw TextException(SBuf("truncated snapshot"), Here());
+
+    const auto fileNosSize = static_cast<size_t>(db.entryLimit) * sizeof(int32_t);
+    const auto entriesStart = FileNosSize(db.entryLimit);
+    if (file_.bodySize() < entriesStart)
+        throw TextException(SBuf("truncated entry positions"), Here());
+    const auto checksum = SnapshotChecksum(SnapshotChecksum(0, file_.body(), fileNosSize),
+                                           file_.body() + entriesStart, file_.bodySize() - entriesStart);
+    if (checksum != header.checksum)
+        throw TextException(SBuf("snapshot checksum mismatch"), Here());
+
+    validateBody();
+}
+
+/// checks that saved entries form a valid index for the snapshot db
+void
+Rock::IndexSnapshot::Reader::validateBody() const
+{
+    const auto &header = *reinterpret_cast<const IndexSnapshotHeader *>(file_.header());
+    const auto &db = header.db;
+    const char *pos = file_.body();
+    const char * const end = file_.end();
+
+    // open() has checked that the body has room for fileNos
+    const auto savedFileNos = reinterpret_cast<const int32_t *>(pos);
+    for (int64_t name = 0; name < db.entryLimit; ++name) {
+        if (savedFileNos[name] < 0 || savedFileNos[name] >= db.entryLimit)
+            throw TextException(ToSBuf("bad entry position for name ", name), Here());
+    }
+    pos += FileNosSize(db.entryLimit);
+
+    std::vector<bool> usedAnchors(db.entryLimit);
+    std::vector<bool> usedSlots(db.slotLimit);
+    uint64_t entryCount = 0;
+    uint64_t sliceCount = 0;
+    while (pos < end) {
+        if (static_cast<size_t>(end - pos) < sizeof(Entry))
+            throw TextException(SBuf("truncated entry"), Here());
+        const auto &entry = *reinterpret_cast<const Entry *>(pos);
+        pos += sizeof(Entry);
+
+        if (entry.fileNo < 0 || entry.fileNo >= db.entryLimit || usedAnchors[entry.fileNo])
+            throw TextException(ToSBuf("bad or reused entry position ", entry.fileNo), Here());
+        usedAnchors[entry.fileNo] = true;
+
+        if (!entry.slices || entry.slices > static_cast<size_t>(end - pos) / sizeof(Slice))
+            throw TextException(ToSBuf("bad slice count for entry ", entry.fileNo), Here());
+        const auto slices = reinterpret_cast<const Slice *>(pos);
+        pos += entry.slices * sizeof(Slice);
+
+        uint64_t entrySize = 0;
+        auto sawSplicingPoint = entry.splicingPoint < 0;
+        for (uint32_t i = 0; i < entry.slices; ++i) {
+            const auto &slice = slices[i];
+            if (slice.id < 0 || slice.id >= db.slotLimit || usedSlots[slice.id])
+                throw TextException(ToSBuf("bad or reused slot ", slice.id, " in entry ", entry.fileNo), Here());
+            usedSlots[slice.id] = true;
+            if (!slice.size || slice.size > db.slotSize)
+                throw TextException(ToSBuf("bad slot ", slice.id, " size: ", slice.size), Here());
+            entrySize += slice.size;
+            if (slice.id == entry.splicingPoint)
+                sawSplicingPoint = true;
+        }
+
+        // zero swapFileSize means that the size was not yet known when saving
+        if (entry.swapFileSize && entry.swapFileSize != entrySize)
+            throw TextException(ToSBuf("entry ", entry.fileNo, " size mismatch: ", entry.swapFileSize, " != ", entrySize), Here());
+        if (!sawSplicingPoint)
+            throw TextException(ToSBuf("entry ", entry.fileNo, " splicing point is not in its chain"), Here());
+
+        ++entryCount;
+        sliceCount += entry.slices;
+    }
+
+    if (entryCount != header.entries || sliceCount != header.slices)
+        throw TextException(SBuf("saved entry count mismatch"), Here());
+}
+
+const int32_t *
+Rock::IndexSnapshot::Reader::fileNos() const
+{
+    return reinterpret_cast<const int32_t *>(file_.body());
+}
+
+uint64_t
+Rock::IndexSnapshot::Reader::entries() const
+{
+    return reinterpret_cast<const IndexSnapshotHeader *>(file_.header())->entries;
+}
+
+void
+Rock::IndexSnapshot::Reader::visitEntries(const std::function<void (const Entry &, const Slice *slices)> &visitor) const
+{
+    const auto &header = *reinterpret_cast<const IndexSnapshotHeader *>(file_.header());
+    const char *pos = file_.body() + FileNosSize(header.db.entryLimit);
+    const char * const end = file_.end();
+    // validateBody() has checked the boundaries
+    while (pos < end) {
+        const auto &entry = *reinterpret_cast<const Entry *>(pos);
+        pos += sizeof(Entry);
+        visitor(entry, reinterpret_cast<const Slice *>(pos));
+        pos += entry.slices * sizeof(Slice);
+    }
+}
+
+/* Rock::IndexSnapshot */
+
+SBuf
+Rock::IndexSnapshot::Path(const char * const dirPath)
+{
+    return ToSBuf(dirPath, "/rock.index");
+}
+
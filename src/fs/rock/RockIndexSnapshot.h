@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_FS_ROCK_ROCKINDEXSNAPSHOT_H
+#define SQUID_SRC_FS_ROCK_ROCKINDEXSNAPSHOT_H
+
+#include "base/SnapshotFile.h"
+#include "sbuf/SBuf.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace Rock
+{
+
+/// A copy of the cache_dir index (i.e. readable Ipc::StoreMap entries, their
+/// slices, and entry name-to-position mapping) saved during a clean shutdown
+/// so that the next Squid instance can skip scanning the db. This class
+/// manages the on-disk snapshot format and knows nothing about StoreMap.
+///
+/// The snapshot file starts with a Header followed by the body: one int32_t
+/// anchor position for every entry name (padded to 8 bytes), and then one
+/// Entry for every saved entry, each followed by Entry::slices Slices.
+class IndexSnapshot
+{
+public:
+    /// db file properties that the snapshot must still match when loaded
+    class DbState
+    {
+    public:
+        /// sets the file-specific members; \returns stat(2) errno or zero
+        int stat(const char *dbPath);
+
+        bool operator ==(const DbState &) const;
+        bool operator !=(const DbState &other) const { return !(*this == other); }
+
+        uint64_t slotSize = 0; ///< Rock::SwapDir::slotSize
+        int64_t slotLimit = 0; ///< the number of db slots
+        int64_t entryLimit = 0; ///< the number of map anchors
+        uint64_t fileSize = 0; ///< db file size
+        uint64_t inode = 0; ///< db file inode
+        int64_t modificationTime = 0; ///< db file mtime
+    };
+
+    /// saved basics of one readable entry
+    class Entry
+    {
+    public:
+        int32_t fileNo = -1; ///< anchor position
+        uint32_t slices = 0; ///< the number of Slices that follow this Entry
+        uint64_t key[2] = {0, 0};
+        int64_t timestamp = 0;
+        int64_t lastref = 0;
+        int64_t expires = 0;
+        int64_t lastmod = 0;
+        uint64_t swapFileSize = 0;
+        int32_t splicingPoint = -1; ///< see StoreMapAnchor::splicingPoint
+        uint16_t refcount = 0;
+        uint16_t flags = 0;
+    };
+
+    /// saved entry slice; slices are saved in their entry chain order
+    class Slice
+    {
+    public:
+        int32_t id = -1; ///< slot ID
+        uint32_t size = 0; ///< StoreMapSlice::size
+    };
+
+    /// writes a new snapshot (see SnapshotFileWriter)
+    class Writer
+    {
+    public:
+        Writer(const SBuf &path, const DbState &);
+
+        /// saves the anchor position of the next entry name; must be called
+        /// for every name, in name order, before any addEntry() calls
+        void addFileNo(int32_t fileNo);
+
+        /// saves the given entry and its slices
+        void addEntry(const Entry &, const Slice *slices);
+
+        /// writes the header and puts the snapshot into place
+        void finish();
+
+    private:
+        void append(const void *buf, size_t size);
+        void finishFileNos();
+
+        SnapshotFileWriter file_;
+        const DbState db_;
+
+        uint32_t checksum_ = 0; ///< body SnapshotChecksum() state
+        int64_t fileNos_ = 0; ///< the number of addFileNo() calls
+        bool fileNosFinished_ = false; ///< whether finishFileNos() was called
+        uint64_t entries_ = 0; ///< the number of addEntry() calls
+        uint64_t slices_ = 0; ///< the total number of saved slices
+    };
+
+    /// maps an existing snapshot into memory and validates it
+    class Reader
+    {
+    public:
+        /// maps the snapshot and checks that it is intact and matches the
+        /// given db state; throws on failures
+        void open(const SBuf &path, const DbState &);
+
+        /// the anchor position for each entry name
+        const int32_t *fileNos() const;
+
+        uint64_t entries() const; ///< the number of saved entries
+
+        /// calls the visitor for every saved entry, in saving order
+        void visitEntries(const std::function<void (const Entry &, const Slice *slices)> &) const;
+
+    private:
+        void validateBody() const;
+
+        SnapshotFileReader file_;
+    };
+
+    /// the snapshot location for the given cache_dir
+    static SBuf Path(const char *dirPath);
+};
+
+} // namespace Rock
+
+#endif /* SQUID_SRC_FS_ROCK_ROCKINDEXSNAPSHOT_H */
+
@@ -13,6 +13,7 @@
 #include "debug/Messages.h"
 #include "fs/rock/RockDbCell.h"
 #include "fs/rock/RockRebuild.h"
+#include "fs/rock/RockRebuildReaders.h"
 #include "fs/rock/RockSwapDir.h"
 #include "fs_io.h"
 #include "globals.h"
@@ -292,6 +293,9 @@ Rock::Rebuild::Start(SwapDir &dir)
         return false;
     }
 
+    if (!stats->counts.started() && dir.loadIndexSnapshot(stats->counts))
+        return false;
+
     AsyncJob::Start(new Rebuild(&dir, stats));
     return true;
 }
@@ -322,6 +326,7 @@ Rock::Rebuild::Rebuild(SwapDir *dir, const Ipc::Mem::Pointer<Stats> &s): AsyncJo
 
 Rock::Rebuild::~Rebuild()
 {
+    delete readers; // before closing the file they read
     if (fd >= 0)
         file_close(fd);
     // normally, segments are used until the Squid instance quits,
@@ -368,6 +373,8 @@ Rock::Rebuild::start()
 
     counts.updateStartTime(current_time);
 
+    startReaders();
+
     checkpoint();
 }
 
@@ -429,6 +436,9 @@ Rock::Rebuild::loadingSteps()
 
     int64_t loaded = 0;
     while (!doneLoading()) {
+        if (readers && !opt_foreground_rebuild && !readers->ready(loadingPos))
+            break; // let reader threads load more slots while we handle other events
+
         loadOneSlot();
         dbOffset += dbSlotSize;
         ++loadingPos;
@@ -448,6 +458,11 @@ Rock::Rebuild::loadingSteps()
             break;
         }
     }
+
+    if (doneLoading() && readers) {
+        delete readers;
+        readers = nullptr;
+    }
 }
 
 Rock::LoadingEntry
@@ -475,12 +490,7 @@ Rock::Rebuild::loadOneSlot()
     // in a case of crash
     ++counts.scancount;
 
-    if (lseek(fd, dbOffset, SEEK_SET) < 0)
-        failure("cannot seek to db entry", errno);
-
-    buf.reset();
-
-    if (!storeRebuildLoadEntry(fd, sd->index, buf, counts))
+    if (!loadSlotPrefix())
         return;
 
     const SlotId slotId = loadingPos;
@@ -510,6 +520,46 @@ Rock::Rebuild::loadOneSlot()
     useNewSlot(slotId, header);
 }
 
+/// starts threads that read db slots ahead of us (if configured and supported)
+void
+Rock::Rebuild::startReaders()
+{
+#if HAVE_DISKIO_MODULE_DISKTHREADS
+    // the readers may use the same POSIX threads that DiskThreads requires
+    if (sd->rebuildReaders <= 0 || doneLoading())
+        return;
+
+    assert(!readers);
+    readers = new RebuildReaders(fd, SwapDir::HeaderSize, dbSlotSize, loadingPos, dbSlotLimit, buf.spaceSize(), sd->rebuildReaders);
+    readers->start();
+    debugs(47, 2, "reading cache_dir #" << sd->index << " slots using " << sd->rebuildReaders << " threads");
+#endif
+}
+
+/// loads the beginning of the loadingPos slot into buf
+/// \returns false on read errors; mimics storeRebuildLoadEntry()
+bool
+Rock::Rebuild::loadSlotPrefix()
+{
+    buf.reset();
+
+    if (!readers) {
+        if (lseek(fd, dbOffset, SEEK_SET) < 0)
+            failure("cannot seek to db entry", errno);
+        return storeRebuildLoadEntry(fd, sd->index, buf, counts);
+    }
+
+    const auto prefix = readers->get(loadingPos);
+    if (prefix.size < 0) {
+        debugs(47, DBG_IMPORTANT, "WARNING: cache_dir[" << sd->index << "]: " <<
+               "Ignoring cached entry after meta data read failure: " << xstrerr(prefix.xerrno));
+        return false;
+    }
+
+    buf.append(prefix.data, prefix.size);
+    return true;
+}
+
 /// whether the given slot buffer is likely to have nothing but zeros, as is
 /// common to slots in pre-initialized (with zeros) db files
 static bool
@@ -24,6 +24,7 @@ namespace Rock
 class LoadingEntry;
 class LoadingSlot;
 class LoadingParts;
+class RebuildReaders;
 
 /// \ingroup Rock
 /// manages store rebuild process: loading meta information from db on disk
@@ -52,13 +53,13 @@ public:
     /// \returns whether the indexing was necessary (and, hence, started)
     static bool Start(SwapDir &dir);
 
+    /// whether the current kid is responsible for rebuilding the given cache_dir
+    static bool IsResponsible(const SwapDir &);
+
     /* AsyncJob API */
     virtual void callException(const std::exception &) override;
 
 protected:
-    /// whether the current kid is responsible for rebuilding the given cache_dir
-    static bool IsResponsible(const SwapDir &);
-
     Rebuild(SwapDir *dir, const Ipc::Mem::Pointer<Stats> &);
     ~Rebuild() override;
 
@@ -78,6 +79,8 @@ private:
     void steps();
     void loadingSteps();
     void validationSteps();
+    void startReaders();
+    bool loadSlotPrefix();
     void loadOneSlot();
     void validateOneEntry(const sfileno fileNo);
     void validateOneSlot(const SlotId slotId);
@@ -122,6 +125,9 @@ private:
     int64_t validationPos; ///< index of the loaded db slot being validated now
     MemBuf buf; ///< space to load current db slot (and entry metadata) into
 
+    /// threads reading db slots ahead of loadingPos (or nil)
+    RebuildReaders *readers = nullptr;
+
     StoreRebuildData &counts; ///< a reference to the shared memory counters
 
     /// whether we have started indexing this cache_dir before,
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 79    Disk IO Routines */
+
+#include "squid.h"
+#include "fs/rock/RockRebuildReaders.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/// the preferred size of one sequential read
+static const int64_t SequentialReadSize = 4*1024*1024;
+
+/// Slots larger than this are loaded using one read per slot prefix because
+/// reading whole slots would transfer too many bytes that we do not need.
+static const int64_t SequentialSlotSizeMax = 64*1024;
+
+Rock::RebuildReaders::RebuildReaders(const int fd, const int64_t dbOffset, const int64_t slotSize, const int64_t firstSlot, const int64_t slotLimit, const size_t prefixSize, const int readers):
+    fd_(fd),
+    dbOffset_(dbOffset),
+    slotSize_(slotSize),
+    firstSlot_(firstSlot),
+    slotLimit_(slotLimit),
+    prefixSize_(std::min<size_t>(prefixSize, slotSize)),
+    readers_(std::max(readers, 1)),
+    batchSlots_(std::max<int64_t>(1, SequentialReadSize / slotSize)),
+    batches_(0),
+    window_(2 * readers_)
+{
+    assert(slotSize_ > 0);
+    assert(firstSlot_ <= slotLimit_);
+    batches_ = (slotLimit_ - firstSlot_ + batchSlots_ - 1) / batchSlots_;
+}
+
+Rock::RebuildReaders::~RebuildReaders()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    released_.notify_all();
+
+    for (auto &thread: threads_)
+        thread.join();
+}
+
+void
+Rock::RebuildReaders::start()
+{
+    assert(threads_.empty());
+    for (auto reader = 0; reader < readers_; ++reader)
+        threads_.emplace_back(&RebuildReaders::read, this, reader);
+}
+
+/// the reader thread body: loads every readers_-th batch
+void
+Rock::RebuildReaders::read(const int reader)
+{
+    std::vector<char> buffer;
+    for (auto number = int64_t(reader); number < batches_; number += readers_) {
+        auto &entry = batch(number);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // wait for the batch previously stored in our window entry to be released
+            const auto windowEnd = [this] { return oldestBatch_ + int64_t(window_.size()); };
+            released_.wait(lock, [&] { return stopping_ || number < windowEnd(); });
+            if (stopping_)
+                return;
+            entry.number = -1;
+            entry.ready = false;
+        }
+
+        load(entry, number, buffer);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entry.number = number;
+            entry.ready = true;
+        }
+        loaded_.notify_all();
+    }
+}
+
+/// loads slot prefixes of the given batch into the given window entry
+void
+Rock::RebuildReaders::load(Batch &entry, const int64_t number, std::vector<char> &buffer)
+{
+    const auto first = firstSlot_ + number * batchSlots_;
+    const auto slots = std::min(batchSlots_, slotLimit_ - first);
+    entry.prefixes.resize(slots * prefixSize_);
+    entry.sizes.assign(slots, 0);
+    entry.errors.assign(slots, 0);
+
+    if (slotSize_ > SequentialSlotSizeMax) {
+        loadSeparately(entry, first, slots);
+        return;
+    }
+
+    const auto offset = dbOffset_ + first * slotSize_;
+    const auto bytes = static_cast<size_t>(slots * slotSize_);
+    buffer.resize(bytes);
+    size_t loaded = 0;
+    while (loaded < bytes) {
+        const auto result = pread(fd_, buffer.data() + loaded, bytes - loaded, offset + loaded);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            // find the broken slot(s), one at a time
+            loadSeparately(entry, first, slots);
+            return;
+        }
+        if (result == 0)
+            break; // the db file is shorter than expected
+        loaded += result;
+    }
+
+    for (int64_t i = 0; i < slots; ++i) {
+        const auto slotStart = static_cast<size_t>(i * slotSize_);
+        const auto size = loaded > slotStart ? std::min(prefixSize_, loaded - slotStart) : 0;
+        memcpy(entry.prefixes.data() + i * prefixSize_, buffer.data() + slotStart, size);
+        entry.sizes[i] = size;
+    }
+
+#if defined(POSIX_FADV_DONTNEED)
+    // we are unlikely to need these pages again soon; do not crowd the page cache
+    (void)posix_fadvise(fd_, offset, bytes, POSIX_FADV_DONTNEED);
+#endif
+}
+
+/// loads each slot prefix using a dedicated read
+void
+Rock::RebuildReaders::loadSeparately(Batch &entry, const int64_t first, const int64_t slots)
+{
+    for (int64_t i = 0; i < slots; ++i) {
+        const auto offset = dbOffset_ + (first + i) * slotSize_;
+        ssize_t result;
+        do {
+            result = pread(fd_, entry.prefixes.data() + i * prefixSize_, prefixSize_, offset);
+        } while (result < 0 && errno == EINTR);
+        entry.sizes[i] = result;
+        entry.errors[i] = result < 0 ? errno : 0;
+    }
+}
+
+/// lets readers reuse the window entries of batches before the given one
+void
+Rock::RebuildReaders::release(const int64_t number)
+{
+    // called with mutex_ locked
+    if (number == oldestBatch_)
+        return;
+    assert(number == oldestBatch_ + 1); // slots are examined in order
+    oldestBatch_ = number;
+    released_.notify_all();
+}
+
+bool
+Rock::RebuildReaders::ready(const int64_t slotId)
+{
+    assert(firstSlot_ <= slotId && slotId < slotLimit_);
+    const auto number = batchOf(slotId);
+    if (number == readyBatch_)
+        return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    release(number);
+    const auto &entry = batch(number);
+    if (entry.number != number || !entry.ready)
+        return false;
+    readyBatch_ = number;
+    return true;
+}
+
+Rock::RebuildReaders::Prefix
+Rock::RebuildReaders::get(const int64_t slotId)
+{
+    assert(firstSlot_ <= slotId && slotId < slotLimit_);
+    const auto number = batchOf(slotId);
+    auto &entry = batch(number);
+    if (number != readyBatch_) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        release(number);
+        loaded_.wait(lock, [&] { return entry.number == number && entry.ready; });
+        readyBatch_ = number;
+    }
+
+    // readers do not touch entries of unreleased batches
+    const auto i = slotId - (firstSlot_ + number * batchSlots_);
+    Prefix prefix;
+    prefix.data = entry.prefixes.data() + i * prefixSize_;
+    prefix.size = entry.sizes[i];
+    prefix.xerrno = entry.errors[i];
+    return prefix;
+}
+
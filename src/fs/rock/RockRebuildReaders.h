@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_FS_ROCK_ROCKREBUILDREADERS_H
+#define SQUID_SRC_FS_ROCK_ROCKREBUILDREADERS_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rock
+{
+
+/// Reads the beginning of each db slot ahead of Rebuild, using several
+/// threads that each split the db file into large sequential reads. Rebuild
+/// still examines the loaded slots one by one, in slot order.
+///
+/// Reader threads do not touch Squid globals, debugs(), or memory pools.
+class RebuildReaders
+{
+public:
+    /// the beginning of one db slot
+    class Prefix
+    {
+    public:
+        const char *data = nullptr; ///< loaded bytes
+        ssize_t size = 0; ///< the number of loaded bytes or -1 on read errors
+        int xerrno = 0; ///< read(2) errno when size is -1
+    };
+
+    /// \param fd an open db file descriptor, shared with pread(2)
+    /// \param dbOffset the db file offset of the first slot (i.e. slot #0)
+    /// \param firstSlot the first slot to load
+    /// \param slotLimit the total number of db slots
+    /// \param prefixSize the maximum number of bytes to load from each slot
+    RebuildReaders(int fd, int64_t dbOffset, int64_t slotSize, int64_t firstSlot, int64_t slotLimit, size_t prefixSize, int readers);
+    ~RebuildReaders();
+
+    RebuildReaders(RebuildReaders &&) = delete; // no copying or moving
+
+    /// starts reader threads
+    void start();
+
+    /// whether the given slot, which must be the next slot to examine, has
+    /// been loaded; a false answer lets the caller do other work meanwhile
+    bool ready(int64_t slotId);
+
+    /// blocks until the given slot, which must be the next slot to examine,
+    /// has been loaded and then provides its prefix; the prefix is valid
+    /// until the next call
+    Prefix get(int64_t slotId);
+
+private:
+    /// loaded prefixes of consecutive slots
+    class Batch
+    {
+    public:
+        int64_t number = -1; ///< which batch this is (or -1 if not loaded yet)
+        bool ready = false; ///< whether all slots have been loaded
+        std::vector<char> prefixes; ///< prefixSize bytes for every slot
+        std::vector<ssize_t> sizes; ///< Prefix::size for every slot
+        std::vector<int> errors; ///< Prefix::xerrno for every slot
+    };
+
+    int64_t batchOf(int64_t slotId) const { return (slotId - firstSlot_) / batchSlots_; }
+    Batch &batch(int64_t number) { return window_[number % window_.size()]; }
+
+    void read(int reader);
+    void load(Batch &batch, int64_t number, std::vector<char> &buffer);
+    void loadSeparately(Batch &batch, int64_t firstSlot, int64_t slots);
+    void release(int64_t number);
+
+    const int fd_;
+    const int64_t dbOffset_;
+    const int64_t slotSize_;
+    const int64_t firstSlot_;
+    const int64_t slotLimit_;
+    const size_t prefixSize_;
+    const int readers_;
+
+    int64_t batchSlots_; ///< the number of slots in a (non-last) batch
+    int64_t batches_; ///< the total number of batches
+
+    std::vector<Batch> window_; ///< batches being loaded or examined
+    std::vector<std::thread> threads_;
+
+    /* protected by mutex_ */
+    std::mutex mutex_;
+    std::condition_variable loaded_; ///< a batch became ready
+    std::condition_variable released_; ///< the oldest batch is no longer needed
+    int64_t oldestBatch_ = 0; ///< the batch being examined
+    bool stopping_ = false; ///< whether the readers must quit
+
+    int64_t readyBatch_ = -1; ///< the last batch known to be ready; main thread only
+};
+
+} // namespace Rock
+
+#endif /* SQUID_SRC_FS_ROCK_ROCKREBUILDREADERS_H */
+
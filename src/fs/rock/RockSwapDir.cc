@@ -10,6 +10,7 @@
 
 #include "squid.h"
 #include "base/IoManip.h"
+#include "base/TextException.h"
 #include "cache_cf.h"
 #include "CollapsedForwarding.h"
 #include "ConfigOption.h"
@@ -17,19 +18,24 @@
 #include "DiskIO/DiskIOStrategy.h"
 #include "DiskIO/ReadRequest.h"
 #include "DiskIO/WriteRequest.h"
+#include "fatal.h"
 #include "fs/rock/RockHeaderUpdater.h"
 #include "fs/rock/RockIoRequests.h"
 #include "fs/rock/RockIoState.h"
 #include "fs/rock/RockSwapDir.h"
 #include "globals.h"
 #include "ipc/mem/Pages.h"
+#include "md5.h"
 #include "MemObject.h"
 #include "Parsing.h"
+#include "sbuf/Stream.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "tools.h"
 
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <limits>
 
@@ -39,7 +45,7 @@
 
 Rock::SwapDir::SwapDir(): ::SwapDir("rock"),
     slotSize(HeaderSize), filePath(nullptr), map(nullptr), io(nullptr),
-    waitingForPage(nullptr)
+    waitingForPage(nullptr), rebuildReaders(4)
 {
 }
 
@@ -374,6 +380,7 @@ Rock::SwapDir::getOptionTree() const
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseSizeOption, &SwapDir::dumpSizeOption));
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseTimeOption, &SwapDir::dumpTimeOption));
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseRateOption, &SwapDir::dumpRateOption));
+        vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseRebuildOption, &SwapDir::dumpRebuildOption));
     } else {
         // we don't know how to handle copt, as it's not a ConfigOptionVector.
         // free it (and return nullptr)
@@ -535,6 +542,49 @@ Rock::SwapDir::dumpSizeOption(StoreEntry * e) const
     storeAppendPrintf(e, " slot-size=%" PRId64, slotSize);
 }
 
+/// parses index rebuild options; mimics ::SwapDir::optionObjectSizeParse()
+bool
+Rock::SwapDir::parseRebuildOption(char const *option, const char *value, int reconfig)
+{
+    int *storedCount;
+    if (strcmp(option, "rebuild-readers") == 0)
+        storedCount = &rebuildReaders;
+    else
+        return false;
+
+    if (!value) {
+        self_destruct();
+        return false;
+    }
+
+    // TODO: detect parsing errors better
+    const int64_t parsedValue = strtoll(value, nullptr, 10);
+    if (parsedValue < 0 || parsedValue > 64) {
+        debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option << " must be between 0 and 64 but is: " << parsedValue);
+        self_destruct();
+        return false;
+    }
+
+    const int newCount = static_cast<int>(parsedValue);
+
+    if (!reconfig)
+        *storedCount = newCount;
+    else if (*storedCount != newCount) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+               << " cannot be changed dynamically, value left unchanged: " <<
+               *storedCount);
+    }
+
+    return true;
+}
+
+/// reports index rebuild options; mimics ::SwapDir::optionObjectSizeDump()
+void
+Rock::SwapDir::dumpRebuildOption(StoreEntry * e) const
+{
+    storeAppendPrintf(e, " rebuild-readers=%d", rebuildReaders);
+}
+
 /// check the results of the configuration; only level-0 debugging works here
 void
 Rock::SwapDir::validateOptions()
@@ -592,6 +642,11 @@ Rock::SwapDir::canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load)
     if (!map)
         return false;
 
+    if (!Store::Root().admits(e)) {
+        debugs(47, 5, "not popular enough: " << e);
+        return false;
+    }
+
     // Do not start I/O transaction if there are less than 10% free pages left.
     // TODO: reserve page instead
     if (needsDiskStrand() &&
@@ -826,6 +881,179 @@ Rock::SwapDir::ioCompletedNotification()
         storeRebuildComplete(nullptr);
 }
 
+int
+Rock::SwapDir::writeCleanStart()
+{
+    // Save the index only after the last db write (i.e. when shutting down)
+    // because db changes that happen within the same db file modification
+    // time tick would go unnoticed when loading the snapshot.
+    if (shutting_down && map && Rebuild::IsResponsible(*this))
+        saveIndexSnapshot();
+    return 0; // we have no cleanLog entries to write
+}
+
+/// the current db state for IndexSnapshot checks; throws on errors
+Rock::IndexSnapshot::DbState
+Rock::SwapDir::indexSnapshotDbState() const
+{
+    IndexSnapshot::DbState db;
+    db.slotSize = slotSize;
+    db.slotLimit = map->sliceLimit();
+    db.entryLimit = map->entryLimit();
+    if (const auto xerrno = db.stat(filePath))
+        throw TextException(ToSBuf("cannot stat ", filePath, ": ", xstrerr(xerrno)), Here());
+    return db;
+}
+
+/// saves the given map entry unless it is unreadable or still being written
+/// \returns whether the entry was saved
+static bool
+SaveIndexEntry(Ipc::StoreMap &map, const sfileno fileNo, Rock::IndexSnapshot::Writer &snapshot, std::vector<Rock::IndexSnapshot::Slice> &slices)
+{
+    // openForReadingAt() checks the peeked key again after locking the entry
+    cache_key key[SQUID_MD5_DIGEST_LENGTH];
+    memcpy(key, map.peekAtEntry(fileNo).key, sizeof(key));
+    const auto anchor = map.openForReadingAt(fileNo, key);
+    if (!anchor)
+        return false; // empty, busy, or marked for deletion
+
+    Rock::IndexSnapshot::Entry entry;
+    slices.clear();
+    if (anchor->complete() && !anchor->writerHalted) {
+        entry.fileNo = fileNo;
+        memcpy(entry.key, anchor->key, sizeof(entry.key));
+        entry.timestamp = anchor->basics.timestamp;
+        entry.lastref = anchor->basics.lastref;
+        entry.expires = anchor->basics.expires;
+        entry.lastmod = anchor->basics.lastmod;
+        entry.swapFileSize = anchor->basics.swap_file_sz;
+        entry.refcount = anchor->basics.refcount;
+        entry.flags = anchor->basics.flags;
+        entry.splicingPoint = anchor->splicingPoint;
+        auto sliceId = anchor->start.load();
+        while (sliceId >= 0 && slices.size() < static_cast<size_t>(map.sliceLimit())) {
+            const auto &slice = map.readableSlice(fileNo, sliceId);
+            slices.push_back(Rock::IndexSnapshot::Slice{sliceId, slice.size});
+            sliceId = slice.next;
+        }
+        entry.slices = slices.size();
+    }
+    map.closeForReading(fileNo);
+
+    if (slices.empty())
+        return false;
+    snapshot.addEntry(entry, slices.data());
+    return true;
+}
+
+/// saves readable map entries so that the next Squid instance can use them
+/// instead of scanning the db; see loadIndexSnapshot()
+void
+Rock::SwapDir::saveIndexSnapshot()
+{
+    auto snapshotPath = IndexSnapshot::Path(path);
+    try {
+        IndexSnapshot::Writer snapshot(snapshotPath, indexSnapshotDbState());
+        for (sfileno name = 0; name < map->entryLimit(); ++name)
+            snapshot.addFileNo(map->exportFileNo(name));
+
+        std::vector<IndexSnapshot::Slice> slices;
+        int64_t saved = 0;
+        for (sfileno fileNo = 0; fileNo < map->entryLimit(); ++fileNo) {
+            if (SaveIndexEntry(*map, fileNo, snapshot, slices))
+                ++saved;
+        }
+        snapshot.finish();
+        debugs(47, DBG_IMPORTANT, "Saved " << saved << " cache_dir #" << index <<
+               " entries to " << snapshotPath);
+    } catch (...) {
+        debugs(47, DBG_IMPORTANT, "ERROR: Cannot save cache_dir #" << index << " index" <<
+               Debug::Extra << "snapshot: " << snapshotPath <<
+               Debug::Extra << "problem: " << CurrentException);
+    }
+}
+
+/// Fills the empty map using the index saved by the previous Squid instance.
+/// \returns whether the index was loaded and, hence, the db need not be scanned
+bool
+Rock::SwapDir::loadIndexSnapshot(StoreRebuildData &counts)
+{
+    auto snapshotPath = IndexSnapshot::Path(path);
+    struct stat st;
+    if (::stat(snapshotPath.c_str(), &st) != 0 && errno == ENOENT) {
+        debugs(47, 2, "no cache_dir #" << index << " index snapshot at " << snapshotPath);
+        return false;
+    }
+
+    IndexSnapshot::Reader snapshot;
+    try {
+        snapshot.open(snapshotPath, indexSnapshotDbState());
+    } catch (...) {
+        debugs(47, DBG_IMPORTANT, "WARNING: Ignoring unusable cache_dir #" << index << " index" <<
+               Debug::Extra << "snapshot: " << snapshotPath <<
+               Debug::Extra << "problem: " << CurrentException);
+        (void)unlink(snapshotPath.c_str());
+        return false;
+    }
+
+    // the snapshot becomes stale as soon as we modify the db
+    if (unlink(snapshotPath.c_str()) != 0) {
+        const auto xerrno = errno;
+        debugs(47, DBG_IMPORTANT, "WARNING: Ignoring cache_dir #" << index << " index" <<
+               Debug::Extra << "snapshot: " << snapshotPath <<
+               Debug::Extra << "problem: cannot remove the snapshot before using it: " << xstrerr(xerrno));
+        return false;
+    }
+
+    const auto fileNos = snapshot.fileNos();
+    for (sfileno name = 0; name < map->entryLimit(); ++name)
+        map->importFileNo(name, fileNos[name]);
+
+    std::vector<bool> usedSlots(map->sliceLimit());
+    snapshot.visitEntries([&](const IndexSnapshot::Entry &entry, const IndexSnapshot::Slice *slices) {
+        // nobody else fills the map (or gets free slots) before we are done
+        const auto anchor = map->openForWritingAt(entry.fileNo, false);
+        assert(anchor);
+        anchor->setKey(reinterpret_cast<const cache_key *>(entry.key));
+        anchor->basics.timestamp = entry.timestamp;
+        anchor->basics.lastref = entry.lastref;
+        anchor->basics.expires = entry.expires;
+        anchor->basics.lastmod = entry.lastmod;
+        anchor->basics.swap_file_sz = entry.swapFileSize;
+        anchor->basics.refcount = entry.refcount;
+        anchor->basics.flags = entry.flags;
+        anchor->start = slices[0].id;
+        anchor->splicingPoint = entry.splicingPoint;
+        for (uint32_t i = 0; i < entry.slices; ++i) {
+            Ipc::StoreMapSlice slice;
+            slice.size = slices[i].size;
+            slice.next = i + 1 < entry.slices ? slices[i + 1].id : -1;
+            map->importSlice(slices[i].id, slice);
+            usedSlots[slices[i].id] = true;
+        }
+        map->closeForWriting(entry.fileNo);
+        ++counts.objcount;
+    });
+
+    for (SlotId slotId = 0; slotId < map->sliceLimit(); ++slotId) {
+        if (usedSlots[slotId])
+            continue;
+        Ipc::Mem::PageId pageId;
+        pageId.pool = Ipc::Mem::PageStack::IdForSwapDirSpace(index);
+        pageId.number = slotId+1;
+        freeSlots->push(pageId);
+    }
+
+    // tell Rebuild that there is nothing left to index
+    counts.scancount = map->sliceLimit();
+    counts.validations = map->entryLimit() + map->sliceLimit();
+    counts.updateStartTime(current_time);
+
+    debugs(47, DBG_IMPORTANT, "Loaded " << counts.objcount << " cache_dir #" << index <<
+           " entries from " << snapshotPath);
+    return true;
+}
+
 void
 Rock::SwapDir::closeCompleted()
 {
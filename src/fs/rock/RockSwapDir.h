@@ -13,6 +13,7 @@
 #include "DiskIO/IORequestor.h"
 #include "fs/rock/forward.h"
 #include "fs/rock/RockDbCell.h"
+#include "fs/rock/RockIndexSnapshot.h"
 #include "fs/rock/RockRebuild.h"
 #include "ipc/mem/Page.h"
 #include "ipc/mem/PageStack.h"
@@ -53,6 +54,7 @@ public:
     void parse(int index, char *path) override;
     bool smpAware() const override { return true; }
     bool hasReadableEntry(const StoreEntry &) const override;
+    int writeCleanStart() override;
 
     // temporary path to the shared memory map of first slots of cached entries
     SBuf inodeMapPath() const;
@@ -117,6 +119,8 @@ protected:
     void dumpRateOption(StoreEntry * e) const;
     bool parseSizeOption(char const *option, const char *value, int reconfiguring);
     void dumpSizeOption(StoreEntry * e) const;
+    bool parseRebuildOption(char const *option, const char *value, int reconfiguring);
+    void dumpRebuildOption(StoreEntry * e) const;
 
     bool full() const; ///< no more entries can be stored without purging
     void trackReferences(StoreEntry &e); ///< add to replacement policy scope
@@ -140,6 +144,10 @@ private:
     void handleWriteCompletionSuccess(const WriteRequest &request);
     void handleWriteCompletionProblem(const int errflag, const WriteRequest &request);
 
+    IndexSnapshot::DbState indexSnapshotDbState() const;
+    void saveIndexSnapshot();
+    bool loadIndexSnapshot(StoreRebuildData &);
+
     DiskIOStrategy *io;
     RefCount<DiskFile> theFile; ///< cache storage for this cache_dir
     Ipc::Mem::Pointer<Ipc::Mem::PageStack> freeSlots; ///< all unused slots
@@ -147,6 +155,7 @@ private:
 
     /* configurable options */
     DiskFile::Config fileConfig; ///< file-level configuration options
+    int rebuildReaders; ///< the number of threads reading db during rebuild
 
     static const int64_t HeaderSize = 16*1024; ///< on-disk db header size
 };
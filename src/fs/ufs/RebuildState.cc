@@ -10,6 +10,7 @@
 
 #include "squid.h"
 #include "base/IoManip.h"
+#include "fs/ufs/SwapLogScanner.h"
 #include "fs_io.h"
 #include "globals.h"
 #include "RebuildState.h"
@@ -21,11 +22,17 @@
 #include "tools.h"
 #include "UFSSwapLogParser.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cmath>
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #if HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
+#include <thread>
 
 CBDATA_NAMESPACED_CLASS_INIT(Fs::Ufs,RebuildState);
 
@@ -76,10 +83,14 @@ Fs::Ufs::RebuildState::RebuildState(const RefCount<UFSSwapDir> &aSwapDir) :
 
     debugs(47, DBG_IMPORTANT, "Rebuilding storage in " << sd->path << " (" <<
            (clean ? "clean log" : (LogParser ? "dirty log" : "no log")) << ")");
+
+    if (fromLog)
+        (void)startScanning();
 }
 
 Fs::Ufs::RebuildState::~RebuildState()
 {
+    stopScanning();
     sd->closeTmpSwapLog();
 
     if (LogParser)
@@ -114,14 +125,26 @@ Fs::Ufs::RebuildState::rebuildStep()
 
     const int totalEntries = LogParser ? LogParser->SwapLogEntries() : -1;
 
+    if (scanner && !scanner->finished()) {
+        if (!opt_foreground_rebuild) {
+            reportScanningProgress(totalEntries);
+            return; // let worker threads parse while we handle other events
+        }
+        scanner->wait();
+    }
+
     while (!isDone()) {
-        if (fromLog)
+        if (scanner) {
+            rebuildFromScanner();
+            if (indexed % 4000 == 0)
+                reportScanningProgress(totalEntries);
+        } else if (fromLog)
             rebuildFromSwapLog();
         else
             rebuildFromDirectory();
 
         // TODO: teach storeRebuildProgress to handle totalEntries <= 0
-        if (totalEntries > 0 && (n_read % 4000 == 0))
+        if (!scanner && totalEntries > 0 && (n_read % 4000 == 0))
             storeRebuildProgress(sd->index, totalEntries, n_read);
 
         if (opt_foreground_rebuild)
@@ -321,6 +344,13 @@ Fs::Ufs::RebuildState::rebuildFromSwapLog()
 
     ++counts.scancount; // XXX: should not this be incremented earlier?
 
+    addFromSwapLog(swapData);
+}
+
+/// indexes a sane SWAP_LOG_ADD entry unless it conflicts with the index
+void
+Fs::Ufs::RebuildState::addFromSwapLog(const StoreSwapLogData &swapData)
+{
     if (!sd->validFileno(swapData.swap_filen, 0)) {
         ++counts.invalid;
         return;
@@ -350,6 +380,118 @@ Fs::Ufs::RebuildState::rebuildFromSwapLog()
                swapData.flags);
 }
 
+/// starts parsing swap.state in worker threads
+/// \returns false if the main thread should parse swap.state instead
+bool
+Fs::Ufs::RebuildState::startScanning()
+{
+#if HAVE_DISKIO_MODULE_DISKTHREADS && HAVE_SYS_MMAN_H
+    // the scanner may use the same POSIX threads that DiskThreads requires
+    assert(LogParser);
+    assert(!scanner);
+
+    const auto fd = fileno(LogParser->log);
+    const auto firstRecord = ftello(LogParser->log);
+    struct stat sb;
+    if (firstRecord < 0 || fstat(fd, &sb) != 0 || sb.st_size <= firstRecord)
+        return false;
+
+    const auto entries = static_cast<size_t>(sb.st_size - firstRecord) / LogParser->record_size;
+    if (!entries || entries > INT_MAX)
+        return false;
+
+    mappedLogSize = firstRecord + entries * LogParser->record_size;
+    const auto mapped = mmap(nullptr, mappedLogSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        const auto xerrno = errno;
+        debugs(47, DBG_IMPORTANT, "WARNING: Cannot map " << sd->path << " swap log; parsing it without worker threads: " << xstrerr(xerrno));
+        mappedLogSize = 0;
+        return false;
+    }
+    mappedLog = static_cast<char *>(mapped);
+
+    const auto workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 8);
+    scanner = new SwapLogScanner(*LogParser, mappedLog + firstRecord, entries, workers);
+    scanner->start();
+    debugs(47, 2, "parsing " << entries << " " << sd->path << " swap log entries using " << workers << " threads");
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// applies one swap log entry that survived SwapLogScanner deduplication
+void
+Fs::Ufs::RebuildState::rebuildFromScanner()
+{
+    StoreSwapLogData swapData;
+
+    if (!scanner->next(swapData)) {
+        n_read = scanner->scanned();
+        scanner->addStatsTo(counts);
+        debugs(47, DBG_IMPORTANT, "Done reading " << sd->path << " swaplog (" << n_read << " entries" <<
+               " parsed by " << scanner->workers() << " threads in " << scanner->seconds() << " seconds" <<
+               ", " << indexed << " entries indexed)");
+        if (counts.bad_log_op)
+            debugs(47, DBG_IMPORTANT, "WARNING: " << counts.bad_log_op << " invalid swap log entries found");
+        stopScanning();
+        LogParser->Close();
+        delete LogParser;
+        LogParser = nullptr;
+        _done = true;
+        return;
+    }
+
+    ++indexed;
+
+    debugs(47, 3, swap_log_op_str[(int) swapData.op]  << " " <<
+           storeKeyText(swapData.key) << " " <<
+           asHex(swapData.swap_filen).upperCase().minDigits(8));
+
+    if (swapData.op == SWAP_LOG_DEL) {
+        // remove any older or same-age entry; +1 covers same-age entries
+        (void)evictStaleAndContinue(swapData.key, swapData.lastref+1, counts.cancelcount);
+        return;
+    }
+
+    addFromSwapLog(swapData);
+}
+
+/// reports worker threads parsing as the first half of the rebuild
+/// and main thread indexing of the surviving entries as the second half
+void
+Fs::Ufs::RebuildState::reportScanningProgress(const int totalEntries) const
+{
+    if (totalEntries <= 0)
+        return;
+
+    const int64_t half = totalEntries / 2;
+    int64_t sofar = 0;
+    if (!scanner->finished())
+        sofar = std::min<int64_t>(half, scanner->scanned() / 2);
+    else if (scanner->survivors())
+        sofar = half + (totalEntries - half) * indexed / static_cast<int64_t>(scanner->survivors());
+    else
+        sofar = totalEntries;
+    storeRebuildProgress(sd->index, totalEntries, sofar);
+}
+
+/// stops worker threads (if any) and releases their resources
+void
+Fs::Ufs::RebuildState::stopScanning()
+{
+    delete scanner; // waits for worker threads
+    scanner = nullptr;
+
+#if HAVE_SYS_MMAN_H
+    if (mappedLog) {
+        munmap(mappedLog, mappedLogSize);
+        mappedLog = nullptr;
+        mappedLogSize = 0;
+    }
+#endif
+}
+
 int
 Fs::Ufs::RebuildState::getNextFile(sfileno * filn_p, int *)
 {
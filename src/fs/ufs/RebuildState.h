@@ -21,6 +21,8 @@ namespace Fs
 namespace Ufs
 {
 
+class SwapLogScanner;
+
 class RebuildState
 {
     CBDATA_CLASS(RebuildState);
@@ -61,6 +63,11 @@ public:
 private:
     void rebuildFromDirectory();
     void rebuildFromSwapLog();
+    void addFromSwapLog(const StoreSwapLogData &swapData);
+    bool startScanning();
+    void rebuildFromScanner();
+    void reportScanningProgress(int totalEntries) const;
+    void stopScanning();
     void rebuildStep();
     void addIfFresh(const cache_key *key,
                     sfileno file_number,
@@ -75,6 +82,14 @@ private:
     int getNextFile(sfileno *, int *size);
     bool fromLog;
     bool _done;
+
+    /// parses swap.state in worker threads (if any)
+    SwapLogScanner *scanner = nullptr;
+    /// the memory-mapped swap.state image used by the scanner
+    char *mappedLog = nullptr;
+    size_t mappedLogSize = 0;
+    int indexed = 0; ///< the number of scanner-supplied records applied so far
+
     // TODO: (callback) should be hidden behind a proper human readable name
     void (callback)(void *cbdata);
     void *cbdata;
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 47    Store Directory Routines */
+
+#include "squid.h"
+#include "defines.h"
+#include "enums.h"
+#include "fs/ufs/SwapLogScanner.h"
+#include "fs/ufs/UFSSwapLogParser.h"
+#include "StoreSwapLogData.h"
+#include "swap_log_op.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+/// how many parsed records a worker accumulates before reporting progress
+static const size_t ProgressBatch = 4096;
+
+/// swap file number bits left after removing obsolete dir index bits
+static const sfileno FilenoMask = 0x00FFFFFF;
+
+Fs::Ufs::SwapLogScanner::SwapLogScanner(const UFSSwapLogParser &parser, const char * const records, const size_t count, const int workers):
+    parser_(parser),
+    records_(records),
+    count_(count),
+    workers_(std::max(workers, 1)),
+    scanned_(0),
+    finished_(false)
+{
+    // Candidate::position is 32 bits wide; swap.state record counts are ints
+    assert(count_ <= UINT32_MAX);
+}
+
+Fs::Ufs::SwapLogScanner::~SwapLogScanner()
+{
+    wait();
+}
+
+void
+Fs::Ufs::SwapLogScanner::start()
+{
+    assert(!coordinator_.joinable());
+    coordinator_ = std::thread(&SwapLogScanner::run, this);
+}
+
+void
+Fs::Ufs::SwapLogScanner::wait()
+{
+    if (coordinator_.joinable())
+        coordinator_.join();
+}
+
+/// decodes the record at the given log position
+void
+Fs::Ufs::SwapLogScanner::decode(const size_t position, StoreSwapLogData &swapData) const
+{
+    parser_.DecodeRecord(records_ + position * parser_.record_size, swapData);
+}
+
+/// the background thread body: parses all records and groups them by key
+/// using all workers and then applies them to each other in log order
+void
+Fs::Ufs::SwapLogScanner::run()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    results_.resize(workers_);
+    for (auto &worker: results_)
+        worker.partitions.resize(workers_);
+
+    std::vector<std::thread> threads;
+    for (auto w = 0; w < workers_; ++w) {
+        const auto begin = count_ * w / workers_;
+        const auto end = count_ * (w + 1) / workers_;
+        threads.emplace_back(&SwapLogScanner::parse, this, std::ref(results_[w]), begin, end);
+    }
+    for (auto &thread: threads)
+        thread.join();
+
+    // all parsing is done: a partition has the same records in every worker
+    threads.clear();
+    for (auto w = 0; w < workers_; ++w)
+        threads.emplace_back(&SwapLogScanner::identify, this, w, std::ref(results_[w]));
+    for (auto &thread: threads)
+        thread.join();
+
+    deduplicate();
+
+    seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    finished_.store(true, std::memory_order_release);
+}
+
+/// parses log records in the [begin, end) range, sorting candidates into
+/// key-based partitions; mimics RebuildState::rebuildFromSwapLog() checks
+void
+Fs::Ufs::SwapLogScanner::parse(Worker &worker, const size_t begin, const size_t end)
+{
+    auto &stats = worker.stats;
+    StoreSwapLogData swapData;
+    for (auto position = begin; position < end; ++position) {
+        if ((position - begin) % ProgressBatch == ProgressBatch - 1)
+            scanned_.fetch_add(ProgressBatch, std::memory_order_relaxed);
+
+        decode(position, swapData);
+
+        if (!swapData.sane()) {
+            ++stats.invalid;
+            continue;
+        }
+
+        // see RebuildState::rebuildFromSwapLog() for the history of these bits
+        swapData.swap_filen &= FilenoMask;
+
+        if (swapData.op == SWAP_LOG_ADD) {
+            ++stats.scancount;
+            // same as UFSSwapDir::validFileno(swapData.swap_filen, 0)
+            if (swapData.swap_filen < 0) {
+                ++stats.invalid;
+                continue;
+            }
+            if (EBIT_TEST(swapData.flags, KEY_PRIVATE)) {
+                ++stats.badflags;
+                continue;
+            }
+        } else if (swapData.op != SWAP_LOG_DEL) {
+            ++stats.bad_log_op;
+            ++stats.invalid;
+            continue;
+        }
+
+        Candidate candidate;
+        memcpy(candidate.key, swapData.key, sizeof(candidate.key));
+        candidate.lastref = swapData.lastref;
+        candidate.position = position;
+        candidate.keyId = 0; // set by identify()
+        candidate.filen = swapData.swap_filen;
+        candidate.removal = swapData.op == SWAP_LOG_DEL;
+        worker.partitions[candidate.key[1] % workers_].push_back(worker.parsed.size());
+        worker.parsed.push_back(candidate);
+    }
+    scanned_.fetch_add((end - begin) % ProgressBatch, std::memory_order_relaxed);
+}
+
+/// gives all candidates in the given partition that share a key the same
+/// Candidate::keyId, unique within the partition
+void
+Fs::Ufs::SwapLogScanner::identify(const size_t partition, Worker &worker)
+{
+    std::vector<Candidate*> candidates;
+    for (auto &other: results_) {
+        auto &indexes = other.partitions[partition];
+        for (const auto index: indexes)
+            candidates.push_back(&other.parsed[index]);
+        std::vector<uint32_t>().swap(indexes);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate *a, const Candidate *b) {
+        if (a->key[0] != b->key[0])
+            return a->key[0] < b->key[0];
+        return a->key[1] < b->key[1];
+    });
+
+    const Candidate *previous = nullptr;
+    for (const auto candidate: candidates) {
+        if (previous && memcmp(previous->key, candidate->key, sizeof(candidate->key)) == 0) {
+            candidate->keyId = previous->keyId;
+            continue;
+        }
+        candidate->keyId = worker.keys++;
+        previous = candidate;
+    }
+}
+
+/// applies all candidates to each other in log order, remembering the
+/// positions of the records that survive; mimics RebuildState decisions
+void
+Fs::Ufs::SwapLogScanner::deduplicate()
+{
+    // where each partition keys start in indexed[]
+    std::vector<size_t> firstKeys;
+    size_t keys = 0;
+    for (const auto &worker: results_) {
+        firstKeys.push_back(keys);
+        keys += worker.keys;
+    }
+
+    // the last surviving addition, by partition and Candidate::keyId
+    std::vector<const Candidate*> indexed(keys, nullptr);
+    // emulates UFSSwapDir::mapBitTest() for the swap files indexed so far
+    std::vector<bool> filenoUsed(size_t(FilenoMask) + 1, false);
+
+    // earlier workers parsed earlier records
+    auto &stats = results_.front().stats;
+    for (const auto &worker: results_) {
+        for (const auto &candidate: worker.parsed) {
+            if (!candidate.removal && filenoUsed[candidate.filen]) {
+                ++stats.clashcount; // see RebuildState::addFromSwapLog()
+                continue;
+            }
+
+            auto &current = indexed[firstKeys[candidate.key[1] % workers_] + candidate.keyId];
+            if (!current) {
+                if (candidate.removal) {
+                    survivors_.push_back(candidate.position); // may affect other cache_dirs
+                } else {
+                    current = &candidate;
+                    filenoUsed[candidate.filen] = true;
+                }
+                continue;
+            }
+
+            // mimic RebuildState::evictStaleAndContinue() decisions;
+            // for removals, +1 covers same-age entries
+            const auto maxRef = candidate.removal ? candidate.lastref + 1 : candidate.lastref;
+            if (current->lastref >= maxRef) {
+                ++stats.clashcount;
+                continue;
+            }
+
+            filenoUsed[current->filen] = false;
+            if (candidate.removal) {
+                ++stats.cancelcount;
+                current = nullptr;
+                // the cancelled addition may have evicted other cache_dirs entries
+                survivors_.push_back(candidate.position);
+            } else {
+                ++stats.dupcount;
+                current = &candidate;
+                filenoUsed[candidate.filen] = true;
+            }
+        }
+    }
+
+    for (const auto current: indexed) {
+        if (current)
+            survivors_.push_back(current->position);
+    }
+    std::sort(survivors_.begin(), survivors_.end());
+
+    for (auto &worker: results_)
+        Candidates().swap(worker.parsed);
+}
+
+bool
+Fs::Ufs::SwapLogScanner::next(StoreSwapLogData &swapData)
+{
+    assert(finished());
+
+    if (cursor_ >= survivors_.size())
+        return false;
+
+    decode(survivors_[cursor_++], swapData);
+    swapData.swap_filen &= FilenoMask;
+    return true;
+}
+
+void
+Fs::Ufs::SwapLogScanner::addStatsTo(StoreRebuildData &counts) const
+{
+    assert(finished());
+    for (const auto &worker: results_) {
+        const auto &stats = worker.stats;
+        counts.scancount += stats.scancount;
+        counts.clashcount += stats.clashcount;
+        counts.dupcount += stats.dupcount;
+        counts.cancelcount += stats.cancelcount;
+        counts.invalid += stats.invalid;
+        counts.badflags += stats.badflags;
+        counts.bad_log_op += stats.bad_log_op;
+    }
+}
+
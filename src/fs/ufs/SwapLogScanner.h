@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_FS_UFS_SWAPLOGSCANNER_H
+#define SQUID_SRC_FS_UFS_SWAPLOGSCANNER_H
+
+#include "store/forward.h"
+#include "store_rebuild.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class StoreSwapLogData;
+
+namespace Fs
+{
+namespace Ufs
+{
+
+class UFSSwapLogParser;
+
+/// Parses swap.state records and applies their additions and removals to
+/// each other in background threads. The main thread then only needs to
+/// apply the records that survived (in log order) to the Store index.
+///
+/// Records are applied to each other in log order, exactly as RebuildState
+/// would apply them one by one to an index without other cache_dirs:
+/// * Additions with invalid swap file numbers are rejected.
+/// * An addition is rejected if its swap file number is used by an entry
+///   indexed earlier (and not yet replaced or removed), even for other keys.
+/// * A later addition replaces an earlier one with an older lastref.
+/// * A removal cancels an earlier addition with the same or older lastref.
+///
+/// Removals survive, except those that lose to a newer addition. When
+/// RebuildState applies a removal that cancelled an addition, it evicts the
+/// same entries of other cache_dirs that the cancelled addition (and the
+/// removal) would have evicted.
+///
+/// Worker threads parse records and group them by key. The final log-order
+/// pass is sequential but also runs outside the main thread.
+/// Background threads do not touch Squid globals, debugs(), or memory pools.
+class SwapLogScanner
+{
+public:
+    /// \param records the in-memory image of all swap.state records
+    /// \param count the number of records at the records address
+    SwapLogScanner(const UFSSwapLogParser &parser, const char *records, size_t count, int workers);
+    ~SwapLogScanner();
+
+    SwapLogScanner(SwapLogScanner &&) = delete; // no copying or moving
+
+    /// starts parsing in background threads
+    void start();
+
+    /// blocks until all background threads are done
+    void wait();
+
+    /// whether the background threads are done; safe to call from any thread
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+
+    /// the number of records parsed so far; safe to call from any thread
+    size_t scanned() const { return scanned_.load(std::memory_order_relaxed); }
+
+    /* the methods below require finished() */
+
+    /// the number of records that the main thread needs to apply
+    size_t survivors() const { return survivors_.size(); }
+
+    /// retrieves the next surviving record in log order
+    /// \returns false when all survivors have been retrieved
+    bool next(StoreSwapLogData &swapData);
+
+    /// adds parsing and deduplication statistics to the given counters
+    void addStatsTo(StoreRebuildData &counts) const;
+
+    /// how long the background threads worked
+    double seconds() const { return seconds_; }
+
+    int workers() const { return workers_; }
+
+private:
+    /// a sane swap.state record worth deduplicating
+    class Candidate
+    {
+    public:
+        uint64_t key[2]; ///< cache key bits
+        time_t lastref; ///< swap.state lastref
+        uint32_t position; ///< the record number in the log
+        uint32_t keyId; ///< the same for all partition candidates with the same key
+        sfileno filen; ///< swap file number, without dir index bits
+        bool removal; ///< whether this is a SWAP_LOG_DEL record
+    };
+
+    using Candidates = std::vector<Candidate>;
+
+    /// work results of one background thread
+    class Worker
+    {
+    public:
+        Candidates parsed; ///< candidates in the worker log range, in log order
+        /// parsed[] indexes, by key-based partition
+        std::vector< std::vector<uint32_t> > partitions;
+        uint32_t keys = 0; ///< the number of different keys in our partition
+        StoreRebuildData stats; ///< counts of rejected and deduplicated records
+    };
+
+    void decode(size_t position, StoreSwapLogData &swapData) const;
+    void run();
+    void parse(Worker &worker, size_t begin, size_t end);
+    void identify(size_t partition, Worker &worker);
+    void deduplicate();
+
+    const UFSSwapLogParser &parser_;
+    const char * const records_;
+    const size_t count_;
+    const int workers_;
+
+    std::vector<Worker> results_; ///< one per worker thread
+    std::thread coordinator_; ///< runs workers and waits for them to finish
+
+    std::atomic<size_t> scanned_;
+    std::atomic<bool> finished_;
+    double seconds_ = 0;
+
+    std::vector<uint32_t> survivors_; ///< surviving record positions, ascending
+    size_t cursor_ = 0; ///< next() position in survivors_
+};
+
+} // namespace Ufs
+} // namespace Fs
+
+#endif /* SQUID_SRC_FS_UFS_SWAPLOGSCANNER_H */
+
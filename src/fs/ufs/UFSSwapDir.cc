@@ -17,6 +17,7 @@
 #include "ConfigOption.h"
 #include "DiskIO/DiskIOModule.h"
 #include "DiskIO/DiskIOStrategy.h"
+#include "fatal.h"
 #include "fde.h"
 #include "FileMap.h"
 #include "fs_io.h"
@@ -228,7 +229,7 @@ Fs::Ufs::UFSSwapDir::optionIOParse(char const *option, const char *value, int is
         return false;
     }
 
-    DiskIOModule *module = DiskIOModule::Find(value);
+    DiskIOModule *module = DiskIOModule::FindUsable(value, ioType);
 
     if (!module) {
         self_destruct();
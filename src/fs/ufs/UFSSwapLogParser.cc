@@ -40,16 +40,10 @@ public:
     UFSSwapLogParser_v1_32bs(FILE *fp):Fs::Ufs::UFSSwapLogParser(fp) {
         record_size = sizeof(UFSSwapLogParser_v1_32bs::StoreSwapLogDataOld);
     }
-    /// Convert the on-disk 32-bit format to our current format while reading
-    bool ReadRecord(StoreSwapLogData &swapData) override {
+    /// Convert the on-disk 32-bit format to our current format
+    void DecodeRecord(const char *raw, StoreSwapLogData &swapData) const override {
         UFSSwapLogParser_v1_32bs::StoreSwapLogDataOld readData;
-        int bytes = sizeof(UFSSwapLogParser_v1_32bs::StoreSwapLogDataOld);
-
-        assert(log);
-
-        if (fread(&readData, bytes, 1, log) != 1) {
-            return false;
-        }
+        memcpy(&readData, raw, sizeof(readData));
         swapData.op = readData.op;
         swapData.swap_filen = readData.swap_filen;
         swapData.timestamp = readData.timestamp;
@@ -60,7 +54,6 @@ public:
         swapData.refcount = readData.refcount;
         swapData.flags = readData.flags;
         memcpy(swapData.key, readData.key, SQUID_MD5_DIGEST_LENGTH);
-        return true;
     }
 };
 
@@ -71,9 +64,8 @@ public:
     UFSSwapLogParser_v2(FILE *fp): Fs::Ufs::UFSSwapLogParser(fp) {
         record_size = sizeof(StoreSwapLogData);
     }
-    bool ReadRecord(StoreSwapLogData &swapData) override {
-        assert(log);
-        return fread(&swapData, sizeof(StoreSwapLogData), 1, log) == 1;
+    void DecodeRecord(const char *raw, StoreSwapLogData &swapData) const override {
+        memcpy(static_cast<void *>(&swapData), raw, sizeof(StoreSwapLogData));
     }
 };
 
@@ -125,6 +117,21 @@ Fs::Ufs::UFSSwapLogParser::GetUFSSwapLogParser(FILE *fp)
     return nullptr;
 }
 
+bool
+Fs::Ufs::UFSSwapLogParser::ReadRecord(StoreSwapLogData &swapData)
+{
+    assert(log);
+    assert(record_size > 0);
+    char raw[sizeof(StoreSwapLogData)];
+    assert(static_cast<size_t>(record_size) <= sizeof(raw));
+
+    if (fread(raw, record_size, 1, log) != 1)
+        return false;
+
+    DecodeRecord(raw, swapData);
+    return true;
+}
+
 int
 Fs::Ufs::UFSSwapLogParser::SwapLogEntries()
 {
@@ -29,7 +29,12 @@ public:
 
     static UFSSwapLogParser *GetUFSSwapLogParser(FILE *fp);
 
-    virtual bool ReadRecord(StoreSwapLogData &swapData) = 0;
+    /// reads the next record_size bytes of the log into swapData
+    bool ReadRecord(StoreSwapLogData &swapData);
+
+    /// converts a record_size-byte on-disk record into swapData (thread-safe)
+    virtual void DecodeRecord(const char *raw, StoreSwapLogData &swapData) const = 0;
+
     int SwapLogEntries();
     void Close() {
         if (log) {
@@ -60,7 +60,6 @@ extern int reconfiguring;   /* 0 */
 extern time_t hit_only_mode_until;  /* 0 */
 extern double request_failure_ratio;    /* 0.0 */
 extern int store_hash_buckets;  /* 0 */
-extern hash_table *store_table; /* NULL */
 extern int hot_obj_count;   /* 0 */
 extern int CacheDigestHashFuncCount;    /* 4 */
 extern CacheDigest *store_digest;   /* NULL */
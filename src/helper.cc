@@ -17,6 +17,7 @@
 #include "comm/Read.h"
 #include "comm/Write.h"
 #include "debug/Messages.h"
+#include "fatal.h"
 #include "fd.h"
 #include "fde.h"
 #include "format/Quoting.h"
@@ -20,6 +20,7 @@
 #include "comm/Loops.h"
 #include "compat/xalloc.h"
 #include "debug/Messages.h"
+#include "fatal.h"
 #include "globals.h"
 #include "htcp.h"
 #include "http.h"
@@ -9,6 +9,7 @@
 #include "squid.h"
 #include "client_side_request.h"
 #include "clientStream.h"
+#include "fatal.h"
 #include "http/Stream.h"
 #include "HttpHdrContRange.h"
 #include "HttpHeaderTools.h"
@@ -277,15 +278,20 @@ Http::Stream::sendStartOfMessage(HttpReply *rep, StoreIOBuffer bodyData)
     /* Save length of headers for persistent conn checks */
     http->out.headers_sz = mb->contentSize();
 
+    // body bytes are sent after mb without being copied into it
+    struct iovec body[2];
+    int bodyPieces = 0;
     if (bodyData.data && bodyData.length) {
         if (multipartRangeRequest())
             packRange(bodyData, mb);
         else if (http->request->flags.chunkedReply) {
-            packChunk(bodyData, *mb);
+            bodyPieces = packChunk(bodyData, *mb, body);
         } else {
             size_t length = lengthToSend(bodyData.range());
             noteSentBodyBytes(length);
-            mb->append(bodyData.data, length);
+            body[0].iov_base = bodyData.data;
+            body[0].iov_len = length;
+            bodyPieces = 1;
         }
     }
 #if USE_DELAY_POOLS
@@ -307,7 +313,7 @@ Http::Stream::sendStartOfMessage(HttpReply *rep, StoreIOBuffer bodyData)
     }
 #endif
 
-    getConn()->write(mb);
+    getConn()->write(mb, body, bodyPieces);
     delete mb;
 }
 
@@ -323,11 +329,14 @@ Http::Stream::sendBody(StoreIOBuffer bodyData)
 
     MemBuf mb;
     mb.init();
-    if (multipartRangeRequest())
-        packRange(bodyData, &mb);
-    else
-        packChunk(bodyData, mb);
+    if (!multipartRangeRequest()) {
+        struct iovec chunk[2];
+        const auto chunkPieces = packChunk(bodyData, mb, chunk);
+        getConn()->write(&mb, chunk, chunkPieces);
+        return;
+    }
 
+    packRange(bodyData, &mb);
     if (mb.contentSize())
         getConn()->write(&mb);
     else
@@ -572,19 +581,31 @@ Http::Stream::prepareReply(HttpReply *rep)
 }
 
 /**
- * Packs bodyData into mb using chunked encoding.
- * Packs the last-chunk if bodyData is empty.
+ * Packs the chunk-size line for bodyData into mb and describes the chunk
+ * data and its CRLF suffix in tail[], to be written after mb (without
+ * copying). Packs the last-chunk if bodyData is empty.
+ * \returns the number of used tail[] entries (at most two)
  */
-void
-Http::Stream::packChunk(const StoreIOBuffer &bodyData, MemBuf &mb)
+int
+Http::Stream::packChunk(const StoreIOBuffer &bodyData, MemBuf &mb, struct iovec *tail)
 {
     const uint64_t length =
         static_cast<uint64_t>(lengthToSend(bodyData.range()));
     noteSentBodyBytes(length);
 
+    static const char crlf[] = "\r\n";
+
     mb.appendf("%" PRIX64 "\r\n", length);
-    mb.append(bodyData.data, length);
-    mb.append("\r\n", 2);
+    int pieces = 0;
+    if (length) {
+        tail[pieces].iov_base = bodyData.data;
+        tail[pieces].iov_len = length;
+        ++pieces;
+    }
+    tail[pieces].iov_base = const_cast<char *>(crlf); // writev(2) does not modify it
+    tail[pieces].iov_len = 2;
+    ++pieces;
+    return pieces;
 }
 
 /**
@@ -161,7 +161,7 @@ public: // HTTP/1.x state data
 
 private:
     void prepareReply(HttpReply *);
-    void packChunk(const StoreIOBuffer &bodyData, MemBuf &);
+    int packChunk(const StoreIOBuffer &bodyData, MemBuf &, struct iovec *tail);
     void packRange(StoreIOBuffer const &, MemBuf *);
     void doClose();
 
@@ -22,6 +22,7 @@
 #include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Loops.h"
+#include "fatal.h"
 #include "fd.h"
 #include "HttpRequest.h"
 #include "icmp/net_db.h"
@@ -31,6 +31,8 @@ Ipc::ReadWriteLock::finalizeExclusive()
     assert(!appending); // nobody can be appending without an exclusive lock
     if (!readLevel) { // no old readers and nobody is becoming a reader
         writing = true;
+        ++version; // odd: warn optimistic readers before we change anything
+        std::atomic_thread_fence(std::memory_order_release);
         return true;
     }
     --writeLevel;
@@ -83,6 +85,7 @@ void
 Ipc::ReadWriteLock::unlockExclusive()
 {
     assert(writing);
+    ++version; // even: publish our changes to optimistic readers
     appending = false;
     writing = false;
     --writeLevel;
@@ -144,6 +147,21 @@ Ipc::ReadWriteLock::stopAppendingAndRestoreExclusive()
     return !readLevel;
 }
 
+bool
+Ipc::ReadWriteLock::startOptimisticRead(uint32_t &startVersion) const
+{
+    startVersion = version.load(std::memory_order_acquire);
+    return !(startVersion & 1);
+}
+
+bool
+Ipc::ReadWriteLock::finishOptimisticRead(const uint32_t startVersion) const
+{
+    // do not let the (relaxed) version load below go before the data reads
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version.load(std::memory_order_relaxed) == startVersion;
+}
+
 void
 Ipc::ReadWriteLock::updateStats(ReadWriteLockStats &stats) const
 {
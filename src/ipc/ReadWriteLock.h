@@ -26,7 +26,7 @@ class ReadWriteLockStats;
 class ReadWriteLock
 {
 public:
-    ReadWriteLock() : readers(0), writing(false), appending(false), readLevel(0), writeLevel(0)
+    ReadWriteLock() : readers(0), writing(false), appending(false), version(0), readLevel(0), writeLevel(0)
     {}
 
     bool lockShared(); ///< lock for reading or return false
@@ -47,6 +47,18 @@ public:
     /// \prec appending is true
     bool stopAppendingAndRestoreExclusive();
 
+    /// Starts reading the protected object without locking it. Unlike shared
+    /// locks, optimistic reads do not modify the lock and, hence, do not
+    /// delay writers. The reader must treat the data it reads as garbage
+    /// until finishOptimisticRead() confirms that no writer was involved.
+    /// \returns false if a writer holds the lock
+    /// \param[out] startVersion is the value to give finishOptimisticRead()
+    bool startOptimisticRead(uint32_t &startVersion) const;
+
+    /// whether no writer has locked the object since the
+    /// startOptimisticRead() call that returned the given version
+    bool finishOptimisticRead(uint32_t startVersion) const;
+
     /// adds approximate current stats to the supplied ones
     void updateStats(ReadWriteLockStats &stats) const;
 
@@ -55,6 +67,9 @@ public:
     std::atomic<bool> writing; ///< there is a writing user (there can be at most 1)
     std::atomic<bool> appending; ///< the writer has promised to only append
     std::atomic_flag updating; ///< a reader is updating metadata/headers
+    /// Odd while a writer holds the lock. Incremented when a writer gets or
+    /// releases the lock, allowing optimistic readers to detect writers.
+    std::atomic<uint32_t> version;
 
 private:
     bool finalizeExclusive();
@@ -493,6 +493,44 @@ Ipc::StoreMap::openForReadingAt(const sfileno fileno, const cache_key *const key
     return &s;
 }
 
+const Ipc::StoreMap::Anchor *
+Ipc::StoreMap::openForOptimisticReading(const cache_key *const key, sfileno &fileno, uint32_t &version) const
+{
+    // validateHit() needs a lock and keeps hit validation statistics
+    if (Config.paranoid_hit_validation.count() && hitValidation)
+        return nullptr;
+
+    const auto idx = fileNoByKey(key);
+    const auto &s = anchorAt(idx);
+    if (!s.lock.startOptimisticRead(version)) {
+        debugs(54, 7, "cannot optimistically open busy entry " << idx << " in " << path);
+        return nullptr;
+    }
+
+    // these checks may see garbage, but closeForOptimisticReading() detects that
+    if (s.empty() || s.waitingToBeFreed || s.writerHalted || !s.sameKey(key))
+        return nullptr;
+
+    debugs(54, 7, "optimistically opened entry " << idx << " version " << version << " in " << path);
+    fileno = idx;
+    return &s;
+}
+
+bool
+Ipc::StoreMap::closeForOptimisticReading(const sfileno fileno, const uint32_t version) const
+{
+    if (anchorAt(fileno).lock.finishOptimisticRead(version))
+        return true;
+    debugs(54, 5, "entry " << fileno << " changed after version " << version << " in " << path);
+    return false;
+}
+
+const Ipc::StoreMap::Slice *
+Ipc::StoreMap::optimisticSlice(const SliceId sliceId) const
+{
+    return validSlice(sliceId) ? &slices->items[sliceId] : nullptr;
+}
+
 void
 Ipc::StoreMap::closeForReading(const sfileno fileno)
 {
@@ -729,6 +767,18 @@ Ipc::StoreMap::importSlice(const SliceId sliceId, const Slice &slice)
     sliceAt(sliceId) = slice;
 }
 
+void
+Ipc::StoreMap::importFileNo(const sfileno name, const sfileno fileno)
+{
+    assert(validEntry(name));
+    assert(validEntry(fileno));
+    // keep the zero item (i.e. "name is fileno") of a never-relocated name
+    if (name != fileno)
+        relocate(name, fileno);
+    else
+        fileNos->items[name] = 0;
+}
+
 int
 Ipc::StoreMap::entryLimit() const
 {
@@ -979,6 +1029,12 @@ void
 Ipc::StoreMapAnchor::exportInto(StoreEntry &into) const
 {
     assert(reading());
+    exportUnlockedInto(into);
+}
+
+void
+Ipc::StoreMapAnchor::exportUnlockedInto(StoreEntry &into) const
+{
     into.timestamp = basics.timestamp;
     into.lastref = basics.lastref;
     into.expires = basics.expires;
@@ -62,6 +62,8 @@ public:
     void set(const StoreEntry &anEntry, const cache_key *aKey = nullptr);
     /// load StoreEntry basics that were previously stored with set()
     void exportInto(StoreEntry &) const;
+    /// exportInto() for optimistic readers that validate the result later
+    void exportUnlockedInto(StoreEntry &) const;
 
     void setKey(const cache_key *const aKey);
     bool sameKey(const cache_key *const aKey) const;
@@ -313,6 +315,17 @@ public:
     /// same as closeForReading() but also frees the entry if it is unlocked
     void closeForReadingAndFreeIdle(const sfileno fileno);
 
+    /// Finds a complete entry with the given key and starts reading it without
+    /// locking the entry (see ReadWriteLock::startOptimisticRead()). Entry
+    /// anchor and slices may change while the caller reads them.
+    /// \returns nil if the entry is missing, incomplete, or otherwise busy
+    const Anchor *openForOptimisticReading(const cache_key *const key, sfileno &fileno, uint32_t &version) const;
+    /// whether the entry opened by openForOptimisticReading() has not changed
+    /// since that call; the caller must not use entry data otherwise
+    bool closeForOptimisticReading(const sfileno fileno, const uint32_t version) const;
+    /// an entry slice for optimistic readers (or nil if sliceId is invalid)
+    const Slice *optimisticSlice(const SliceId sliceId) const;
+
     /// openForReading() but creates a new entry if there is no old one
     const Anchor *openOrCreateForReading(const cache_key *, sfileno &);
 
@@ -348,6 +361,11 @@ public:
     /// copies slice to its designated position
     void importSlice(const SliceId sliceId, const Slice &slice);
 
+    /// the anchor position for the given entry name (e.g., to save the map)
+    sfileno exportFileNo(const sfileno name) const { return fileNoByName(name); }
+    /// restores an exportFileNo() result in a map without entries
+    void importFileNo(const sfileno name, const sfileno fileno);
+
     /* SwapFilenMax limits the number of entries, but not slices or slots */
     bool validEntry(const int n) const; ///< whether n is a valid slice coordinate
     bool validSlice(const int n) const; ///< whether n is a valid slice coordinate
@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "AccessLogEntry.h"
 #include "acl/Checklist.h"
+#include "fatal.h"
 #include "sbuf/Algorithms.h"
 #if USE_ADAPTATION
 #include "adaptation/Config.h"
@@ -35,6 +35,7 @@
 #include "event.h"
 #include "EventLoop.h"
 #include "ExternalACL.h"
+#include "fatal.h"
 #include "fd.h"
 #include "format/Token.h"
 #include "fqdncache.h"
@@ -2117,6 +2118,7 @@ SquidShutdown()
     unlinkdClose();   /* after sync/flush. NOP if !USE_UNLINKD */
 
     storeDirWriteCleanLogs(0);
+    (void)Store::Root().saveMemoryCacheSnapshot();
     PrintRusage();
     dumpMallocStats();
     Store::Root().sync();       /* Flush log writes */
@@ -41,18 +41,13 @@ public:
     virtual size_t getStats(PoolStats &) = 0;
 
     /// provide (and reserve) memory suitable for storing one object
-    void *alloc() {
-        if (++countAlloc == FlushLimit)
-            flushCounters();
-        return allocate();
-    }
+    void *alloc() { return allocate(); }
 
     /// return memory reserved by alloc()
     void freeOne(void *obj) {
         assert(obj != nullptr);
         (void) VALGRIND_CHECK_MEM_IS_ADDRESSABLE(obj, objectSize);
         deallocate(obj);
-        ++countFreeOne;
     }
 
     /// the difference between the number of alloc() and freeOne() calls
@@ -70,8 +65,9 @@ public:
 
     /**
      * Flush temporary counter values into the statistics held in 'meter'.
+     * Allocators shared by several threads override this to synchronize.
      */
-    void flushCounters() {
+    virtual void flushCounters() {
         if (countFreeOne) {
             meter.gb_freed.update(countFreeOne, objectSize);
             countFreeOne = 0;
@@ -116,8 +112,10 @@ public:
 
 protected:
     /// \copydoc void *alloc()
+    /// Also updates countAlloc and countSavedAllocs.
     virtual void *allocate() = 0;
     /// \copydoc void freeOne(void *)
+    /// Also updates countFreeOne.
     virtual void deallocate(void *) = 0;
 
     /**
@@ -12,6 +12,10 @@
 #include "mem/Pool.h"
 #include "mem/Stats.h"
 
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
 void *
 Mem::AllocatorProxy::alloc()
 {
@@ -71,3 +75,13 @@ Mem::AllocatorProxy::getStats(PoolStats &stats)
     return getAllocator()->getStats(stats);
 }
 
+const char *
+Mem::TypeLabel(const std::type_info &type)
+{
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    if (const auto demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status))
+        return demangled; // malloc()ed; never freed
+#endif
+    return type.name();
+}
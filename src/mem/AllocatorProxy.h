@@ -9,10 +9,16 @@
 #ifndef SQUID_SRC_MEM_ALLOCATORPROXY_H
 #define SQUID_SRC_MEM_ALLOCATORPROXY_H
 
+#include <typeinfo>
+
 // XXX: remove AllocatorProxy.h include from mem/forward.h
 namespace Mem {
 class Allocator;
 class PoolStats;
+
+/// A human-readable name of the given type, for labeling its memory pool.
+/// The returned string is never freed.
+const char *TypeLabel(const std::type_info &);
 }
 
 /**
@@ -25,10 +31,22 @@ class PoolStats;
  * responsibility of users to ensure that constructors correctly
  * initialize all data members.
  */
-#define MEMPROXY_CLASS(CLASS) \
+#define MEMPROXY_CLASS(CLASS) MEMPROXY_CLASS_LABELED_(CLASS, #CLASS)
+
+/**
+ * \hideinitializer
+ *
+ * MEMPROXY_CLASS() for use within a class template declaration. The
+ * template source text is the same for all instantiations, so each
+ * instantiation pool is labeled with the name of its instantiated type.
+ */
+#define MEMPROXY_CLASS_TEMPLATE(CLASS) MEMPROXY_CLASS_LABELED_(CLASS, Mem::TypeLabel(typeid(CLASS)))
+
+/// MEMPROXY_CLASS() implementation with the given pool label
+#define MEMPROXY_CLASS_LABELED_(CLASS, LABEL) \
     private: \
     static inline Mem::AllocatorProxy &Pool() { \
-        static Mem::AllocatorProxy thePool(#CLASS, sizeof(CLASS), false); \
+        static Mem::AllocatorProxy thePool(LABEL, sizeof(CLASS), false); \
         return thePool; \
     } \
     public: \
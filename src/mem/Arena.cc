@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 13    High Level Memory Pool Management */
+
+#include "squid.h"
+#include "mem/Arena.h"
+
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+/// a chunk of arena memory, followed by the memory it provides
+class Mem::ArenaBlock
+{
+public:
+    ArenaBlock *next = nullptr; ///< the previously added block of the same arena
+    bool standard = true; ///< whether this block is Arena::BlockSize bytes long
+};
+
+/// the size of the ArenaBlock header, preserving the alignment of the memory after it
+static const size_t HeaderSize = (sizeof(Mem::ArenaBlock) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+/// the maximum number of idle standard blocks kept for future arenas
+static const size_t IdleBlocksMax = 256;
+
+/// idle standard blocks, linked via ArenaBlock::next
+static Mem::ArenaBlock *IdleBlocks = nullptr;
+static size_t IdleBlocksCount = 0;
+
+static Mem::ArenaStats TheStats;
+
+/// \returns the first address at or after the given one with the given alignment
+static char *
+Align(char * const address, const size_t alignment)
+{
+    return address + (-reinterpret_cast<uintptr_t>(address) & (alignment - 1));
+}
+
+/// adds a new block with room for the given (already counted) allocation
+void *
+Mem::Arena::allocateSlowly(const size_t size, const size_t alignment)
+{
+    ArenaBlock *block = nullptr;
+    const auto standard = size + alignment <= BlockSize - HeaderSize;
+    if (standard && IdleBlocks) {
+        block = IdleBlocks;
+        IdleBlocks = block->next;
+        --IdleBlocksCount;
+        ++TheStats.blocksReused;
+    } else {
+        block = static_cast<ArenaBlock *>(xmalloc(standard ? BlockSize : HeaderSize + size + alignment));
+        ++TheStats.blocksAllocated;
+    }
+
+    block->next = head_;
+    block->standard = standard;
+    head_ = block;
+    ++blocks_;
+
+    const auto start = Align(reinterpret_cast<char *>(block) + HeaderSize, alignment);
+    if (standard) {
+        // unlike a large block, a standard one serves future allocations
+        next_ = start + size;
+        end_ = reinterpret_cast<char *>(block) + BlockSize;
+    }
+    return start;
+}
+
+char *
+Mem::Arena::dup(const char * const buf, const size_t size)
+{
+    const auto copy = static_cast<char *>(allocate(size + 1, 1));
+    memcpy(copy, buf, size);
+    copy[size] = '\0';
+    return copy;
+}
+
+void
+Mem::Arena::release()
+{
+    if (allocations_) {
+        ++TheStats.arenas;
+        TheStats.allocations += allocations_;
+        TheStats.bytes += used_;
+        if (TheStats.maxBytes < used_)
+            TheStats.maxBytes = used_;
+
+        auto bin = 0;
+        for (auto limit = size_t(256); used_ >= limit && bin + 1 < ArenaStats::SizeBins; limit *= 2)
+            ++bin;
+        ++TheStats.sizes[bin];
+    }
+
+    while (const auto block = head_) {
+        head_ = block->next;
+        if (block->standard && IdleBlocksCount < IdleBlocksMax) {
+            block->next = IdleBlocks;
+            IdleBlocks = block;
+            ++IdleBlocksCount;
+        } else {
+            xfree(block);
+        }
+    }
+
+    next_ = nullptr;
+    end_ = nullptr;
+    used_ = 0;
+    allocations_ = 0;
+    blocks_ = 0;
+}
+
+const Mem::ArenaStats &
+Mem::ArenaStatistics()
+{
+    return TheStats;
+}
+
+void
+Mem::ArenaReport(std::ostream &os)
+{
+    const auto &stats = TheStats;
+    const auto perArena = [&stats](const uint64_t total) {
+        return stats.arenas ? double(total) / stats.arenas : 0.0;
+    };
+
+    os << "Master transaction arenas:\n" <<
+       "\tReleased arenas: " << stats.arenas << "\n" <<
+       std::fixed << std::setprecision(1) <<
+       "\tAllocations per arena: " << perArena(stats.allocations) << "\n" <<
+       "\tMean arena size: " << perArena(stats.bytes) << " bytes\n" <<
+       "\tLargest arena: " << stats.maxBytes << " bytes\n" <<
+       "\tBlocks allocated: " << stats.blocksAllocated << "\n" <<
+       "\tBlocks reused: " << stats.blocksReused << "\n" <<
+       "\tIdle blocks: " << IdleBlocksCount << "\n" <<
+       "\tArena sizes:\n";
+
+    auto limit = size_t(256);
+    for (auto bin = 0; bin < ArenaStats::SizeBins; ++bin, limit *= 2) {
+        if (bin + 1 < ArenaStats::SizeBins)
+            os << "\t\t< " << std::setw(7) << limit << " bytes: ";
+        else
+            os << "\t\t>= " << std::setw(6) << (limit / 2) << " bytes: ";
+        os << stats.sizes[bin] << "\n";
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
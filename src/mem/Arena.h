@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_MEM_ARENA_H
+#define SQUID_SRC_MEM_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Mem
+{
+
+class ArenaBlock;
+
+/// A bump-pointer allocator for short-lived objects that share one lifetime
+/// (e.g., the lifetime of a master transaction). Individual allocations are
+/// never freed; all arena memory is released at once, when the arena is
+/// destroyed or release()d. Arena memory comes from fixed-size blocks that
+/// are recycled across arenas, so most arenas do not call malloc() at all.
+/// Requests that do not fit a standard block get their own heap block.
+///
+/// Not thread-safe: Arenas and their block cache are meant for the main
+/// thread of a Squid kid process.
+class Arena
+{
+public:
+    Arena() = default;
+    Arena(Arena &&) = delete; // no copying or moving of any kind
+    ~Arena() { release(); }
+
+    /// \returns size bytes of uninitialized memory with the given alignment
+    /// \param alignment a power of two
+    void *allocate(const size_t size, const size_t alignment = alignof(std::max_align_t))
+    {
+        ++allocations_;
+        used_ += size;
+        if (next_) {
+            const auto padding = -reinterpret_cast<uintptr_t>(next_) & (alignment - 1);
+            if (padding + size <= size_t(end_ - next_)) {
+                const auto start = next_ + padding;
+                next_ = start + size;
+                return start;
+            }
+        }
+        return allocateSlowly(size, alignment);
+    }
+
+    /// \returns a 0-terminated copy of the given size bytes of the buffer
+    char *dup(const char *buf, size_t size);
+
+    /// Creates a T object in arena memory. The object destructor is never
+    /// called, so T must not own resources beyond its arena memory.
+    template <class T, class... Args>
+    T *make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are not destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// frees all arena memory, invalidating all previous allocations
+    void release();
+
+    /// the total size of allocate()d memory since the last release()
+    size_t used() const { return used_; }
+
+    /// the number of allocate() calls since the last release()
+    size_t allocations() const { return allocations_; }
+
+    /// the number of blocks currently holding arena memory
+    size_t blocks() const { return blocks_; }
+
+    /// the size of each standard arena block, including block overheads
+    static constexpr size_t BlockSize = 4096;
+
+private:
+    void *allocateSlowly(size_t size, size_t alignment);
+
+    ArenaBlock *head_ = nullptr; ///< the most recently added block (or nil)
+    char *next_ = nullptr; ///< the start of unused memory in a standard block
+    char *end_ = nullptr; ///< the end of that standard block
+
+    size_t used_ = 0;
+    size_t allocations_ = 0;
+    size_t blocks_ = 0;
+};
+
+/// cumulative statistics of released non-empty arenas
+class ArenaStats
+{
+public:
+    /// the number of powers-of-two buckets in the arena size histogram
+    static constexpr int SizeBins = 12;
+
+    uint64_t arenas = 0; ///< the number of released non-empty arenas
+    uint64_t allocations = 0; ///< the total number of Arena::allocate() calls
+    uint64_t bytes = 0; ///< the total volume of allocated arena memory
+    uint64_t maxBytes = 0; ///< the largest used() of a released arena
+    uint64_t blocksAllocated = 0; ///< the number of arena blocks malloc()ed
+    uint64_t blocksReused = 0; ///< the number of arena blocks taken from the block cache
+
+    /// arenas by used() size: [0] counts arenas below 256 bytes, [i]
+    /// counts arenas below 256*2^i bytes, and the last bin counts the rest
+    uint64_t sizes[SizeBins] = {};
+};
+
+/// statistics of all arenas released so far
+const ArenaStats &ArenaStatistics();
+
+/// reports arena statistics for the cache manager mem page
+void ArenaReport(std::ostream &);
+
+} // namespace Mem
+
+#endif /* SQUID_SRC_MEM_ARENA_H */
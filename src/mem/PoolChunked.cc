@@ -14,6 +14,8 @@
 #include "mem/PoolChunked.h"
 #include "mem/Stats.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 
@@ -67,10 +69,59 @@
  *   badly fragmentation is spread across all chunks.
  *
  *   Andres Kroonmaa.
+ *
+ * Magazines:
+ *   Each thread caches a few free objects of each pool in a MemMagazine, a
+ *   short list used as a stack. Allocating and freeing an object usually
+ *   just pops or pushes a list element. When a magazine becomes empty, up
+ *   to half of its capacity is taken from the pool structures described
+ *   above. A full magazine is spliced into the pool freeCache as a whole.
+ *   Both happen under the pool mutex. Magazine objects are
+ *   counted as idle, but pool meters and counters learn about magazine
+ *   allocations only when the magazine and the pool are synchronized. A
+ *   finishing thread returns its magazine objects to their pools. A pool
+ *   being destroyed empties and detaches magazines of all threads.
  */
 
 extern time_t squid_curtime;
 
+/// this thread's magazines, indexed by MemPoolChunked::magazineIndex
+static thread_local MemMagazine *Magazines = nullptr;
+/// the number of Magazines elements
+static thread_local size_t MagazineCount = 0;
+/// whether this thread has returned its magazines and must not make more
+static thread_local bool MagazinesRetired = false;
+
+/// the next MemPoolChunked::magazineIndex value
+static std::atomic<size_t> NextMagazineIndex(0);
+
+/// Protects MemPoolChunked::magazineTables, MemMagazine::pool changes, and
+/// Magazines (re)allocation, so that a pool and a thread that are both
+/// finishing agree on who empties their magazine.
+static std::mutex &
+MagazineTablesMutex()
+{
+    static const auto mutex = new std::mutex(); // may be used after main()
+    return *mutex;
+}
+
+/// returns magazine objects of a finishing thread to their pools
+class MagazineReleaser
+{
+public:
+    ~MagazineReleaser() {
+        const std::lock_guard<std::mutex> lock(MagazineTablesMutex());
+        for (size_t i = 0; i < MagazineCount; ++i) {
+            if (const auto pool = Magazines[i].pool)
+                pool->retireMagazine();
+        }
+        delete[] Magazines;
+        Magazines = nullptr;
+        MagazineCount = 0;
+        MagazinesRetired = true;
+    }
+};
+
 /* local prototypes */
 static int memCompChunks(MemChunk * const &, MemChunk * const &);
 static int memCompObjChunks(void * const &, MemChunk * const &);
@@ -142,7 +193,8 @@ MemPoolChunked::MemPoolChunked(const char *aLabel, size_t aSize) :
     Mem::Allocator(aLabel, aSize),
     chunk_size(0),
     chunk_capacity(0), chunkCount(0), freeCache(nullptr), nextFreeChunk(nullptr),
-    Chunks(nullptr), allChunks(Splay<MemChunk *>())
+    Chunks(nullptr), allChunks(Splay<MemChunk *>()),
+    magazineCapacity(1), magazineIndex(NextMagazineIndex++)
 {
     setChunkSize(MEM_CHUNK_SIZE);
 
@@ -290,16 +342,33 @@ MemPoolChunked::setChunkSize(size_t chunksize)
 
     chunk_capacity = cap;
     chunk_size = csize;
+
+    // do not let idle magazine objects pin down more than one chunk
+    magazineCapacity = std::min(MemMagazine::Capacity, chunk_capacity);
 }
 
 /*
  * warning: we do not clean this entry from Pools assuming destruction
  * is used at the end of the program only
+ *
+ * Other threads may still have magazines for this pool, but they must not
+ * use the pool concurrently with (or after) its destruction.
  */
 MemPoolChunked::~MemPoolChunked()
 {
     MemChunk *chunk, *fchunk;
 
+    {
+        // prevent finishing threads from flushing into a destroyed pool
+        const std::lock_guard<std::mutex> lock(MagazineTablesMutex());
+        for (const auto table: magazineTables) {
+            auto &m = (*table)[magazineIndex];
+            flush(m);
+            m.pool = nullptr;
+        }
+        magazineTables.clear();
+    }
+
     flushCounters();
     clean(0);
     assert(getInUseCount() == 0);
@@ -316,20 +385,203 @@ MemPoolChunked::~MemPoolChunked()
 void *
 MemPoolChunked::allocate()
 {
-    void *p = get();
-    assert(meter.idle.currentLevel() > 0);
-    --meter.idle;
-    ++meter.inuse;
-    return p;
+    const auto m = magazine();
+    if (!m) {
+        const std::lock_guard<std::mutex> lock(depotMutex);
+        ++countAlloc;
+        void *p = get();
+        assert(meter.idle.currentLevel() > 0);
+        --meter.idle;
+        ++meter.inuse;
+        return p;
+    }
+
+    if (!m->count)
+        refill(*m);
+
+    if (++m->allocs >= int(FlushLimit)) {
+        const std::lock_guard<std::mutex> lock(depotMutex);
+        sync(*m);
+    }
+
+    // the link of the last object is stale; m->count guards against using it
+    const auto obj = m->head;
+    (void) VALGRIND_MAKE_MEM_DEFINED(obj, objectSize);
+    m->head = *static_cast<void **>(obj);
+    *static_cast<void **>(obj) = nullptr; // see get()
+    --m->count;
+    return obj;
 }
 
 void
 MemPoolChunked::deallocate(void *obj)
 {
-    push(obj);
-    assert(meter.inuse.currentLevel() > 0);
-    --meter.inuse;
-    ++meter.idle;
+    const auto m = magazine();
+    if (!m) {
+        const std::lock_guard<std::mutex> lock(depotMutex);
+        push(obj);
+        assert(meter.inuse.currentLevel() > 0);
+        --meter.inuse;
+        ++meter.idle;
+        ++countFreeOne;
+        return;
+    }
+
+    // see push() for the reasons behind zeroing
+    if (doZero)
+        memset(obj, 0, objectSize);
+
+    if (m->count >= magazineCapacity)
+        flush(*m);
+
+    *static_cast<void **>(obj) = m->head;
+    m->head = obj;
+    if (!m->count++)
+        m->tail = obj;
+    ++m->frees;
+    (void) VALGRIND_MAKE_MEM_NOACCESS(obj, objectSize);
+}
+
+/// the calling thread's magazine for this pool (or nil if the thread is exiting)
+MemMagazine *
+MemPoolChunked::magazine()
+{
+    if (magazineIndex < MagazineCount) {
+        const auto m = &Magazines[magazineIndex];
+        if (m->pool)
+            return m;
+    }
+    return initMagazine();
+}
+
+/// magazine() helper for the first pool use by the calling thread
+MemMagazine *
+MemPoolChunked::initMagazine()
+{
+    if (MagazinesRetired)
+        return nullptr;
+
+    static thread_local MagazineReleaser Releaser;
+
+    const std::lock_guard<std::mutex> lock(MagazineTablesMutex());
+    if (magazineIndex >= MagazineCount) {
+        const auto newCount = std::max({magazineIndex + 1, MagazineCount * 2, size_t(64)});
+        const auto newMagazines = new MemMagazine[newCount];
+        std::copy(Magazines, Magazines + MagazineCount, newMagazines);
+        delete[] Magazines;
+        Magazines = newMagazines;
+        MagazineCount = newCount;
+    }
+
+    const auto m = &Magazines[magazineIndex];
+    m->pool = this;
+    magazineTables.push_back(&Magazines);
+    return m;
+}
+
+/// empties and forgets the calling thread's magazine for this pool;
+/// requires MagazineTablesMutex()
+void
+MemPoolChunked::retireMagazine()
+{
+    auto &m = Magazines[magazineIndex];
+    flush(m);
+    m.pool = nullptr;
+    magazineTables.erase(std::remove(magazineTables.begin(), magazineTables.end(), &Magazines), magazineTables.end());
+}
+
+/// the calling thread's magazine for this pool (or nil if there is none)
+MemMagazine *
+MemPoolChunked::existingMagazine()
+{
+    if (magazineIndex < MagazineCount && Magazines[magazineIndex].pool == this)
+        return &Magazines[magazineIndex];
+    return nullptr;
+}
+
+/// fills (up to) half of an empty magazine with pool objects
+void
+MemPoolChunked::refill(MemMagazine &m)
+{
+    const std::lock_guard<std::mutex> lock(depotMutex);
+    sync(m);
+
+    const auto batch = std::max(1, magazineCapacity / 2);
+
+    if (!freeCache) {
+        // get() counts pool allocations, but sync() counts magazine allocations
+        const auto savedAllocsBefore = countSavedAllocs;
+        const auto chunksBefore = chunkCount;
+        for (auto i = batch; i > 0; --i)
+            release(get());
+        countSavedAllocs = savedAllocsBefore;
+        m.mallocs += chunkCount - chunksBefore;
+    }
+
+    // detach the first batch of freeCache objects
+    m.head = freeCache;
+    m.count = 0;
+    do {
+        m.tail = freeCache;
+        (void) VALGRIND_MAKE_MEM_DEFINED(freeCache, sizeof(void *));
+        freeCache = *static_cast<void **>(freeCache);
+        (void) VALGRIND_MAKE_MEM_NOACCESS(m.tail, objectSize);
+    } while (++m.count < batch && freeCache);
+}
+
+/// returns all magazine objects to the pool freeCache
+void
+MemPoolChunked::flush(MemMagazine &m)
+{
+    const std::lock_guard<std::mutex> lock(depotMutex);
+    sync(m);
+
+    if (!m.count)
+        return;
+
+    // keep the most recently freed objects in front
+    (void) VALGRIND_MAKE_MEM_DEFINED(m.tail, sizeof(void *));
+    *static_cast<void **>(m.tail) = freeCache;
+    (void) VALGRIND_MAKE_MEM_NOACCESS(m.tail, objectSize);
+    freeCache = m.head;
+    m.head = m.tail = nullptr;
+    m.count = 0;
+}
+
+/// updates pool statistics with magazine activity; requires depotMutex
+void
+MemPoolChunked::sync(MemMagazine &m)
+{
+    const auto inUseDelta = m.allocs - m.frees;
+    if (inUseDelta > 0) {
+        meter.idle -= inUseDelta;
+        meter.inuse += inUseDelta;
+    } else if (inUseDelta < 0) {
+        meter.inuse -= -inUseDelta;
+        meter.idle += -inUseDelta;
+    }
+
+    countAlloc += m.allocs;
+    countFreeOne += m.frees;
+    // each chunk created by refill() cost a malloc()
+    if (m.allocs > m.mallocs) {
+        countSavedAllocs += m.allocs - m.mallocs;
+        m.mallocs = 0;
+    } else {
+        m.mallocs -= m.allocs;
+    }
+    m.allocs = 0;
+    m.frees = 0;
+}
+
+/// push() for an already zeroed (if needed) object
+void
+MemPoolChunked::release(void *obj)
+{
+    (void) VALGRIND_MAKE_MEM_DEFINED(obj, sizeof(void *));
+    *static_cast<void **>(obj) = freeCache;
+    freeCache = obj;
+    (void) VALGRIND_MAKE_MEM_NOACCESS(obj, objectSize);
 }
 
 void
@@ -360,6 +612,14 @@ MemPoolChunked::convertFreeCacheToChunkFreeCache()
 /* removes empty Chunks from pool */
 void
 MemPoolChunked::clean(time_t maxage)
+{
+    const std::lock_guard<std::mutex> lock(depotMutex);
+    cleanLocked(maxage);
+}
+
+/// clean() implementation; requires depotMutex
+void
+MemPoolChunked::cleanLocked(time_t maxage)
 {
     MemChunk *chunk, *freechunk, *listTail;
     time_t age;
@@ -367,7 +627,7 @@ MemPoolChunked::clean(time_t maxage)
     if (!Chunks)
         return;
 
-    flushCounters();
+    Allocator::flushCounters();
     convertFreeCacheToChunkFreeCache();
     /* Now we have all chunks in this pool cleared up, all free items returned to their home */
     /* We start now checking all chunks to see if we can release any */
@@ -422,6 +682,16 @@ MemPoolChunked::clean(time_t maxage)
     return;
 }
 
+void
+MemPoolChunked::flushCounters()
+{
+    const auto m = existingMagazine();
+    const std::lock_guard<std::mutex> lock(depotMutex);
+    if (m)
+        sync(*m);
+    Allocator::flushCounters();
+}
+
 bool
 MemPoolChunked::idleTrigger(int shift) const
 {
@@ -435,7 +705,12 @@ MemPoolChunked::getStats(Mem::PoolStats &stats)
     int chunks_free = 0;
     int chunks_partial = 0;
 
-    clean((time_t) 555555); /* don't want to get chunks released before reporting */
+    // report accurate levels, at least for single-threaded programs
+    if (const auto m = existingMagazine())
+        flush(*m);
+
+    const std::lock_guard<std::mutex> lock(depotMutex);
+    cleanLocked((time_t) 555555); /* don't want to get chunks released before reporting */
 
     stats.pool = this;
     stats.label = label;
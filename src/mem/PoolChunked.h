@@ -12,16 +12,21 @@
 #include "mem/Allocator.h"
 #include "splay.h"
 
+#include <mutex>
+#include <vector>
+
 #define MEM_CHUNK_SIZE        4 * 4096  /* 16KB ... 4 * VM_PAGE_SZ */
 #define MEM_CHUNK_MAX_SIZE  256 * 1024  /* 2MB */
 
 class MemChunk;
+class MemMagazine;
 
 /// \ingroup MemPoolsAPI
 class MemPoolChunked : public Mem::Allocator
 {
 public:
     friend class MemChunk;
+    friend class MagazineReleaser;
     MemPoolChunked(const char *label, size_t obj_size);
     ~MemPoolChunked() override;
     void convertFreeCacheToChunkFreeCache();
@@ -29,7 +34,11 @@ public:
     void *get();
     void push(void *obj);
 
+    /// returns all objects cached in the given magazine to this pool
+    void flush(MemMagazine &);
+
     /* Mem::Allocator API */
+    void flushCounters() override;
     size_t getStats(Mem::PoolStats &) override;
     void setChunkSize(size_t) override;
     bool idleTrigger(int) const override;
@@ -40,6 +49,16 @@ protected:
     void *allocate() override;
     void deallocate(void *) override;
 
+private:
+    MemMagazine *magazine();
+    MemMagazine *initMagazine();
+    MemMagazine *existingMagazine();
+    void refill(MemMagazine &);
+    void sync(MemMagazine &);
+    void retireMagazine();
+    void release(void *obj);
+    void cleanLocked(time_t);
+
 public:
     size_t chunk_size;
     int chunk_capacity;
@@ -48,6 +67,19 @@ public:
     MemChunk *nextFreeChunk;
     MemChunk *Chunks;
     Splay<MemChunk *> allChunks;
+
+    /// the maximum number of objects cached in each MemMagazine of this pool
+    int magazineCapacity;
+    /// this pool's position in per-thread magazine tables
+    const size_t magazineIndex;
+    /// protects pool structures shared by threads (i.e. all but magazines
+    /// and magazineTables), including Mem::Allocator counters
+    std::mutex depotMutex;
+
+private:
+    /// per-thread magazine tables with a magazine for this pool;
+    /// guarded by the global magazine tables mutex (see PoolChunked.cc)
+    std::vector<MemMagazine * const *> magazineTables;
 };
 
 /// \ingroup MemPoolsAPI
@@ -65,5 +97,26 @@ public:
     MemPoolChunked *pool;
 };
 
+/// \ingroup MemPoolsAPI
+/// A small per-thread stack of free objects in front of a MemPoolChunked.
+/// Serves allocations without locking or walking pool free lists.
+/// Refilled from (and drained to) the pool free cache in batches.
+class MemMagazine
+{
+public:
+    /// the maximum number of objects a magazine of any pool can cache
+    static constexpr int Capacity = 32;
+
+    MemPoolChunked *pool = nullptr; ///< the pool that cached objects belong to
+    int count = 0; ///< the number of cached objects
+    int allocs = 0; ///< allocations since the last pool sync()
+    int frees = 0; ///< deallocations since the last pool sync()
+    int mallocs = 0; ///< pool chunks created for refills since the last pool sync()
+    /// cached objects linked through their first word, like the pool
+    /// freeCache; the first one is the most recently freed
+    void *head = nullptr;
+    void *tail = nullptr; ///< the least recently freed cached object
+};
+
 #endif /* SQUID_SRC_MEM_POOLCHUNKED_H */
 
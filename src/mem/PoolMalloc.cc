@@ -23,6 +23,9 @@ extern time_t squid_curtime;
 void *
 MemPoolMalloc::allocate()
 {
+    if (++countAlloc == FlushLimit)
+        flushCounters();
+
     void *obj = nullptr;
     if (!freelist.empty()) {
         obj = freelist.top();
@@ -60,6 +63,7 @@ MemPoolMalloc::deallocate(void *obj)
         ++meter.idle;
         freelist.push(obj);
     }
+    ++countFreeOne;
 }
 
 /* TODO extract common logic to MemAllocate */
@@ -17,6 +17,7 @@
 #include "icmp/net_db.h"
 #include "md5.h"
 #include "mem/Allocator.h"
+#include "mem/Arena.h"
 #include "mem/Pool.h"
 #include "mem/Stats.h"
 #include "MemBuf.h"
@@ -615,5 +616,8 @@ Mem::Report(std::ostream &stream)
     stream << "Total Pools created: " << poolCount << "\n";
     stream << "Pools ever used:     " << poolCount - not_used << " (shown above)\n";
     stream << "Currently in use:    " << poolsInUse << "\n";
+
+    stream << "\n";
+    ArenaReport(stream);
 }
 
@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "base/RegexPattern.h"
 #include "debug/Messages.h"
+#include "fatal.h"
 #include "fde.h"
 #include "fs_io.h"
 #include "globals.h"
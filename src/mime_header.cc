@@ -16,51 +16,28 @@
 size_t
 headersEnd(const char *mime, size_t l, bool &containsObsFold)
 {
-    size_t e = 0;
-    int state = 1;
     containsObsFold = false;
 
-    while (e < l && state < 3) {
-        switch (state) {
-
-        case 0:
-
-            if ('\n' == mime[e])
-                state = 1;
-
-            break;
-
-        case 1:
-            if ('\r' == mime[e])
-                state = 2;
-            else if ('\n' == mime[e])
-                state = 3;
-            else if (' ' == mime[e] || '\t' == mime[e]) {
-                containsObsFold = true;
-                state = 0;
-            } else
-                state = 0;
-
-            break;
-
-        case 2:
-            if ('\n' == mime[e])
-                state = 3;
-            else
-                state = 0;
-
-            break;
-
-        default:
-            break;
+    // jump from one line start to the next using (vectorized) memchr(3)
+    size_t e = 0; // the start of the current line
+    while (e < l) {
+        if (mime[e] == '\n')
+            return e + 1; // LF-terminated empty line
+        if (mime[e] == '\r') {
+            if (e + 1 >= l)
+                return 0; // need more data to check for CRLF
+            if (mime[e + 1] == '\n')
+                return e + 2; // CRLF-terminated empty line
+        } else if (mime[e] == ' ' || mime[e] == '\t') {
+            containsObsFold = true;
         }
 
-        ++e;
+        const auto lf = static_cast<const char *>(memchr(mime + e, '\n', l - e));
+        if (!lf)
+            break;
+        e = lf - mime + 1;
     }
 
-    if (3 == state)
-        return e;
-
     return 0;
 }
 
@@ -13,7 +13,9 @@
 #endif
 
 #include "squid.h"
+#include "base/AhoCorasick.h"
 #include "base/PackableStream.h"
+#include "base/RunnersRegistry.h"
 #include "HttpHdrCc.h"
 #include "HttpReply.h"
 #include "HttpRequest.h"
@@ -25,6 +27,8 @@
 #include "Store.h"
 #include "util.h"
 
+#include <vector>
+
 typedef enum {
     rcHTTP,
     rcICP,
@@ -84,6 +88,93 @@ static int refreshStaleness(const StoreEntry * entry, time_t check_time, const t
 
 static RefreshPattern DefaultRefresh(nullptr);
 
+/// Speeds up refresh_pattern lookups by scanning the URL once for literal
+/// strings required by rule regexes. Rules whose required literal is absent
+/// from the URL cannot match and are not given to regexec(3). Rules are still
+/// checked in the configured order, and their statistics are updated as if
+/// each rule were tested.
+class RefreshMatcher
+{
+public:
+    /// (re)indexes the given refresh_pattern list
+    void reset(const RefreshPattern *rules);
+
+    /// whether we have indexed the given refresh_pattern list
+    bool indexes(const RefreshPattern *rules) const { return rules && rules == head; }
+
+    /// refreshLimits() implementation for the indexed list
+    const RefreshPattern *match(const char *url);
+
+private:
+    /// marks a rule without a usable required literal
+    static constexpr AhoCorasick::Id NoLiteral = UINT32_MAX;
+
+    /// the first rule of the indexed list
+    const RefreshPattern *head = nullptr;
+
+    /// required literals of all indexed rules
+    AhoCorasick literals;
+
+    /// the required literal of each indexed rule (or NoLiteral), in rule order
+    std::vector<AhoCorasick::Id> ruleLiterals;
+
+    /// the last match() generation that found the corresponding literal
+    std::vector<uint64_t> seenLiterals;
+
+    /// the number of match() calls, used to avoid clearing seenLiterals
+    uint64_t generation = 0;
+};
+
+static RefreshMatcher TheRefreshMatcher;
+
+void
+RefreshMatcher::reset(const RefreshPattern * const rules)
+{
+    head = rules;
+    literals = AhoCorasick();
+    ruleLiterals.clear();
+    seenLiterals.clear();
+    generation = 0;
+
+    size_t indexed = 0;
+    for (auto R = rules; R; R = R->next) {
+        const auto literal = R->regex().requiredLiteral();
+        if (literal.isEmpty()) {
+            ruleLiterals.push_back(NoLiteral);
+        } else {
+            ruleLiterals.push_back(literals.add(literal));
+            ++indexed;
+        }
+    }
+    literals.compile();
+    seenLiterals.resize(literals.size(), 0);
+
+    debugs(22, 3, "indexed " << indexed << " out of " << ruleLiterals.size() << " rules using " << literals.size() << " literals");
+}
+
+const RefreshPattern *
+RefreshMatcher::match(const char * const url)
+{
+    ++generation;
+    literals.find(url, strlen(url), [this](const AhoCorasick::Id id, size_t) {
+        seenLiterals[id] = generation;
+        return true;
+    });
+
+    auto literal = ruleLiterals.cbegin();
+    for (auto R = head; R; R = R->next, ++literal) {
+        ++(R->stats.matchTests);
+        if (*literal != NoLiteral && seenLiterals[*literal] != generation)
+            continue; // cannot match
+        if (R->regex().match(url)) {
+            ++(R->stats.matchCount);
+            return R;
+        }
+    }
+
+    return nullptr;
+}
+
 /** Locate the first refresh_pattern rule that matches the given URL by regex.
  *
  * \return A pointer to the refresh_pattern parameters to use, or nullptr if there is no match.
@@ -91,6 +182,9 @@ static RefreshPattern DefaultRefresh(nullptr);
 const RefreshPattern *
 refreshLimits(const char *url)
 {
+    if (TheRefreshMatcher.indexes(Config.Refresh))
+        return TheRefreshMatcher.match(url);
+
     for (auto R = Config.Refresh; R; R = R->next) {
         ++(R->stats.matchTests);
         if (R->regex().match(url)) {
@@ -756,6 +850,18 @@ refreshRegisterWithCacheManager(void)
     Mgr::RegisterAction("refresh", "Refresh Algorithm Statistics", refreshStats, 0, 1);
 }
 
+/// reacts to RegisteredRunner events relevant to this module
+class RefreshRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override { TheRefreshMatcher.reset(Config.Refresh); }
+    void startReconfigure() override { TheRefreshMatcher.reset(nullptr); }
+    void syncConfig() override { TheRefreshMatcher.reset(Config.Refresh); }
+};
+
+DefineRunnerRegistrator(RefreshRr);
+
 void
 refreshInit(void)
 {
@@ -18,6 +18,7 @@
  */
 
 #include "squid.h"
+#include "fatal.h"
 #include "heap.h"
 #include "MemObject.h"
 #include "Store.h"
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 81    Store W-TinyLFU Removal Policy */
+
+#include "squid.h"
+#include "repl/tinylfu/WTinyLfu.h"
+
+#include <algorithm>
+#include <limits>
+
+/// the protected segment share of the main segment, in percents
+static const size_t ProtectedPercent = 80;
+
+/* WTinyLfu::List */
+
+void
+WTinyLfu::List::pushBack(Node &node)
+{
+    node.prev = tail;
+    node.next = nullptr;
+    if (tail)
+        tail->next = &node;
+    else
+        head = &node;
+    tail = &node;
+    ++count;
+}
+
+void
+WTinyLfu::List::erase(Node &node)
+{
+    if (node.prev)
+        node.prev->next = node.next;
+    else
+        head = node.next;
+    if (node.next)
+        node.next->prev = node.prev;
+    else
+        tail = node.prev;
+    node.prev = node.next = nullptr;
+    assert(count > 0);
+    --count;
+}
+
+/* WTinyLfu */
+
+WTinyLfu::WTinyLfu(const int windowPercent):
+    windowPercent_(std::clamp(windowPercent, 1, 100)),
+    capacity_(std::numeric_limits<size_t>::max())
+{
+}
+
+/// the maximum number of window entries that need not compete for space
+size_t
+WTinyLfu::windowLimit() const
+{
+    return std::max<size_t>(1, count_ * windowPercent_ / 100);
+}
+
+void
+WTinyLfu::link(Node &node, const Segment segment)
+{
+    assert(segment > sgNone && segment < sgEnd);
+    node.segment = segment;
+    lists_[segment].pushBack(node);
+    ++count_;
+}
+
+/// removes the node from its list but remembers its segment for restore()
+void
+WTinyLfu::unlink(Node &node)
+{
+    assert(node.segment > sgNone && node.segment < sgEnd);
+    lists_[node.segment].erase(node);
+    assert(count_ > 0);
+    --count_;
+}
+
+void
+WTinyLfu::add(Node &node, const uint64_t hash)
+{
+    assert(node.segment == sgNone);
+
+    // the sketch should have roughly one counter per entry in each row
+    if (count_ >= sketch_.width() && sketch_.width() < Store::FrequencySketch::MaxWidth)
+        sketch_.resize(2 * (count_ + 1));
+
+    node.hash = hash;
+    sketch_.record(hash);
+    link(node, sgWindow);
+    admitOverflow();
+}
+
+/// while the cache is not full, moves window overflow to the main segment
+/// without forcing those entries to compete with the main segment ones
+void
+WTinyLfu::admitOverflow()
+{
+    auto &window = lists_[sgWindow];
+    while (count_ < capacity_ && window.count > windowLimit()) {
+        auto &node = *window.head;
+        unlink(node);
+        link(node, sgProbation);
+    }
+}
+
+void
+WTinyLfu::touch(Node &node)
+{
+    sketch_.record(node.hash);
+    if (node.segment == sgProbation) {
+        unlink(node);
+        link(node, sgProtected);
+        shrinkProtected();
+    } else {
+        requeue(node);
+    }
+}
+
+void
+WTinyLfu::requeue(Node &node)
+{
+    auto &list = lists_[node.segment];
+    list.erase(node);
+    list.pushBack(node);
+}
+
+/// demotes the least recently used protected entries to keep the protected
+/// segment within its share of the main segment
+void
+WTinyLfu::shrinkProtected()
+{
+    auto &protectedList = lists_[sgProtected];
+    const auto mainCount = lists_[sgProbation].count + protectedList.count;
+    const auto limit = mainCount * ProtectedPercent / 100;
+    while (protectedList.count > limit) {
+        auto &node = *protectedList.head;
+        unlink(node);
+        link(node, sgProbation);
+    }
+}
+
+void
+WTinyLfu::remove(Node &node)
+{
+    unlink(node);
+    node.segment = sgNone;
+}
+
+WTinyLfu::Node *
+WTinyLfu::evict()
+{
+    capacity_ = count_;
+
+    const auto &window = lists_[sgWindow];
+    const auto candidate = window.count > windowLimit() ? window.head : nullptr;
+    auto victim = lists_[sgProbation].head ? lists_[sgProbation].head : lists_[sgProtected].head;
+
+    if (candidate && victim) {
+        // the window candidate replaces the main segment victim only if the
+        // candidate is more popular; ties favor the incumbent
+        if (sketch_.frequency(candidate->hash) > sketch_.frequency(victim->hash)) {
+            unlink(*candidate);
+            link(*candidate, sgProbation);
+        } else {
+            victim = candidate;
+        }
+    } else if (!victim) {
+        victim = window.head;
+    }
+
+    if (victim)
+        unlink(*victim);
+    return victim;
+}
+
+void
+WTinyLfu::restore(Node &node)
+{
+    assert(!node.prev && !node.next);
+    link(node, node.segment);
+}
+
+WTinyLfu::Node *
+WTinyLfu::walk(const Node * const previous) const
+{
+    if (previous && previous->next)
+        return previous->next;
+
+    auto segment = previous ? previous->segment + 1 : sgWindow;
+    for (; segment < sgEnd; ++segment) {
+        if (const auto head = lists_[segment].head)
+            return head;
+    }
+    return nullptr;
+}
+
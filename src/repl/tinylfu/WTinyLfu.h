@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_REPL_TINYLFU_WTINYLFU_H
+#define SQUID_SRC_REPL_TINYLFU_WTINYLFU_H
+
+#include "store/FrequencySketch.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/// Eviction order of the W-TinyLFU policy. New entries enter a small LRU
+/// "window". Entries leaving the window compete with the least valuable
+/// entry of the main segmented LRU (probation and protected segments): the
+/// entry recorded more often by the frequency sketch stays. Thus, a burst of
+/// one-hit wonders (e.g., a large scan) only churns the window.
+///
+/// This class knows nothing about StoreEntry and cache capacity: the caller
+/// decides when to evict() and what to do with evicted entries.
+class WTinyLfu
+{
+public:
+    /// where an entry currently lives
+    enum Segment { sgNone = 0, sgWindow, sgProbation, sgProtected, sgEnd };
+
+    /// the caller-allocated part of each tracked entry
+    class Node
+    {
+    public:
+        Node *prev = nullptr; ///< the next less recently used node
+        Node *next = nullptr; ///< the next more recently used node
+        uint64_t hash = 0; ///< the entry identity for the frequency sketch
+        Segment segment = sgNone;
+    };
+
+    /// \param windowPercent the window share of all tracked entries;
+    /// 100 results in plain LRU order (with an unused frequency sketch)
+    explicit WTinyLfu(int windowPercent = 1);
+
+    WTinyLfu(WTinyLfu &&) = delete; // no copying or moving
+
+    /// starts tracking a new entry; counts as an entry access
+    void add(Node &, uint64_t hash);
+
+    /// updates the position of an accessed entry
+    void touch(Node &);
+
+    /// adjusts recency of a tracked entry without counting an access
+    void requeue(Node &);
+
+    /// stops tracking the given entry
+    void remove(Node &);
+
+    /// stops tracking and returns the least valuable entry (or nil)
+    Node *evict();
+
+    /// resumes tracking of an evict()ed entry that cannot be evicted now
+    void restore(Node &);
+
+    /// iterates all tracked entries, starting with nil
+    Node *walk(const Node *previous) const;
+
+    size_t count() const { return count_; } ///< the number of tracked entries
+    size_t count(const Segment segment) const { return lists_[segment].count; }
+
+    const Store::FrequencySketch &sketch() const { return sketch_; }
+
+private:
+    /// a doubly-linked list of nodes, from the least to the most recently used
+    class List
+    {
+    public:
+        void pushBack(Node &);
+        void erase(Node &);
+
+        Node *head = nullptr; ///< the least recently used node
+        Node *tail = nullptr; ///< the most recently used node
+        size_t count = 0;
+    };
+
+    void link(Node &, Segment);
+    void unlink(Node &);
+    void admitOverflow();
+    void shrinkProtected();
+    size_t windowLimit() const;
+
+    List lists_[sgEnd];
+    size_t count_ = 0; ///< the number of tracked entries
+    const int windowPercent_; ///< see the constructor
+
+    /// the number of entries when evict() was called last time (i.e. cache
+    /// capacity as far as we know); below that, the window spills freely
+    size_t capacity_;
+
+    Store::FrequencySketch sketch_;
+};
+
+#endif /* SQUID_SRC_REPL_TINYLFU_WTINYLFU_H */
+
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 81    Store W-TinyLFU Removal Policy */
+
+#include "squid.h"
+#include "debug/Stream.h"
+#include "fatal.h"
+#include "MemObject.h"
+#include "repl/tinylfu/WTinyLfu.h"
+#include "Store.h"
+#include "wordlist.h"
+
+#include <cstring>
+
+REMOVALPOLICYCREATE createRemovalPolicy_tinylfu;
+
+/// a StoreEntry tracked by a W-TinyLFU policy
+class TinyLfuNode: public WTinyLfu::Node
+{
+    MEMPROXY_CLASS(TinyLfuNode);
+
+public:
+    explicit TinyLfuNode(StoreEntry *anEntry): entry(anEntry) {}
+
+    StoreEntry *entry;
+};
+
+struct TinyLfuPolicyData {
+    explicit TinyLfuPolicyData(const int windowPercent): order(windowPercent) {}
+
+    void setPolicyNode(StoreEntry *, void *) const;
+
+    WTinyLfu order;
+    int nwalkers = 0;
+    enum heap_entry_type {
+        TYPE_UNKNOWN = 0, TYPE_STORE_ENTRY, TYPE_STORE_MEM
+    } type = TYPE_UNKNOWN;
+};
+
+/* Hack to avoid having to remember the RemovalPolicyNode location.
+ * Needed by the purge walker to clear the policy information
+ */
+static enum TinyLfuPolicyData::heap_entry_type
+repl_guessType(StoreEntry * entry, RemovalPolicyNode * node)
+{
+    if (node == &entry->repl)
+        return TinyLfuPolicyData::TYPE_STORE_ENTRY;
+
+    if (entry->mem_obj && node == &entry->mem_obj->repl)
+        return TinyLfuPolicyData::TYPE_STORE_MEM;
+
+    fatal("W-TinyLFU Replacement: Unknown StoreEntry node type");
+
+    return TinyLfuPolicyData::TYPE_UNKNOWN;
+}
+
+void
+TinyLfuPolicyData::setPolicyNode(StoreEntry *entry, void *value) const
+{
+    switch (type) {
+
+    case TYPE_STORE_ENTRY:
+        entry->repl.data = value;
+        break ;
+
+    case TYPE_STORE_MEM:
+        entry->mem_obj->repl.data = value ;
+        break ;
+
+    default:
+        break;
+    }
+}
+
+/// the frequency sketch identity of the given entry
+static uint64_t
+tinylfu_hash(const StoreEntry *entry)
+{
+    if (entry->key)
+        return Store::FrequencySketch::Hash(static_cast<const cache_key *>(entry->key));
+    return reinterpret_cast<uintptr_t>(entry); // should not happen
+}
+
+static void
+tinylfu_add(RemovalPolicy * policy, StoreEntry * entry, RemovalPolicyNode * node)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    assert(!node->data);
+    const auto tinylfu_node = new TinyLfuNode(entry);
+    node->data = tinylfu_node;
+    data->order.add(*tinylfu_node, tinylfu_hash(entry));
+
+    if (!data->type)
+        data->type = repl_guessType(entry, node);
+}
+
+static void
+tinylfu_remove(RemovalPolicy * policy, StoreEntry * entry, RemovalPolicyNode * node)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    TinyLfuNode *tinylfu_node = (TinyLfuNode *)node->data;
+
+    if (!tinylfu_node)
+        return;
+
+    assert(tinylfu_node->entry == entry);
+    node->data = nullptr;
+    data->order.remove(*tinylfu_node);
+    delete tinylfu_node;
+}
+
+static void
+tinylfu_referenced(RemovalPolicy * policy, const StoreEntry * entry,
+                   RemovalPolicyNode * node)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    TinyLfuNode *tinylfu_node = (TinyLfuNode *)node->data;
+
+    if (!tinylfu_node)
+        return;
+
+    // the entry key may have changed since tinylfu_add()
+    tinylfu_node->hash = tinylfu_hash(entry);
+    data->order.touch(*tinylfu_node);
+}
+
+/// unlike tinylfu_referenced(), does not count as another entry access
+static void
+tinylfu_dereferenced(RemovalPolicy * policy, const StoreEntry *,
+                     RemovalPolicyNode * node)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    TinyLfuNode *tinylfu_node = (TinyLfuNode *)node->data;
+
+    if (!tinylfu_node)
+        return;
+
+    data->order.requeue(*tinylfu_node);
+}
+
+/** RemovalPolicyWalker **/
+
+struct TinyLfuWalkData {
+    const WTinyLfu::Node *current = nullptr;
+};
+
+static const StoreEntry *
+tinylfu_walkNext(RemovalPolicyWalker * walker)
+{
+    TinyLfuWalkData *tinylfu_walk = (TinyLfuWalkData *)walker->_data;
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)walker->_policy->_data;
+    const auto next = data->order.walk(tinylfu_walk->current);
+
+    if (!next)
+        return nullptr;
+
+    tinylfu_walk->current = next;
+
+    return static_cast<const TinyLfuNode *>(next)->entry;
+}
+
+static void
+tinylfu_walkDone(RemovalPolicyWalker * walker)
+{
+    RemovalPolicy *policy = walker->_policy;
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    assert(strcmp(policy->_type, "tinylfu") == 0);
+    assert(data->nwalkers > 0);
+    data->nwalkers -= 1;
+    delete (TinyLfuWalkData *)walker->_data;
+    delete walker;
+}
+
+static RemovalPolicyWalker *
+tinylfu_walkInit(RemovalPolicy * policy)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    data->nwalkers += 1;
+    RemovalPolicyWalker *walker = new RemovalPolicyWalker;
+    walker->_policy = policy;
+    walker->_data = new TinyLfuWalkData;
+    walker->Next = tinylfu_walkNext;
+    walker->Done = tinylfu_walkDone;
+    return walker;
+}
+
+/** RemovalPurgeWalker **/
+
+static StoreEntry *
+tinylfu_purgeNext(RemovalPurgeWalker * walker)
+{
+    RemovalPolicy *policy = walker->_policy;
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+
+    while (walker->scanned < walker->max_scan) {
+        const auto victim = static_cast<TinyLfuNode *>(data->order.evict());
+        if (!victim)
+            return nullptr;
+
+        walker->scanned += 1;
+
+        StoreEntry *entry = victim->entry;
+        if (entry->locked()) {
+            /* we cannot return this one; make it the most recently used */
+            ++ walker->locked;
+            data->order.restore(*victim);
+            continue;
+        }
+
+        delete victim;
+        data->setPolicyNode(entry, nullptr);
+        return entry;
+    }
+
+    return nullptr;
+}
+
+static void
+tinylfu_purgeDone(RemovalPurgeWalker * walker)
+{
+    RemovalPolicy *policy = walker->_policy;
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    assert(strcmp(policy->_type, "tinylfu") == 0);
+    assert(data->nwalkers > 0);
+    data->nwalkers -= 1;
+    delete walker;
+}
+
+static RemovalPurgeWalker *
+tinylfu_purgeInit(RemovalPolicy * policy, int max_scan)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    data->nwalkers += 1;
+    RemovalPurgeWalker *walker = new RemovalPurgeWalker;
+    walker->_policy = policy;
+    walker->_data = nullptr;
+    walker->max_scan = max_scan;
+    walker->Next = tinylfu_purgeNext;
+    walker->Done = tinylfu_purgeDone;
+    return walker;
+}
+
+static void
+tinylfu_stats(RemovalPolicy * policy, StoreEntry * sentry)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    const auto &order = data->order;
+    storeAppendPrintf(sentry, "W-TinyLFU entries: %zu (window: %zu, probation: %zu, protected: %zu)\n",
+                      order.count(),
+                      order.count(WTinyLfu::sgWindow),
+                      order.count(WTinyLfu::sgProbation),
+                      order.count(WTinyLfu::sgProtected));
+    storeAppendPrintf(sentry, "W-TinyLFU sketch width: %zu, memory: %zu bytes, agings: %" PRIu64 "\n",
+                      order.sketch().width(), order.sketch().memoryUsed(), order.sketch().agings());
+}
+
+static void
+tinylfu_free(RemovalPolicy * policy)
+{
+    TinyLfuPolicyData *data = (TinyLfuPolicyData *)policy->_data;
+    /* Make some verification of the policy state */
+    assert(strcmp(policy->_type, "tinylfu") == 0);
+    assert(!data->nwalkers);
+    /* Ok, time to destroy this policy */
+    delete data;
+    memset(policy, 0, sizeof(*policy));
+    delete policy;
+}
+
+RemovalPolicy *
+createRemovalPolicy_tinylfu(wordlist * args)
+{
+    int windowPercent = 1;
+
+    for (; args; args = args->next) {
+        const char *value = nullptr;
+        if (strncmp(args->key, "window=", 7) == 0)
+            value = args->key + 7;
+
+        char *end = nullptr;
+        const auto parsed = value ? strtol(value, &end, 10) : 0;
+        if (!value || end == value || (*end && strcmp(end, "%") != 0) || parsed < 1 || parsed > 100) {
+            debugs(81, DBG_CRITICAL, "ERROR: createRemovalPolicy_tinylfu: Ignoring unsupported option '" << args->key << "'" <<
+                   Debug::Extra << "supported options: window=<1-100>%");
+            continue;
+        }
+        windowPercent = static_cast<int>(parsed);
+    }
+
+    RemovalPolicy *policy = new RemovalPolicy;
+
+    /* Populate the policy structure */
+    policy->_type = "tinylfu";
+
+    policy->_data = new TinyLfuPolicyData(windowPercent);
+
+    policy->Free = tinylfu_free;
+
+    policy->Add = tinylfu_add;
+
+    policy->Remove = tinylfu_remove;
+
+    policy->Referenced = tinylfu_referenced;
+
+    policy->Dereferenced = tinylfu_dereferenced;
+
+    policy->WalkInit = tinylfu_walkInit;
+
+    policy->PurgeInit = tinylfu_purgeInit;
+
+    policy->Stats = tinylfu_stats;
+
+    return policy;
+}
+
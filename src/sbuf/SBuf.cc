@@ -731,13 +731,10 @@ SBuf::findFirstOf(const CharacterSet &set, size_type startPos) const
         return npos;
 
     debugs(24, 7, "first of characterset " << set.name << " in id " << id);
-    char *cur = buf()+startPos;
     const char *bufend = bufEnd();
-    while (cur < bufend) {
-        if (set[*cur])
-            return cur-buf();
-        ++cur;
-    }
+    const auto found = set.findFirstIn(buf()+startPos, bufend);
+    if (found < bufend)
+        return found-buf();
     debugs(24, 7, "not found");
     return npos;
 }
@@ -754,13 +751,10 @@ SBuf::findFirstNotOf(const CharacterSet &set, size_type startPos) const
         return npos;
 
     debugs(24, 7, "first not of characterset " << set.name << " in id " << id);
-    char *cur = buf()+startPos;
     const char *bufend = bufEnd();
-    while (cur < bufend) {
-        if (!set[*cur])
-            return cur-buf();
-        ++cur;
-    }
+    const auto found = set.findFirstNotIn(buf()+startPos, bufend);
+    if (found < bufend)
+        return found-buf();
     debugs(24, 7, "not found");
     return npos;
 }
@@ -75,6 +75,13 @@ public:
         Comm::Write(clientConnection, mb, writer);
     }
 
+    /// schedule a gathered Comm::Write() of mb content followed by iov buffers
+    void write(MemBuf *mb, const struct iovec *iov, int iovcnt) {
+        typedef CommCbMemFunT<Server, CommIoCbParams> Dialer;
+        writer = JobCallback(33, 5, Dialer, this, Server::clientWriteDone);
+        Comm::Write(clientConnection, mb, iov, iovcnt, writer);
+    }
+
     /// schedule some data for a Comm::Write()
     void write(char *buf, int len) {
         typedef CommCbMemFunT<Server, CommIoCbParams> Dialer;
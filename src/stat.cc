@@ -10,6 +10,8 @@
 
 #include "squid.h"
 #include "AccessLogEntry.h"
+#include "base/AsyncCallQueue.h"
+#include "base/PackableStream.h"
 #include "CacheDigest.h"
 #include "CachePeer.h"
 #include "CachePeers.h"
@@ -1160,6 +1162,14 @@ DumpAvgStat(Mgr::IntervalActionData& stats, StoreEntry* sentry)
     storeAppendPrintf(sentry, "cpu_usage = %f%%\n", Math::doublePercent(stats.cpu_time, stats.wall_time));
 }
 
+/// reports AsyncCallQueue dispatch statistics
+static void
+statAsyncCalls(StoreEntry *sentry)
+{
+    PackableStream os(*sentry);
+    AsyncCallQueue::Instance().reportStats(os);
+}
+
 static void
 statRegisterWithCacheManager(void)
 {
@@ -1198,6 +1208,8 @@ statRegisterWithCacheManager(void)
 #endif
     Mgr::RegisterAction("openfd_objects", "Objects with Swapout files open",
                         statOpenfdObj, 0, 0);
+    Mgr::RegisterAction("async_calls", "Async Call Dispatch Statistics",
+                        statAsyncCalls, 0, 1);
 #if STAT_GRAPHS
     Mgr::RegisterAction("graph_variables", "Display cache metrics graphically",
                         statGraphDump, 0, 1);
@@ -9,12 +9,15 @@
 /* DEBUG: section 19    Store Memory Primitives */
 
 #include "squid.h"
+#include "fatal.h"
 #include "Generic.h"
 #include "HttpReply.h"
 #include "mem_node.h"
 #include "MemObject.h"
 #include "stmem.h"
 
+#include <algorithm>
+
 /*
  * NodeGet() is called to get the data buffer to pass to storeIOWrite().
  * By setting the write_pending flag here we are assuming that there
@@ -33,10 +36,8 @@ mem_hdr::NodeGet(mem_node * aNode)
 int64_t
 mem_hdr::lowestOffset () const
 {
-    const SplayNode<mem_node *> *theStart = nodes.start();
-
-    if (theStart)
-        return theStart->data->nodeBuffer.offset;
+    if (!nodes.empty())
+        return nodes.front()->nodeBuffer.offset;
 
     return 0;
 }
@@ -45,10 +46,10 @@ int64_t
 mem_hdr::endOffset () const
 {
     int64_t result = 0;
-    const SplayNode<mem_node *> *theEnd = nodes.finish();
 
-    if (theEnd)
-        result = theEnd->data->dataRange().end;
+    // nodes do not overlap so the last node ends last
+    if (!nodes.empty())
+        result = nodes.back()->dataRange().end;
 
     assert (result == inmem_hi);
 
@@ -58,21 +59,24 @@ mem_hdr::endOffset () const
 void
 mem_hdr::freeContent()
 {
-    nodes.destroy();
+    for (const auto node: nodes)
+        delete node;
+    nodes.clear();
     inmem_hi = 0;
     debugs(19, 9, this << " hi: " << inmem_hi);
 }
 
 bool
-mem_hdr::unlink(mem_node *aNode)
+mem_hdr::unlinkFirst()
 {
+    const auto aNode = nodes.front();
     if (aNode->write_pending) {
         debugs(0, DBG_CRITICAL, "ERROR: cannot unlink mem_node " << aNode << " while write_pending");
         return false;
     }
 
     debugs(19, 8, this << " removing " << aNode);
-    nodes.remove (aNode, NodeCompare);
+    nodes.pop_front();
     delete aNode;
     return true;
 }
@@ -82,16 +86,11 @@ mem_hdr::freeDataUpto(int64_t target_offset)
 {
     debugs(19, 8, this << " up to " << target_offset);
     /* keep the last one to avoid change to other part of code */
-    SplayNode<mem_node*> const * theStart;
-
-    while ((theStart = nodes.start())) {
-        if (theStart == nodes.finish())
+    while (nodes.size() > 1) {
+        if (nodes.front()->end() > target_offset)
             break;
 
-        if (theStart->data->end() > target_offset )
-            break;
-
-        if (!unlink(theStart->data))
+        if (!unlinkFirst())
             break;
     }
 
@@ -124,10 +123,44 @@ mem_hdr::writeAvailable(mem_node *aNode, int64_t location, size_t amount, char c
     return copyLen;
 }
 
+/// inserts a new (empty) node, preserving nodes order
 void
 mem_hdr::appendNode (mem_node *aNode)
 {
-    nodes.insert (aNode, NodeCompare);
+    // the common case: objects are stored front to back
+    if (nodes.empty() || nodes.back()->start() < aNode->start()) {
+        nodes.push_back(aNode);
+        return;
+    }
+
+    const auto pos = std::upper_bound(nodes.begin(), nodes.end(), aNode,
+    [](const mem_node *left, const mem_node *right) { return *left < *right; });
+    nodes.insert(pos, aNode);
+}
+
+/// \returns the position of the node containing the given location or, if
+/// there is no such node, nodes.end()
+mem_hdr::Nodes::const_iterator
+mem_hdr::findNode(const int64_t location) const
+{
+    if (nodes.empty() || location < nodes.front()->start())
+        return nodes.end();
+
+    // O(1) for the common case of full pages stored back to back
+    const auto pageIndex = static_cast<uint64_t>(location - nodes.front()->start()) / SM_PAGE_SIZE;
+    if (pageIndex < nodes.size()) {
+        const auto guess = nodes.begin() + pageIndex;
+        if ((*guess)->contains(location))
+            return guess;
+    }
+
+    // sparse or partially filled pages: find the last node starting at or
+    // before location and check whether it covers that location
+    auto pos = std::upper_bound(nodes.begin(), nodes.end(), location,
+    [](const int64_t loc, const mem_node *node) { return loc < node->start(); });
+    assert(pos != nodes.begin()); // because front() starts at or before location
+    --pos;
+    return (*pos)->contains(location) ? pos : nodes.end();
 }
 
 /* returns a mem_node that contains location..
@@ -136,15 +169,8 @@ mem_hdr::appendNode (mem_node *aNode)
 mem_node *
 mem_hdr::getBlockContainingLocation (int64_t location) const
 {
-    // Optimize: do not create a whole mem_node just to store location
-    mem_node target (location);
-    target.nodeBuffer.length = 1;
-    mem_node *const *result = nodes.find (&target, NodeCompare);
-
-    if (result)
-        return *result;
-
-    return nullptr;
+    const auto pos = findNode(location);
+    return pos == nodes.end() ? nullptr : *pos;
 }
 
 size_t
@@ -172,7 +198,7 @@ mem_hdr::debugDump() const
     debugs (19, 0, "mem_hdr::debugDump: lowest offset: " << lowestOffset() << " highest offset + 1: " << endOffset() << ".");
     std::ostringstream result;
     PointerPrinter<mem_node *> foo(result, " - ");
-    getNodes().visit(foo);
+    std::for_each(nodes.begin(), nodes.end(), foo);
     debugs (19, 0, "mem_hdr::debugDump: Current available data is: " << result.str() << ".");
 }
 
@@ -192,7 +218,7 @@ mem_hdr::copy(StoreIOBuffer const &target) const
 
     /* we shouldn't ever ask for absent offsets */
 
-    if (nodes.size() == 0) {
+    if (nodes.empty()) {
         debugs(19, DBG_IMPORTANT, "mem_hdr::copy: No data to read");
         debugDump();
         assert (0);
@@ -203,9 +229,9 @@ mem_hdr::copy(StoreIOBuffer const &target) const
     assert(target.length > 0);
 
     /* Seek our way into store */
-    mem_node *p = getBlockContainingLocation(target.offset);
+    auto pos = findNode(target.offset);
 
-    if (!p) {
+    if (pos == nodes.end()) {
         debugs(19, DBG_IMPORTANT, "ERROR: memCopy: could not find start of " << target.range() <<
                " in memory.");
         debugDump();
@@ -220,8 +246,8 @@ mem_hdr::copy(StoreIOBuffer const &target) const
     /* Start copying beginning with this block until
      * we're satiated */
 
-    while (p && bytes_to_go > 0) {
-        size_t bytes_to_copy = copyAvailable (p,
+    while (pos != nodes.end() && bytes_to_go > 0) {
+        size_t bytes_to_copy = copyAvailable (*pos,
                                               location, bytes_to_go, ptr_to_buf);
 
         /* hit a sparse patch */
@@ -235,7 +261,10 @@ mem_hdr::copy(StoreIOBuffer const &target) const
 
         bytes_to_go -= bytes_to_copy;
 
-        p = getBlockContainingLocation(location);
+        // the next page, if any, usually continues where this one ended
+        ++pos;
+        if (pos != nodes.end() && !(*pos)->contains(location))
+            pos = findNode(location);
     }
 
     return target.length - bytes_to_go;
@@ -260,9 +289,18 @@ bool
 mem_hdr::unionNotEmpty(StoreIOBuffer const &candidate)
 {
     assert (candidate.offset >= 0);
-    mem_node target(candidate.offset);
-    target.nodeBuffer.length = candidate.length;
-    return nodes.find (&target, NodeCompare);
+    const auto candidateRange = candidate.range();
+    if (!candidateRange.size())
+        return false;
+
+    // the last node starting before the candidate end is the only node that
+    // may overlap the candidate without also covering candidate.offset
+    auto pos = std::lower_bound(nodes.begin(), nodes.end(), candidateRange.end,
+    [](const mem_node *node, const int64_t end) { return node->start() < end; });
+    if (pos == nodes.begin())
+        return false;
+    --pos;
+    return (*pos)->dataRange().intersection(candidateRange).size() > 0;
 }
 
 mem_node *
@@ -270,22 +308,16 @@ mem_hdr::nodeToRecieve(int64_t offset)
 {
     /* case 1: Nothing in memory */
 
-    if (!nodes.size()) {
+    if (nodes.empty()) {
         appendNode (new mem_node(offset));
-        return nodes.start()->data;
+        return nodes.front();
     }
 
     mem_node *candidate = nullptr;
     /* case 2: location fits within an extant node */
 
-    if (offset > 0) {
-        mem_node search (offset - 1);
-        search.nodeBuffer.length = 1;
-        mem_node *const *leadup =  nodes.find (&search, NodeCompare);
-
-        if (leadup)
-            candidate = *leadup;
-    }
+    if (offset > 0)
+        candidate = getBlockContainingLocation(offset - 1);
 
     if (candidate && candidate->canAccept(offset))
         return candidate;
@@ -339,27 +371,11 @@ mem_hdr::~mem_hdr()
     freeContent();
 }
 
-/* splay of mem nodes:
- * conditions:
- * a = b if a.intersection(b).size > 0;
- * a < b if a < b
- */
-int
-mem_hdr::NodeCompare(mem_node * const &left, mem_node * const &right)
-{
-    // possibly Range can help us at some point.
-
-    if (left->dataRange().intersection(right->dataRange()).size() > 0)
-        return 0;
-
-    return *left < *right ? -1 : 1;
-}
-
 void
 mem_hdr::dump() const
 {
-    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.start() " << nodes.start());
-    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.finish() " << nodes.finish());
+    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.front() " << (nodes.empty() ? nullptr : nodes.front()));
+    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.back() " << (nodes.empty() ? nullptr : nodes.back()));
 }
 
 size_t
@@ -368,7 +384,7 @@ mem_hdr::size() const
     return nodes.size();
 }
 
-const Splay<mem_node *> &
+const mem_hdr::Nodes &
 mem_hdr::getNodes() const
 {
     return nodes;
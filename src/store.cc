@@ -19,6 +19,7 @@
 #include "comm/Connection.h"
 #include "comm/Read.h"
 #include "debug/Messages.h"
+#include "fatal.h"
 #if HAVE_DISKIO_MODULE_IPCIO
 #include "DiskIO/IpcIo/IpcIoFile.h"
 #endif
@@ -44,6 +45,7 @@
 #include "store/Controller.h"
 #include "store/Disk.h"
 #include "store/Disks.h"
+#include "store/KeyIndex.h"
 #include "store/SwapMetaOut.h"
 #include "store_digest.h"
 #include "store_key_md5.h"
@@ -143,6 +145,19 @@ StatQueues(StoreEntry *e)
     stream.flush();
 }
 
+/// starts saving the shared memory cache for the next Squid instance
+static void
+SaveMemoryCacheSnapshot(StoreEntry *e)
+{
+    assert(e);
+    PackableStream stream(*e);
+    if (Store::Root().startSavingMemoryCacheSnapshot())
+        stream << "Saving memory_cache_snapshot; see cache.log for progress.\n";
+    else
+        stream << "This process does not save memory_cache_snapshot files.\n";
+    stream.flush();
+}
+
 // XXX: new/delete operators need to be replaced with MEMPROXY_CLASS
 // definitions but doing so exposes bug 4370, and maybe 4354 and 4355
 void *
@@ -420,20 +435,22 @@ destroyStoreEntry(void *data)
 
 /* ----- INTERFACE BETWEEN STORAGE MANAGER AND HASH TABLE FUNCTIONS --------- */
 
+Store::EntryIndex *store_table = nullptr;
+
 void
 StoreEntry::hashInsert(const cache_key * someKey)
 {
     debugs(20, 3, "StoreEntry::hashInsert: Inserting Entry " << *this << " key '" << storeKeyText(someKey) << "'");
     assert(!key);
     key = storeKeyDup(someKey);
-    hash_join(store_table, this);
+    store_table->insert(someKey, this);
 }
 
 void
 StoreEntry::hashDelete()
 {
     if (key) { // some test cases do not create keys and do not hashInsert()
-        hash_remove_link(store_table, this);
+        store_table->erase(static_cast<const cache_key *>(key), this);
         storeKeyFree((const cache_key *)key);
         key = nullptr;
     }
@@ -565,7 +582,7 @@ StoreEntry::setPrivateKey(const bool shareable, const bool permanent)
         mem_obj->id = getKeyCounter();
     const cache_key *newkey = storeKeyPrivate();
 
-    assert(hash_lookup(store_table, newkey) == nullptr);
+    assert(!store_table->find(newkey));
     EBIT_SET(flags, KEY_PRIVATE);
     shareableWhenPrivate = shareable;
     hashInsert(newkey);
@@ -628,7 +645,7 @@ StoreEntry::forcePublicKey(const cache_key *newkey)
     debugs(20, 3, storeKeyText(newkey) << " for " << *this);
     assert(mem_obj);
 
-    if (StoreEntry *e2 = (StoreEntry *)hash_lookup(store_table, newkey)) {
+    if (const auto e2 = store_table->find(newkey)) {
         assert(e2 != this);
         debugs(20, 3, "releasing clashing " << *e2);
         e2->release(true);
@@ -1251,6 +1268,8 @@ storeRegisterWithCacheManager(void)
     Mgr::RegisterAction("store_check_cachable_stats", "storeCheckCachable() Stats",
                         storeCheckCachableStats, 0, 1);
     Mgr::RegisterAction("store_queues", "SMP Transients and Caching Queues", StatQueues, 0, 1);
+    Mgr::RegisterAction("memory_cache_snapshot", "Save Shared Memory Cache Snapshot",
+                        SaveMemoryCacheSnapshot, 1, 1);
 }
 
 void
@@ -16,6 +16,7 @@
 #include "store/Controller.h"
 #include "store/Disks.h"
 #include "store/forward.h"
+#include "store/KeyIndex.h"
 #include "store/LocalSearch.h"
 #include "tools.h"
 #include "Transients.h"
@@ -134,6 +135,9 @@ Store::Controller::stat(StoreEntry &output) const
     storeAppendPrintf(&output, "Store Directory Statistics:\n");
     storeAppendPrintf(&output, "Store Entries          : %lu\n",
                       (unsigned long int)StoreEntry::inUseCount());
+    if (store_table)
+        storeAppendPrintf(&output, "Store Index Entries    : %zu (%zu slots)\n",
+                          store_table->size(), store_table->capacity());
     storeAppendPrintf(&output, "Maximum Swap Size      : %" PRIu64 " KB\n",
                       maxSize() >> 10);
     storeAppendPrintf(&output, "Current Store Swap Size: %.2f KB\n",
@@ -199,6 +203,35 @@ Store::Controller::configure()
     const int64_t memMax = static_cast<int64_t>(min(Config.Store.maxInMemObjSize, Config.memMaxSize));
     const int64_t disksMax = disks->maxObjectSize();
     store_maxobjsize = std::max(disksMax, memMax);
+
+    if (Config.Store.admissionMinFrequency > FrequencySketch::MaxFrequency) {
+        debugs(20, DBG_IMPORTANT, "WARNING: cache_admission_min_frequency " <<
+               Config.Store.admissionMinFrequency << " exceeds the maximum supported value; using " <<
+               int(FrequencySketch::MaxFrequency));
+        Config.Store.admissionMinFrequency = FrequencySketch::MaxFrequency;
+    }
+    if (Config.Store.admissionMinFrequency > 0) {
+        // roughly one sketch counter per cachable object
+        const auto cacheSize = maxSize() + (sharedMemStore ? Config.memMaxSize : 0);
+        admissionSketch_.resize(cacheSize / std::max(Config.Store.avgObjectSize, int64_t(1)));
+        debugs(20, 3, "admission sketch width: " << admissionSketch_.width() <<
+               ", memory: " << admissionSketch_.memoryUsed() << " bytes");
+    }
+}
+
+bool
+Store::Controller::admits(const StoreEntry &e) const
+{
+    if (Config.Store.admissionMinFrequency <= 0)
+        return true;
+
+    const auto key = e.publicKey();
+    if (!key)
+        return false; // private entries are not going to be shared anyway
+
+    const auto frequency = admissionSketch_.frequency(key);
+    debugs(20, 7, "frequency " << int(frequency) << " of " << e);
+    return frequency >= Config.Store.admissionMinFrequency;
 }
 
 StoreSearch *
@@ -216,6 +249,18 @@ Store::Controller::sync(void)
     disks->sync();
 }
 
+bool
+Store::Controller::startSavingMemoryCacheSnapshot()
+{
+    return sharedMemStore && sharedMemStore->startSavingSnapshot();
+}
+
+bool
+Store::Controller::saveMemoryCacheSnapshot()
+{
+    return sharedMemStore && sharedMemStore->saveSnapshot();
+}
+
 /*
  * handle callbacks all available fs'es
  */
@@ -342,6 +387,9 @@ Store::Controller::checkFoundCandidate(const StoreEntry &entry) const
 StoreEntry *
 Store::Controller::find(const cache_key *key)
 {
+    if (Config.Store.admissionMinFrequency > 0)
+        admissionSketch_.record(key);
+
     if (const auto entry = peek(key)) {
         try {
             if (!entry->key)
@@ -395,7 +443,7 @@ Store::Controller::findCallbackXXX(const cache_key *key)
     // member or use an HTCP/ICP-specific index rather than store_table.
 
     // cannot reuse peekAtLocal() because HTCP/ICP callbacks may use private keys
-    return static_cast<StoreEntry*>(hash_lookup(store_table, key));
+    return store_table->find(key);
 }
 
 /// \returns either an existing local reusable StoreEntry object or nil
@@ -404,7 +452,7 @@ Store::Controller::findCallbackXXX(const cache_key *key)
 StoreEntry *
 Store::Controller::peekAtLocal(const cache_key *key)
 {
-    if (StoreEntry *e = static_cast<StoreEntry*>(hash_lookup(store_table, key))) {
+    if (const auto e = store_table->find(key)) {
         // callers must only search for public entries
         assert(!EBIT_TEST(e->flags, KEY_PRIVATE));
         assert(e->publicKey());
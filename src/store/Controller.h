@@ -9,6 +9,7 @@
 #ifndef SQUID_SRC_STORE_CONTROLLER_H
 #define SQUID_SRC_STORE_CONTROLLER_H
 
+#include "store/FrequencySketch.h"
 #include "store/Storage.h"
 
 class MemObject;
@@ -76,6 +77,21 @@ public:
     /// update configuration, including limits (re)calculation
     void configure();
 
+    /// whether a shared memory cache or a rock cache_dir may store the entry,
+    /// given how often its key was looked up recently by this worker
+    /// \sa cache_admission_min_frequency
+    bool admits(const StoreEntry &) const;
+
+    /// starts saving shared memory cache entries for the next Squid instance
+    /// without blocking other main loop activities
+    /// \returns whether this process is responsible for such snapshots
+    bool startSavingMemoryCacheSnapshot();
+
+    /// saves shared memory cache entries for the next Squid instance,
+    /// finishing startSavingMemoryCacheSnapshot() work (if any)
+    /// \returns whether this process is responsible for such snapshots
+    bool saveMemoryCacheSnapshot();
+
     /// called when the entry is no longer needed by any transaction
     void handleIdleEntry(StoreEntry &);
 
@@ -161,6 +177,9 @@ private:
 
     /// Hack: Relays page shortage from freeMemorySpace() to handleIdleEntry().
     int memoryPagesDebt_ = 0;
+
+    /// recent find() key frequencies for admits()
+    FrequencySketch admissionSketch_;
 };
 
 /// safely access controller singleton
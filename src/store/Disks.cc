@@ -14,12 +14,14 @@
 #include "ConfigParser.h"
 #include "debug/Messages.h"
 #include "debug/Stream.h"
+#include "fatal.h"
 #include "globals.h"
 #include "sbuf/Stream.h"
 #include "SquidConfig.h"
 #include "Store.h"
 #include "store/Disk.h"
 #include "store/Disks.h"
+#include "store/KeyIndex.h"
 #include "store_rebuild.h"
 #include "StoreFileSystem.h"
 #include "swap_log_op.h"
@@ -266,10 +268,10 @@ Store::Disks::init()
     /* Calculate size of hash table (maximum currently 64k buckets).  */
     /* this is very bogus, its specific to the any Store maintaining an
      * in-core index, not global */
-    size_t buckets = (Store::Root().maxSize() + Config.memMaxSize) / Config.Store.avgObjectSize;
+    const size_t expectedObjects = (Store::Root().maxSize() + Config.memMaxSize) / Config.Store.avgObjectSize;
     debugs(20, Important(31), "Swap maxSize " << (Store::Root().maxSize() >> 10) <<
-           " + " << ( Config.memMaxSize >> 10) << " KB, estimated " << buckets << " objects");
-    buckets /= Config.Store.objectsPerBucket;
+           " + " << ( Config.memMaxSize >> 10) << " KB, estimated " << expectedObjects << " objects");
+    size_t buckets = expectedObjects / Config.Store.objectsPerBucket;
     debugs(20, Important(32), "Target number of buckets: " << buckets);
     /* ideally the full scan period should be configurable, for the
      * moment it remains at approximately 24 hours.  */
@@ -279,8 +281,9 @@ Store::Disks::init()
            (Config.memShared ? " [shared]" : ""));
     debugs(20, Important(35), "Max Swap size: " << (Store::Root().maxSize() >> 10) << " KB");
 
-    store_table = hash_create(storeKeyHashCmp,
-                              store_hash_buckets, storeKeyHashHash);
+    // size the index for the estimated number of objects so that the cache
+    // does not have to grow it while the index is being loaded and filled
+    store_table = new Store::EntryIndex(expectedObjects);
 
     // Increment _before_ any possible storeRebuildComplete() calls so that
     // storeRebuildComplete() can reliably detect when all disks are done. The
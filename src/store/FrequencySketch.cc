@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "store/FrequencySketch.h"
+
+#include <algorithm>
+#include <cstring>
+
+/// per-row seeds that turn one hash into Depth independent ones
+static const uint64_t RowSeeds[] = {
+    0xc3a5c85c97cb3127ULL,
+    0xb492b66fbe98f273ULL,
+    0x9ae16a3b2f90404fULL,
+    0xcbf29ce484222325ULL
+};
+
+Store::FrequencySketch::FrequencySketch(const size_t expectedEntries)
+{
+    resize(expectedEntries);
+}
+
+void
+Store::FrequencySketch::resize(const size_t expectedEntries)
+{
+    // a power of two at least as large as the number of entries, but not
+    // too large: huge caches get a less accurate sketch instead of hundreds
+    // of megabytes of counters
+    size_t newWidth = CountersPerWord;
+    while (newWidth < expectedEntries && newWidth < MaxWidth)
+        newWidth <<= 1;
+
+    if (!counters_.empty() && newWidth == width())
+        return;
+
+    const auto newRowWords = newWidth / CountersPerWord;
+    if (counters_.empty() || newWidth < width()) {
+        counters_.assign(Depth * newRowWords, 0);
+        additions_ = 0;
+    } else {
+        // After doubling the width, a hash counter index is either the old
+        // index or the old index plus the old width. Copying each row into
+        // both halves of the wider row preserves all estimates. Rows start
+        // at word boundaries, so whole words can be copied.
+        const auto oldRowWords = width() / CountersPerWord;
+        std::vector<uint64_t> wider(Depth * newRowWords);
+        for (int row = 0; row < Depth; ++row) {
+            const auto source = counters_.begin() + row * oldRowWords;
+            for (size_t offset = 0; offset < newRowWords; offset += oldRowWords)
+                std::copy(source, source + oldRowWords, wider.begin() + row * newRowWords + offset);
+        }
+        counters_.swap(wider);
+    }
+    widthMask_ = newWidth - 1;
+    sampleSize_ = 10 * static_cast<uint64_t>(newWidth);
+}
+
+/// the position of the given hash counter in the given row
+size_t
+Store::FrequencySketch::counterIndex(const uint64_t hash, const int row) const
+{
+    // a 64-bit finalizer from MurmurHash3
+    auto h = hash ^ RowSeeds[row];
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return row * width() + (h & widthMask_);
+}
+
+/// the value of the counter at the given position
+uint8_t
+Store::FrequencySketch::counter(const size_t index) const
+{
+    const auto shift = (index % CountersPerWord) * 4;
+    return (counters_[index / CountersPerWord] >> shift) & 0xF;
+}
+
+void
+Store::FrequencySketch::record(const uint64_t hash)
+{
+    size_t indexes[Depth];
+    auto minimum = MaxFrequency;
+    for (int row = 0; row < Depth; ++row) {
+        indexes[row] = counterIndex(hash, row);
+        minimum = std::min(minimum, counter(indexes[row]));
+    }
+
+    // conservative update: only the counters defining the estimate grow;
+    // a counter below MaxFrequency cannot carry into its neighbor
+    if (minimum < MaxFrequency) {
+        for (const auto index: indexes) {
+            if (counter(index) == minimum)
+                counters_[index / CountersPerWord] += uint64_t(1) << ((index % CountersPerWord) * 4);
+        }
+    }
+
+    if (++additions_ >= sampleSize_)
+        age();
+}
+
+uint8_t
+Store::FrequencySketch::frequency(const uint64_t hash) const
+{
+    auto minimum = MaxFrequency;
+    for (int row = 0; row < Depth; ++row)
+        minimum = std::min(minimum, counter(counterIndex(hash, row)));
+    return minimum;
+}
+
+/// halves all counters so that recent occurrences weigh more
+void
+Store::FrequencySketch::age()
+{
+    // shift all packed counters at once, dropping the bits that each
+    // counter would otherwise receive from its higher neighbor
+    for (auto &word: counters_)
+        word = (word >> 1) & 0x7777777777777777ULL;
+    additions_ /= 2;
+    ++agings_;
+}
+
+uint64_t
+Store::FrequencySketch::Hash(const cache_key * const key)
+{
+    // cache keys are MD5 digests, so any of their bytes are well mixed
+    uint64_t hash = 0;
+    memcpy(&hash, key, sizeof(hash));
+    return hash;
+}
+
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_FREQUENCYSKETCH_H
+#define SQUID_SRC_STORE_FREQUENCYSKETCH_H
+
+#include "store/forward.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Store
+{
+
+/// Approximately counts recent occurrences of cache keys (or other 64-bit
+/// hashes) using a count-min sketch with 4-bit saturating counters. After
+/// every sampleSize() recorded occurrences, all counters are halved so that
+/// old popularity fades away. This is the frequency filter of the TinyLFU
+/// admission policy (Einziger, Friedman, and Manes, ACM ToS 2017).
+class FrequencySketch
+{
+public:
+    /// the largest frequency() value
+    static constexpr uint8_t MaxFrequency = 15;
+
+    /// the largest width(), limiting the sketch to 32 MB
+    static constexpr size_t MaxWidth = size_t(1) << 24;
+
+    /// creates a sketch suitable for tracking the given number of entries
+    explicit FrequencySketch(size_t expectedEntries = 0);
+
+    /// adjusts the sketch for the given number of entries (up to MaxWidth);
+    /// growing preserves frequency estimates while shrinking forgets everything
+    void resize(size_t expectedEntries);
+
+    /// counts one more occurrence of the given hash
+    void record(uint64_t hash);
+    void record(const cache_key *key) { record(Hash(key)); }
+
+    /// an estimate of recorded occurrences of the given hash, not exceeding
+    /// MaxFrequency; never underestimates (except due to aging)
+    uint8_t frequency(uint64_t hash) const;
+    uint8_t frequency(const cache_key *key) const { return frequency(Hash(key)); }
+
+    /// the number of counters in each sketch row
+    size_t width() const { return widthMask_ + 1; }
+
+    /// the number of bytes occupied by the counters
+    size_t memoryUsed() const { return counters_.size() * sizeof(uint64_t); }
+
+    /// the number of record() calls that trigger counter aging
+    uint64_t sampleSize() const { return sampleSize_; }
+
+    /// the number of times the counters were halved
+    uint64_t agings() const { return agings_; }
+
+    /// a sketch-friendly summary of an (MD5-based) cache key
+    static uint64_t Hash(const cache_key *);
+
+private:
+    /// the number of rows (i.e. hash functions)
+    static constexpr int Depth = 4;
+
+    /// the number of 4-bit counters packed into each counters_ word
+    static constexpr int CountersPerWord = 16;
+
+    size_t counterIndex(uint64_t hash, int row) const;
+    uint8_t counter(size_t index) const;
+    void age();
+
+    /// Depth rows of width() counters each, CountersPerWord in each word
+    std::vector<uint64_t> counters_;
+    size_t widthMask_ = 0; ///< width() - 1; width() is a power of two
+    uint64_t sampleSize_ = 0; ///< see sampleSize()
+    uint64_t additions_ = 0; ///< record() calls since the last aging, halved
+    uint64_t agings_ = 0; ///< see agings()
+};
+
+} // namespace Store
+
+#endif /* SQUID_SRC_STORE_FREQUENCYSKETCH_H */
+
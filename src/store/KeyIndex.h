@@ -0,0 +1,458 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_KEYINDEX_H
+#define SQUID_SRC_STORE_KEYINDEX_H
+
+#include "base/Assure.h"
+#include "store/forward.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Store
+{
+
+/// An index of Value objects by their 16-byte (MD5) cache keys. Each shard
+/// of the index is an open-addressing hash table that keeps keys next to
+/// their Value pointers, so that lookups do not dereference Value objects.
+/// Table slots are probed in groups of 16, using SIMD instructions where
+/// available.
+///
+/// A shard that runs out of room does not rehash all of its entries at once.
+/// Instead, it starts using a new table and moves a few entries from its old
+/// table during each subsequent insert() or erase() call. Lookups check both
+/// tables while entries are being moved.
+///
+/// The index does not own Value objects and never dereferences them.
+template <class Value>
+class KeyIndex
+{
+public:
+    /// A visitSome() position. The index may be modified between
+    /// visitSome() calls. Entries added or removed during iteration may or
+    /// may not be visited. Other entries are visited at least once: Entries
+    /// moved to a new shard table during iteration may be visited twice, and
+    /// a shard that starts growing while being visited is visited again.
+    class Cursor
+    {
+    public:
+        /// whether all index positions have been visited
+        bool done() const { return shard_ >= ShardCount; }
+
+    private:
+        friend class KeyIndex;
+
+        size_t shard_ = 0;
+        bool inPrevious_ = true; ///< whether we are visiting the old shard table
+        size_t slot_ = 0;
+        uint64_t generation_ = 0; ///< Shard::generation when we started visiting it
+    };
+
+    /// \param expectedSize the number of entries that would fit without growth
+    explicit KeyIndex(size_t expectedSize = 0);
+    KeyIndex(KeyIndex &&) = delete; // no copying or moving of any kind
+
+    /// \returns the value indexed by the given key (or nil)
+    Value *find(const cache_key *) const;
+
+    /// indexes the value by the given key, which must not be indexed already
+    void insert(const cache_key *, Value *);
+
+    /// forgets the given value indexed by the given key
+    /// \returns whether the value was indexed
+    bool erase(const cache_key *, const Value *);
+
+    /// the number of indexed values
+    size_t size() const { return size_; }
+
+    /// the total number of slots in all shard tables
+    size_t capacity() const;
+
+    /// Calls visitor(Value *) for indexed values in the next few index
+    /// positions and advances the cursor. Visitors must not modify the index.
+    template <class Visitor>
+    void visitSome(Cursor &, Visitor &&) const;
+
+private:
+    static constexpr int ShardBits = 4;
+    static constexpr size_t ShardCount = size_t(1) << ShardBits;
+    static constexpr size_t GroupSize = 16;
+
+    /// control byte values for slots that do not hold a value; values of
+    /// used slots are 7-bit hash fragments (see ControlOf())
+    static constexpr uint8_t Empty = 0x80;
+    static constexpr uint8_t Deleted = 0xFE;
+
+    /// the number of old table slots moved during each modification
+    static constexpr size_t MigrationStep = 2 * GroupSize;
+
+    /// a table position
+    class Slot
+    {
+    public:
+        uint64_t key[2];
+        Value *value;
+    };
+
+    /// an open-addressing hash table; its capacity is a power of two
+    class Table
+    {
+    public:
+        explicit Table(size_t aCapacity);
+
+        size_t groupMask() const { return capacity / GroupSize - 1; }
+
+        /// whether there is no room for another entry within the load limit
+        bool full() const { return (used + deleted + 1) * 8 > capacity * 7; }
+
+        size_t capacity;
+        std::unique_ptr<uint8_t[]> controls;
+        std::unique_ptr<Slot[]> slots;
+        size_t used = 0; ///< the number of slots with values
+        size_t deleted = 0; ///< the number of Deleted slots
+    };
+
+    /// an independently growing part of the index
+    class Shard
+    {
+    public:
+        std::unique_ptr<Table> current; ///< accepts new entries
+        std::unique_ptr<Table> previous; ///< entries yet to be moved to current (or nil)
+        size_t migrated = 0; ///< the number of previous table slots already moved
+        uint64_t generation = 0; ///< the number of grow() calls
+    };
+
+    static uint64_t Hash(const uint64_t key[2]);
+    static size_t ShardOf(const uint64_t hash) { return hash >> (64 - ShardBits); }
+    static uint8_t ControlOf(const uint64_t hash) { return (hash >> (64 - ShardBits - 7)) & 0x7F; }
+    static uint32_t Match(const uint8_t *group, uint8_t control);
+    static uint32_t MatchAvailable(const uint8_t *group);
+    static int LowestBit(uint32_t bits);
+    static size_t Locate(const Table &, const uint64_t key[2], uint64_t hash);
+    static void Place(Table &, const Slot &, uint64_t hash);
+    static void Forget(Table &, size_t position);
+
+    void grow(Shard &);
+    void migrate(Shard &, size_t limit);
+
+    Shard shards_[ShardCount];
+    size_t size_ = 0;
+};
+
+} // namespace Store
+
+/* KeyIndex implementation */
+
+template <class Value>
+Store::KeyIndex<Value>::Table::Table(const size_t aCapacity):
+    capacity(aCapacity),
+    controls(new uint8_t[aCapacity]),
+    slots(new Slot[aCapacity])
+{
+    memset(controls.get(), Empty, capacity);
+}
+
+template <class Value>
+Store::KeyIndex<Value>::KeyIndex(const size_t expectedSize)
+{
+    // load at most 7/8 of each table
+    const auto perShard = expectedSize / ShardCount * 8 / 7 + 1;
+    auto tableCapacity = GroupSize;
+    while (tableCapacity < perShard)
+        tableCapacity <<= 1;
+
+    for (auto &shard: shards_)
+        shard.current.reset(new Table(tableCapacity));
+}
+
+template <class Value>
+size_t
+Store::KeyIndex<Value>::capacity() const
+{
+    size_t total = 0;
+    for (const auto &shard: shards_)
+        total += shard.current->capacity + (shard.previous ? shard.previous->capacity : 0);
+    return total;
+}
+
+/// MD5 keys are well mixed already, but scramble them anyway because some
+/// (e.g., test) keys may not be
+template <class Value>
+uint64_t
+Store::KeyIndex<Value>::Hash(const uint64_t key[2])
+{
+    return (key[0] ^ (key[1] >> 1)) * 0x9E3779B97F4A7C15ULL;
+}
+
+/// a bitmask of group slots with the given control byte
+template <class Value>
+uint32_t
+Store::KeyIndex<Value>::Match(const uint8_t * const group, const uint8_t control)
+{
+#if defined(__SSE2__)
+    const auto controls = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(static_cast<char>(control))));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < GroupSize; ++i)
+        bits |= uint32_t(group[i] == control) << i;
+    return bits;
+#endif
+}
+
+/// a bitmask of Empty or Deleted group slots
+template <class Value>
+uint32_t
+Store::KeyIndex<Value>::MatchAvailable(const uint8_t * const group)
+{
+#if defined(__SSE2__)
+    // only Empty and Deleted control bytes have their high bit set
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group)));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < GroupSize; ++i)
+        bits |= uint32_t(group[i] >> 7) << i;
+    return bits;
+#endif
+}
+
+/// the position of the lowest set bit in a non-zero bitmask
+template <class Value>
+int
+Store::KeyIndex<Value>::LowestBit(uint32_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(bits);
+#else
+    int position = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        ++position;
+    }
+    return position;
+#endif
+}
+
+/// \returns the table position of the given key or the table capacity
+template <class Value>
+size_t
+Store::KeyIndex<Value>::Locate(const Table &table, const uint64_t key[2], const uint64_t hash)
+{
+    const auto control = ControlOf(hash);
+    auto group = hash & table.groupMask();
+    // triangular probing visits every group of a power-of-two table
+    for (size_t probe = 1; ; ++probe) {
+        const auto controls = table.controls.get() + group * GroupSize;
+        for (auto candidates = Match(controls, control); candidates; candidates &= candidates - 1) {
+            const auto position = group * GroupSize + LowestBit(candidates);
+            const auto &slot = table.slots[position];
+            if (slot.key[0] == key[0] && slot.key[1] == key[1])
+                return position;
+        }
+        if (Match(controls, Empty))
+            return table.capacity; // the key would have been placed in this group
+        group = (group + probe) & table.groupMask();
+    }
+}
+
+/// stores the slot in the first available position of its probe sequence
+template <class Value>
+void
+Store::KeyIndex<Value>::Place(Table &table, const Slot &slot, const uint64_t hash)
+{
+    auto group = hash & table.groupMask();
+    for (size_t probe = 1; ; ++probe) {
+        const auto controls = table.controls.get() + group * GroupSize;
+        if (const auto available = MatchAvailable(controls)) {
+            const auto position = group * GroupSize + LowestBit(available);
+            if (table.controls[position] == Deleted)
+                --table.deleted;
+            table.controls[position] = ControlOf(hash);
+            table.slots[position] = slot;
+            ++table.used;
+            return;
+        }
+        group = (group + probe) & table.groupMask();
+    }
+}
+
+/// empties the given used table position
+template <class Value>
+void
+Store::KeyIndex<Value>::Forget(Table &table, const size_t position)
+{
+    // Probes stop at groups with Empty slots. If our group has one, no probe
+    // sequence continues past our group, and our slot may become Empty too.
+    const auto group = table.controls.get() + position / GroupSize * GroupSize;
+    if (Match(group, Empty)) {
+        table.controls[position] = Empty;
+    } else {
+        table.controls[position] = Deleted;
+        ++table.deleted;
+    }
+    --table.used;
+}
+
+template <class Value>
+Value *
+Store::KeyIndex<Value>::find(const cache_key * const rawKey) const
+{
+    uint64_t key[2];
+    memcpy(key, rawKey, sizeof(key));
+    const auto hash = Hash(key);
+    const auto &shard = shards_[ShardOf(hash)];
+
+    const auto position = Locate(*shard.current, key, hash);
+    if (position < shard.current->capacity)
+        return shard.current->slots[position].value;
+
+    if (shard.previous) {
+        const auto oldPosition = Locate(*shard.previous, key, hash);
+        if (oldPosition < shard.previous->capacity)
+            return shard.previous->slots[oldPosition].value;
+    }
+
+    return nullptr;
+}
+
+template <class Value>
+void
+Store::KeyIndex<Value>::insert(const cache_key * const rawKey, Value * const value)
+{
+    Slot slot;
+    memcpy(slot.key, rawKey, sizeof(slot.key));
+    slot.value = value;
+    const auto hash = Hash(slot.key);
+    auto &shard = shards_[ShardOf(hash)];
+
+    migrate(shard, MigrationStep);
+    if (shard.current->full())
+        grow(shard);
+    Place(*shard.current, slot, hash);
+    ++size_;
+}
+
+template <class Value>
+bool
+Store::KeyIndex<Value>::erase(const cache_key * const rawKey, const Value * const value)
+{
+    uint64_t key[2];
+    memcpy(key, rawKey, sizeof(key));
+    const auto hash = Hash(key);
+    auto &shard = shards_[ShardOf(hash)];
+
+    migrate(shard, MigrationStep);
+    for (const auto table: { shard.current.get(), shard.previous.get() }) {
+        if (!table)
+            continue;
+        const auto position = Locate(*table, key, hash);
+        if (position < table->capacity && table->slots[position].value == value) {
+            Forget(*table, position);
+            Assure(size_ > 0);
+            --size_;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// starts moving shard entries into a new table
+template <class Value>
+void
+Store::KeyIndex<Value>::grow(Shard &shard)
+{
+    if (shard.previous)
+        migrate(shard, shard.previous->capacity); // should not happen; see migrate()
+
+    // grow unless most of the room is taken by Deleted slots
+    const auto &table = *shard.current;
+    const auto newCapacity = table.used * 16 > table.capacity * 7 ? table.capacity * 2 : table.capacity;
+    shard.previous = std::move(shard.current);
+    shard.current.reset(new Table(newCapacity));
+    shard.migrated = 0;
+    ++shard.generation;
+}
+
+/// Moves entries from up to the given number of old table slots to the new
+/// table. With MigrationStep slots moved per modification, the old table is
+/// gone long before the new table (at least as large as the old one, with
+/// at least half of its room left) fills up.
+template <class Value>
+void
+Store::KeyIndex<Value>::migrate(Shard &shard, const size_t limit)
+{
+    if (!shard.previous)
+        return;
+
+    auto &from = *shard.previous;
+    const auto end = std::min(from.capacity, shard.migrated + limit);
+    for (; shard.migrated < end; ++shard.migrated) {
+        const auto position = shard.migrated;
+        if (from.controls[position] & Empty)
+            continue; // Empty or Deleted
+        const auto &slot = from.slots[position];
+        Place(*shard.current, slot, Hash(slot.key));
+        // Deleted (rather than Empty) keeps probe sequences of unmoved entries
+        from.controls[position] = Deleted;
+        ++from.deleted;
+        --from.used;
+    }
+
+    if (shard.migrated >= from.capacity) {
+        Assure(!from.used);
+        shard.previous.reset();
+        shard.migrated = 0;
+    }
+}
+
+template <class Value>
+template <class Visitor>
+void
+Store::KeyIndex<Value>::visitSome(Cursor &cursor, Visitor &&visitor) const
+{
+    while (!cursor.done()) {
+        const auto &shard = shards_[cursor.shard_];
+        const auto starting = cursor.inPrevious_ && !cursor.slot_;
+        if (starting) {
+            cursor.generation_ = shard.generation;
+        } else if (cursor.generation_ != shard.generation) {
+            // Entries not visited yet may have moved to a new table, ahead of
+            // our current table position. Visit the whole shard again.
+            cursor.inPrevious_ = true;
+            cursor.slot_ = 0;
+            cursor.generation_ = shard.generation;
+        }
+
+        // visit old table first because entries only move to the new one
+        const auto table = cursor.inPrevious_ ? shard.previous.get() : shard.current.get();
+        if (table && cursor.slot_ < table->capacity) {
+            const auto end = cursor.slot_ + GroupSize;
+            for (; cursor.slot_ < end; ++cursor.slot_) {
+                if (!(table->controls[cursor.slot_] & Empty))
+                    visitor(table->slots[cursor.slot_].value);
+            }
+            return;
+        }
+
+        cursor.slot_ = 0;
+        if (cursor.inPrevious_) {
+            cursor.inPrevious_ = false;
+        } else {
+            cursor.inPrevious_ = true;
+            ++cursor.shard_;
+        }
+    }
+}
+
+#endif /* SQUID_SRC_STORE_KEYINDEX_H */
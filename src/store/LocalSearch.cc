@@ -10,7 +10,8 @@
 
 #include "squid.h"
 #include "debug/Stream.h"
-#include "globals.h"
+#include "Store.h"
+#include "store/KeyIndex.h"
 #include "store/LocalSearch.h"
 #include "StoreSearch.h"
 
@@ -30,9 +31,9 @@ public:
     StoreEntry *currentItem() override;
 
 private:
-    void copyBucket();
+    void copySome();
     bool _done = false;
-    int bucket = 0;
+    EntryIndex::Cursor cursor; ///< the next store_table position to copy
     std::vector<StoreEntry *> entries;
 };
 
@@ -60,7 +61,7 @@ Store::LocalSearch::next()
         entries.pop_back();
 
     while (!isDone() && !entries.size())
-        copyBucket();
+        copySome();
 
     return currentItem() != nullptr;
 }
@@ -74,7 +75,7 @@ Store::LocalSearch::error() const
 bool
 Store::LocalSearch::isDone() const
 {
-    return bucket >= store_hash_buckets || _done;
+    return cursor.done() || _done;
 }
 
 StoreEntry *
@@ -87,26 +88,17 @@ Store::LocalSearch::currentItem()
 }
 
 void
-Store::LocalSearch::copyBucket()
+Store::LocalSearch::copySome()
 {
     /* probably need to lock the store entries...
-     * we copy them all to prevent races on the links. */
+     * we copy them all to prevent races on index changes. */
     assert (!entries.size());
-    hash_link *link_ptr = nullptr;
-    hash_link *link_next = nullptr;
-    link_next = hash_get_bucket(store_table, bucket);
-
-    while (nullptr != (link_ptr = link_next)) {
-        link_next = link_ptr->next;
-        StoreEntry *e = (StoreEntry *) link_ptr;
-
+    store_table->visitSome(cursor, [this](StoreEntry *e) {
         entries.push_back(e);
-    }
+    });
 
     // minimize debugging: we may be called more than a million times on startup
     if (const auto count = entries.size())
-        debugs(47, 8, "bucket #" << bucket << " entries: " << count);
-
-    ++bucket;
+        debugs(47, 8, "entries: " << count);
 }
 
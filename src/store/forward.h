@@ -47,8 +47,10 @@ class Disk;
 class DiskConfig;
 class EntryGuard;
 class ParsingBuffer;
+template <class Value> class KeyIndex;
 
 typedef ::StoreEntry Entry;
+typedef KeyIndex<Entry> EntryIndex; ///< an index of StoreEntry objects
 typedef ::MemStore Memory;
 typedef ::Transients Transients;
 } // namespace Store
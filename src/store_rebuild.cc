@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "debug/Messages.h"
 #include "event.h"
+#include "fatal.h"
 #include "fde.h"
 #include "globals.h"
 #include "md5.h"
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Measures dstdomain ACL index (Acl::DomainIndex) load and lookup times
+ * for a large synthetic block list. A quarter of the checked host names
+ * match a configured domain exactly, a quarter are subdomains of a
+ * configured domain (that only match ".domain" entries), and the rest
+ * match nothing.
+ *
+ * Usage: tests/benchACLDomainIndex [domains [hosts to check]]
+ */
+
+#include "squid.h"
+#include "acl/DomainIndex.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double
+Seconds(const Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// a configured domain resembling those found in real-world block lists
+static std::string
+MakeDomain(const size_t n)
+{
+    const auto name = "d" + std::to_string(n) + ".zone" + std::to_string(n % 997);
+    return (n % 3 ? "" : ".") + name + (n % 2 ? ".com" : ".net");
+}
+
+int
+main(int argc, char *argv[])
+{
+    const auto domainCount = argc > 1 ? atol(argv[1]) : 1000000;
+    const auto hostCount = argc > 2 ? atol(argv[2]) : 200000;
+    if (domainCount <= 0 || hostCount <= 0) {
+        std::cerr << "usage: " << argv[0] << " [domains [hosts to check]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> domains;
+    domains.reserve(domainCount);
+    for (long i = 0; i < domainCount; ++i)
+        domains.push_back(MakeDomain(i));
+
+    // an index is rebuilt from scratch on every reconfiguration
+    auto start = Clock::now();
+    Acl::DomainIndex index;
+    for (const auto &domain: domains)
+        index.add(domain.c_str());
+    index.commit();
+    const auto loadTime = Seconds(start);
+
+    std::vector<std::string> hosts;
+    hosts.reserve(hostCount);
+    size_t expected = 0;
+    for (long i = 0; i < hostCount; ++i) {
+        const auto n = (i * 7919) % domainCount;
+        switch (i % 4) {
+        case 0: // an exact match
+            hosts.push_back(MakeDomain(n).substr(n % 3 ? 0 : 1));
+            ++expected;
+            break;
+        case 1: // a subdomain that only matches sets
+            hosts.push_back("www" + MakeDomain(n).insert(0, n % 3 ? "." : ""));
+            expected += (n % 3 == 0);
+            break;
+        default: // a miss
+            hosts.push_back("www.miss" + std::to_string(n) + ".example.com");
+        }
+    }
+
+    size_t matches = 0;
+    start = Clock::now();
+    for (const auto &host: hosts)
+        matches += index.match(host.c_str());
+    const auto lookupTime = Seconds(start);
+
+    if (matches != expected) {
+        std::cerr << "BUG: expected " << expected << " matches but found " << matches << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << index.size() << " domains loaded in " <<
+              std::fixed << std::setprecision(3) << loadTime << " s; " <<
+              hostCount << " hosts, " << matches << " matches, " <<
+              std::setprecision(2) << (lookupTime * 1e6 / hostCount) << " us/lookup" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Measures shared memory contention on a single hot cache entry read by N
+ * worker processes, as with a popular small object in an SMP memory cache.
+ * Compares reading under Ipc::ReadWriteLock shared locks (every read
+ * modifies lock counters shared by all workers) with optimistic reads that
+ * only load the lock version. An optional writer process periodically
+ * rewrites the entry under an exclusive lock, ruining some optimistic reads.
+ *
+ * Usage: tests/benchReadWriteLock [workers [seconds [entry size [writes/s]]]]
+ */
+
+#include "squid.h"
+#include "ipc/ReadWriteLock.h"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// per-worker results, padded to avoid false sharing among workers
+class alignas(64) WorkerStats
+{
+public:
+    uint64_t reads = 0; ///< successful entry reads
+    uint64_t conflicts = 0; ///< optimistic reads ruined by the writer
+    uint64_t corrupted = 0; ///< reads that returned an inconsistent entry
+};
+
+/// the shared memory segment layout
+class Shared
+{
+public:
+    Ipc::ReadWriteLock lock;
+    std::atomic<bool> stop;
+    WorkerStats stats[1]; // followed by more WorkerStats and entry bytes
+};
+
+using Clock = std::chrono::steady_clock;
+
+static Shared *TheShared = nullptr;
+static char *TheEntry = nullptr;
+static size_t EntrySize = 0;
+
+/// whether a copied entry has the same byte everywhere, as written by Write()
+static bool
+Consistent(const char *buf)
+{
+    return buf[0] == buf[EntrySize - 1] && !memcmp(buf, buf + 1, EntrySize - 1);
+}
+
+static void
+ReadLocked(WorkerStats &stats, char *buf)
+{
+    while (!TheShared->stop.load(std::memory_order_relaxed)) {
+        if (!TheShared->lock.lockShared())
+            continue;
+        memcpy(buf, TheEntry, EntrySize);
+        TheShared->lock.unlockShared();
+        ++stats.reads;
+        stats.corrupted += !Consistent(buf);
+    }
+}
+
+static void
+ReadOptimistically(WorkerStats &stats, char *buf)
+{
+    while (!TheShared->stop.load(std::memory_order_relaxed)) {
+        uint32_t version;
+        if (!TheShared->lock.startOptimisticRead(version))
+            continue;
+        memcpy(buf, TheEntry, EntrySize);
+        if (!TheShared->lock.finishOptimisticRead(version)) {
+            ++stats.conflicts;
+            continue;
+        }
+        ++stats.reads;
+        stats.corrupted += !Consistent(buf);
+    }
+}
+
+/// rewrites the entry under an exclusive lock at the given rate
+static void
+Write(const int writesPerSecond)
+{
+    const auto pause = std::chrono::microseconds(1000000 / writesPerSecond);
+    char fill = 0;
+    while (!TheShared->stop.load(std::memory_order_relaxed)) {
+        if (TheShared->lock.lockExclusive()) {
+            memset(TheEntry, ++fill, EntrySize);
+            TheShared->lock.unlockExclusive();
+        }
+        std::this_thread::sleep_for(pause);
+    }
+}
+
+/// runs one benchmark round in freshly forked processes
+static void
+Run(const char *name, void (*reader)(WorkerStats &, char *), const int workers, const int seconds, const int writesPerSecond)
+{
+    new (&TheShared->lock) Ipc::ReadWriteLock();
+    TheShared->stop = false;
+    for (int i = 0; i < workers; ++i)
+        new (&TheShared->stats[i]) WorkerStats();
+    memset(TheEntry, 0, EntrySize);
+
+    std::vector<pid_t> kids;
+    const auto spawn = [&kids](const std::function<void()> &job) {
+        const auto pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (!pid) {
+            job();
+            _exit(EXIT_SUCCESS);
+        }
+        kids.push_back(pid);
+    };
+
+    const auto start = Clock::now();
+    for (int i = 0; i < workers; ++i) {
+        spawn([i, reader] {
+            std::vector<char> buf(EntrySize);
+            reader(TheShared->stats[i], buf.data());
+        });
+    }
+    if (writesPerSecond > 0)
+        spawn([writesPerSecond] { Write(writesPerSecond); });
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    TheShared->stop = true;
+    for (const auto pid: kids)
+        waitpid(pid, nullptr, 0);
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WorkerStats total;
+    for (int i = 0; i < workers; ++i) {
+        total.reads += TheShared->stats[i].reads;
+        total.conflicts += TheShared->stats[i].conflicts;
+        total.corrupted += TheShared->stats[i].corrupted;
+    }
+
+    std::cout << std::setw(10) << name << ": " <<
+              std::fixed << std::setprecision(2) << (total.reads / elapsed / 1e6) << " M reads/s, " <<
+              std::setprecision(1) << (workers * elapsed * 1e9 / (total.reads ? total.reads : 1)) << " ns/read/worker, " <<
+              total.conflicts << " conflicts, " << total.corrupted << " corrupted reads" << std::endl;
+    if (writesPerSecond > 0 && total.corrupted) {
+        std::cerr << "BUG: readers saw entries modified by the writer" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    const auto workers = argc > 1 ? atoi(argv[1]) : int(std::thread::hardware_concurrency());
+    const auto seconds = argc > 2 ? atoi(argv[2]) : 3;
+    const auto entrySize = argc > 3 ? atol(argv[3]) : 4096;
+    const auto writesPerSecond = argc > 4 ? atoi(argv[4]) : 100;
+    if (workers <= 0 || seconds <= 0 || entrySize <= 0 || writesPerSecond < 0) {
+        std::cerr << "usage: " << argv[0] << " [workers [seconds [entry size [writes/s]]]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    EntrySize = entrySize;
+    const auto size = sizeof(Shared) + sizeof(WorkerStats) * workers + EntrySize;
+    const auto segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (segment == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    TheShared = new (segment) Shared();
+    TheEntry = reinterpret_cast<char *>(&TheShared->stats[workers]);
+
+    std::cout << workers << " workers reading a " << EntrySize << "-byte entry for " << seconds << " s, " <<
+              writesPerSecond << " writes/s" << std::endl;
+    Run("locked", ReadLocked, workers, seconds, writesPerSecond);
+    Run("optimistic", ReadOptimistically, workers, seconds, writesPerSecond);
+
+    munmap(segment, size);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Compares regex ACL matching engines for block lists of 1k, 10k, and 100k
+ * synthetic patterns: the default walk over a list of regexes (each
+ * combining up to 1KB of configured patterns, as ACLRegexData does) and
+ * the acl_regex_automaton engine (RegexSet). Most checked URLs do not
+ * match, as is typical for block lists.
+ *
+ * Usage: tests/benchRegexSet [URLs to check]
+ */
+
+#include "squid.h"
+#include "base/RegexSet.h"
+#include "sbuf/Algorithms.h"
+#include "sbuf/List.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int Flags = REG_EXTENDED | REG_NOSUB | REG_ICASE;
+
+/// a block list entry resembling those found in real-world lists
+static SBuf
+MakePattern(const size_t n)
+{
+    const auto id = std::to_string(n);
+    switch (n % 4) {
+    case 0:
+        return SBuf("ads" + id + "\\.example\\.com");
+    case 1:
+        return SBuf("^https?://([a-z0-9-]+\\.)*tracker" + id + "\\.net/");
+    case 2:
+        return SBuf("/banners?/campaign" + id + "/.*");
+    default:
+        return SBuf("pixel" + id + "[0-9]*\\.gif$");
+    }
+}
+
+/// \returns a URL that matches the pattern with the given number or, if the
+/// number is negative, a URL that matches no pattern
+static std::string
+MakeUrl(const long n)
+{
+    if (n < 0)
+        return "http://www.squid-cache.org/Versions/v7/squid-7.1.tar.gz";
+    const auto id = std::to_string(n);
+    switch (n % 4) {
+    case 0:
+        return "http://ads" + id + ".example.com/a.js";
+    case 1:
+        return "https://cdn.tracker" + id + ".net/p";
+    case 2:
+        return "http://news.test/banner/campaign" + id + "/1.png";
+    default:
+        return "http://img.test/pixel" + id + "0.gif";
+    }
+}
+
+/// mimics ACLRegexData list of combined regexes
+static void
+CompileList(std::list<RegexPattern> &list, const std::vector<SBuf> &patterns)
+{
+    static const SBuf openparen("("), closeparen(")"), separator(")|(");
+    SBufList accumulated;
+    size_t accumulatedSize = 0;
+    for (const auto &pattern: patterns) {
+        accumulated.push_back(pattern);
+        accumulatedSize += pattern.length();
+        if (accumulatedSize > 1024) {
+            SBuf re;
+            JoinContainerIntoSBuf(re, accumulated.begin(), accumulated.end(), separator, openparen, closeparen);
+            list.emplace_back(re, Flags);
+            accumulated.clear();
+            accumulatedSize = 0;
+        }
+    }
+    if (!accumulated.empty()) {
+        SBuf re;
+        JoinContainerIntoSBuf(re, accumulated.begin(), accumulated.end(), separator, openparen, closeparen);
+        list.emplace_back(re, Flags);
+    }
+}
+
+static bool
+ListMatches(const std::list<RegexPattern> &list, const char *url)
+{
+    for (const auto &re: list) {
+        if (re.match(url))
+            return true;
+    }
+    return false;
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double
+Seconds(const Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void
+Benchmark(const size_t patternCount, const size_t urlCount)
+{
+    std::vector<SBuf> patterns;
+    patterns.reserve(patternCount);
+    for (size_t i = 0; i < patternCount; ++i)
+        patterns.push_back(MakePattern(i));
+
+    // one in ten URLs matches some pattern
+    std::mt19937 rng(patternCount);
+    std::vector<std::string> urls;
+    urls.reserve(urlCount);
+    for (size_t i = 0; i < urlCount; ++i)
+        urls.push_back(MakeUrl(i % 10 ? -1 : long(rng() % patternCount)));
+
+    auto start = Clock::now();
+    std::list<RegexPattern> list;
+    CompileList(list, patterns);
+    const auto listBuild = Seconds(start);
+
+    start = Clock::now();
+    RegexSet set;
+    for (const auto &pattern: patterns) {
+        if (!set.add(pattern, Flags)) {
+            std::cerr << "BUG: no literal in " << pattern << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    set.compile();
+    const auto setBuild = Seconds(start);
+
+    size_t listMatches = 0;
+    start = Clock::now();
+    for (const auto &url: urls)
+        listMatches += ListMatches(list, url.c_str());
+    const auto listTime = Seconds(start);
+
+    size_t setMatches = 0;
+    start = Clock::now();
+    for (const auto &url: urls)
+        setMatches += set.match(url.c_str()) != nullptr;
+    const auto setTime = Seconds(start);
+
+    if (listMatches != setMatches) {
+        std::cerr << "BUG: list walk found " << listMatches << " matches but the automaton found " << setMatches << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << std::setw(6) << patternCount << " patterns (" << list.size() << " combined regexes), " <<
+              urlCount << " URLs, " << setMatches << " matches" << std::endl <<
+              std::fixed << std::setprecision(3) <<
+              "    list walk: build " << listBuild << " s, " <<
+              std::setprecision(1) << (listTime * 1e6 / urlCount) << " us/URL" << std::endl <<
+              std::setprecision(3) <<
+              "    automaton: build " << setBuild << " s, " <<
+              std::setprecision(1) << (setTime * 1e6 / urlCount) << " us/URL" << std::endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const auto urlCount = argc > 1 ? atol(argv[1]) : 1000;
+    if (urlCount <= 0) {
+        std::cerr << "usage: " << argv[0] << " [URLs to check]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for (const auto patternCount: {1000, 10000, 100000})
+        Benchmark(patternCount, urlCount);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Compares the store_table implementations on a synthetic index of random
+ * MD5-like keys: the old chained hash_table (sized like Store::Disks::init()
+ * sized it, for 20 objects per bucket) and the open-addressing
+ * Store::KeyIndex, both sized for all entries (as Store::Disks::init() sizes
+ * it) and starting at the old hash_table size and growing as needed. Reports
+ * the time to index all entries (as a cache_dir rebuild does) and the times
+ * to look up present and absent keys, in random order.
+ *
+ * The production index size of interest is 50M entries; that run needs
+ * about 4 GB of RAM.
+ *
+ * Usage: tests/benchStoreKeyIndex [entries [lookups]]
+ */
+
+#include "squid.h"
+#include "hash.h"
+#include "md5.h"
+#include "store/KeyIndex.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/// Store::Disks::init() default for store_objects_per_bucket
+static const size_t ObjectsPerBucket = 20;
+
+/* Copies of store_key_md5.cc functions, avoiding its many dependencies */
+
+static int
+KeyHashCmp(const void *a, const void *b)
+{
+    return memcmp(a, b, SQUID_MD5_DIGEST_LENGTH);
+}
+
+static unsigned int
+KeyHashHash(const void *key, unsigned int n)
+{
+    const auto digest = static_cast<const unsigned char *>(key);
+    const unsigned int i = digest[0] | digest[1] << 8 | digest[2] << 16 | digest[3] << 24;
+    return i & (n - 1);
+}
+
+static int
+KeyHashBuckets(const int nbuckets)
+{
+    int n = 0x2000;
+    while (n < nbuckets)
+        n <<= 1;
+    return n;
+}
+
+/// a 16-byte cache key
+class Key
+{
+public:
+    cache_key bytes[SQUID_MD5_DIGEST_LENGTH];
+};
+
+static std::vector<Key>
+MakeKeys(const size_t count, const uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<Key> keys(count);
+    for (auto &key: keys) {
+        const uint64_t words[2] = { rng(), rng() };
+        memcpy(key.bytes, words, sizeof(key.bytes));
+    }
+    return keys;
+}
+
+/// random positions in a keys vector
+static std::vector<size_t>
+MakeOrder(const size_t lookups, const size_t keyCount)
+{
+    std::mt19937_64 rng(7);
+    std::vector<size_t> order(lookups);
+    for (auto &position: order)
+        position = rng() % keyCount;
+    return order;
+}
+
+static double
+Since(const Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void
+Report(const char *name, const double insertSeconds, const double hitSeconds, const double missSeconds, const size_t entries, const size_t lookups, const double bytesPerEntry, const size_t errors)
+{
+    std::cout << std::setw(10) << name << ": " <<
+              std::fixed << std::setprecision(1) <<
+              "index " << (insertSeconds * 1e9 / entries) << " ns/entry, " <<
+              "hit " << (hitSeconds * 1e9 / lookups) << " ns/lookup, " <<
+              "miss " << (missSeconds * 1e9 / lookups) << " ns/lookup, " <<
+              bytesPerEntry << " bytes/entry of index overhead" << std::endl;
+    if (errors) {
+        std::cerr << "BUG: " << errors << " wrong lookup results" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void
+RunKeyIndex(const char *name, const size_t expectedSize, const std::vector<Key> &keys, const std::vector<Key> &absent, const std::vector<size_t> &order)
+{
+    auto start = Clock::now();
+    Store::KeyIndex<const Key> index(expectedSize);
+    for (const auto &key: keys)
+        index.insert(key.bytes, &key);
+    const auto insertSeconds = Since(start);
+
+    size_t errors = 0;
+    start = Clock::now();
+    for (const auto position: order)
+        errors += index.find(keys[position].bytes) != &keys[position];
+    const auto hitSeconds = Since(start);
+
+    start = Clock::now();
+    for (const auto position: order)
+        errors += index.find(absent[position].bytes) != nullptr;
+    const auto missSeconds = Since(start);
+
+    // each slot has a control byte and two key words next to a value pointer
+    const auto bytes = double(index.capacity()) * (1 + 2*sizeof(uint64_t) + sizeof(void*));
+    Report(name, insertSeconds, hitSeconds, missSeconds, keys.size(), order.size(), bytes / keys.size(), errors);
+}
+
+static void
+RunHashTable(const std::vector<Key> &keys, const std::vector<Key> &absent, const std::vector<size_t> &order)
+{
+    // StoreEntry is a hash_link; each link points to its own key copy
+    std::vector<hash_link> links(keys.size());
+
+    auto start = Clock::now();
+    const auto buckets = KeyHashBuckets(keys.size() / ObjectsPerBucket);
+    const auto table = hash_create(KeyHashCmp, buckets, KeyHashHash);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        links[i].key = const_cast<cache_key *>(keys[i].bytes);
+        hash_join(table, &links[i]);
+    }
+    const auto insertSeconds = Since(start);
+
+    size_t errors = 0;
+    start = Clock::now();
+    for (const auto position: order)
+        errors += hash_lookup(table, keys[position].bytes) != &links[position];
+    const auto hitSeconds = Since(start);
+
+    start = Clock::now();
+    for (const auto position: order)
+        errors += hash_lookup(table, absent[position].bytes) != nullptr;
+    const auto missSeconds = Since(start);
+
+    // bucket heads and the hash_link::next pointer inside each entry
+    const auto bytes = double(buckets) * sizeof(hash_link *) + double(keys.size()) * sizeof(hash_link *);
+    Report("hash_table", insertSeconds, hitSeconds, missSeconds, keys.size(), order.size(), bytes / keys.size(), errors);
+
+    hashFreeMemory(table);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const auto entries = argc > 1 ? atol(argv[1]) : 5000000;
+    const auto lookups = argc > 2 ? atol(argv[2]) : 10000000;
+    if (entries <= 0 || lookups <= 0) {
+        std::cerr << "usage: " << argv[0] << " [entries [lookups]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const auto keys = MakeKeys(entries, 1);
+    const auto absent = MakeKeys(entries, 2);
+    const auto order = MakeOrder(lookups, entries);
+
+    std::cout << entries << " entries, " << lookups << " lookups" << std::endl;
+    RunKeyIndex("KeyIndex", keys.size(), keys, absent, order);
+    RunKeyIndex("growing", keys.size() / ObjectsPerBucket, keys, absent, order);
+    RunHashTable(keys, absent, order);
+    return EXIT_SUCCESS;
+}
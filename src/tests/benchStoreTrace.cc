@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Replays a request trace against Store::Controller with a non-shared
+ * memory cache and, optionally, a UFS cache_dir (place it on tmpfs to
+ * measure the store rather than the disk). Every trace record is treated as
+ * a cachable GET request: a lookup via Store::Root().find() followed, on a
+ * miss, by storing a reply of the recorded size. Cache hits are not read
+ * back, so disk hits are not promoted to the memory cache. Reports hit and byte hit ratios (separately for memory and disk
+ * hits), store lookup rate, and memory footprint.
+ *
+ * Each text trace line is either "key [size]" or a native access.log record
+ * (the time in the first field, the reply size in the fifth one, and the
+ * URL in the seventh one). The store clock follows trace times, starting at
+ * the current time. Traces without times advance the store clock by one
+ * second every RecordsPerSecond records.
+ *
+ * A binary trace starts with BinaryTraceMagic, followed by records of three
+ * host-order 64-bit integers: time (or zero), URL hash, and reply size.
+ * Binary traces are faster to replay; --convert creates them from text
+ * traces.
+ *
+ * Usage: tests/benchStoreTrace [options] trace
+ *   --policy "name [args]" cache_replacement_policy and memory_replacement_policy (lru)
+ *   --cache-mem MB         cache_mem (256)
+ *   --ufs dir:MB           add a UFS cache_dir of the given size
+ *   --admission N          cache_admission_min_frequency (0)
+ *   --convert output       write a binary trace instead of replaying
+ */
+
+#include "squid.h"
+#include "DiskIO/DiskIOModule.h"
+#include "fde.h"
+#include "fs/ufs/UFSStrategy.h"
+#include "fs/ufs/UFSSwapDir.h"
+#include "globals.h"
+#include "HttpHeader.h"
+#include "HttpReply.h"
+#include "mem_node.h"
+#include "MemObject.h"
+#include "repl_modules.h"
+#include "RequestFlags.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "store/Controller.h"
+#include "store/Disks.h"
+#include "store/KeyIndex.h"
+#include "store_key_md5.h"
+#include "testStoreSupport.h"
+#include "tools.h"
+#include "wordlist.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+using Clock = std::chrono::steady_clock;
+
+// Unlike the stub_tools.cc version, this debug_trap() is not fatal, just like
+// the real one when Squid catches signals (the default). UFS cache_dirs call
+// it before falling back to synchronous unlinking when unlinkd is not running.
+void
+debug_trap(const char *)
+{
+}
+
+/// the first bytes of a binary trace file
+static const char BinaryTraceMagic[8] = { 'S', 'Q', 'T', 'R', 'A', 'C', 'E', '1' };
+
+/// the assumed request rate of traces without request times
+static const uint64_t RecordsPerSecond = 1000;
+
+/// a single trace record
+class TraceRecord
+{
+public:
+    time_t time = 0; ///< request time or zero
+    std::string url;
+    uint64_t size = 0; ///< reply size
+};
+
+/// reads text and binary trace records
+class TraceReader
+{
+public:
+    explicit TraceReader(const char *path);
+
+    /// \returns false at the end of the trace
+    bool next(TraceRecord &);
+
+    bool binary() const { return binary_; }
+
+private:
+    bool nextBinary(TraceRecord &);
+    bool nextText(TraceRecord &);
+
+    std::ifstream in_;
+    bool binary_ = false;
+};
+
+TraceReader::TraceReader(const char *path):
+    in_(path, std::ios::binary)
+{
+    if (!in_) {
+        std::cerr << "cannot open " << path << ": " << xstrerr(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    char magic[sizeof(BinaryTraceMagic)];
+    binary_ = in_.read(magic, sizeof(magic)) && memcmp(magic, BinaryTraceMagic, sizeof(magic)) == 0;
+    if (!binary_) {
+        in_.clear();
+        in_.seekg(0);
+    }
+}
+
+bool
+TraceReader::next(TraceRecord &record)
+{
+    return binary_ ? nextBinary(record) : nextText(record);
+}
+
+bool
+TraceReader::nextBinary(TraceRecord &record)
+{
+    uint64_t fields[3];
+    if (!in_.read(reinterpret_cast<char *>(fields), sizeof(fields)))
+        return false;
+
+    record.time = static_cast<time_t>(fields[0]);
+    std::ostringstream url;
+    url << "http://trace.invalid/" << std::hex << fields[1];
+    record.url = url.str();
+    record.size = fields[2];
+    return true;
+}
+
+bool
+TraceReader::nextText(TraceRecord &record)
+{
+    for (std::string line; std::getline(in_, line);) {
+        std::istringstream fields(line);
+        std::vector<std::string> field;
+        for (std::string f; field.size() < 7 && fields >> f;)
+            field.push_back(f);
+
+        if (field.empty() || field[0][0] == '#')
+            continue;
+
+        if (field.size() >= 7) {
+            record.time = static_cast<time_t>(strtoll(field[0].c_str(), nullptr, 10));
+            record.size = strtoull(field[4].c_str(), nullptr, 10);
+            record.url = field[6];
+        } else {
+            record.time = 0;
+            record.size = field.size() > 1 ? strtoull(field[1].c_str(), nullptr, 10) : 0;
+            record.url = field[0];
+        }
+        return true;
+    }
+    return false;
+}
+
+/// replay statistics
+class Counters
+{
+public:
+    uint64_t requests = 0;
+    uint64_t requestedBytes = 0;
+    uint64_t memHits = 0;
+    uint64_t memHitBytes = 0;
+    uint64_t diskHits = 0;
+    uint64_t diskHitBytes = 0;
+    uint64_t stored = 0; ///< the number of misses we tried to cache
+    double lookupSeconds = 0; ///< time spent in Store::Root().find()
+    double replaySeconds = 0; ///< total replay time
+};
+
+/// a reusable reply body source
+static const char *
+Filler()
+{
+    static std::vector<char> filler(SM_PAGE_SIZE, 'x');
+    return filler.data();
+}
+
+/// creates a complete cachable entry for the given missed record
+static void
+StoreReply(const TraceRecord &record)
+{
+    RequestFlags flags;
+    flags.cachable.support();
+    const auto e = storeCreateEntry(record.url.c_str(), record.url.c_str(), flags, Http::METHOD_GET);
+
+    auto &reply = e->mem().adjustableBaseReply();
+    reply.setHeaders(Http::scOkay, "OK", "application/octet-stream", record.size, squid_curtime, squid_curtime + 86400);
+    e->setPublicKey();
+
+    e->buffer();
+    e->mem().freshestReply().packHeadersUsingSlowPacker(*e);
+    e->flush();
+    // the stubbed StoreEntry::invokeHandlers() does not swap out as it goes
+    e->swapOut();
+    for (auto left = record.size; left > 0;) {
+        const auto chunk = std::min<uint64_t>(left, SM_PAGE_SIZE);
+        e->append(Filler(), static_cast<int>(chunk));
+        e->swapOut();
+        left -= chunk;
+    }
+    e->timestampsSet();
+    e->completeSuccessfully("benchStoreTrace stored the whole reply");
+    e->swapOut();
+    e->unlock("benchStoreTrace");
+}
+
+/// advances the store clock to the given time
+static void
+SetClock(const time_t now)
+{
+    if (now <= squid_curtime)
+        return;
+
+    squid_curtime = now;
+    current_time.tv_sec = now;
+    current_time.tv_usec = 0;
+    current_dtime = now;
+
+    // what the "storeMaintain" event and the main loop do once a second
+    Store::Root().maintain();
+    Store::Root().callback();
+}
+
+static void
+Replay(TraceReader &trace, Counters &counters)
+{
+    TraceRecord record;
+    const auto start = squid_curtime;
+    time_t firstRecordTime = 0;
+    const auto replayStart = Clock::now();
+
+    while (trace.next(record)) {
+        // trace times are shifted to start now
+        if (record.time && !firstRecordTime)
+            firstRecordTime = record.time;
+        const auto offset = record.time ?
+                            record.time - firstRecordTime :
+                            static_cast<time_t>(counters.requests / RecordsPerSecond);
+        SetClock(start + offset);
+
+        ++counters.requests;
+        counters.requestedBytes += record.size;
+
+        const auto key = storeKeyPublic(record.url.c_str(), Http::METHOD_GET);
+        const auto lookupStart = Clock::now();
+        const auto e = Store::Root().find(key);
+        counters.lookupSeconds += std::chrono::duration<double>(Clock::now() - lookupStart).count();
+
+        if (e && e->store_status == STORE_OK && !EBIT_TEST(e->flags, ENTRY_ABORTED)) {
+            e->lock("benchStoreTrace hit");
+            // as clientReplyContext and the store_client constructor do
+            e->ensureMemObject(record.url.c_str(), record.url.c_str(), Http::METHOD_GET);
+            ++e->refcount;
+            if (e->mem_status == IN_MEMORY) {
+                ++counters.memHits;
+                counters.memHitBytes += record.size;
+            } else {
+                ++counters.diskHits;
+                counters.diskHitBytes += record.size;
+            }
+            e->unlock("benchStoreTrace hit");
+            continue;
+        }
+
+        if (record.size > static_cast<uint64_t>(store_maxobjsize))
+            continue; // not cachable anyway
+
+        ++counters.stored;
+        StoreReply(record);
+    }
+
+    counters.replaySeconds = std::chrono::duration<double>(Clock::now() - replayStart).count();
+}
+
+static double
+Percent(const uint64_t part, const uint64_t whole)
+{
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+static void
+Report(const Counters &counters)
+{
+    const auto hits = counters.memHits + counters.diskHits;
+    const auto hitBytes = counters.memHitBytes + counters.diskHitBytes;
+    std::cout << std::fixed << std::setprecision(2) <<
+              counters.requests << " requests, " << counters.stored << " stored" << std::endl <<
+              "hit ratio: " << Percent(hits, counters.requests) << "% " <<
+              "(memory " << Percent(counters.memHits, counters.requests) << "%, " <<
+              "disk " << Percent(counters.diskHits, counters.requests) << "%)" << std::endl <<
+              "byte hit ratio: " << Percent(hitBytes, counters.requestedBytes) << "% " <<
+              "(memory " << Percent(counters.memHitBytes, counters.requestedBytes) << "%, " <<
+              "disk " << Percent(counters.diskHitBytes, counters.requestedBytes) << "%)" << std::endl;
+
+    const auto lookupRate = counters.lookupSeconds > 0 ? counters.requests / counters.lookupSeconds : 0.0;
+    const auto replayRate = counters.replaySeconds > 0 ? counters.requests / counters.replaySeconds : 0.0;
+    std::cout << std::setprecision(0) <<
+              "lookups/sec: " << lookupRate << ", requests/sec: " << replayRate << std::endl;
+
+    // each store_table slot has a control byte and two key words next to a value pointer
+    const auto indexBytes = store_table->capacity() * (1 + 2*sizeof(uint64_t) + sizeof(void*));
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout <<
+              "store entries: " << StoreEntry::inUseCount() <<
+              ", memory objects: " << MemObject::inUseCount() <<
+              ", memory cache: " << (mem_node::StoreMemSize() >> 10) << " KB" <<
+              ", store_table: " << (indexBytes >> 10) << " KB" <<
+              ", max RSS: " << usage.ru_maxrss << " KB" << std::endl;
+}
+
+/// \returns policy settings parsed from a "name [args]" string
+static RemovalPolicySettings *
+MakePolicySettings(const char *description)
+{
+    std::istringstream in(description);
+    std::string word;
+    if (!(in >> word)) {
+        std::cerr << "missing replacement policy name" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const auto settings = new RemovalPolicySettings;
+    settings->type = xstrdup(word.c_str());
+    while (in >> word)
+        wordlistAdd(&settings->args, word.c_str());
+    return settings;
+}
+
+static void
+AddUfsDir(const char *spec)
+{
+    const auto colon = strrchr(spec, ':');
+    if (!colon || colon == spec || atoi(colon + 1) <= 0) {
+        std::cerr << "expected --ufs directory:megabytes, got " << spec << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    RefCount<Fs::Ufs::UFSSwapDir> dir(new Fs::Ufs::UFSSwapDir("ufs", "Blocking"));
+    dir->IO = new Fs::Ufs::UFSStrategy(DiskIOModule::Find("Blocking")->createStrategy());
+    allocate_new_swapdir(Config.cacheSwap);
+    Config.cacheSwap.swapDirs[Config.cacheSwap.n_configured] = dir.getRaw();
+    ++Config.cacheSwap.n_configured;
+
+    char *path = xstrndup(spec, colon - spec + 1);
+    const auto configLine = std::string(colon + 1) + " 16 256";
+    char *line = xstrdup(configLine.c_str());
+    ConfigParser::SetCfgLine(line);
+    dir->parse(Config.cacheSwap.n_configured - 1, path);
+    safe_free(path);
+    safe_free(line);
+
+    dir->create();
+}
+
+static int
+Usage(const char *program)
+{
+    std::cerr << "usage: " << program << " [--policy \"name [args]\"] [--cache-mem MB] [--ufs dir:MB] " <<
+              "[--admission N] [--convert output] trace" << std::endl;
+    return EXIT_FAILURE;
+}
+
+/// writes the given trace in binary format
+static int
+Convert(TraceReader &trace, const char *outputPath)
+{
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    out.write(BinaryTraceMagic, sizeof(BinaryTraceMagic));
+
+    uint64_t records = 0;
+    TraceRecord record;
+    while (trace.next(record)) {
+        uint64_t hash = 0;
+        memcpy(&hash, storeKeyPublic(record.url.c_str(), Http::METHOD_GET), sizeof(hash));
+        const uint64_t fields[3] = { static_cast<uint64_t>(record.time), hash, record.size };
+        out.write(reinterpret_cast<const char *>(fields), sizeof(fields));
+        ++records;
+    }
+
+    if (!out.flush()) {
+        std::cerr << "cannot write " << outputPath << ": " << xstrerr(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << records << " records written to " << outputPath << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *policy = "lru";
+    int64_t cacheMem = 256;
+    std::vector<const char *> ufsDirs;
+    int admission = 0;
+    const char *convertPath = nullptr;
+
+    int arg = 1;
+    for (; arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0; arg += 2) {
+        const auto option = argv[arg];
+        const auto value = argv[arg + 1];
+        if (strcmp(option, "--policy") == 0)
+            policy = value;
+        else if (strcmp(option, "--cache-mem") == 0)
+            cacheMem = atoll(value);
+        else if (strcmp(option, "--ufs") == 0)
+            ufsDirs.push_back(value);
+        else if (strcmp(option, "--admission") == 0)
+            admission = atoi(value);
+        else if (strcmp(option, "--convert") == 0)
+            convertPath = value;
+        else
+            return Usage(argv[0]);
+    }
+    if (arg + 1 != argc || cacheMem < 0)
+        return Usage(argv[0]);
+
+    TraceReader trace(argv[arg]);
+    if (convertPath)
+        return Convert(trace, convertPath);
+
+    getCurrentTime();
+
+    Config.Store.avgObjectSize = 13 * 1024;
+    Config.Store.objectsPerBucket = 20;
+    Config.Store.maxObjectSize = 4 * 1024 * 1024;
+    Config.Store.maxInMemObjSize = 512 * 1024;
+    Config.Store.admissionMinFrequency = admission;
+    Config.Swap.lowWaterMark = 90;
+    Config.Swap.highWaterMark = 95;
+    Config.memMaxSize = cacheMem << 20;
+    Config.memShared.configure(false);
+    Config.onoff.memory_cache_first = 1; // memory_cache_mode always
+    Config.onoff.memory_cache_disk = 1;
+    Config.store_dir_select_algorithm = xstrdup("least-load");
+    Config.replPolicy = MakePolicySettings(policy);
+    Config.memPolicy = MakePolicySettings(policy);
+    visible_appname_string = xstrdup(PACKAGE "/" VERSION);
+
+    storeReplSetup();
+    Mem::Init();
+    fde::Init();
+    comm_init();
+    httpHeaderInitModule();
+
+    for (const auto dir: ufsDirs)
+        AddUfsDir(dir);
+
+    Store::Root().configure();
+    mem_policy = createRemovalPolicy(Config.memPolicy);
+    Store::Root().init();
+
+    StockEventLoop loop;
+    while (StoreController::store_dirs_rebuilding > 1)
+        loop.runOnce();
+
+    std::cout << "replaying " << (trace.binary() ? "binary" : "text") << " trace " << argv[arg] <<
+              " with " << policy << " policy, cache_mem " << cacheMem << " MB, " <<
+              ufsDirs.size() << " UFS cache_dir(s)" << std::endl;
+
+    // store_client.cc stubs complain about every call, slowing the replay down
+    const auto stderrBuffer = std::cerr.rdbuf(nullptr);
+    Counters counters;
+    Replay(trace, counters);
+    std::cerr.rdbuf(stderrBuffer);
+    std::cerr.clear();
+
+    Report(counters);
+
+    storeDirWriteCleanLogs(0);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Compares two ways to allocate the short-lived objects of a simulated HTTP
+ * transaction: Allocating and freeing each object individually (using
+ * memory pools for fixed-size objects and malloc() for strings and
+ * buffers, as most Squid code does today) and allocating them all from a
+ * Mem::Arena released when the transaction ends. The per-transaction mix
+ * resembles header entries with their names and values, an ACL checklist,
+ * logged header images, and log format assembly buffers.
+ *
+ * Usage: tests/benchTransactionArena [transactions [header fields]]
+ */
+
+#include "squid.h"
+#include "mem/Allocator.h"
+#include "mem/Arena.h"
+#include "mem/Pool.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/// the size of header entry objects
+static const size_t EntrySize = 48;
+/// the size of ACL checklist objects
+static const size_t ChecklistSize = 640;
+/// the number of logged header images (virgin, adapted, adaptation meta)
+static const int HeaderImages = 3;
+/// the number of log format assembly buffers
+static const int FormatBuffers = 6;
+static const size_t FormatBufferSize = 256;
+
+using Clock = std::chrono::steady_clock;
+
+/// the size of the n-th header field name or value
+static size_t
+FieldSize(const int n)
+{
+    return 8 + (n * 37) % 72;
+}
+
+/// the results of one benchmark round
+class Result
+{
+public:
+    double seconds = 0;
+    uint64_t allocatorCalls = 0; ///< pool and heap (de)allocation calls
+    uint64_t bytes = 0; ///< allocated memory volume
+};
+
+/// allocates and frees each object individually
+static Result
+RunIndividually(const int transactions, const int fields)
+{
+    const auto entries = memPoolCreate("bench entries", EntrySize);
+    const auto checklists = memPoolCreate("bench checklists", ChecklistSize);
+
+    Result result;
+    std::vector<void *> pooled;
+    std::vector<void *> heap;
+    const auto start = Clock::now();
+    for (int t = 0; t < transactions; ++t) {
+        for (int f = 0; f < fields; ++f) {
+            pooled.push_back(entries->alloc());
+            heap.push_back(xmalloc(FieldSize(f)));
+            heap.push_back(xmalloc(FieldSize(f + 1)));
+            result.bytes += EntrySize + FieldSize(f) + FieldSize(f + 1);
+        }
+        const auto checklist = checklists->alloc();
+        result.bytes += ChecklistSize;
+
+        for (int i = 0; i < HeaderImages; ++i) {
+            const auto size = fields * (FieldSize(i) + 4);
+            heap.push_back(xmalloc(size));
+            memset(heap.back(), 'h', size);
+            result.bytes += size;
+        }
+        for (int i = 0; i < FormatBuffers; ++i) {
+            heap.push_back(xmalloc(FormatBufferSize));
+            result.bytes += FormatBufferSize;
+        }
+
+        result.allocatorCalls += 2 * (pooled.size() + heap.size() + 1);
+        checklists->freeOne(checklist);
+        for (const auto entry: pooled)
+            entries->freeOne(entry);
+        for (const auto buf: heap)
+            xfree(buf);
+        pooled.clear();
+        heap.clear();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+/// allocates all objects from a per-transaction arena
+static Result
+RunInArena(const int transactions, const int fields)
+{
+    const auto blocksBefore = Mem::ArenaStatistics().blocksAllocated;
+
+    Result result;
+    const auto start = Clock::now();
+    for (int t = 0; t < transactions; ++t) {
+        Mem::Arena arena;
+        for (int f = 0; f < fields; ++f) {
+            (void)arena.allocate(EntrySize);
+            (void)arena.allocate(FieldSize(f), 1);
+            (void)arena.allocate(FieldSize(f + 1), 1);
+        }
+        (void)arena.allocate(ChecklistSize);
+
+        for (int i = 0; i < HeaderImages; ++i) {
+            const auto size = fields * (FieldSize(i) + 4);
+            memset(arena.allocate(size, 1), 'h', size);
+        }
+        for (int i = 0; i < FormatBuffers; ++i)
+            (void)arena.allocate(FormatBufferSize, 1);
+
+        result.bytes += arena.used();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // each heap block is malloc()ed once and freed (or cached) once
+    result.allocatorCalls = 2 * (Mem::ArenaStatistics().blocksAllocated - blocksBefore);
+    return result;
+}
+
+static void
+Report(const char *name, const Result &result, const int transactions)
+{
+    std::cout << std::setw(12) << name << ": " <<
+              std::fixed << std::setprecision(1) <<
+              (result.seconds * 1e9 / transactions) << " ns/transaction, " <<
+              (double(result.allocatorCalls) / transactions) << " allocator calls/transaction, " <<
+              (double(result.bytes) / transactions) << " bytes/transaction" << std::endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const auto transactions = argc > 1 ? atoi(argv[1]) : 1000000;
+    const auto fields = argc > 2 ? atoi(argv[2]) : 20;
+    if (transactions <= 0 || fields < 0) {
+        std::cerr << "usage: " << argv[0] << " [transactions [header fields]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << transactions << " transactions with " << fields << " header fields each" << std::endl;
+    Report("individual", RunIndividually(transactions, fields), transactions);
+    Report("arena", RunInArena(transactions, fields), transactions);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Replays a request trace against a cache of the given capacity using the
+ * eviction order of the tinylfu cache_replacement_policy (WTinyLfu) with a
+ * 1% and a 20% window, and with a 100% window (i.e. plain LRU, like the lru
+ * policy). Reports hit and byte hit ratios of each configuration.
+ *
+ * Each trace line is either "key [size]" or a native access.log record (the
+ * URL in the seventh field and the reply size in the fifth one). Missing
+ * sizes default to one byte. Every request is treated as cachable.
+ *
+ * Usage: tests/simTinyLfu [--bytes] capacity [trace]
+ *   capacity is the maximum number of cached objects or, with --bytes, the
+ *   maximum total size of cached objects; the trace is read from stdin by
+ *   default
+ */
+
+#include "squid.h"
+#include "repl/tinylfu/WTinyLfu.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// a single trace record
+class Request
+{
+public:
+    std::string key;
+    uint64_t size = 1;
+};
+
+/// parses a trace line; \returns false for lines without a request
+static bool
+ParseRequest(const std::string &line, Request &request)
+{
+    std::istringstream in(line);
+    std::vector<std::string> fields;
+    for (std::string field; fields.size() < 7 && in >> field;)
+        fields.push_back(field);
+
+    if (fields.empty() || fields[0][0] == '#')
+        return false;
+
+    std::string size;
+    if (fields.size() >= 7) {
+        request.key = fields[6];
+        size = fields[4];
+    } else {
+        request.key = fields[0];
+        if (fields.size() > 1)
+            size = fields[1];
+    }
+    request.size = size.empty() ? 1 : std::max<uint64_t>(1, strtoull(size.c_str(), nullptr, 10));
+    return true;
+}
+
+/// a cache simulated with the given WTinyLfu window size
+class Simulation
+{
+public:
+    Simulation(const char *aName, const int windowPercent, const uint64_t aCapacity, const bool byBytes):
+        name(aName), order(windowPercent), capacity(aCapacity), countBytes(byBytes) {}
+
+    void request(const Request &);
+    void report(std::ostream &) const;
+
+private:
+    /// a cached object
+    class Entry: public WTinyLfu::Node
+    {
+    public:
+        const std::string *key = nullptr; ///< points to the index key
+        uint64_t size = 0;
+    };
+
+    uint64_t used() const { return countBytes ? bytes : order.count(); }
+
+    const char *name;
+    WTinyLfu order;
+    std::unordered_map<std::string, Entry> index;
+    const uint64_t capacity;
+    const bool countBytes; ///< whether capacity limits bytes rather than objects
+
+    uint64_t bytes = 0; ///< total size of cached objects
+
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    uint64_t requestedBytes = 0;
+    uint64_t hitBytes = 0;
+};
+
+void
+Simulation::request(const Request &request)
+{
+    ++requests;
+    requestedBytes += request.size;
+
+    const auto found = index.find(request.key);
+    if (found != index.end()) {
+        ++hits;
+        hitBytes += found->second.size;
+        order.touch(found->second);
+        return;
+    }
+
+    const auto hash = std::hash<std::string>()(request.key);
+    const auto size = countBytes ? request.size : 1;
+    if (size > capacity)
+        return; // would not fit even into an empty cache
+
+    const auto inserted = index.emplace(request.key, Entry()).first;
+    auto &entry = inserted->second;
+    entry.key = &inserted->first;
+    entry.size = request.size;
+    bytes += request.size;
+    order.add(entry, hash);
+
+    while (used() > capacity) {
+        const auto victim = static_cast<Entry *>(order.evict());
+        assert(victim);
+        bytes -= victim->size;
+        index.erase(*victim->key);
+    }
+}
+
+void
+Simulation::report(std::ostream &os) const
+{
+    const auto ratio = [](const uint64_t part, const uint64_t whole) {
+        return whole ? 100.0 * part / whole : 0.0;
+    };
+    os << std::setw(12) << name << ": " <<
+       std::fixed << std::setprecision(2) <<
+       "hit ratio " << ratio(hits, requests) << "%, " <<
+       "byte hit ratio " << ratio(hitBytes, requestedBytes) << "%, " <<
+       order.count() << " objects cached" << std::endl;
+}
+
+static int
+Usage(const char *program)
+{
+    std::cerr << "usage: " << program << " [--bytes] capacity [trace]" << std::endl;
+    return EXIT_FAILURE;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int arg = 1;
+    const auto byBytes = arg < argc && strcmp(argv[arg], "--bytes") == 0;
+    if (byBytes)
+        ++arg;
+
+    if (arg >= argc)
+        return Usage(argv[0]);
+    const auto capacity = strtoull(argv[arg++], nullptr, 10);
+    if (!capacity)
+        return Usage(argv[0]);
+
+    std::ifstream file;
+    if (arg < argc) {
+        file.open(argv[arg]);
+        if (!file) {
+            std::cerr << argv[0] << ": cannot open " << argv[arg] << ": " << strerror(errno) << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    auto &in = file.is_open() ? static_cast<std::istream &>(file) : std::cin;
+
+    Simulation simulations[] = {
+        Simulation("lru", 100, capacity, byBytes),
+        Simulation("tinylfu 1%", 1, capacity, byBytes),
+        Simulation("tinylfu 20%", 20, capacity, byBytes)
+    };
+
+    uint64_t requests = 0;
+    Request request;
+    for (std::string line; std::getline(in, line);) {
+        if (!ParseRequest(line, request))
+            continue;
+        ++requests;
+        for (auto &simulation: simulations)
+            simulation.request(request);
+    }
+
+    std::cout << requests << " requests, capacity " << capacity << (byBytes ? " bytes" : " objects") << std::endl;
+    for (const auto &simulation: simulations)
+        simulation.report(std::cout);
+    return EXIT_SUCCESS;
+}
@@ -39,4 +39,7 @@ void MemStore::evictIfFound(const cache_key *) STUB
 bool MemStore::anchorToCache(StoreEntry&) STUB_RETVAL(false)
 bool MemStore::updateAnchored(StoreEntry&) STUB_RETVAL(false)
 int64_t MemStore::EntryLimit() STUB_RETVAL(0)
+bool MemStore::startSavingSnapshot() STUB_RETVAL(false)
+bool MemStore::saveSnapshot() STUB_RETVAL(false)
+bool MemStore::KeepsSnapshots() STUB_RETVAL(false)
 
@@ -50,6 +50,7 @@ void commUnsetFdTimeout(int) STUB
 // int commSetTimeout(const Comm::ConnectionPointer &, int, AsyncCall::Pointer&) STUB_RETVAL(-1)
 void commSetConnTimeout(const Comm::ConnectionPointer &, time_t, AsyncCall::Pointer &) STUB
 void commUnsetConnTimeout(const Comm::ConnectionPointer &) STUB
+void commScheduleTimeoutCheck(int) STUB
 int ignoreErrno(int) STUB_RETVAL(-1)
 void commCloseAllSockets(void) STUB
 void checkTimeouts(void) STUB
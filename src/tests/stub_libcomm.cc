@@ -44,17 +44,12 @@ const char * Comm::ConnOpener::getHost() const STUB_RETVAL(nullptr)
 #include "comm/forward.h"
 bool Comm::IsConnOpen(const Comm::ConnectionPointer &) STUB_RETVAL(false)
 
-#include "comm/IoCallback.h"
-void Comm::IoCallback::setCallback(iocb_type, AsyncCall::Pointer &, char *, FREE *, int) STUB
-void Comm::IoCallback::selectOrQueueWrite() STUB
-void Comm::IoCallback::cancel(const char *) STUB
-void Comm::IoCallback::finish(Comm::Flag, int) STUB
-
 #include "comm/Loops.h"
 void Comm::SelectLoopInit(void) STUB
 void Comm::SetSelect(int, unsigned int, PF *, void *, time_t) STUB
 Comm::Flag Comm::DoSelect(int) STUB_RETVAL(Comm::COMM_ERROR)
 void Comm::QuickPollRequired(void) STUB
+void Comm::NoteIoReadiness(int, unsigned int, bool) STUB
 
 #include "comm/Read.h"
 void Comm::Read(const Comm::ConnectionPointer &, AsyncCall::Pointer &) STUB
@@ -79,6 +74,7 @@ void Comm::ApplyTcpKeepAlive(int, const TcpKeepAlive &) STUB
 #include "comm/Write.h"
 void Comm::Write(const Comm::ConnectionPointer &, const char *, int, AsyncCall::Pointer &, FREE *) STUB
 void Comm::Write(const Comm::ConnectionPointer &, MemBuf *, AsyncCall::Pointer &) STUB
+void Comm::Write(const Comm::ConnectionPointer &, MemBuf *, const struct iovec *, int, AsyncCall::Pointer &) STUB
 void Comm::WriteCancel(const Comm::ConnectionPointer &, const char *) STUB
 /*PF*/ void Comm::HandleWrite(int, void*) STUB
 
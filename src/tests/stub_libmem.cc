@@ -20,6 +20,14 @@ void *Mem::AllocatorProxy::alloc() {return xmalloc(64*1024);}
 void Mem::AllocatorProxy::freeOne(void *address) {xfree(address);}
 int Mem::AllocatorProxy::inUseCount() const {return 0;}
 size_t Mem::AllocatorProxy::getStats(PoolStats &) STUB_RETVAL(0)
+const char *Mem::TypeLabel(const std::type_info &type) {return type.name();}
+
+#include "mem/Arena.h"
+void *Mem::Arena::allocateSlowly(size_t, size_t) STUB_RETVAL(nullptr)
+char *Mem::Arena::dup(const char *, size_t) STUB_RETVAL(nullptr)
+void Mem::Arena::release() STUB_NOP
+const Mem::ArenaStats &Mem::ArenaStatistics() STUB_RETSTATREF(Mem::ArenaStats)
+void Mem::ArenaReport(std::ostream &) STUB_NOP
 
 #include "mem/forward.h"
 void Mem::Init() STUB_NOP
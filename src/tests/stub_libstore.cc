@@ -38,6 +38,9 @@ bool Controller::markedForDeletionAndAbandoned(const StoreEntry &) const STUB_RE
 bool Controller::hasReadableDiskEntry(const StoreEntry &) const STUB_RETVAL(false)
 int64_t Controller::accumulateMore(StoreEntry &) const STUB_RETVAL(0)
 void Controller::configure() STUB
+bool Controller::admits(const StoreEntry &) const STUB_RETVAL(true)
+bool Controller::startSavingMemoryCacheSnapshot() STUB_RETVAL(false)
+bool Controller::saveMemoryCacheSnapshot() STUB_RETVAL(false)
 void Controller::handleIdleEntry(StoreEntry &) STUB
 void Controller::freeMemorySpace(const int) STUB
 void Controller::memoryOut(StoreEntry &, const bool) STUB
@@ -132,6 +135,16 @@ void allocate_new_swapdir(Store::DiskConfig &) STUB
 void free_cachedir(Store::DiskConfig *) STUB;
 void storeDirSwapLog(const StoreEntry *, int) STUB
 
+#include "store/FrequencySketch.h"
+namespace Store
+{
+FrequencySketch::FrequencySketch(size_t) {STUB_NOP}
+void FrequencySketch::resize(size_t) STUB
+void FrequencySketch::record(uint64_t) STUB
+uint8_t FrequencySketch::frequency(uint64_t) const STUB_RETVAL(0)
+uint64_t FrequencySketch::Hash(const cache_key *) STUB_RETVAL(0)
+}
+
 #include "store/LocalSearch.h"
 namespace Store
 {
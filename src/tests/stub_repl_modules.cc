@@ -0,0 +1,15 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "repl_modules.h"
+
+#define STUB_API "repl_modules.cc"
+#include "tests/STUB.h"
+
+void storeReplSetup(void) STUB
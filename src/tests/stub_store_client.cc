@@ -7,7 +7,6 @@
  */
 
 #include "squid.h"
-#include "repl_modules.h"
 #include "Store.h"
 #include "store_digest.h"
 #include "store_log.h"
@@ -23,7 +22,6 @@ void storeLog(int, const StoreEntry *) STUB_NOP
 void storeLogOpen(void) STUB
 void storeDigestInit(void) STUB
 void storeRebuildStart(void) STUB
-void storeReplSetup(void) STUB
 void store_client::noteSwapInDone(bool) STUB
 #if USE_DELAY_POOLS
 int store_client::bytesWanted() const STUB_RETVAL(0)
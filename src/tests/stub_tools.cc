@@ -25,7 +25,9 @@ void PrintRusage(void) STUB
 void death(int) STUB
 void BroadcastSignalIfAny(int &) STUB
 void sigusr2_handle(int) STUB
+#if !STUB_TOOLS_WITHOUT_DEBUG_TRAP
 void debug_trap(const char *) STUB
+#endif
 void sig_child(int) STUB
 const char * getMyHostname(void) STUB_RETVAL(nullptr)
 const char * uniqueHostname(void) STUB_RETVAL(nullptr)
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "acl/DomainIndex.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <string>
+#include <vector>
+
+class TestACLDomainIndex : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestACLDomainIndex);
+    CPPUNIT_TEST(testDomainNames);
+    CPPUNIT_TEST(testWildcards);
+    CPPUNIT_TEST(testCoveredDomains);
+    CPPUNIT_TEST(testIncrementalCommits);
+    CPPUNIT_TEST(testLargeList);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testDomainNames();
+    void testWildcards();
+    void testCoveredDomains();
+    void testIncrementalCommits();
+    void testLargeList();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestACLDomainIndex );
+
+/// an index of the given domains
+static Acl::DomainIndex
+MakeIndex(const std::vector<const char *> &domains)
+{
+    Acl::DomainIndex index;
+    for (const auto domain: domains)
+        index.add(domain);
+    index.commit();
+    return index;
+}
+
+/// whether the host matches an index with just the given domain
+static bool
+Matches(const char *host, const char *domain, const bool honorWildcards = false)
+{
+    return MakeIndex({domain}).match(host, honorWildcards);
+}
+
+void
+TestACLDomainIndex::testDomainNames()
+{
+    // matchDomainName() mdnNone rules documented in anyp/Uri.h
+    CPPUNIT_ASSERT(Matches("foo.com", "foo.com"));
+    CPPUNIT_ASSERT(Matches(".foo.com", "foo.com"));
+    CPPUNIT_ASSERT(!Matches("x.foo.com", "foo.com"));
+    CPPUNIT_ASSERT(Matches("foo.com", ".foo.com"));
+    CPPUNIT_ASSERT(Matches(".foo.com", ".foo.com"));
+    CPPUNIT_ASSERT(Matches("x.foo.com", ".foo.com"));
+    CPPUNIT_ASSERT(Matches(".x.foo.com", ".foo.com"));
+    CPPUNIT_ASSERT(Matches("y.x.foo.com", ".foo.com"));
+
+    // partial labels do not match
+    CPPUNIT_ASSERT(!Matches("xfoo.com", ".foo.com"));
+    CPPUNIT_ASSERT(!Matches("foo.com", ".xfoo.com"));
+    CPPUNIT_ASSERT(!Matches("oo.com", "foo.com"));
+    CPPUNIT_ASSERT(!Matches("com", ".foo.com"));
+    CPPUNIT_ASSERT(!Matches("foo.com.", "foo.com"));
+
+    // configured names are lowercased by the caller
+    CPPUNIT_ASSERT(Matches("WWW.Foo.COM", ".foo.com"));
+
+    CPPUNIT_ASSERT(!Matches("", "foo.com"));
+    CPPUNIT_ASSERT(!Matches(".", ".foo.com"));
+    CPPUNIT_ASSERT(!Matches(nullptr, "foo.com"));
+    CPPUNIT_ASSERT(!Acl::DomainIndex().match("foo.com"));
+}
+
+void
+TestACLDomainIndex::testWildcards()
+{
+    // matchDomainName() mdnHonorWildcards rules documented in anyp/Uri.h
+    CPPUNIT_ASSERT(Matches("*.foo.com", "x.foo.com", true));
+    CPPUNIT_ASSERT(Matches("*.foo.com", ".x.foo.com", true));
+    CPPUNIT_ASSERT(Matches("*.foo.com", ".foo.com", true));
+    CPPUNIT_ASSERT(!Matches("*.foo.com", "foo.com", true));
+
+    // wildcards are literal characters without mdnHonorWildcards
+    CPPUNIT_ASSERT(!Matches("*.foo.com", "x.foo.com"));
+    CPPUNIT_ASSERT(Matches("*.foo.com", "*.foo.com"));
+
+    CPPUNIT_ASSERT(Matches("*.foo.com", "y.x.foo.com", true));
+    CPPUNIT_ASSERT(!Matches("*.foo.com", "x.bar.com", true));
+    CPPUNIT_ASSERT(!Matches("*.foo.com", "xfoo.com", true));
+    // like matchDomainName(), only the "*" position matters
+    CPPUNIT_ASSERT(Matches("x*.foo.com", "xy.foo.com", true));
+    CPPUNIT_ASSERT(!Matches("*x.foo.com", "yx.foo.com", true));
+
+    // other index entries do not hide a wildcard match
+    CPPUNIT_ASSERT(MakeIndex({"foo.com", "*.foo.com", "a.foo.com"}).match("*.foo.com", true));
+    CPPUNIT_ASSERT(MakeIndex({"foo.com", "z.foo.com"}).match("*.foo.com", true));
+    CPPUNIT_ASSERT(!MakeIndex({"foo.com", "x.bar.com"}).match("*.foo.com", true));
+}
+
+void
+TestACLDomainIndex::testCoveredDomains()
+{
+    auto index = MakeIndex({"www.example.com", ".example.com", "example.com", "example.net", "example.net", "a.b.example.com"});
+    CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+
+    const auto contents = index.dump();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), contents.size());
+    CPPUNIT_ASSERT_EQUAL(SBuf(".example.com"), contents.front());
+    CPPUNIT_ASSERT_EQUAL(SBuf("example.net"), contents.back());
+
+    CPPUNIT_ASSERT(index.match("www.example.com"));
+    CPPUNIT_ASSERT(index.match("example.net"));
+    CPPUNIT_ASSERT(!index.match("www.example.net"));
+
+    // a set does not cover its sibling that shares a name prefix
+    index = MakeIndex({".example.com", "xexample.com", "example.com.au"});
+    CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+}
+
+void
+TestACLDomainIndex::testIncrementalCommits()
+{
+    Acl::DomainIndex index;
+    index.add("www.example.com");
+    index.add("example.org");
+    index.commit();
+    CPPUNIT_ASSERT(index.match("www.example.com"));
+    CPPUNIT_ASSERT(!index.match("mail.example.com"));
+
+    index.add(".example.com");
+    CPPUNIT_ASSERT(!index.match("mail.example.com")); // not committed yet
+    index.commit();
+    CPPUNIT_ASSERT(index.match("mail.example.com"));
+    CPPUNIT_ASSERT(index.match("example.org"));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+}
+
+/// a configured domain resembling those found in real-world block lists
+static std::string
+MakeDomain(const size_t n)
+{
+    const auto name = "d" + std::to_string(n) + ".zone" + std::to_string(n % 997);
+    return (n % 3 ? "" : ".") + name + (n % 2 ? ".com" : ".net");
+}
+
+void
+TestACLDomainIndex::testLargeList()
+{
+    // timing measurements for much larger lists are in tests/benchACLDomainIndex
+    const size_t domainCount = 10000;
+    Acl::DomainIndex index;
+    for (size_t i = 0; i < domainCount; ++i)
+        index.add(MakeDomain(i).c_str());
+    index.commit();
+    CPPUNIT_ASSERT_EQUAL(domainCount, index.size());
+
+    for (size_t n = 0; n < domainCount; n += 7) {
+        const auto domain = MakeDomain(n);
+        const auto isSet = domain[0] == '.';
+        // an exact match
+        CPPUNIT_ASSERT(index.match(domain.substr(isSet ? 1 : 0).c_str()));
+        // a subdomain only matches sets
+        const auto subdomain = "www" + (isSet ? domain : "." + domain);
+        CPPUNIT_ASSERT_EQUAL(isSet, index.match(subdomain.c_str()));
+        // a miss
+        const auto miss = "www.miss" + std::to_string(n) + ".example.com";
+        CPPUNIT_ASSERT(!index.match(miss.c_str()));
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "acl/Ip.h"
+#include "acl/IpIndex.h"
+#include "anyp/PortCfg.h"
+#include "compat/cppunit.h"
+#include "ip/tools.h"
+#include "sbuf/Stream.h"
+#include "unitTestMain.h"
+
+#include <vector>
+
+class TestACLIpIndex : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestACLIpIndex);
+    CPPUNIT_TEST(testAddresses);
+    CPPUNIT_TEST(testRanges);
+    CPPUNIT_TEST(testMasks);
+    CPPUNIT_TEST(testMaskedValues);
+    CPPUNIT_TEST(testOverlaps);
+    CPPUNIT_TEST(testProtocolOverlaps);
+    CPPUNIT_TEST(testIncrementalCommits);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testAddresses();
+    void testRanges();
+    void testMasks();
+    void testMaskedValues();
+    void testOverlaps();
+    void testProtocolOverlaps();
+    void testIncrementalCommits();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestACLIpIndex );
+
+/* globals required to resolve link issues */
+AnyP::PortCfgPointer HttpPortList;
+
+/// adds the given squid.conf ACL values to the index
+static void
+Add(Acl::IpIndex &index, const std::vector<const char *> &values)
+{
+    for (const auto value: values) {
+        const auto parsed = acl_ip_data::FactoryParse(value);
+        CPPUNIT_ASSERT_MESSAGE(value, parsed);
+        CPPUNIT_ASSERT_MESSAGE(value, !parsed->next); // no host names here
+        index.add(parsed);
+    }
+    index.commit();
+}
+
+/// whether the given address belongs to a committed value
+static bool
+Matches(const Acl::IpIndex &index, const char *address)
+{
+    const Ip::Address ip(address);
+    CPPUNIT_ASSERT_MESSAGE(address, !ip.isAnyAddr());
+    return index.match(ip);
+}
+
+/// the index contents in squid.conf ACL value format
+static SBuf
+Dump(const Acl::IpIndex &index)
+{
+    SBufStream os;
+    auto separator = "";
+    for (const auto &value: index.dump()) {
+        os << separator << value;
+        separator = " ";
+    }
+    return os.buf();
+}
+
+void
+TestACLIpIndex::testAddresses()
+{
+    Acl::IpIndex index;
+    CPPUNIT_ASSERT(index.empty());
+    CPPUNIT_ASSERT(!Matches(index, "127.0.0.1"));
+
+    Add(index, {"127.0.0.1", "192.0.2.7", "2001:db8::1"});
+    CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+
+    CPPUNIT_ASSERT(Matches(index, "127.0.0.1"));
+    CPPUNIT_ASSERT(Matches(index, "192.0.2.7"));
+    CPPUNIT_ASSERT(Matches(index, "2001:db8::1"));
+
+    CPPUNIT_ASSERT(!Matches(index, "127.0.0.2"));
+    CPPUNIT_ASSERT(!Matches(index, "127.0.0.0"));
+    CPPUNIT_ASSERT(!Matches(index, "192.0.2.6"));
+    CPPUNIT_ASSERT(!Matches(index, "192.0.2.8"));
+    CPPUNIT_ASSERT(!Matches(index, "2001:db8::2"));
+    CPPUNIT_ASSERT(!Matches(index, "::1"));
+    CPPUNIT_ASSERT(!Matches(index, "255.255.255.255"));
+}
+
+void
+TestACLIpIndex::testRanges()
+{
+    Acl::IpIndex index;
+    Add(index, {"10.0.0.10-10.0.0.20", "10.0.1.0-10.0.2.255", "2001:db8::100-2001:db8::1ff"});
+    CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+
+    CPPUNIT_ASSERT(!Matches(index, "10.0.0.9"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.0.10"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.0.15"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.0.20"));
+    CPPUNIT_ASSERT(!Matches(index, "10.0.0.21"));
+
+    // ranges cross octet boundaries
+    CPPUNIT_ASSERT(!Matches(index, "10.0.0.255"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.1.0"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.1.255"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.2.0"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.2.255"));
+    CPPUNIT_ASSERT(!Matches(index, "10.0.3.0"));
+
+    CPPUNIT_ASSERT(!Matches(index, "2001:db8::ff"));
+    CPPUNIT_ASSERT(Matches(index, "2001:db8::100"));
+    CPPUNIT_ASSERT(Matches(index, "2001:db8::1ff"));
+    CPPUNIT_ASSERT(!Matches(index, "2001:db8::200"));
+}
+
+void
+TestACLIpIndex::testMasks()
+{
+    Acl::IpIndex index;
+    Add(index, {"192.168.0.0/16", "172.16.0.0/255.240.0.0", "198.51.100.128/25", "2001:db8:1::/48"});
+    CPPUNIT_ASSERT_EQUAL(size_t(4), index.size());
+
+    CPPUNIT_ASSERT(!Matches(index, "192.167.255.255"));
+    CPPUNIT_ASSERT(Matches(index, "192.168.0.0"));
+    CPPUNIT_ASSERT(Matches(index, "192.168.77.1"));
+    CPPUNIT_ASSERT(Matches(index, "192.168.255.255"));
+    CPPUNIT_ASSERT(!Matches(index, "192.169.0.0"));
+
+    // a netmask
+    CPPUNIT_ASSERT(!Matches(index, "172.15.255.255"));
+    CPPUNIT_ASSERT(Matches(index, "172.16.0.0"));
+    CPPUNIT_ASSERT(Matches(index, "172.31.255.255"));
+    CPPUNIT_ASSERT(!Matches(index, "172.32.0.0"));
+
+    CPPUNIT_ASSERT(!Matches(index, "198.51.100.127"));
+    CPPUNIT_ASSERT(Matches(index, "198.51.100.128"));
+    CPPUNIT_ASSERT(Matches(index, "198.51.100.255"));
+    CPPUNIT_ASSERT(!Matches(index, "198.51.101.0"));
+
+    CPPUNIT_ASSERT(!Matches(index, "2001:db8:0:ffff::1"));
+    CPPUNIT_ASSERT(Matches(index, "2001:db8:1::"));
+    CPPUNIT_ASSERT(Matches(index, "2001:db8:1:ffff:ffff:ffff:ffff:ffff"));
+    CPPUNIT_ASSERT(!Matches(index, "2001:db8:2::"));
+}
+
+void
+TestACLIpIndex::testMaskedValues()
+{
+    // an address with bits outside its mask matches the whole subnet
+    {
+        Acl::IpIndex index;
+        Add(index, {"127.0.0.1/24"});
+        CPPUNIT_ASSERT(Matches(index, "127.0.0.0"));
+        CPPUNIT_ASSERT(Matches(index, "127.0.0.1"));
+        CPPUNIT_ASSERT(Matches(index, "127.0.0.255"));
+        CPPUNIT_ASSERT(!Matches(index, "127.0.1.0"));
+        CPPUNIT_ASSERT(!Matches(index, "126.255.255.255"));
+    }
+
+    // a masked range covers all subnets touched by its boundaries
+    {
+        Acl::IpIndex index;
+        Add(index, {"10.0.0.1-10.0.0.255/24"});
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.0"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.1"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.255"));
+        CPPUNIT_ASSERT(!Matches(index, "10.0.1.0"));
+    }
+    {
+        Acl::IpIndex index;
+        Add(index, {"10.0.0.200-10.0.2.1/24"});
+        CPPUNIT_ASSERT(!Matches(index, "9.255.255.255"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.0"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.1.7"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.2.255"));
+        CPPUNIT_ASSERT(!Matches(index, "10.0.3.0"));
+    }
+
+    {
+        Acl::IpIndex index;
+        Add(index, {"2001:db8::1/64"});
+        CPPUNIT_ASSERT(Matches(index, "2001:db8::"));
+        CPPUNIT_ASSERT(Matches(index, "2001:db8::ffff:ffff:ffff:ffff"));
+        CPPUNIT_ASSERT(!Matches(index, "2001:db8:0:1::"));
+    }
+}
+
+void
+TestACLIpIndex::testOverlaps()
+{
+    // covered values are dropped, regardless of their configuration order
+    {
+        Acl::IpIndex index;
+        Add(index, {"10.1.2.3", "10.0.0.0/8", "10.2.0.0/16", "10.3.0.1-10.3.0.9"});
+        CPPUNIT_ASSERT_EQUAL(size_t(1), index.size());
+        CPPUNIT_ASSERT_EQUAL(SBuf("10.0.0.0/8"), Dump(index));
+        CPPUNIT_ASSERT(Matches(index, "10.255.255.255"));
+        CPPUNIT_ASSERT(!Matches(index, "11.0.0.0"));
+    }
+
+    // partially overlapping values are combined
+    {
+        Acl::IpIndex index;
+        Add(index, {"10.0.0.1-10.0.0.20", "10.0.0.10-10.0.0.30", "10.0.0.25-10.0.0.40"});
+        CPPUNIT_ASSERT_EQUAL(size_t(1), index.size());
+        CPPUNIT_ASSERT(!Matches(index, "10.0.0.0"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.1"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.22"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.40"));
+        CPPUNIT_ASSERT(!Matches(index, "10.0.0.41"));
+    }
+
+    // adjacent values stay separate, leaving no gaps
+    {
+        Acl::IpIndex index;
+        Add(index, {"10.0.1.0/24", "10.0.0.0/24", "10.0.3.0/24"});
+        CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+        CPPUNIT_ASSERT_EQUAL(SBuf("10.0.0.0/24 10.0.1.0/24 10.0.3.0/24"), Dump(index));
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.255"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.1.0"));
+        CPPUNIT_ASSERT(!Matches(index, "10.0.2.0"));
+        CPPUNIT_ASSERT(Matches(index, "10.0.3.0"));
+    }
+
+    // duplicates
+    {
+        Acl::IpIndex index;
+        Add(index, {"192.0.2.1", "192.0.2.1", "2001:db8::/32", "2001:db8::/32"});
+        CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+    }
+}
+
+void
+TestACLIpIndex::testProtocolOverlaps()
+{
+    // IPv4 values do not match IPv6 addresses, even if their bits are equal
+    {
+        Acl::IpIndex index;
+        Add(index, {"10.0.0.0/8", "0.0.0.1"});
+        CPPUNIT_ASSERT(Matches(index, "10.1.1.1"));
+        CPPUNIT_ASSERT(Matches(index, "0.0.0.1"));
+        CPPUNIT_ASSERT(!Matches(index, "::a01:101"));
+        CPPUNIT_ASSERT(!Matches(index, "::1"));
+    }
+
+    // IPv4 addresses use their IPv4-mapped IPv6 form
+    {
+        Acl::IpIndex index;
+        Add(index, {"::ffff:10.0.0.1", "::ffff:0:0-::ffff:0:ffff"});
+        CPPUNIT_ASSERT(Matches(index, "10.0.0.1"));
+        CPPUNIT_ASSERT(Matches(index, "::ffff:10.0.0.1"));
+        CPPUNIT_ASSERT(Matches(index, "0.0.255.255"));
+        CPPUNIT_ASSERT(!Matches(index, "0.1.0.0"));
+    }
+
+    // an IPv6 range spanning all IPv4-mapped addresses covers IPv4 values
+    {
+        Acl::IpIndex index;
+        Add(index, {"192.0.2.0/24", "::fffe:0:0-::1:0:0:0", "2001:db8::/32"});
+        CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+        CPPUNIT_ASSERT(Matches(index, "192.0.2.1"));
+        CPPUNIT_ASSERT(Matches(index, "203.0.113.1"));
+        CPPUNIT_ASSERT(Matches(index, "::fffe:0:1"));
+        CPPUNIT_ASSERT(!Matches(index, "::1:0:0:1"));
+        CPPUNIT_ASSERT(Matches(index, "2001:db8::1"));
+        CPPUNIT_ASSERT(!Matches(index, "::1"));
+    }
+}
+
+void
+TestACLIpIndex::testIncrementalCommits()
+{
+    Acl::IpIndex index;
+    Add(index, {"10.0.0.0/24"});
+    Add(index, {"10.0.0.128/25", "10.0.1.0/24", "2001:db8::1"});
+    CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+    CPPUNIT_ASSERT(Matches(index, "10.0.0.200"));
+    CPPUNIT_ASSERT(Matches(index, "10.0.1.200"));
+    CPPUNIT_ASSERT(Matches(index, "2001:db8::1"));
+
+    // an empty commit changes nothing
+    index.commit();
+    CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+}
+
+/// customizes our test setup
+class MyTestProgram: public TestProgram
+{
+public:
+    /* TestProgram API */
+    void startup() override { Ip::EnableIpv6 = IPV6_ON; }
+};
+
+int
+main(int argc, char *argv[])
+{
+    return MyTestProgram().run(argc, argv);
+}
+
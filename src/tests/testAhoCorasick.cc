@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/AhoCorasick.h"
+#include "base/RegexPattern.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <set>
+#include <vector>
+
+class TestAhoCorasick : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestAhoCorasick);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testIds);
+    CPPUNIT_TEST(testOverlaps);
+    CPPUNIT_TEST(testCaseInsensitivity);
+    CPPUNIT_TEST(testStop);
+    CPPUNIT_TEST(testRequiredLiteral);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testEmpty();
+    void testIds();
+    void testOverlaps();
+    void testCaseInsensitivity();
+    void testStop();
+    void testRequiredLiteral();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestAhoCorasick );
+
+/// all needle ids found in the given text, in their find() order
+static std::vector<AhoCorasick::Id>
+FindAll(const AhoCorasick &ac, const char *text)
+{
+    std::vector<AhoCorasick::Id> found;
+    ac.find(text, strlen(text), [&found](const AhoCorasick::Id id, size_t) {
+        found.push_back(id);
+        return true;
+    });
+    return found;
+}
+
+/// RegexPattern::requiredLiteral() result for the given extended regex
+static SBuf
+RequiredLiteral(const char *re, const int extraFlags = 0)
+{
+    const RegexPattern pattern(SBuf(re), REG_EXTENDED | REG_NOSUB | extraFlags);
+    return pattern.requiredLiteral();
+}
+
+void
+TestAhoCorasick::testEmpty()
+{
+    AhoCorasick ac;
+    CPPUNIT_ASSERT(ac.empty());
+    ac.compile();
+    CPPUNIT_ASSERT(FindAll(ac, "anything").empty());
+}
+
+void
+TestAhoCorasick::testIds()
+{
+    AhoCorasick ac;
+    CPPUNIT_ASSERT_EQUAL(AhoCorasick::Id(0), ac.add(SBuf("example")));
+    CPPUNIT_ASSERT_EQUAL(AhoCorasick::Id(1), ac.add(SBuf(".gif")));
+    CPPUNIT_ASSERT_EQUAL(AhoCorasick::Id(0), ac.add(SBuf("EXAMPLE")));
+    CPPUNIT_ASSERT_EQUAL(AhoCorasick::Id(2), ac.add(SBuf("exam")));
+    ac.compile();
+    CPPUNIT_ASSERT_EQUAL(size_t(3), ac.size());
+
+    const auto found = FindAll(ac, "http://example.com/a.gif");
+    const std::vector<AhoCorasick::Id> expected = { 2, 0, 1 };
+    CPPUNIT_ASSERT(found == expected);
+
+    CPPUNIT_ASSERT(FindAll(ac, "http://exa.com/a.jpg").empty());
+}
+
+void
+TestAhoCorasick::testOverlaps()
+{
+    // classic example with needles that are suffixes of each other
+    AhoCorasick ac;
+    const auto he = ac.add(SBuf("he"));
+    const auto she = ac.add(SBuf("she"));
+    const auto his = ac.add(SBuf("his"));
+    const auto hers = ac.add(SBuf("hers"));
+    ac.compile();
+
+    const auto found = FindAll(ac, "ushers");
+    const std::multiset<AhoCorasick::Id> foundSet(found.begin(), found.end());
+    const std::multiset<AhoCorasick::Id> expected = { she, he, hers };
+    CPPUNIT_ASSERT(foundSet == expected);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), foundSet.count(his));
+
+    // overlapping occurrences are all reported
+    const auto repeated = FindAll(ac, "hehehe");
+    CPPUNIT_ASSERT_EQUAL(size_t(3), repeated.size());
+}
+
+void
+TestAhoCorasick::testCaseInsensitivity()
+{
+    AhoCorasick ac;
+    const auto id = ac.add(SBuf("WindowsUpdate"));
+    ac.compile();
+
+    const auto found = FindAll(ac, "http://download.windowsupdate.com/");
+    CPPUNIT_ASSERT_EQUAL(size_t(1), found.size());
+    CPPUNIT_ASSERT_EQUAL(id, found.front());
+}
+
+void
+TestAhoCorasick::testStop()
+{
+    AhoCorasick ac;
+    (void)ac.add(SBuf("a"));
+    ac.compile();
+
+    int calls = 0;
+    ac.find("aaaa", 4, [&calls](AhoCorasick::Id, size_t) {
+        ++calls;
+        return false;
+    });
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+}
+
+void
+TestAhoCorasick::testRequiredLiteral()
+{
+    CPPUNIT_ASSERT_EQUAL(SBuf("windowsupdate.com"), RequiredLiteral("windowsupdate\\.com"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("/cgi-bin/"), RequiredLiteral("/cgi-bin/"));
+    CPPUNIT_ASSERT_EQUAL(SBuf(".gif"), RequiredLiteral("\\.gif$", REG_ICASE));
+    CPPUNIT_ASSERT_EQUAL(SBuf("ftp:"), RequiredLiteral("^ftp:"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("example."), RequiredLiteral("^http://(www\\.)?example\\.[a-z]+/"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("update"), RequiredLiteral("update[0-9]*\\.ms"));
+    CPPUNIT_ASSERT_EQUAL(SBuf(".microsoft"), RequiredLiteral("updates?\\.microsoft"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("abc"), RequiredLiteral("abc+d"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("xyz"), RequiredLiteral("ab{2}xyz"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("bar"), RequiredLiteral("[]x[:alpha:]]fo[[:digit:]]bar"));
+
+    // no usable literal
+    CPPUNIT_ASSERT(RequiredLiteral(".").isEmpty());
+    CPPUNIT_ASSERT(RequiredLiteral("^$").isEmpty());
+    CPPUNIT_ASSERT(RequiredLiteral("foo|bar").isEmpty());
+    CPPUNIT_ASSERT(RequiredLiteral("(foo|bar)").isEmpty());
+    CPPUNIT_ASSERT(RequiredLiteral("a*").isEmpty());
+
+    // non-ASCII letters are folded by the locale, not the literal automaton
+    CPPUNIT_ASSERT_EQUAL(SBuf("caf\xC3\xA9.example"), RequiredLiteral("caf\xC3\xA9\\.example"));
+    CPPUNIT_ASSERT(RequiredLiteral("caf\xC3\xA9\\.example", REG_ICASE).isEmpty());
+    CPPUNIT_ASSERT(RequiredLiteral("^http://\xC3\x89t\xC3\xA9/", REG_ICASE).isEmpty());
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
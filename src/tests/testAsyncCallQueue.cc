@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/AsyncCall.h"
+#include "base/AsyncCallQueue.h"
+#include "base/AsyncFunCalls.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <sstream>
+#include <vector>
+
+class TestAsyncCallQueue : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestAsyncCallQueue);
+    CPPUNIT_TEST(testFiringOrder);
+    CPPUNIT_TEST(testCallsScheduledWhileFiring);
+    CPPUNIT_TEST(testPools);
+    CPPUNIT_TEST(testStats);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testFiringOrder();
+    void testCallsScheduledWhileFiring();
+    void testPools();
+    void testStats();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestAsyncCallQueue );
+
+/// IDs of fired calls, in their firing order
+static std::vector<int> Fired;
+
+static void
+RecordCall(const int id)
+{
+    Fired.push_back(id);
+}
+
+static void
+IgnoreCall()
+{
+}
+
+static void
+ScheduleRecordCall(const char *name, const int id)
+{
+    ScheduleCallHere(asyncCall(5, 5, name, callDialer(&RecordCall, id)));
+}
+
+/// schedules the calls that testCallsScheduledWhileFiring() expects
+static void
+RescheduleCall(const int id)
+{
+    RecordCall(id);
+    if (id < 1000)
+        ScheduleRecordCall("TestAsyncCallQueue::RescheduleCall", id + 1000);
+}
+
+void
+TestAsyncCallQueue::testFiringOrder()
+{
+    Fired.clear();
+    CPPUNIT_ASSERT(!AsyncCallQueue::Instance().fire());
+
+    // enough calls for several dispatch batches
+    std::vector<int> expected;
+    for (int id = 0; id < 200; ++id) {
+        ScheduleRecordCall("TestAsyncCallQueue::RecordCall", id);
+        expected.push_back(id);
+    }
+
+    CPPUNIT_ASSERT(AsyncCallQueue::Instance().fire());
+    CPPUNIT_ASSERT(Fired == expected);
+    CPPUNIT_ASSERT(!AsyncCallQueue::Instance().fire());
+}
+
+void
+TestAsyncCallQueue::testCallsScheduledWhileFiring()
+{
+    Fired.clear();
+
+    // calls scheduled by fired calls are fired after the already scheduled
+    // ones, by the same fire() call, even when they start a new batch
+    std::vector<int> expected;
+    for (int id = 0; id < 100; ++id) {
+        ScheduleCallHere(asyncCall(5, 5, "TestAsyncCallQueue::RescheduleCall", callDialer(&RescheduleCall, id)));
+        expected.push_back(id);
+    }
+    for (int id = 0; id < 100; ++id)
+        expected.push_back(id + 1000);
+
+    CPPUNIT_ASSERT(AsyncCallQueue::Instance().fire());
+    CPPUNIT_ASSERT(Fired == expected);
+    CPPUNIT_ASSERT(!AsyncCallQueue::Instance().fire());
+}
+
+void
+TestAsyncCallQueue::testPools()
+{
+    using NullaryCall = AsyncCallT<NullaryFunDialer>;
+    using UnaryCall = AsyncCallT<UnaryFunDialer<int> >;
+
+    const auto nullaryCalls = NullaryCall::UseCount();
+    const auto unaryCalls = UnaryCall::UseCount();
+    {
+        const AsyncCall::Pointer call = asyncCall(5, 5, "TestAsyncCallQueue::IgnoreCall", NullaryFunDialer(&IgnoreCall));
+        CPPUNIT_ASSERT_EQUAL(nullaryCalls + 1, NullaryCall::UseCount());
+        // calls with other dialers are allocated from their own pools
+        CPPUNIT_ASSERT_EQUAL(unaryCalls, UnaryCall::UseCount());
+
+        ScheduleCallHere(call);
+        CPPUNIT_ASSERT(AsyncCallQueue::Instance().fire());
+        CPPUNIT_ASSERT_EQUAL(nullaryCalls + 1, NullaryCall::UseCount());
+    }
+    // fired calls are returned to their pool when released
+    CPPUNIT_ASSERT_EQUAL(nullaryCalls, NullaryCall::UseCount());
+}
+
+/// whether the async_calls report mentions the given call name
+static bool
+Reported(const char *callName)
+{
+    std::ostringstream os;
+    AsyncCallQueue::Instance().reportStats(os);
+    return os.str().find(callName) != std::string::npos;
+}
+
+void
+TestAsyncCallQueue::testStats()
+{
+    AsyncCallQueue::CollectStats = 0;
+    ScheduleRecordCall("TestAsyncCallQueue::Unmeasured", 1);
+    CPPUNIT_ASSERT(AsyncCallQueue::Instance().fire());
+    CPPUNIT_ASSERT(!Reported("TestAsyncCallQueue::Unmeasured"));
+
+    // calls scheduled before statistics collection was enabled are skipped
+    ScheduleRecordCall("TestAsyncCallQueue::Unmeasured", 2);
+    AsyncCallQueue::CollectStats = 1;
+    ScheduleRecordCall("TestAsyncCallQueue::Measured", 3);
+    CPPUNIT_ASSERT(AsyncCallQueue::Instance().fire());
+    CPPUNIT_ASSERT(!Reported("TestAsyncCallQueue::Unmeasured"));
+    CPPUNIT_ASSERT(Reported("TestAsyncCallQueue::Measured"));
+
+    AsyncCallQueue::CollectStats = 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
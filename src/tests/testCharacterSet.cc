@@ -23,6 +23,7 @@ class TestCharacterSet : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST(CharacterSetConstants);
     CPPUNIT_TEST(CharacterSetUnion);
     CPPUNIT_TEST(CharacterSetSubtract);
+    CPPUNIT_TEST(CharacterSetFind);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -33,6 +34,7 @@ protected:
     void CharacterSetUnion();
     void CharacterSetEqualityOp();
     void CharacterSetSubtract();
+    void CharacterSetFind();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( TestCharacterSet );
@@ -143,6 +145,57 @@ TestCharacterSet::CharacterSetSubtract()
     CPPUNIT_ASSERT_EQUAL(CharacterSet::HEXDIG, sample - CharacterSet(nullptr, "qz"));
 }
 
+/// the first character in [begin, end) with the given membership, one character at a time
+static const char *
+FindSlowly(const CharacterSet &set, const char *begin, const char * const end, const bool member)
+{
+    while (begin < end && set[*begin] != member)
+        ++begin;
+    return begin;
+}
+
+void
+TestCharacterSet::CharacterSetFind()
+{
+    const std::string empty;
+    CPPUNIT_ASSERT(CharacterSet::ALPHA.findFirstIn(empty.data(), empty.data()) == empty.data());
+    CPPUNIT_ASSERT(CharacterSet::ALPHA.findFirstNotIn(empty.data(), empty.data()) == empty.data());
+
+    // sets with members in both halves of the character table
+    const CharacterSet sets[] = {
+        CharacterSet::TCHAR,
+        CharacterSet::CTL,
+        CharacterSet::QDTEXT,
+        CharacterSet::OBSTEXT.complement(),
+        CharacterSet(nullptr, "\x80\xff").add('\0'),
+    };
+
+    // exercise vectorized and plain scans: short and long inputs, with the
+    // wanted character at every position
+    std::string input;
+    for (int c = 0; c < 256; ++c)
+        input.push_back(static_cast<char>(c));
+    input += input;
+    for (const auto &set: sets) {
+        for (size_t length = 0; length <= input.size(); length += 7) {
+            for (size_t offset = 0; offset + length <= input.size(); offset += 61) {
+                const auto begin = input.data() + offset;
+                const auto end = begin + length;
+                CPPUNIT_ASSERT(set.findFirstIn(begin, end) == FindSlowly(set, begin, end, true));
+                CPPUNIT_ASSERT(set.findFirstNotIn(begin, end) == FindSlowly(set, begin, end, false));
+            }
+        }
+    }
+
+    // the wanted character is the last one in a long input
+    std::string token(1000, 'x');
+    token.back() = ' ';
+    CPPUNIT_ASSERT(CharacterSet::TCHAR.findFirstNotIn(token.data(), token.data() + token.size()) == &token.back());
+    CPPUNIT_ASSERT(CharacterSet::SP.findFirstIn(token.data(), token.data() + token.size()) == &token.back());
+    token.back() = 'y';
+    CPPUNIT_ASSERT(CharacterSet::SP.findFirstIn(token.data(), token.data() + token.size()) == token.data() + token.size());
+}
+
 int
 main(int argc, char *argv[])
 {
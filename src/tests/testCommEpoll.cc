@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "comm/Loops.h"
+#include "compat/cppunit.h"
+#include "fde.h"
+#include "globals.h"
+#include "SquidConfig.h"
+#include "unitTestMain.h"
+
+#include <cstring>
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if USE_EPOLL
+
+/// the number of ReadHandler() calls
+static int ReadHandlerCalls = 0;
+
+/// a read handler that only counts its calls; tests perform reads themselves
+static void
+ReadHandler(int, void *)
+{
+    ++ReadHandlerCalls;
+}
+
+/// a connected pair of non-blocking stream sockets, with the receiving socket
+/// open in fd_table and monitored by the edge-triggered I/O loop
+class EdgeSockets
+{
+public:
+    EdgeSockets();
+    ~EdgeSockets();
+
+    /// writes the given string into the sending socket
+    void send(const char *text);
+
+    /// reads up to maxSize bytes from the receiving socket
+    /// \returns the number of bytes read or -1 with errno set
+    ssize_t receive(size_t maxSize);
+
+    /// (re)registers ReadHandler() for the receiving socket
+    void waitForReading() { Comm::SetSelect(receiver, COMM_SELECT_READ, ReadHandler, nullptr, 0); }
+
+    int sender = -1; ///< sends bytes to receiver
+    int receiver = -1; ///< the socket monitored by the I/O loop
+};
+
+EdgeSockets::EdgeSockets()
+{
+    int sockets[2];
+    CPPUNIT_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets));
+    sender = sockets[0];
+    receiver = sockets[1];
+    CPPUNIT_ASSERT(receiver < Squid_MaxFD);
+    fd_table[receiver].flags.open = true;
+}
+
+EdgeSockets::~EdgeSockets()
+{
+    // deregisters the FD from epoll
+    Comm::SetSelect(receiver, COMM_SELECT_READ | COMM_SELECT_WRITE, nullptr, nullptr, 0);
+    // forget any queued dispatch before the FD number is reused
+    while (Comm::DoSelect(0) != Comm::TIMEOUT) {}
+    fd_table[receiver].flags.open = false;
+    close(receiver);
+    close(sender);
+}
+
+void
+EdgeSockets::send(const char *text)
+{
+    const auto size = strlen(text);
+    CPPUNIT_ASSERT_EQUAL(ssize_t(size), write(sender, text, size));
+}
+
+ssize_t
+EdgeSockets::receive(const size_t maxSize)
+{
+    char buf[64];
+    CPPUNIT_ASSERT(maxSize <= sizeof(buf));
+    return read(receiver, buf, maxSize);
+}
+
+/// the number of ReadHandler() calls made by one I/O loop iteration
+static int
+HandlerCallsDuringSelect()
+{
+    const auto before = ReadHandlerCalls;
+    (void)Comm::DoSelect(0);
+    return ReadHandlerCalls - before;
+}
+
+/*
+ * Checks how the edge-triggered epoll(7) I/O loop tracks FD readiness in
+ * userspace: The kernel reports each readiness change once, so the loop must
+ * call handlers of FDs that are still ready without any new kernel events and
+ * must re-check readiness with EPOLL_CTL_MOD when the last handler did not
+ * tell what happened to it.
+ */
+class TestCommEpoll : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestCommEpoll);
+    CPPUNIT_TEST(testFirstEdge);
+    CPPUNIT_TEST(testPartialReadLeavesReady);
+    CPPUNIT_TEST(testWouldBlockClearsReadiness);
+    CPPUNIT_TEST(testUnknownReadinessRearms);
+    CPPUNIT_TEST(testReadinessWithHandler);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+
+protected:
+    void testFirstEdge();
+    void testPartialReadLeavesReady();
+    void testWouldBlockClearsReadiness();
+    void testUnknownReadinessRearms();
+    void testReadinessWithHandler();
+
+private:
+    /// registers ReadHandler(), delivers some bytes, and checks that the
+    /// kernel edge results in a single handler call
+    void startReading(EdgeSockets &sockets);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestCommEpoll );
+
+void
+TestCommEpoll::setUp()
+{
+    static bool initialized = false;
+    if (!initialized) {
+        fde::Table = static_cast<fde *>(xcalloc(Squid_MaxFD, sizeof(fde))); // as fde::Init() does
+        Config.onoff.epoll_edge_triggered = 1;
+        Comm::SelectLoopInit();
+        initialized = true;
+    }
+}
+
+void
+TestCommEpoll::startReading(EdgeSockets &sockets)
+{
+    sockets.waitForReading(); // EPOLL_CTL_ADD
+    CPPUNIT_ASSERT_EQUAL(0, HandlerCallsDuringSelect());
+
+    sockets.send("hello");
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+}
+
+void
+TestCommEpoll::testFirstEdge()
+{
+    EdgeSockets sockets;
+    startReading(sockets);
+
+    // the handler was not re-registered
+    sockets.send("more");
+    CPPUNIT_ASSERT_EQUAL(0, HandlerCallsDuringSelect());
+}
+
+void
+TestCommEpoll::testPartialReadLeavesReady()
+{
+    EdgeSockets sockets;
+    startReading(sockets);
+
+    // a read that fills the reader buffer may leave more bytes in the socket
+    CPPUNIT_ASSERT_EQUAL(ssize_t(2), sockets.receive(2));
+    Comm::NoteIoReadiness(sockets.receiver, COMM_SELECT_READ, true);
+
+    // the kernel will not report the remaining bytes again, but the loop
+    // still calls the new handler
+    sockets.waitForReading();
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+
+    // ... even when the remaining bytes are gone and no re-check happens
+    CPPUNIT_ASSERT_EQUAL(ssize_t(3), sockets.receive(3));
+    Comm::NoteIoReadiness(sockets.receiver, COMM_SELECT_READ, true);
+    sockets.waitForReading();
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+}
+
+void
+TestCommEpoll::testWouldBlockClearsReadiness()
+{
+    EdgeSockets sockets;
+    startReading(sockets);
+
+    CPPUNIT_ASSERT_EQUAL(ssize_t(5), sockets.receive(5));
+    CPPUNIT_ASSERT_EQUAL(ssize_t(-1), sockets.receive(5));
+    CPPUNIT_ASSERT_EQUAL(EAGAIN, errno);
+    Comm::NoteIoReadiness(sockets.receiver, COMM_SELECT_READ, false);
+
+    // a drained FD waits for the kernel
+    sockets.waitForReading();
+    CPPUNIT_ASSERT_EQUAL(0, HandlerCallsDuringSelect());
+
+    // which reports new bytes as a new edge
+    sockets.send("more");
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+}
+
+void
+TestCommEpoll::testUnknownReadinessRearms()
+{
+    EdgeSockets sockets;
+    startReading(sockets);
+
+    // the handler read some bytes but did not report readiness; the kernel
+    // will not report the remaining bytes again, so only an EPOLL_CTL_MOD
+    // re-check can get the new handler called
+    CPPUNIT_ASSERT_EQUAL(ssize_t(2), sockets.receive(2));
+    sockets.waitForReading();
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+
+    // a re-check of a drained socket does not call the handler
+    CPPUNIT_ASSERT_EQUAL(ssize_t(3), sockets.receive(3));
+    sockets.waitForReading();
+    CPPUNIT_ASSERT_EQUAL(0, HandlerCallsDuringSelect());
+
+    sockets.send("more");
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+}
+
+void
+TestCommEpoll::testReadinessWithHandler()
+{
+    EdgeSockets sockets;
+    startReading(sockets);
+
+    // handlers may re-register before reporting what their I/O did
+    sockets.waitForReading(); // re-checks unknown readiness
+    CPPUNIT_ASSERT_EQUAL(ssize_t(2), sockets.receive(2));
+    Comm::NoteIoReadiness(sockets.receiver, COMM_SELECT_READ, true);
+    CPPUNIT_ASSERT_EQUAL(1, HandlerCallsDuringSelect());
+}
+
+#endif /* USE_EPOLL */
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/AsyncCall.h"
+#include "base/AsyncFunCalls.h"
+#include "comm/Connection.h"
+#include "comm/IoCallback.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <string>
+
+class TestCommIoCallback : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestCommIoCallback);
+    CPPUNIT_TEST(testPlainBuffer);
+    CPPUNIT_TEST(testTail);
+    CPPUNIT_TEST(testMaxBytes);
+    CPPUNIT_TEST(testAdvance);
+    CPPUNIT_TEST(testPartialWrites);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testPlainBuffer();
+    void testTail();
+    void testMaxBytes();
+    void testAdvance();
+    void testPartialWrites();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestCommIoCallback );
+
+static void
+IgnoreCall()
+{
+}
+
+/// a write IoCallback for the given buffer, ready for setTail()
+static void
+StartWrite(Comm::IoCallback &io, char *buf, const int size)
+{
+    io.type = Comm::IOCB_WRITE;
+    AsyncCall::Pointer call = asyncCall(5, 5, "TestCommIoCallback", NullaryFunDialer(&IgnoreCall));
+    io.setCallback(Comm::IOCB_WRITE, call, buf, nullptr, size);
+}
+
+/// iovec for the given caller-owned string
+static struct iovec
+Piece(std::string &s)
+{
+    struct iovec piece;
+    piece.iov_base = s.data();
+    piece.iov_len = s.size();
+    return piece;
+}
+
+/// asserts that the given iov[] entry describes length bytes starting at base
+static void
+AssertPiece(const struct iovec &piece, const char *base, const size_t length)
+{
+    CPPUNIT_ASSERT_EQUAL(static_cast<const void *>(base), static_cast<const void *>(piece.iov_base));
+    CPPUNIT_ASSERT_EQUAL(length, piece.iov_len);
+}
+
+void
+TestCommIoCallback::testPlainBuffer()
+{
+    char buf[] = "0123456789";
+    Comm::IoCallback io{};
+    StartWrite(io, buf, 10);
+    CPPUNIT_ASSERT_EQUAL(0, io.tailCount);
+
+    struct iovec iov[1 + Comm::WriteVectorMax];
+    CPPUNIT_ASSERT_EQUAL(1, io.pendingIoVector(iov, io.size));
+    AssertPiece(iov[0], buf, 10);
+
+    io.offset = 4;
+    CPPUNIT_ASSERT_EQUAL(1, io.pendingIoVector(iov, io.size - io.offset));
+    AssertPiece(iov[0], buf + 4, 6);
+}
+
+void
+TestCommIoCallback::testTail()
+{
+    char buf[] = "headers";
+    std::string body1("first"), empty, body2("second!");
+    const struct iovec tail[] = { Piece(body1), Piece(empty), Piece(body2) };
+
+    Comm::IoCallback io{};
+    StartWrite(io, buf, 7);
+    io.setTail(tail, 3);
+
+    // empty buffers are not stored
+    CPPUNIT_ASSERT_EQUAL(2, io.tailCount);
+    CPPUNIT_ASSERT_EQUAL(7 + 5 + 7, io.size);
+
+    struct iovec iov[1 + Comm::WriteVectorMax];
+    CPPUNIT_ASSERT_EQUAL(3, io.pendingIoVector(iov, io.size));
+    AssertPiece(iov[0], buf, 7);
+    AssertPiece(iov[1], body1.data(), 5);
+    AssertPiece(iov[2], body2.data(), 7);
+
+    // without buf bytes, only tail buffers are described
+    Comm::IoCallback bodyOnly{};
+    StartWrite(bodyOnly, nullptr, 0);
+    bodyOnly.setTail(tail, 3);
+    CPPUNIT_ASSERT_EQUAL(2, bodyOnly.pendingIoVector(iov, bodyOnly.size));
+    AssertPiece(iov[0], body1.data(), 5);
+    AssertPiece(iov[1], body2.data(), 7);
+}
+
+void
+TestCommIoCallback::testMaxBytes()
+{
+    char buf[] = "0123456789";
+    std::string body1("abcde"), body2("ABCDEFG");
+    const struct iovec tail[] = { Piece(body1), Piece(body2) };
+
+    Comm::IoCallback io{};
+    StartWrite(io, buf, 10);
+    io.setTail(tail, 2);
+
+    struct iovec iov[1 + Comm::WriteVectorMax];
+    CPPUNIT_ASSERT_EQUAL(1, io.pendingIoVector(iov, 4));
+    AssertPiece(iov[0], buf, 4);
+
+    CPPUNIT_ASSERT_EQUAL(1, io.pendingIoVector(iov, 10));
+    AssertPiece(iov[0], buf, 10);
+
+    CPPUNIT_ASSERT_EQUAL(2, io.pendingIoVector(iov, 12));
+    AssertPiece(iov[0], buf, 10);
+    AssertPiece(iov[1], body1.data(), 2);
+
+    CPPUNIT_ASSERT_EQUAL(0, io.pendingIoVector(iov, 0));
+}
+
+void
+TestCommIoCallback::testAdvance()
+{
+    char buf[] = "0123456789";
+    std::string body1("abcde"), body2("ABCDEFG");
+    const struct iovec tail[] = { Piece(body1), Piece(body2) };
+
+    Comm::IoCallback io{};
+    StartWrite(io, buf, 10);
+    io.setTail(tail, 2);
+    CPPUNIT_ASSERT_EQUAL(22, io.size);
+
+    struct iovec iov[1 + Comm::WriteVectorMax];
+
+    // inside buf
+    io.offset = 3;
+    CPPUNIT_ASSERT_EQUAL(3, io.pendingIoVector(iov, io.size - io.offset));
+    AssertPiece(iov[0], buf + 3, 7);
+    AssertPiece(iov[1], body1.data(), 5);
+    AssertPiece(iov[2], body2.data(), 7);
+
+    // exactly at a buffer boundary
+    io.offset = 10;
+    CPPUNIT_ASSERT_EQUAL(2, io.pendingIoVector(iov, io.size - io.offset));
+    AssertPiece(iov[0], body1.data(), 5);
+    AssertPiece(iov[1], body2.data(), 7);
+
+    // inside the first tail buffer
+    io.offset = 13;
+    CPPUNIT_ASSERT_EQUAL(2, io.pendingIoVector(iov, io.size - io.offset));
+    AssertPiece(iov[0], body1.data() + 3, 2);
+    AssertPiece(iov[1], body2.data(), 7);
+
+    // inside the last tail buffer
+    io.offset = 21;
+    CPPUNIT_ASSERT_EQUAL(1, io.pendingIoVector(iov, io.size - io.offset));
+    AssertPiece(iov[0], body2.data() + 6, 1);
+
+    // everything was written
+    io.offset = 22;
+    CPPUNIT_ASSERT_EQUAL(0, io.pendingIoVector(iov, io.size - io.offset));
+}
+
+void
+TestCommIoCallback::testPartialWrites()
+{
+    // mimic Comm::HandleWrite() loops with writev(2) calls that accept a
+    // few bytes at a time, for various partial write sizes
+    for (int chunk = 1; chunk <= 23; ++chunk) {
+        char buf[] = "HTTP/1.1 200 OK\r\n\r\n";
+        std::string chunkHeader("5\r\n"), body("hello"), crlf("\r\n");
+        const struct iovec tail[] = { Piece(chunkHeader), Piece(body), Piece(crlf) };
+        const std::string expected = std::string(buf) + chunkHeader + body + crlf;
+
+        Comm::IoCallback io{};
+        StartWrite(io, buf, strlen(buf));
+        io.setTail(tail, 3);
+        CPPUNIT_ASSERT_EQUAL(static_cast<int>(expected.size()), io.size);
+
+        std::string written;
+        auto calls = 0;
+        while (io.offset < io.size) {
+            struct iovec iov[1 + Comm::WriteVectorMax];
+            const auto iovcnt = io.pendingIoVector(iov, io.size - io.offset);
+            CPPUNIT_ASSERT(iovcnt > 0);
+            CPPUNIT_ASSERT(iovcnt <= 1 + Comm::WriteVectorMax);
+
+            // the "socket" accepts up to chunk bytes per call
+            auto accepted = 0;
+            for (int i = 0; i < iovcnt && accepted < chunk; ++i) {
+                const auto n = std::min(static_cast<int>(iov[i].iov_len), chunk - accepted);
+                CPPUNIT_ASSERT(n > 0);
+                written.append(static_cast<const char *>(iov[i].iov_base), n);
+                accepted += n;
+            }
+            io.offset += accepted;
+            ++calls;
+        }
+
+        CPPUNIT_ASSERT_EQUAL(expected, written);
+        CPPUNIT_ASSERT_EQUAL((io.size + chunk - 1) / chunk, calls);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
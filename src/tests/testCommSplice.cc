@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "comm/Splice.h"
+#include "compat/cppunit.h"
+#include "fde.h"
+#include "unitTestMain.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if HAVE_SPLICE
+
+/// a connected pair of non-blocking stream sockets and a non-blocking pipe,
+/// closed on destruction
+class SpliceDescriptors
+{
+public:
+    SpliceDescriptors();
+    ~SpliceDescriptors();
+
+    /// writes the given string into the sending socket
+    void send(const char *text);
+
+    int sender = -1; ///< sends bytes to receiver
+    int receiver = -1; ///< the socket we splice from
+    int pipeIn = -1; ///< the pipe end we splice into
+    int pipeOut = -1; ///< the pipe end holding spliced bytes
+};
+
+SpliceDescriptors::SpliceDescriptors()
+{
+    int sockets[2];
+    CPPUNIT_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets));
+    sender = sockets[0];
+    receiver = sockets[1];
+
+    int ends[2];
+    CPPUNIT_ASSERT_EQUAL(0, pipe2(ends, O_NONBLOCK));
+    pipeOut = ends[0];
+    pipeIn = ends[1];
+}
+
+SpliceDescriptors::~SpliceDescriptors()
+{
+    for (const auto fd: {sender, receiver, pipeIn, pipeOut}) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+void
+SpliceDescriptors::send(const char *text)
+{
+    const auto size = strlen(text);
+    CPPUNIT_ASSERT_EQUAL(ssize_t(size), write(sender, text, size));
+}
+
+/// the bytes accumulated in the given pipe
+static std::string
+Drain(const int pipeOut)
+{
+    char buf[256];
+    const auto size = read(pipeOut, buf, sizeof(buf));
+    CPPUNIT_ASSERT(size >= 0);
+    return std::string(buf, size);
+}
+
+/// an open descriptor table entry
+static std::unique_ptr<fde>
+OpenFde()
+{
+    auto F = std::make_unique<fde>();
+    F->flags.open = true;
+    return F;
+}
+
+class TestCommSplice : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestCommSplice);
+    CPPUNIT_TEST(testMoved);
+    CPPUNIT_TEST(testMaxBytes);
+    CPPUNIT_TEST(testWait);
+    CPPUNIT_TEST(testEof);
+    CPPUNIT_TEST(testUnsupported);
+    CPPUNIT_TEST(testFailed);
+    CPPUNIT_TEST(testEligibility);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testMoved();
+    void testMaxBytes();
+    void testWait();
+    void testEof();
+    void testUnsupported();
+    void testFailed();
+    void testEligibility();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestCommSplice );
+
+void
+TestCommSplice::testMoved()
+{
+    SpliceDescriptors fds;
+    fds.send("hello");
+
+    const auto in = Comm::Splice(fds.receiver, fds.pipeIn, 100);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::moved, in.status);
+    CPPUNIT_ASSERT_EQUAL(size_t(5), in.size);
+
+    // and out of the pipe into another socket
+    SpliceDescriptors other;
+    const auto out = Comm::Splice(fds.pipeOut, other.sender, 100);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::moved, out.status);
+    CPPUNIT_ASSERT_EQUAL(size_t(5), out.size);
+
+    char buf[16];
+    CPPUNIT_ASSERT_EQUAL(ssize_t(5), read(other.receiver, buf, sizeof(buf)));
+    CPPUNIT_ASSERT_EQUAL(std::string("hello"), std::string(buf, 5));
+}
+
+void
+TestCommSplice::testMaxBytes()
+{
+    // callers limit spliced reads to the bytes their delay pools allow
+    SpliceDescriptors fds;
+    fds.send("0123456789");
+
+    const auto first = Comm::Splice(fds.receiver, fds.pipeIn, 4);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::moved, first.status);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), first.size);
+    CPPUNIT_ASSERT_EQUAL(std::string("0123"), Drain(fds.pipeOut));
+
+    const auto rest = Comm::Splice(fds.receiver, fds.pipeIn, 100);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), rest.size);
+    CPPUNIT_ASSERT_EQUAL(std::string("456789"), Drain(fds.pipeOut));
+}
+
+void
+TestCommSplice::testWait()
+{
+    SpliceDescriptors fds;
+    const auto result = Comm::Splice(fds.receiver, fds.pipeIn, 100);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::wait, result.status);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), result.size);
+    CPPUNIT_ASSERT_EQUAL(EAGAIN, result.xerrno);
+}
+
+void
+TestCommSplice::testEof()
+{
+    SpliceDescriptors fds;
+    CPPUNIT_ASSERT_EQUAL(0, shutdown(fds.sender, SHUT_WR));
+    const auto result = Comm::Splice(fds.receiver, fds.pipeIn, 100);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::moved, result.status);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), result.size);
+}
+
+void
+TestCommSplice::testUnsupported()
+{
+    // splice(2) needs a pipe on one side; tunnels fall back to buffers
+    SpliceDescriptors fds;
+    SpliceDescriptors other;
+    fds.send("hello");
+    const auto result = Comm::Splice(fds.receiver, other.sender, 100);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::unsupported, result.status);
+    CPPUNIT_ASSERT_EQUAL(EINVAL, result.xerrno);
+}
+
+void
+TestCommSplice::testFailed()
+{
+    SpliceDescriptors fds;
+    const auto closedFd = fds.receiver;
+    close(closedFd);
+    fds.receiver = -1;
+
+    const auto result = Comm::Splice(closedFd, fds.pipeIn, 100);
+    CPPUNIT_ASSERT_EQUAL(Comm::SpliceResult::failed, result.status);
+    CPPUNIT_ASSERT_EQUAL(EBADF, result.xerrno);
+}
+
+void
+TestCommSplice::testEligibility()
+{
+    const auto from = OpenFde();
+    const auto to = OpenFde();
+    CPPUNIT_ASSERT(Comm::CanSplice(*from, *to));
+
+    // closed descriptors
+    to->flags.open = false;
+    CPPUNIT_ASSERT(!Comm::CanSplice(*from, *to));
+    CPPUNIT_ASSERT(!Comm::CanSplice(*to, *from));
+    to->flags.open = true;
+
+    // Squid-terminated TLS on either side; CanSplice() only checks whether
+    // a session is present, so a fake session suffices
+    const auto owner = std::make_shared<int>(0);
+    const Security::SessionPointer session(owner, reinterpret_cast<Security::SessionPointer::element_type *>(owner.get()));
+    from->ssl = session;
+    CPPUNIT_ASSERT(!Comm::CanSplice(*from, *to));
+    CPPUNIT_ASSERT(!Comm::CanSplice(*to, *from));
+    from->ssl.reset();
+    CPPUNIT_ASSERT(Comm::CanSplice(*from, *to));
+}
+
+#endif /* HAVE_SPLICE */
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "comm/Tcp.h"
+#include "compat/cppunit.h"
+#include "CpuAffinity.h"
+#include "CpuAffinityMap.h"
+#include "CpuAffinitySet.h"
+#include "SquidConfig.h"
+#include "unitTestMain.h"
+
+#include <memory>
+#if HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/*
+ * Checks the worker-queues listening port option and how workers with
+ * worker-queues=cpu-affinity find the CPU to steer their connections from.
+ */
+class TestCommWorkerQueues : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestCommWorkerQueues);
+    CPPUNIT_TEST(testParsePlain);
+    CPPUNIT_TEST(testParseCpuAffinity);
+    CPPUNIT_TEST(testParseUnknown);
+    CPPUNIT_TEST(testKidCpu);
+    CPPUNIT_TEST(testDedicatedCpu);
+    CPPUNIT_TEST(testApplyIncomingCpu);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void tearDown() override;
+
+protected:
+    void testParsePlain();
+    void testParseCpuAffinity();
+    void testParseUnknown();
+    void testKidCpu();
+    void testDedicatedCpu();
+    void testApplyIncomingCpu();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestCommWorkerQueues );
+
+#if HAVE_CPU_AFFINITY
+/// the first CPU that the test process may run on
+static int
+AllowedCpu()
+{
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPPUNIT_ASSERT_EQUAL(0, sched_getaffinity(0, sizeof(cpuSet), &cpuSet));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuSet))
+            return cpu;
+    }
+    CPPUNIT_FAIL("no CPUs");
+    return -1;
+}
+
+/// the CPU (or -1) that the given cpu_affinity_map dedicates to the given kid
+static int
+KidCpu(const CpuAffinityMap &map, const int kid)
+{
+    const std::unique_ptr<CpuAffinitySet> set(map.calculateSet(kid));
+    return set ? set->soleCpu() : -1;
+}
+#endif /* HAVE_CPU_AFFINITY */
+
+void
+TestCommWorkerQueues::tearDown()
+{
+    delete Config.cpuAffinityMap;
+    Config.cpuAffinityMap = nullptr;
+    CpuAffinityReconfigure(); // forgets and undoes any applied affinity
+}
+
+void
+TestCommWorkerQueues::testParsePlain()
+{
+    Comm::WorkerQueues queues;
+    CPPUNIT_ASSERT(!queues.enabled);
+#if defined(SO_REUSEPORT)
+    queues.parse(nullptr);
+    CPPUNIT_ASSERT(queues.enabled);
+    CPPUNIT_ASSERT(!queues.byCpu);
+#else
+    CPPUNIT_ASSERT_THROW(queues.parse(nullptr), TextException);
+#endif
+}
+
+void
+TestCommWorkerQueues::testParseCpuAffinity()
+{
+    Comm::WorkerQueues queues;
+#if defined(SO_REUSEPORT) && defined(SO_INCOMING_CPU)
+    queues.parse("cpu-affinity");
+    CPPUNIT_ASSERT(queues.enabled);
+    CPPUNIT_ASSERT(queues.byCpu);
+
+    // the last option wins
+    queues.parse(nullptr);
+    CPPUNIT_ASSERT(queues.enabled);
+    CPPUNIT_ASSERT(!queues.byCpu);
+#else
+    CPPUNIT_ASSERT_THROW(queues.parse("cpu-affinity"), TextException);
+    CPPUNIT_ASSERT(!queues.byCpu);
+#endif
+}
+
+void
+TestCommWorkerQueues::testParseUnknown()
+{
+    Comm::WorkerQueues queues;
+    CPPUNIT_ASSERT_THROW(queues.parse("cpu"), TextException);
+    CPPUNIT_ASSERT_THROW(queues.parse(""), TextException);
+    CPPUNIT_ASSERT(!queues.enabled);
+    CPPUNIT_ASSERT(!queues.byCpu);
+}
+
+void
+TestCommWorkerQueues::testKidCpu()
+{
+#if HAVE_CPU_AFFINITY
+    // cpu_affinity_map process_numbers=1,2,4 cores=3,1,2
+    CpuAffinityMap map;
+    CPPUNIT_ASSERT(map.add({1, 2, 4}, {3, 1, 2}));
+
+    // cores are numbered from 1, but SO_INCOMING_CPU expects CPU numbers
+    CPPUNIT_ASSERT_EQUAL(2, KidCpu(map, 1));
+    CPPUNIT_ASSERT_EQUAL(0, KidCpu(map, 2));
+    CPPUNIT_ASSERT_EQUAL(1, KidCpu(map, 4));
+
+    // kids without a core are not steered
+    CPPUNIT_ASSERT_EQUAL(-1, KidCpu(map, 3));
+    CPPUNIT_ASSERT_EQUAL(-1, KidCpu(map, 5));
+#endif
+}
+
+void
+TestCommWorkerQueues::testDedicatedCpu()
+{
+#if HAVE_CPU_AFFINITY
+    // without cpu_affinity_map
+    CpuAffinityInit();
+    CPPUNIT_ASSERT_EQUAL(-1, CpuAffinityDedicatedCpu());
+
+    // without -N, the test runs as process number 1; bind it to a CPU that
+    // external affinity restrictions allow
+    const auto cpu = AllowedCpu();
+    Config.cpuAffinityMap = new CpuAffinityMap;
+    CPPUNIT_ASSERT(Config.cpuAffinityMap->add({2, 1}, {cpu + 2, cpu + 1}));
+    CpuAffinityReconfigure();
+    CPPUNIT_ASSERT_EQUAL(cpu, CpuAffinityDedicatedCpu());
+
+    // a map without this kid
+    delete Config.cpuAffinityMap;
+    Config.cpuAffinityMap = new CpuAffinityMap;
+    CPPUNIT_ASSERT(Config.cpuAffinityMap->add({2}, {cpu + 1}));
+    CpuAffinityReconfigure();
+    CPPUNIT_ASSERT_EQUAL(-1, CpuAffinityDedicatedCpu());
+#endif
+}
+
+void
+TestCommWorkerQueues::testApplyIncomingCpu()
+{
+#if defined(SO_INCOMING_CPU) && HAVE_CPU_AFFINITY
+    const auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    CPPUNIT_ASSERT(fd >= 0);
+
+    const auto cpu = AllowedCpu();
+    CPPUNIT_ASSERT(Comm::ApplyIncomingCpu(fd, cpu));
+
+    int applied = -1;
+    socklen_t size = sizeof(applied);
+    CPPUNIT_ASSERT_EQUAL(0, getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &applied, &size));
+    CPPUNIT_ASSERT_EQUAL(cpu, applied);
+
+    close(fd);
+#endif
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
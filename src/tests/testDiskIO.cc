@@ -7,17 +7,29 @@
  */
 
 #include "squid.h"
+#include "comm/Loops.h"
 #include "compat/cppunit.h"
 #include "DiskIO/DiskIOModule.h"
+#include "DiskIO/DiskIOStrategy.h"
+#include "DiskIO/IORequestor.h"
+#include "DiskIO/ReadRequest.h"
+#include "DiskIO/WriteRequest.h"
+#include "fde.h"
 #include "HttpHeader.h"
 #include "HttpReply.h"
 #include "MemObject.h"
+#include "sbuf/SBuf.h"
 #include "Store.h"
 #include "StoreFileSystem.h"
 #include "testStoreSupport.h"
 #include "unitTestMain.h"
 
-#include <stdexcept>
+#include <cstring>
+#include <memory>
+#include <vector>
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
 
 /*
  * test the DiskIO framework
@@ -27,10 +39,18 @@ class TestDiskIO : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE(TestDiskIO);
     CPPUNIT_TEST(testFindDefault);
+    CPPUNIT_TEST(testUnusableModule);
+#if HAVE_DISKIO_MODULE_IOURING
+    CPPUNIT_TEST(testIoUringReadWrite);
+#endif
     CPPUNIT_TEST_SUITE_END();
 
 protected:
     void testFindDefault();
+    void testUnusableModule();
+#if HAVE_DISKIO_MODULE_IOURING
+    void testIoUringReadWrite();
+#endif
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( TestDiskIO );
@@ -47,6 +67,8 @@ void
 MyTestProgram::startup()
 {
     Mem::Init();
+    fde::Init();
+    Comm::SelectLoopInit();
     DiskIOModule::SetupAllModules();
 }
 
@@ -63,6 +85,135 @@ TestDiskIO::testFindDefault()
 #endif
 }
 
+/// a module that this system cannot support, like IoUring on old kernels
+class UnusableDiskIOModule: public DiskIOModule
+{
+public:
+    /* DiskIOModule API */
+    void init() override {}
+    void gracefulShutdown() override {}
+    DiskIOStrategy *createStrategy() override { ++strategiesCreated; return nullptr; }
+    char const *type() const override { return "Unusable"; }
+    bool usable() const override { return false; }
+
+    int strategiesCreated = 0;
+};
+
+void
+TestDiskIO::testUnusableModule()
+{
+#if HAVE_DISKIO_MODULE_BLOCKING
+    static UnusableDiskIOModule unusable;
+    if (!DiskIOModule::Find(unusable.type()))
+        DiskIOModule::ModuleAdd(unusable);
+
+    const auto blocking = DiskIOModule::Find("Blocking");
+    CPPUNIT_ASSERT(blocking);
+
+    // e.g., cache_dir ufs ... IOEngine=Unusable keeps its Blocking module
+    CPPUNIT_ASSERT_EQUAL(blocking, DiskIOModule::FindUsable("Unusable", "Blocking"));
+    CPPUNIT_ASSERT_EQUAL(0, unusable.strategiesCreated);
+
+    // usable and unknown modules are not replaced
+    CPPUNIT_ASSERT_EQUAL(blocking, DiskIOModule::FindUsable("Blocking", "Unusable"));
+    CPPUNIT_ASSERT(!DiskIOModule::FindUsable("Unknown", "Blocking"));
+#endif
+}
+
+#if HAVE_DISKIO_MODULE_IOURING
+
+/// remembers DiskFile notifications
+class RecordingRequestor: public IORequestor
+{
+public:
+    /* IORequestor API */
+    void ioCompletedNotification() override { ++opened; }
+    void closeCompleted() override { ++closed; }
+    void readCompleted(const char *, int len, int errflag, RefCount<ReadRequest>) override {
+        ++reads;
+        lastLen = len;
+        lastErrflag = errflag;
+    }
+    void writeCompleted(int errflag, size_t len, RefCount<WriteRequest>) override {
+        ++writes;
+        written += len;
+        lastErrflag = errflag;
+    }
+
+    int opened = 0;
+    int closed = 0;
+    int reads = 0;
+    int writes = 0;
+    size_t written = 0;
+    int lastLen = -1;
+    int lastErrflag = -1;
+};
+
+void
+TestDiskIO::testIoUringReadWrite()
+{
+    // use tmpfs to avoid depending on (and wearing out) real disks
+    struct stat sb;
+    if (stat("/dev/shm", &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+        std::cerr << "skipping IoUring test: no /dev/shm" << std::endl;
+        return;
+    }
+    SBuf path;
+    path.appendf("/dev/shm/testDiskIO-%d", static_cast<int>(getpid()));
+
+    DiskIOModule *module = DiskIOModule::Find("IoUring");
+    CPPUNIT_ASSERT(module);
+    if (!module->usable()) {
+        // e.g., an old kernel or a container that blocks io_uring syscalls
+        std::cerr << "skipping IoUring test: no kernel support" << std::endl;
+        return;
+    }
+    std::unique_ptr<DiskIOStrategy> strategy(module->createStrategy());
+    strategy->init();
+
+    const RefCount<RecordingRequestor> requestor = new RecordingRequestor();
+    const auto file = strategy->newFile(path.c_str());
+    file->create(O_RDWR | O_CREAT | O_TRUNC, 0644, requestor);
+    CPPUNIT_ASSERT_EQUAL(1, requestor->opened);
+    CPPUNIT_ASSERT(!file->error());
+
+    // two writes submitted together, completing in any order
+    const size_t halfSize = 64*1024;
+    std::vector<char> original(2*halfSize);
+    for (size_t i = 0; i < original.size(); ++i)
+        original[i] = static_cast<char>(i % 251);
+    file->write(new WriteRequest(original.data() + halfSize, halfSize, halfSize, nullptr));
+    file->write(new WriteRequest(original.data(), 0, halfSize, nullptr));
+    CPPUNIT_ASSERT(file->ioInProgress());
+    strategy->sync();
+    CPPUNIT_ASSERT(!file->ioInProgress());
+    CPPUNIT_ASSERT_EQUAL(2, requestor->writes);
+    CPPUNIT_ASSERT_EQUAL(original.size(), requestor->written);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(DISK_OK), requestor->lastErrflag);
+
+    std::vector<char> copy(original.size());
+    file->read(new ReadRequest(copy.data(), 0, copy.size()));
+    strategy->sync();
+    CPPUNIT_ASSERT_EQUAL(1, requestor->reads);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(copy.size()), requestor->lastLen);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(DISK_OK), requestor->lastErrflag);
+    CPPUNIT_ASSERT(memcmp(original.data(), copy.data(), copy.size()) == 0);
+
+    // reading past the end of file is not an error
+    file->read(new ReadRequest(copy.data(), 2*original.size(), halfSize));
+    strategy->sync();
+    CPPUNIT_ASSERT_EQUAL(2, requestor->reads);
+    CPPUNIT_ASSERT_EQUAL(0, requestor->lastLen);
+
+    file->close();
+    CPPUNIT_ASSERT_EQUAL(1, requestor->closed);
+    unlink(path.c_str());
+
+    module->gracefulShutdown();
+}
+
+#endif /* HAVE_DISKIO_MODULE_IOURING */
+
 int
 main(int argc, char *argv[])
 {
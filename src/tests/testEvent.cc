@@ -11,6 +11,7 @@
 #include "compat/cppunit.h"
 #include "event.h"
 #include "MemBuf.h"
+#include "time/gadgets.h"
 #include "unitTestMain.h"
 
 /*
@@ -26,6 +27,7 @@ class TestEvent : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST(testCheckEvents);
     CPPUNIT_TEST(testSingleton);
     CPPUNIT_TEST(testCancel);
+    CPPUNIT_TEST(testFiringOrder);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -35,6 +37,7 @@ protected:
     void testCheckEvents();
     void testSingleton();
     void testCancel();
+    void testFiringOrder();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( TestEvent );
@@ -74,6 +77,78 @@ TestEvent::testCancel()
     AsyncCallQueue::Instance().fire();
     CPPUNIT_ASSERT_EQUAL(1, event.calls);
     CPPUNIT_ASSERT_EQUAL(0, event_to_cancel.calls);
+
+    // cancelling one of several identical events cancels the earliest one
+    scheduler.schedule("later event", CalledEvent::Handler, &event, 2, 0, false);
+    scheduler.schedule("test event", CalledEvent::Handler, &event, 0, 0, false);
+    scheduler.cancel(CalledEvent::Handler, &event);
+    CPPUNIT_ASSERT_EQUAL(2000, scheduler.checkEvents(0));
+    AsyncCallQueue::Instance().fire();
+    CPPUNIT_ASSERT_EQUAL(1, event.calls);
+    CPPUNIT_ASSERT(scheduler.find(CalledEvent::Handler, &event));
+
+    // cancelling without an argument cancels all events with that handler
+    scheduler.schedule("test event", CalledEvent::Handler, &event_to_cancel, 0, 0, false);
+    scheduler.cancel(CalledEvent::Handler, nullptr);
+    CPPUNIT_ASSERT(!scheduler.find(CalledEvent::Handler, &event));
+    CPPUNIT_ASSERT(!scheduler.find(CalledEvent::Handler, &event_to_cancel));
+    CPPUNIT_ASSERT_EQUAL(int(AsyncEngine::EVENT_IDLE), scheduler.checkEvents(0));
+}
+
+/// Helper for tests - an event which records its position in the firing order
+class OrderedEvent
+{
+public:
+    static void Handler(void *data) {
+        static_cast<OrderedEvent *>(data)->position = ++Fired;
+    }
+
+    static int Fired; ///< the number of Handler() calls
+    int position = 0; ///< our Handler() call number or zero
+};
+
+int OrderedEvent::Fired = 0;
+
+/* events due at the same time fire in timestamp and then submission order */
+void
+TestEvent::testFiringOrder()
+{
+    EventScheduler scheduler;
+    OrderedEvent late;
+    OrderedEvent early;
+    OrderedEvent middle;
+    OrderedEvent sameTime;
+    OrderedEvent immediate;
+    OrderedEvent future;
+    const auto started = current_dtime;
+    const auto firedBefore = OrderedEvent::Fired;
+    scheduler.schedule("late", OrderedEvent::Handler, &late, 0.003, 0, false);
+    scheduler.schedule("early", OrderedEvent::Handler, &early, 0.001, 1, false);
+    scheduler.schedule("middle", OrderedEvent::Handler, &middle, 0.002, 0, false);
+    scheduler.schedule("same time", OrderedEvent::Handler, &sameTime, 0.002, 0, false);
+    scheduler.schedule("immediate", OrderedEvent::Handler, &immediate, 0, 0, false);
+    scheduler.schedule("future", OrderedEvent::Handler, &future, 1, 0, false);
+
+    current_dtime = started + 0.010;
+
+    // the heavy "early" event stops dequeuing
+    CPPUNIT_ASSERT_EQUAL(0, scheduler.checkEvents(0));
+    AsyncCallQueue::Instance().fire();
+    CPPUNIT_ASSERT_EQUAL(1, immediate.position - firedBefore);
+    CPPUNIT_ASSERT_EQUAL(2, early.position - firedBefore);
+
+    // events that are already due can still be canceled
+    scheduler.cancel(OrderedEvent::Handler, &middle);
+    const auto remaining = scheduler.checkEvents(0); // until "future" is due
+    CPPUNIT_ASSERT(980 < remaining && remaining <= 1000);
+    AsyncCallQueue::Instance().fire();
+    CPPUNIT_ASSERT_EQUAL(0, middle.position);
+    CPPUNIT_ASSERT_EQUAL(3, sameTime.position - firedBefore);
+    CPPUNIT_ASSERT_EQUAL(4, late.position - firedBefore);
+    CPPUNIT_ASSERT_EQUAL(0, future.position);
+    CPPUNIT_ASSERT(scheduler.find(OrderedEvent::Handler, &future));
+
+    current_dtime = started;
 }
 
 // submit two callbacks, and then dump the queue.
@@ -87,7 +162,13 @@ TestEvent::testDump()
                            "\n"
                            "Operation                \tNext Execution \tWeight\tCallback Valid?\n"
                            "test event               \t0.000 sec\t    0\t N/A\n"
-                           "test event2              \t0.000 sec\t    0\t N/A\n";
+                           "test event2              \t0.000 sec\t    0\t N/A\n"
+                           "\n"
+                           "Queue depth: 2\n"
+                           "Events scheduled: 3\n"
+                           "Events fired: 1\n"
+                           "Mean lateness: 0.000 sec\n"
+                           "Max lateness: 0.000 sec\n";
     MemBuf expect;
     expect.init();
     expect.append(expected, strlen(expected));
@@ -138,6 +219,11 @@ TestEvent::testFind()
     scheduler.schedule("test event", CalledEvent::Handler, &event, 0, 0, false);
     scheduler.schedule("test event2", CalledEvent::Handler, &event_to_find, 0, 0, false);
     CPPUNIT_ASSERT_EQUAL(true, scheduler.find(CalledEvent::Handler, &event_to_find));
+    CPPUNIT_ASSERT_EQUAL(false, scheduler.find(CalledEvent::Handler, nullptr));
+
+    scheduler.cancel(CalledEvent::Handler, &event_to_find);
+    CPPUNIT_ASSERT_EQUAL(false, scheduler.find(CalledEvent::Handler, &event_to_find));
+    CPPUNIT_ASSERT_EQUAL(true, scheduler.find(CalledEvent::Handler, &event));
 }
 
 /* do a trivial test of invoking callbacks */
@@ -21,6 +21,10 @@
 #include "SquidConfig.h"
 #include "unitTestMain.h"
 
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
 class TestHttp1Parser : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE(TestHttp1Parser);
@@ -1194,9 +1198,53 @@ TestHttp1Parser::testDripFeed()
 
 }
 
+/// Measures parsing speed of a typical browser request (request line and
+/// mime block). Started with the --benchmark [requests] command line.
+static int
+Benchmark(const long requests)
+{
+    Mem::Init();
+    Config.onoff.relaxed_header_parser = 0;
+    Config.maxRequestHeaderSize = 64*1024;
+
+    const SBuf request(
+        "GET /search/results?q=squid+http+proxy+cache&source=hp&ei=Xb3tZ8KhLpW&lang=en HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Referer: https://www.example.com/\r\n"
+        "Connection: keep-alive\r\n"
+        "Cookie: session=2b7c1f9a8e6d4c3b2a190817; prefs=lang:en|theme:dark; _ga=GA1.2.1234567890.1700000000\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n"
+        "Sec-Fetch-Dest: document\r\n"
+        "Sec-Fetch-Mode: navigate\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "Priority: u=0, i\r\n"
+        "\r\n");
+
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < requests; ++i) {
+        Http1::RequestParser parser;
+        if (!parser.parse(request) || parser.needsMoreData()) {
+            std::cerr << "BUG: failed to parse the benchmark request" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << requests << " requests of " << request.length() << " bytes in " << elapsed << " s: " <<
+              (requests / elapsed) << " requests/s, " <<
+              (requests * request.length() / elapsed / 1e6) << " MB/s" << std::endl;
+    return EXIT_SUCCESS;
+}
+
 int
 main(int argc, char *argv[])
 {
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+        return Benchmark(argc > 2 ? atol(argv[2]) : 1000000);
     return TestProgram().run(argc, argv);
 }
 
@@ -10,6 +10,7 @@
 #include <cppunit/TestAssert.h>
 
 #include "compat/cppunit.h"
+#include "http/ContentLengthInterpreter.h"
 #include "HttpHeader.h"
 #include "HttpReply.h"
 #include "mime_header.h"
@@ -20,10 +21,14 @@ class TestHttpReply : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE(TestHttpReply);
     CPPUNIT_TEST(testSanityCheckFirstLine);
+    CPPUNIT_TEST(testHeaderIndex);
+    CPPUNIT_TEST(testHeaderParse);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
     void testSanityCheckFirstLine();
+    void testHeaderIndex();
+    void testHeaderParse();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( TestHttpReply );
@@ -220,6 +225,129 @@ TestHttpReply::testSanityCheckFirstLine()
     error = Http::scNone;
 }
 
+/// the sum of packed entry lengths, computed without HttpHeader::len
+static int
+PackedLength(const HttpHeader &header)
+{
+    int length = 0;
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (const auto e = header.getEntry(&pos))
+        length += e->length();
+    return length;
+}
+
+void
+TestHttpReply::testHeaderIndex()
+{
+    HttpHeader header(hoReply);
+    header.putStr(Http::HdrType::SERVER, "a");
+    header.putStr(Http::HdrType::VIA, "1.1 a");
+    header.putExt("X-Custom", "1");
+    header.putStr(Http::HdrType::VIA, "1.1 b");
+    header.putExt("x-CUSTOM", "2");
+    header.putStr(Http::HdrType::SERVER, "b");
+    header.putExt("X-Other", "3");
+
+    // lookups by ID and by (case-insensitive) name
+    CPPUNIT_ASSERT_EQUAL(String("a"), String(header.getStr(Http::HdrType::SERVER)));
+    CPPUNIT_ASSERT_EQUAL(String("b"), String(header.getLastStr(Http::HdrType::SERVER)));
+    CPPUNIT_ASSERT_EQUAL(String("1.1 a, 1.1 b"), header.getList(Http::HdrType::VIA));
+    CPPUNIT_ASSERT_EQUAL(String("1, 2"), header.getByName("X-CUSTOM"));
+    CPPUNIT_ASSERT_EQUAL(String("1.1 a, 1.1 b"), header.getByName("via"));
+    CPPUNIT_ASSERT(header.hasNamed(SBuf("x-other")));
+    CPPUNIT_ASSERT(!header.hasNamed(SBuf("X-Missing")));
+    CPPUNIT_ASSERT(!header.has(Http::HdrType::CONTENT_TYPE));
+
+    // lookups by a name that is not terminated where it ends
+    String value;
+    CPPUNIT_ASSERT(header.hasNamed("x-custom: 3", 8, &value));
+    CPPUNIT_ASSERT_EQUAL(String("1, 2"), value);
+    CPPUNIT_ASSERT(!header.hasNamed("X-Other", 5, nullptr));
+    CPPUNIT_ASSERT(header.hasNamed("Via: x", 3, nullptr));
+    CPPUNIT_ASSERT_EQUAL(PackedLength(header), header.len);
+
+    // deletions keep the mask and lookups current
+    CPPUNIT_ASSERT_EQUAL(2, header.delByName(SBuf("x-custom")));
+    CPPUNIT_ASSERT(!header.hasNamed(SBuf("X-Custom")));
+    CPPUNIT_ASSERT(header.hasNamed(SBuf("X-Other")));
+    CPPUNIT_ASSERT_EQUAL(2, header.delByName(SBuf("VIA")));
+    CPPUNIT_ASSERT(!header.has(Http::HdrType::VIA));
+    CPPUNIT_ASSERT_EQUAL(0, header.delByName(SBuf("X-Custom")));
+
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    int deleted = 0;
+    while (const auto e = header.getEntry(&pos)) {
+        if (e->id == Http::HdrType::SERVER) {
+            header.delAt(pos, deleted); // only the first Server field
+            break;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(1, deleted);
+    CPPUNIT_ASSERT(header.has(Http::HdrType::SERVER));
+    CPPUNIT_ASSERT_EQUAL(String("b"), String(header.getStr(Http::HdrType::SERVER)));
+    CPPUNIT_ASSERT_EQUAL(PackedLength(header), header.len);
+
+    // compaction moves entries
+    header.compact();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), header.entries.size());
+    CPPUNIT_ASSERT_EQUAL(String("b"), String(header.getStr(Http::HdrType::SERVER)));
+    CPPUNIT_ASSERT_EQUAL(String("3"), header.getByName("X-Other"));
+
+    header.putStr(Http::HdrType::SERVER, "c");
+    header.updateOrAddStr(Http::HdrType::SERVER, SBuf("d"));
+    CPPUNIT_ASSERT_EQUAL(String("d"), String(header.getStr(Http::HdrType::SERVER)));
+    CPPUNIT_ASSERT_EQUAL(String("d"), String(header.getLastStr(Http::HdrType::SERVER)));
+    CPPUNIT_ASSERT_EQUAL(PackedLength(header), header.len);
+
+    CPPUNIT_ASSERT_EQUAL(1, header.delById(Http::HdrType::SERVER));
+    CPPUNIT_ASSERT_EQUAL(1, header.delByName(SBuf("X-Other")));
+    CPPUNIT_ASSERT(!header.has(Http::HdrType::SERVER));
+    CPPUNIT_ASSERT_EQUAL(0, header.len);
+
+    // copies have their own index
+    header.putExt("X-Custom", "4");
+    HttpHeader copy(hoReply);
+    copy.update(&header);
+    header.clean();
+    CPPUNIT_ASSERT(!header.hasNamed(SBuf("X-Custom")));
+    CPPUNIT_ASSERT_EQUAL(String("4"), copy.getByName("X-Custom"));
+}
+
+void
+TestHttpReply::testHeaderParse()
+{
+    char raw[] =
+        "Server: squid\r\n"
+        "X-Custom:  one \r\n"
+        "Content-Length: 10\r\n"
+        "x-custom: two\r\n";
+
+    HttpHeader header(hoReply);
+    Http::ContentLengthInterpreter clen;
+    CPPUNIT_ASSERT(header.parse(raw, strlen(raw), clen));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), header.entries.size());
+
+    // names keep their original case and values are trimmed
+    CPPUNIT_ASSERT_EQUAL(SBuf("Server"), header.entries[0]->name);
+    CPPUNIT_ASSERT_EQUAL(SBuf("X-Custom"), header.entries[1]->name);
+    CPPUNIT_ASSERT_EQUAL(SBuf("x-custom"), header.entries[3]->name);
+    CPPUNIT_ASSERT_EQUAL(String("one"), header.entries[1]->value);
+    CPPUNIT_ASSERT_EQUAL(String("one, two"), header.getByName("X-CUSTOM"));
+    CPPUNIT_ASSERT_EQUAL(int64_t(10), header.getInt64(Http::HdrType::CONTENT_LENGTH));
+    CPPUNIT_ASSERT_EQUAL(PackedLength(header), header.len);
+
+    // parsed entries do not depend on the parsed buffer
+    memset(raw, 'z', strlen(raw));
+    CPPUNIT_ASSERT_EQUAL(SBuf("X-Custom"), header.entries[1]->name);
+    CPPUNIT_ASSERT_EQUAL(SBuf("x-custom"), header.entries[3]->name);
+    HttpHeader copy(hoReply);
+    copy.update(&header);
+    header.clean();
+    CPPUNIT_ASSERT_EQUAL(SBuf("X-Custom"), copy.entries[1]->name);
+    CPPUNIT_ASSERT_EQUAL(String("one, two"), copy.getByName("x-custom"));
+    CPPUNIT_ASSERT_EQUAL(String("squid"), String(copy.getStr(Http::HdrType::SERVER)));
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -9,11 +9,20 @@
 #include "squid.h"
 #include "compat/cppunit.h"
 #include "mem/Allocator.h"
+#include "mem/Arena.h"
 #include "mem/Pool.h"
+#include "mem/PoolChunked.h"
+#include "mem/Stats.h"
 #include "unitTestMain.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 class TestMem : public CPPUNIT_NS::TestFixture
 {
@@ -21,12 +30,18 @@ class TestMem : public CPPUNIT_NS::TestFixture
     /* note the statement here and then the actual prototype below */
     CPPUNIT_TEST(testMemPool);
     CPPUNIT_TEST(testMemProxy);
+    CPPUNIT_TEST(testChunkedPoolMagazine);
+    CPPUNIT_TEST(testChunkedPoolThreads);
+    CPPUNIT_TEST(testArena);
     CPPUNIT_TEST_SUITE_END();
 
 public:
 protected:
     void testMemPool();
     void testMemProxy();
+    void testChunkedPoolMagazine();
+    void testChunkedPoolThreads();
+    void testArena();
 };
 CPPUNIT_TEST_SUITE_REGISTRATION(TestMem);
 
@@ -80,6 +95,154 @@ TestMem::testMemProxy()
     CPPUNIT_ASSERT_EQUAL(otherthing->aValue, 0);
 }
 
+void
+TestMem::testChunkedPoolMagazine()
+{
+    const auto pool = new MemPoolChunked("Test Chunked Pool", sizeof(SomethingToAlloc));
+
+    // enough objects to refill and drain the magazine many times
+    std::vector<SomethingToAlloc *> objects;
+    for (int i = 0; i < 1000; ++i) {
+        const auto something = static_cast<SomethingToAlloc *>(pool->alloc());
+        CPPUNIT_ASSERT(something);
+        CPPUNIT_ASSERT_EQUAL(0, something->aValue);
+        something->aValue = i + 1;
+        objects.push_back(something);
+    }
+
+    auto sorted = objects;
+    std::sort(sorted.begin(), sorted.end());
+    CPPUNIT_ASSERT(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+    for (const auto something: objects)
+        pool->freeOne(something);
+
+    // the most recently freed object is reused first and is zeroed
+    const auto reused = static_cast<SomethingToAlloc *>(pool->alloc());
+    CPPUNIT_ASSERT_EQUAL(objects.back(), reused);
+    CPPUNIT_ASSERT_EQUAL(0, reused->aValue);
+    pool->freeOne(reused);
+
+    Mem::PoolStats stats;
+    CPPUNIT_ASSERT_EQUAL(size_t(0), pool->getStats(stats));
+    CPPUNIT_ASSERT_EQUAL(0, pool->getInUseCount());
+    CPPUNIT_ASSERT_EQUAL(stats.items_alloc, stats.items_idle);
+    CPPUNIT_ASSERT(stats.items_alloc >= 1000);
+
+    delete pool;
+}
+
+/// allocates and frees the given number of objects, leaving some of them
+/// cached in the calling thread's magazine
+static void
+AllocateAndFree(Mem::Allocator &pool, const int count)
+{
+    std::vector<void *> objects;
+    for (int i = 0; i < count; ++i)
+        objects.push_back(pool.alloc());
+    for (const auto object: objects)
+        pool.freeOne(object);
+}
+
+void
+TestMem::testChunkedPoolThreads()
+{
+    // a finished thread returns its magazine objects to the pool
+    {
+        const auto pool = new MemPoolChunked("Test Chunked Pool", sizeof(SomethingToAlloc));
+        std::thread helper(AllocateAndFree, std::ref(*pool), 100);
+        helper.join();
+
+        Mem::PoolStats stats;
+        CPPUNIT_ASSERT_EQUAL(size_t(0), pool->getStats(stats));
+        CPPUNIT_ASSERT_EQUAL(stats.items_alloc, stats.items_idle);
+        CPPUNIT_ASSERT_EQUAL(100.0, pool->meter.gb_allocated.count);
+        CPPUNIT_ASSERT_EQUAL(100.0, pool->meter.gb_freed.count);
+        delete pool;
+    }
+
+    // a pool destroyed before a thread with a pool magazine finishes
+    {
+        const auto pool = new MemPoolChunked("Test Chunked Pool", sizeof(SomethingToAlloc));
+        std::mutex mutex;
+        std::condition_variable cond;
+        auto used = false;
+        auto destroyed = false;
+        std::thread helper([&]() {
+            AllocateAndFree(*pool, 100);
+            std::unique_lock<std::mutex> lock(mutex);
+            used = true;
+            cond.notify_all();
+            cond.wait(lock, [&]() { return destroyed; });
+            // the thread magazine for the destroyed pool must be ignored now
+        });
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [&]() { return used; });
+        }
+        delete pool; // asserts that all magazine objects were returned
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            destroyed = true;
+            cond.notify_all();
+        }
+        helper.join();
+    }
+}
+
+void
+TestMem::testArena()
+{
+    const auto before = Mem::ArenaStatistics();
+
+    {
+        Mem::Arena arena;
+        CPPUNIT_ASSERT_EQUAL(size_t(0), arena.blocks());
+
+        // small allocations share a block and respect alignment
+        const auto first = arena.make<SomethingToAlloc>();
+        first->aValue = 1;
+        const auto text = arena.dup("abc", 2);
+        const auto second = arena.make<SomethingToAlloc>();
+        second->aValue = 2;
+        CPPUNIT_ASSERT_EQUAL(size_t(1), arena.blocks());
+        CPPUNIT_ASSERT_EQUAL(uintptr_t(0), reinterpret_cast<uintptr_t>(second) % alignof(SomethingToAlloc));
+        CPPUNIT_ASSERT_EQUAL(0, strcmp(text, "ab"));
+        CPPUNIT_ASSERT_EQUAL(1, first->aValue);
+
+        // a large allocation gets its own block
+        const auto large = static_cast<char *>(arena.allocate(3*Mem::Arena::BlockSize));
+        memset(large, 'x', 3*Mem::Arena::BlockSize);
+        CPPUNIT_ASSERT_EQUAL(size_t(2), arena.blocks());
+        CPPUNIT_ASSERT_EQUAL(2, second->aValue);
+
+        // exhausting a standard block adds another one
+        size_t added = 0;
+        while (arena.blocks() == 2) {
+            CPPUNIT_ASSERT(arena.allocate(100, 1));
+            ++added;
+        }
+        CPPUNIT_ASSERT_EQUAL(size_t(3), arena.blocks());
+        CPPUNIT_ASSERT(added > 30 && added <= Mem::Arena::BlockSize/100 + 1);
+        CPPUNIT_ASSERT_EQUAL(4 + added, arena.allocations());
+
+        arena.release();
+        CPPUNIT_ASSERT_EQUAL(size_t(0), arena.blocks());
+        CPPUNIT_ASSERT_EQUAL(size_t(0), arena.used());
+
+        // released standard blocks are reused by later allocations
+        const auto reusedBefore = Mem::ArenaStatistics().blocksReused;
+        CPPUNIT_ASSERT(arena.allocate(10));
+        CPPUNIT_ASSERT_EQUAL(reusedBefore + 1, Mem::ArenaStatistics().blocksReused);
+    }
+
+    const auto &after = Mem::ArenaStatistics();
+    CPPUNIT_ASSERT_EQUAL(before.arenas + 2, after.arenas);
+    CPPUNIT_ASSERT(after.maxBytes >= 3*Mem::Arena::BlockSize);
+}
+
 int
 main(int argc, char *argv[])
 {
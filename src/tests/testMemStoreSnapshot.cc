@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "MemStoreSnapshot.h"
+#include "sbuf/Stream.h"
+#include "unitTestMain.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+class TestMemStoreSnapshot : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestMemStoreSnapshot);
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testDamage);
+    CPPUNIT_TEST(testContentSizeMismatch);
+    CPPUNIT_TEST(testUnfinished);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+protected:
+    void testRoundTrip();
+    void testDamage();
+    void testContentSizeMismatch();
+    void testUnfinished();
+
+private:
+    SBuf dir; ///< a temporary directory for the snapshot files
+    SBuf snapshotPath;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestMemStoreSnapshot );
+
+using Snapshot = MemStoreSnapshot;
+
+/// content of the test entry with the given ID
+static std::string
+MakeContent(const int id)
+{
+    std::string content = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    content.append(id * 7, char('a' + id)); // various unaligned sizes
+    return content;
+}
+
+/// saves the test entry with the given ID, feeding its content in small pieces
+static void
+AddEntry(Snapshot::Writer &writer, const int id)
+{
+    const auto content = MakeContent(id);
+    Snapshot::Entry entry;
+    entry.key[0] = id;
+    entry.key[1] = ~uint64_t(id);
+    entry.timestamp = 1000 + id;
+    entry.refcount = id;
+    entry.size = content.size();
+    writer.addEntry(entry);
+    for (size_t pos = 0; pos < content.size(); pos += 10)
+        writer.addContent(content.data() + pos, std::min(size_t(10), content.size() - pos));
+}
+
+/// writes a valid snapshot with the given number of entries
+static void
+WriteSnapshot(const SBuf &path, const int entries)
+{
+    Snapshot::Writer writer(path);
+    for (int id = 0; id < entries; ++id)
+        AddEntry(writer, id);
+    writer.finish();
+}
+
+/// reads all snapshot entries
+/// \param intact the number of entries the reader returned
+/// \returns whether the reader accepted the entire snapshot
+static bool
+ReadAll(const SBuf &path, uint64_t &intact)
+{
+    intact = 0;
+    Snapshot::Reader reader;
+    try {
+        reader.open(path);
+        const Snapshot::Entry *entry = nullptr;
+        const char *content = nullptr;
+        while (reader.nextEntry(entry, content))
+            ++intact;
+    } catch (const std::exception &) {
+        return false;
+    }
+    CPPUNIT_ASSERT_EQUAL(intact, reader.visited());
+    return true;
+}
+
+/// whether Reader rejects the snapshot (or any of its entries)
+static bool
+Rejected(const SBuf &path)
+{
+    uint64_t intact = 0;
+    return !ReadAll(path, intact);
+}
+
+/// appends the given bytes to the given file
+static void
+Append(SBuf path, const char *bytes)
+{
+    const auto file = fopen(path.c_str(), "ab");
+    CPPUNIT_ASSERT(file);
+    CPPUNIT_ASSERT_EQUAL(strlen(bytes), fwrite(bytes, 1, strlen(bytes), file));
+    CPPUNIT_ASSERT_EQUAL(0, fclose(file));
+}
+
+void
+TestMemStoreSnapshot::setUp()
+{
+    char dirTemplate[] = "/tmp/testMemStoreSnapshot.XXXXXX";
+    CPPUNIT_ASSERT(mkdtemp(dirTemplate));
+    dir = SBuf(dirTemplate);
+    snapshotPath = ToSBuf(dir, "/mem.snapshot");
+}
+
+void
+TestMemStoreSnapshot::tearDown()
+{
+    (void)unlink(snapshotPath.c_str());
+    CPPUNIT_ASSERT_EQUAL(0, rmdir(dir.c_str()));
+}
+
+void
+TestMemStoreSnapshot::testRoundTrip()
+{
+    WriteSnapshot(snapshotPath, 5);
+
+    Snapshot::Reader reader;
+    reader.open(snapshotPath);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(5), reader.entries());
+
+    int id = 0;
+    const Snapshot::Entry *entry = nullptr;
+    const char *content = nullptr;
+    while (reader.nextEntry(entry, content)) {
+        const auto expected = MakeContent(id);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(id), entry->key[0]);
+        CPPUNIT_ASSERT_EQUAL(~uint64_t(id), entry->key[1]);
+        CPPUNIT_ASSERT_EQUAL(int64_t(1000 + id), entry->timestamp);
+        CPPUNIT_ASSERT_EQUAL(uint16_t(id), entry->refcount);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(expected.size()), entry->size);
+        CPPUNIT_ASSERT(std::string(content, entry->size) == expected);
+        ++id;
+    }
+    CPPUNIT_ASSERT_EQUAL(5, id);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(5), reader.visited());
+
+    // an empty cache produces a valid snapshot
+    WriteSnapshot(snapshotPath, 0);
+    CPPUNIT_ASSERT(!Rejected(snapshotPath));
+}
+
+void
+TestMemStoreSnapshot::testDamage()
+{
+    WriteSnapshot(snapshotPath, 3);
+    Append(snapshotPath, "garbage");
+    CPPUNIT_ASSERT(Rejected(snapshotPath));
+
+    // damaged content of the last entry
+    WriteSnapshot(snapshotPath, 3);
+    const auto file = fopen(snapshotPath.c_str(), "r+b");
+    CPPUNIT_ASSERT(file);
+    CPPUNIT_ASSERT_EQUAL(0, fseek(file, -20, SEEK_END));
+    CPPUNIT_ASSERT_EQUAL(int('x'), fputc('x', file));
+    CPPUNIT_ASSERT_EQUAL(0, fclose(file));
+    uint64_t intact = 0;
+    CPPUNIT_ASSERT(!ReadAll(snapshotPath, intact));
+    // entries are checked one by one, so earlier entries are still usable
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), intact);
+
+    CPPUNIT_ASSERT_EQUAL(0, truncate(snapshotPath.c_str(), 10));
+    CPPUNIT_ASSERT(Rejected(snapshotPath));
+}
+
+void
+TestMemStoreSnapshot::testContentSizeMismatch()
+{
+    Snapshot::Entry entry;
+    entry.size = 10;
+
+    {
+        Snapshot::Writer writer(snapshotPath);
+        writer.addEntry(entry);
+        writer.addContent("12345", 5);
+        CPPUNIT_ASSERT_THROW(writer.finish(), std::exception);
+    }
+
+    {
+        Snapshot::Writer writer(snapshotPath);
+        writer.addEntry(entry);
+        CPPUNIT_ASSERT_THROW(writer.addContent("12345678901", 11), std::exception);
+    }
+
+    {
+        Snapshot::Writer writer(snapshotPath);
+        writer.addEntry(entry);
+        writer.addContent("12345", 5);
+        CPPUNIT_ASSERT_THROW(writer.addEntry(entry), std::exception);
+    }
+
+    // failed writers leave nothing behind
+    CPPUNIT_ASSERT(access(snapshotPath.c_str(), F_OK) != 0);
+}
+
+void
+TestMemStoreSnapshot::testUnfinished()
+{
+    {
+        Snapshot::Writer writer(snapshotPath);
+        AddEntry(writer, 1);
+        // an exception or shutdown interrupts saving
+    }
+    CPPUNIT_ASSERT(access(snapshotPath.c_str(), F_OK) != 0);
+    CPPUNIT_ASSERT(access(ToSBuf(snapshotPath, ".new").c_str(), F_OK) != 0);
+
+    // an old snapshot survives until the new one is finished
+    WriteSnapshot(snapshotPath, 2);
+    {
+        Snapshot::Writer writer(snapshotPath);
+        AddEntry(writer, 1);
+    }
+    CPPUNIT_ASSERT(!Rejected(snapshotPath));
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/RegexSet.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <vector>
+
+class TestRegexSet : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestRegexSet);
+    CPPUNIT_TEST(testAdd);
+    CPPUNIT_TEST(testPlainStrings);
+    CPPUNIT_TEST(testRegexes);
+    CPPUNIT_TEST(testLetterCase);
+    CPPUNIT_TEST(testExactLiteral);
+    CPPUNIT_TEST(testSameAsRegexec);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testAdd();
+    void testPlainStrings();
+    void testRegexes();
+    void testLetterCase();
+    void testExactLiteral();
+    void testSameAsRegexec();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestRegexSet );
+
+static const int Flags = REG_EXTENDED | REG_NOSUB;
+
+/// RegexPattern::RequiredLiteral() exactness for the given regex
+static bool
+IsExact(const char *re, const int flags = Flags)
+{
+    auto exact = false;
+    (void)RegexPattern::RequiredLiteral(SBuf(re), flags, exact);
+    return exact;
+}
+
+void
+TestRegexSet::testAdd()
+{
+    RegexSet set;
+    CPPUNIT_ASSERT(set.add(SBuf("example\\.com"), Flags));
+    CPPUNIT_ASSERT(set.add(SBuf("^http://ads[0-9]+\\."), Flags));
+    CPPUNIT_ASSERT(!set.add(SBuf("foo|bar"), Flags));
+    CPPUNIT_ASSERT(!set.add(SBuf("^[0-9]+$"), Flags));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), set.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), set.literalPatterns());
+}
+
+void
+TestRegexSet::testPlainStrings()
+{
+    RegexSet set;
+    CPPUNIT_ASSERT(set.add(SBuf("example\\.com"), Flags));
+    CPPUNIT_ASSERT(set.add(SBuf("/banner/.*"), Flags));
+    set.compile();
+
+    const auto found = set.match("http://www.example.com/");
+    CPPUNIT_ASSERT(found);
+    CPPUNIT_ASSERT_EQUAL(SBuf("example\\.com"), *found);
+    CPPUNIT_ASSERT(set.match("http://ads.test/banner/1.gif"));
+    CPPUNIT_ASSERT(!set.match("http://www.example.org/"));
+    CPPUNIT_ASSERT(!set.match("http://examplexcom/"));
+    CPPUNIT_ASSERT(!set.match(""));
+}
+
+void
+TestRegexSet::testRegexes()
+{
+    RegexSet set;
+    CPPUNIT_ASSERT(set.add(SBuf("^http://ads[0-9]+\\.example\\."), Flags));
+    CPPUNIT_ASSERT(set.add(SBuf("/banner[0-9]+\\.example\\."), Flags));
+    set.compile();
+
+    CPPUNIT_ASSERT(set.match("http://ads12.example.net/"));
+    // the literal is present, but the regexes do not match
+    CPPUNIT_ASSERT(!set.match("http://ads.example.net/"));
+    CPPUNIT_ASSERT(!set.match("https://ads12.example.net/"));
+    // the second regex sharing a literal with the first one matches
+    CPPUNIT_ASSERT(set.match("http://ads.example.net/banner7.example.gif"));
+}
+
+void
+TestRegexSet::testLetterCase()
+{
+    RegexSet set;
+    CPPUNIT_ASSERT(set.add(SBuf("Tracker"), Flags));
+    CPPUNIT_ASSERT(set.add(SBuf("beacon"), Flags | REG_ICASE));
+    CPPUNIT_ASSERT(set.add(SBuf("^/Pixel[0-9]"), Flags));
+    set.compile();
+
+    CPPUNIT_ASSERT(set.match("/Tracker.js"));
+    CPPUNIT_ASSERT(!set.match("/tracker.js"));
+    // a later occurrence may have the right letter case
+    CPPUNIT_ASSERT(set.match("/tracker/Tracker.js"));
+    CPPUNIT_ASSERT(set.match("/BEACON"));
+    CPPUNIT_ASSERT(set.match("/Pixel1"));
+    CPPUNIT_ASSERT(!set.match("/pixel1"));
+
+    // case-insensitive non-ASCII literals are left to regexec(3) callers
+    RegexSet other;
+    CPPUNIT_ASSERT(!other.add(SBuf("caf\xC3\xA9\\.example"), Flags | REG_ICASE));
+    CPPUNIT_ASSERT(!other.add(SBuf("^/\xC3\x89t\xC3\xA9[0-9]"), Flags | REG_ICASE));
+    CPPUNIT_ASSERT(other.add(SBuf("caf\xC3\xA9\\.example"), Flags));
+    other.compile();
+    CPPUNIT_ASSERT(other.match("http://caf\xC3\xA9.example/"));
+    CPPUNIT_ASSERT(!other.match("http://caf\xC3\x89.example/"));
+}
+
+void
+TestRegexSet::testExactLiteral()
+{
+    CPPUNIT_ASSERT(IsExact("example\\.com"));
+    CPPUNIT_ASSERT(IsExact("example\\.com.*"));
+    CPPUNIT_ASSERT(IsExact("/ads/", Flags | REG_ICASE));
+    CPPUNIT_ASSERT(!IsExact("^example"));
+    CPPUNIT_ASSERT(!IsExact("example$"));
+    CPPUNIT_ASSERT(!IsExact("examples?"));
+    CPPUNIT_ASSERT(!IsExact("example\\\\.*"));
+    CPPUNIT_ASSERT(!IsExact("\\<example"));
+    CPPUNIT_ASSERT(!IsExact("exa.ple"));
+    CPPUNIT_ASSERT(!IsExact("ex(am)ple"));
+    CPPUNIT_ASSERT(!IsExact("example", REG_NOSUB));
+    CPPUNIT_ASSERT(!IsExact("\xC3\x89t\xC3\xA9", Flags | REG_ICASE));
+    CPPUNIT_ASSERT(IsExact("\xC3\x89t\xC3\xA9"));
+}
+
+void
+TestRegexSet::testSameAsRegexec()
+{
+    const std::vector<const char *> patterns = {
+        "example\\.com",
+        "^https?://(www\\.)?ads\\.",
+        "/pixel\\.gif$",
+        "track(er|ing)[0-9]*\\.js",
+        "a+b{2,3}c",
+        "\\.exe.*",
+        "[[:digit:]]{3}\\.test/",
+        "x\\*y",
+    };
+    const std::vector<const char *> subjects = {
+        "http://example.com/",
+        "http://EXAMPLE.com/",
+        "https://www.ads.example.org/",
+        "http://ads.x/",
+        "http://wwwads.x/",
+        "http://a.b/pixel.gif",
+        "http://a.b/pixel.gif?x",
+        "http://a.b/tracking12.js",
+        "http://a.b/track.js",
+        "aabbbc",
+        "abc",
+        "http://a.b/setup.EXE",
+        "http://a.b/setup.exe",
+        "http://123.test/",
+        "http://12.test/",
+        "x*y",
+        "xy",
+        "",
+    };
+
+    for (const auto icase: {0, REG_ICASE}) {
+        for (const auto pattern: patterns) {
+            RegexSet set;
+            if (!set.add(SBuf(pattern), Flags | icase))
+                continue;
+            set.compile();
+            const RegexPattern regex(SBuf(pattern), Flags | icase);
+            for (const auto subject: subjects) {
+                const auto expected = regex.match(subject);
+                const auto actual = set.match(subject) != nullptr;
+                if (expected != actual)
+                    CPPUNIT_FAIL(std::string("mismatch for ") + pattern + " and " + subject);
+            }
+        }
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "fs/rock/RockIndexSnapshot.h"
+#include "sbuf/Stream.h"
+#include "unitTestMain.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+class TestRockIndexSnapshot : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestRockIndexSnapshot);
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testStaleDb);
+    CPPUNIT_TEST(testDamage);
+    CPPUNIT_TEST(testInvalidEntries);
+    CPPUNIT_TEST(testUnfinished);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+protected:
+    void testRoundTrip();
+    void testStaleDb();
+    void testDamage();
+    void testInvalidEntries();
+    void testUnfinished();
+
+private:
+    SBuf dir; ///< a temporary directory for the db and snapshot files
+    SBuf dbPath;
+    SBuf snapshotPath;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestRockIndexSnapshot );
+
+using Snapshot = Rock::IndexSnapshot;
+
+/// an entry with the given position and slots, each slot storing 100 bytes
+static Snapshot::Entry
+MakeEntry(const int32_t fileNo, std::vector<Snapshot::Slice> &slices, const std::vector<int32_t> &slotIds)
+{
+    Snapshot::Entry entry;
+    entry.fileNo = fileNo;
+    entry.key[0] = fileNo;
+    entry.key[1] = ~uint64_t(fileNo);
+    entry.timestamp = 1000 + fileNo;
+    entry.lastref = 2000 + fileNo;
+    entry.refcount = 3;
+    slices.clear();
+    for (const auto slotId: slotIds)
+        slices.push_back(Snapshot::Slice{slotId, 100});
+    entry.slices = slices.size();
+    entry.swapFileSize = 100 * slices.size();
+    entry.splicingPoint = slotIds.front();
+    return entry;
+}
+
+/// saves a MakeEntry() entry
+static void
+AddEntry(Snapshot::Writer &writer, const int32_t fileNo, const std::vector<int32_t> &slotIds)
+{
+    std::vector<Snapshot::Slice> slices;
+    const auto entry = MakeEntry(fileNo, slices, slotIds);
+    writer.addEntry(entry, slices.data());
+}
+
+/// the state of the test db with 7 entry names and 10 slots
+static Snapshot::DbState
+CurrentDbState(SBuf &dbPath)
+{
+    Snapshot::DbState db;
+    db.slotSize = 4096;
+    db.slotLimit = 10;
+    db.entryLimit = 7;
+    CPPUNIT_ASSERT_EQUAL(0, db.stat(dbPath.c_str()));
+    return db;
+}
+
+/// writes a valid snapshot with three entries
+static void
+WriteSnapshot(const SBuf &path, const Snapshot::DbState &db)
+{
+    Snapshot::Writer writer(path, db);
+    for (int32_t name = 0; name < db.entryLimit; ++name)
+        writer.addFileNo(name == 2 ? 5 : (name == 5 ? 2 : name)); // a relocation
+
+    AddEntry(writer, 0, {3});
+    AddEntry(writer, 5, {9, 0, 4});
+    AddEntry(writer, 6, {1, 2});
+    writer.finish();
+}
+
+/// whether Reader::open() rejects the snapshot
+static bool
+Rejected(const SBuf &path, const Snapshot::DbState &db)
+{
+    Snapshot::Reader reader;
+    try {
+        reader.open(path, db);
+    } catch (const std::exception &) {
+        return true;
+    }
+    return false;
+}
+
+/// appends the given bytes to the given file
+static void
+Append(SBuf path, const char *bytes)
+{
+    const auto file = fopen(path.c_str(), "ab");
+    CPPUNIT_ASSERT(file);
+    CPPUNIT_ASSERT_EQUAL(strlen(bytes), fwrite(bytes, 1, strlen(bytes), file));
+    CPPUNIT_ASSERT_EQUAL(0, fclose(file));
+}
+
+void
+TestRockIndexSnapshot::setUp()
+{
+    char dirTemplate[] = "/tmp/testRockIndexSnapshot.XXXXXX";
+    CPPUNIT_ASSERT(mkdtemp(dirTemplate));
+    dir = SBuf(dirTemplate);
+    dbPath = ToSBuf(dir, "/rock");
+    snapshotPath = Snapshot::Path(dir.c_str());
+    Append(dbPath, "db contents");
+}
+
+void
+TestRockIndexSnapshot::tearDown()
+{
+    (void)unlink(snapshotPath.c_str());
+    (void)unlink(dbPath.c_str());
+    CPPUNIT_ASSERT_EQUAL(0, rmdir(dir.c_str()));
+}
+
+void
+TestRockIndexSnapshot::testRoundTrip()
+{
+    const auto db = CurrentDbState(dbPath);
+    WriteSnapshot(snapshotPath, db);
+
+    Snapshot::Reader reader;
+    reader.open(snapshotPath, db);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), reader.entries());
+    const auto fileNos = reader.fileNos();
+    const std::vector<int32_t> expectedFileNos = {0, 1, 5, 3, 4, 2, 6};
+    CPPUNIT_ASSERT(std::vector<int32_t>(fileNos, fileNos + db.entryLimit) == expectedFileNos);
+
+    std::vector<int32_t> visitedSlots;
+    int entries = 0;
+    reader.visitEntries([&](const Snapshot::Entry &entry, const Snapshot::Slice *slices) {
+        ++entries;
+        CPPUNIT_ASSERT_EQUAL(int64_t(1000 + entry.fileNo), entry.timestamp);
+        CPPUNIT_ASSERT_EQUAL(~uint64_t(entry.fileNo), entry.key[1]);
+        CPPUNIT_ASSERT_EQUAL(slices[0].id, entry.splicingPoint);
+        for (uint32_t i = 0; i < entry.slices; ++i) {
+            CPPUNIT_ASSERT_EQUAL(uint32_t(100), slices[i].size);
+            visitedSlots.push_back(slices[i].id);
+        }
+    });
+    CPPUNIT_ASSERT_EQUAL(3, entries);
+    const std::vector<int32_t> expectedSlots = {3, 9, 0, 4, 1, 2};
+    CPPUNIT_ASSERT(visitedSlots == expectedSlots);
+}
+
+void
+TestRockIndexSnapshot::testStaleDb()
+{
+    const auto db = CurrentDbState(dbPath);
+    WriteSnapshot(snapshotPath, db);
+    CPPUNIT_ASSERT(!Rejected(snapshotPath, db));
+
+    auto reconfigured = db;
+    reconfigured.slotLimit = 11;
+    CPPUNIT_ASSERT(Rejected(snapshotPath, reconfigured));
+
+    Append(dbPath, "more db contents");
+    CPPUNIT_ASSERT(Rejected(snapshotPath, CurrentDbState(dbPath)));
+}
+
+void
+TestRockIndexSnapshot::testDamage()
+{
+    const auto db = CurrentDbState(dbPath);
+    WriteSnapshot(snapshotPath, db);
+    Append(snapshotPath, "garbage");
+    CPPUNIT_ASSERT(Rejected(snapshotPath, db));
+
+    WriteSnapshot(snapshotPath, db);
+    const auto file = fopen(snapshotPath.c_str(), "r+b");
+    CPPUNIT_ASSERT(file);
+    CPPUNIT_ASSERT_EQUAL(0, fseek(file, -3, SEEK_END));
+    CPPUNIT_ASSERT_EQUAL(int('x'), fputc('x', file));
+    CPPUNIT_ASSERT_EQUAL(0, fclose(file));
+    CPPUNIT_ASSERT(Rejected(snapshotPath, db));
+}
+
+void
+TestRockIndexSnapshot::testInvalidEntries()
+{
+    const auto db = CurrentDbState(dbPath);
+
+    {
+        Snapshot::Writer writer(snapshotPath, db);
+        for (int32_t name = 0; name < db.entryLimit; ++name)
+            writer.addFileNo(name);
+        AddEntry(writer, 0, {3, 4});
+        AddEntry(writer, 1, {5, 3}); // slot 3 is reused
+        writer.finish();
+    }
+    CPPUNIT_ASSERT(Rejected(snapshotPath, db));
+
+    {
+        Snapshot::Writer writer(snapshotPath, db);
+        for (int32_t name = 0; name < db.entryLimit; ++name)
+            writer.addFileNo(name);
+        std::vector<Snapshot::Slice> slices;
+        auto entry = MakeEntry(0, slices, {3, 4});
+        entry.swapFileSize += 1;
+        writer.addEntry(entry, slices.data());
+        writer.finish();
+    }
+    CPPUNIT_ASSERT(Rejected(snapshotPath, db));
+
+    {
+        Snapshot::Writer writer(snapshotPath, db);
+        for (int32_t name = 0; name < db.entryLimit; ++name)
+            writer.addFileNo(name);
+        AddEntry(writer, 0, {3, int32_t(db.slotLimit)});
+        writer.finish();
+    }
+    CPPUNIT_ASSERT(Rejected(snapshotPath, db));
+}
+
+void
+TestRockIndexSnapshot::testUnfinished()
+{
+    const auto db = CurrentDbState(dbPath);
+    {
+        Snapshot::Writer writer(snapshotPath, db);
+        writer.addFileNo(0);
+        // an exception or shutdown interrupts saving
+    }
+    CPPUNIT_ASSERT(access(snapshotPath.c_str(), F_OK) != 0);
+    CPPUNIT_ASSERT(access(ToSBuf(snapshotPath, ".new").c_str(), F_OK) != 0);
+
+    // an old snapshot survives until the new one is finished
+    WriteSnapshot(snapshotPath, db);
+    {
+        Snapshot::Writer writer(snapshotPath, db);
+    }
+    CPPUNIT_ASSERT(!Rejected(snapshotPath, db));
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
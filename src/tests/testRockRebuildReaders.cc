@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "fs/rock/RockRebuildReaders.h"
+#include "unitTestMain.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+class TestRockRebuildReaders : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestRockRebuildReaders);
+    CPPUNIT_TEST(testSmallSlots);
+    CPPUNIT_TEST(testLargeSlots);
+    CPPUNIT_TEST(testResumingAndTruncation);
+    CPPUNIT_TEST(testEarlyDestruction);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testSmallSlots();
+    void testLargeSlots();
+    void testResumingAndTruncation();
+    void testEarlyDestruction();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestRockRebuildReaders );
+
+/// the size of the db header preceding the first slot
+static const int64_t DbOffset = 512;
+
+/// the byte at the given offset of the given slot
+static char
+SlotByte(const int64_t slotId, const int64_t offset)
+{
+    return static_cast<char>(slotId * 31 + offset % 251);
+}
+
+/// a temporary db file with slots filled using SlotByte()
+class Db
+{
+public:
+    Db(const int64_t slotSize, const int64_t slots, const int64_t truncatedBytes = 0) {
+        file = tmpfile();
+        CPPUNIT_ASSERT(file);
+        const std::vector<char> header(DbOffset, 'h');
+        CPPUNIT_ASSERT_EQUAL(size_t(1), fwrite(header.data(), header.size(), 1, file));
+        std::vector<char> slot(slotSize);
+        for (int64_t slotId = 0; slotId < slots; ++slotId) {
+            for (int64_t offset = 0; offset < slotSize; ++offset)
+                slot[offset] = SlotByte(slotId, offset);
+            const auto size = slotId + 1 == slots ? slotSize - truncatedBytes : slotSize;
+            if (size > 0)
+                CPPUNIT_ASSERT_EQUAL(size_t(1), fwrite(slot.data(), size, 1, file));
+        }
+        CPPUNIT_ASSERT_EQUAL(0, fflush(file));
+    }
+    ~Db() { fclose(file); }
+
+    int fd() const { return fileno(file); }
+
+    FILE *file = nullptr;
+};
+
+/// checks that the readers supply the expected prefixes of [firstSlot, slotLimit) slots
+static void
+CheckSlots(Rock::RebuildReaders &readers, const int64_t firstSlot, const int64_t slotLimit, const size_t prefixSize, const int64_t lastSlotSize)
+{
+    for (auto slotId = firstSlot; slotId < slotLimit; ++slotId) {
+        // exercise both the polling and the blocking interfaces
+        if (slotId % 2)
+            while (!readers.ready(slotId))
+                usleep(100);
+
+        const auto prefix = readers.get(slotId);
+        const auto expectedSize = slotId + 1 == slotLimit ?
+                                  std::min<int64_t>(prefixSize, lastSlotSize) : int64_t(prefixSize);
+        CPPUNIT_ASSERT_EQUAL(ssize_t(expectedSize), prefix.size);
+        for (int64_t offset = 0; offset < expectedSize; ++offset)
+            CPPUNIT_ASSERT_EQUAL(SlotByte(slotId, offset), prefix.data[offset]);
+    }
+}
+
+void
+TestRockRebuildReaders::testSmallSlots()
+{
+    const int64_t slotSize = 16*1024;
+    const int64_t slots = 1000; // several 4MB batches
+    Db db(slotSize, slots);
+    for (const auto threads: {1, 3}) {
+        Rock::RebuildReaders readers(db.fd(), DbOffset, slotSize, 0, slots, 4096, threads);
+        readers.start();
+        CheckSlots(readers, 0, slots, 4096, slotSize);
+    }
+}
+
+void
+TestRockRebuildReaders::testLargeSlots()
+{
+    // slots too large to be read in full
+    const int64_t slotSize = 256*1024;
+    const int64_t slots = 40;
+    Db db(slotSize, slots);
+    Rock::RebuildReaders readers(db.fd(), DbOffset, slotSize, 0, slots, 4096, 2);
+    readers.start();
+    CheckSlots(readers, 0, slots, 4096, slotSize);
+}
+
+void
+TestRockRebuildReaders::testResumingAndTruncation()
+{
+    const int64_t slotSize = 1024;
+    const int64_t slots = 10000;
+    const int64_t truncatedBytes = 1000;
+    Db db(slotSize, slots, truncatedBytes);
+
+    // prefixes are limited to the slot size
+    Rock::RebuildReaders readers(db.fd(), DbOffset, slotSize, 7777, slots, 4096, 4);
+    readers.start();
+    CheckSlots(readers, 7777, slots, slotSize, slotSize - truncatedBytes);
+}
+
+void
+TestRockRebuildReaders::testEarlyDestruction()
+{
+    const int64_t slotSize = 4096;
+    const int64_t slots = 20000;
+    Db db(slotSize, slots);
+    Rock::RebuildReaders readers(db.fd(), DbOffset, slotSize, 0, slots, 4096, 3);
+    readers.start();
+    CheckSlots(readers, 0, 10, 4096, slotSize);
+    // the destructor must stop readers waiting for unexamined batches
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
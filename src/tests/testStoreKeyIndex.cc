@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "store/KeyIndex.h"
+#include "unitTestMain.h"
+
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+class TestStoreKeyIndex : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestStoreKeyIndex);
+    CPPUNIT_TEST(testBasics);
+    CPPUNIT_TEST(testGrowth);
+    CPPUNIT_TEST(testVisitSome);
+    CPPUNIT_TEST(testVisitWhileGrowing);
+    CPPUNIT_TEST(testSameAsOrderedMap);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testBasics();
+    void testGrowth();
+    void testVisitSome();
+    void testVisitWhileGrowing();
+    void testSameAsOrderedMap();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestStoreKeyIndex );
+
+/// a stand-in for StoreEntry
+class Item
+{
+public:
+    cache_key key[16];
+};
+
+using Index = Store::KeyIndex<Item>;
+
+/// creates items with distinct random keys
+static std::vector<Item>
+MakeItems(const size_t count, const uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<Item> items(count);
+    for (auto &item: items) {
+        const uint64_t words[2] = { rng(), rng() };
+        memcpy(item.key, words, sizeof(item.key));
+    }
+    return items;
+}
+
+void
+TestStoreKeyIndex::testBasics()
+{
+    Index index;
+    auto items = MakeItems(3, 1);
+    CPPUNIT_ASSERT(!index.find(items[0].key));
+
+    for (auto &item: items)
+        index.insert(item.key, &item);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), index.size());
+    for (auto &item: items)
+        CPPUNIT_ASSERT_EQUAL(&item, index.find(item.key));
+
+    // erasing needs both the key and the indexed value
+    CPPUNIT_ASSERT(!index.erase(items[0].key, &items[1]));
+    CPPUNIT_ASSERT(index.erase(items[0].key, &items[0]));
+    CPPUNIT_ASSERT(!index.erase(items[0].key, &items[0]));
+    CPPUNIT_ASSERT(!index.find(items[0].key));
+    CPPUNIT_ASSERT_EQUAL(&items[1], index.find(items[1].key));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+
+    // keys that differ in just one byte
+    Item twin = items[1];
+    twin.key[15] ^= 1;
+    CPPUNIT_ASSERT(!index.find(twin.key));
+    index.insert(twin.key, &twin);
+    CPPUNIT_ASSERT_EQUAL(&twin, index.find(twin.key));
+    CPPUNIT_ASSERT_EQUAL(&items[1], index.find(items[1].key));
+}
+
+void
+TestStoreKeyIndex::testGrowth()
+{
+    Index index(100);
+    const auto initialCapacity = index.capacity();
+    auto items = MakeItems(100000, 2);
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        index.insert(items[i].key, &items[i]);
+        // check a few items, including those that may be moving between tables
+        for (auto j = i; j > 0 && j + 5 > i; --j)
+            CPPUNIT_ASSERT_EQUAL(&items[j], index.find(items[j].key));
+    }
+    CPPUNIT_ASSERT(index.capacity() > initialCapacity);
+    CPPUNIT_ASSERT(index.capacity() >= index.size());
+    for (auto &item: items)
+        CPPUNIT_ASSERT_EQUAL(&item, index.find(item.key));
+
+    // many erasures and insertions without size changes reuse the space
+    const auto grownCapacity = index.capacity();
+    auto replacements = MakeItems(items.size(), 3);
+    for (size_t i = 0; i < items.size(); ++i) {
+        CPPUNIT_ASSERT(index.erase(items[i].key, &items[i]));
+        index.insert(replacements[i].key, &replacements[i]);
+    }
+    CPPUNIT_ASSERT(index.capacity() <= 2*grownCapacity);
+    for (size_t i = 0; i < items.size(); ++i) {
+        CPPUNIT_ASSERT(!index.find(items[i].key));
+        CPPUNIT_ASSERT_EQUAL(&replacements[i], index.find(replacements[i].key));
+    }
+}
+
+void
+TestStoreKeyIndex::testVisitSome()
+{
+    Index index;
+    auto items = MakeItems(5000, 4);
+    for (auto &item: items)
+        index.insert(item.key, &item);
+
+    std::set<Item *> visited;
+    Index::Cursor cursor;
+    while (!cursor.done()) {
+        index.visitSome(cursor, [&visited](Item *item) {
+            CPPUNIT_ASSERT(visited.insert(item).second);
+        });
+    }
+    CPPUNIT_ASSERT_EQUAL(items.size(), visited.size());
+}
+
+void
+TestStoreKeyIndex::testVisitWhileGrowing()
+{
+    Index index;
+    auto items = MakeItems(5000, 7);
+    auto added = MakeItems(100000, 8);
+    for (auto &item: items)
+        index.insert(item.key, &item);
+
+    // shards grow (and move entries to new tables) between visitSome() calls
+    std::set<Item *> visited;
+    Index::Cursor cursor;
+    size_t addedCount = 0;
+    while (!cursor.done()) {
+        index.visitSome(cursor, [&visited](Item *item) {
+            visited.insert(item);
+        });
+        for (auto i = 0; i < 50 && addedCount < added.size(); ++i, ++addedCount)
+            index.insert(added[addedCount].key, &added[addedCount]);
+    }
+    CPPUNIT_ASSERT(addedCount > items.size());
+
+    for (auto &item: items)
+        CPPUNIT_ASSERT(visited.count(&item));
+}
+
+void
+TestStoreKeyIndex::testSameAsOrderedMap()
+{
+    Index index;
+    auto items = MakeItems(3000, 5);
+    std::map<Item *, bool> model; // item -> whether it is indexed
+    std::mt19937_64 rng(6);
+
+    for (int step = 0; step < 200000; ++step) {
+        auto &item = items[rng() % items.size()];
+        auto &indexed = model[&item];
+        if (rng() % 2) {
+            if (!indexed)
+                index.insert(item.key, &item);
+            indexed = true;
+        } else {
+            CPPUNIT_ASSERT_EQUAL(indexed, index.erase(item.key, &item));
+            indexed = false;
+        }
+
+        const auto &probe = items[rng() % items.size()];
+        const auto found = index.find(probe.key);
+        CPPUNIT_ASSERT_EQUAL(model[const_cast<Item *>(&probe)], found != nullptr);
+        CPPUNIT_ASSERT(!found || found == &probe);
+    }
+
+    size_t expectedSize = 0;
+    for (const auto &m: model)
+        expectedSize += m.second;
+    CPPUNIT_ASSERT_EQUAL(expectedSize, index.size());
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/TimerWheel.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+class TestTimerWheel : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestTimerWheel);
+    CPPUNIT_TEST(testAdvance);
+    CPPUNIT_TEST(testCancel);
+    CPPUNIT_TEST(testEarliest);
+    CPPUNIT_TEST(testDistantTimers);
+    CPPUNIT_TEST(testSameAsOrderedMap);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testAdvance();
+    void testCancel();
+    void testEarliest();
+    void testDistantTimers();
+    void testSameAsOrderedMap();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestTimerWheel );
+
+using Tick = TimerWheel::Tick;
+
+/// the ticks at which the given timers became due, indexed by timer
+static std::vector<Tick>
+AdvanceByOne(TimerWheel &wheel, std::vector<TimerWheel::Timer> &timers, const Tick last)
+{
+    std::vector<Tick> firedAt(timers.size(), 0);
+    while (wheel.now() < last) {
+        const auto now = wheel.now() + 1;
+        wheel.advance(now, [&](TimerWheel::Timer &timer) {
+            firedAt[&timer - timers.data()] = now;
+        });
+    }
+    return firedAt;
+}
+
+void
+TestTimerWheel::testAdvance()
+{
+    TimerWheel wheel(100);
+    std::vector<TimerWheel::Timer> timers(6);
+    const std::vector<Tick> due = { 101, 163, 164, 165, 100 + 64*64, 100 + 64*64*64 + 7 };
+    for (size_t i = 0; i < due.size(); ++i)
+        wheel.schedule(timers[i], due[i]);
+    CPPUNIT_ASSERT_EQUAL(due.size(), wheel.size());
+
+    const auto firedAt = AdvanceByOne(wheel, timers, due.back());
+    for (size_t i = 0; i < due.size(); ++i) {
+        CPPUNIT_ASSERT_EQUAL(due[i], firedAt[i]);
+        CPPUNIT_ASSERT(!timers[i].scheduled());
+    }
+    CPPUNIT_ASSERT(wheel.empty());
+
+    // timers that are already due fire without advancing the clock
+    TimerWheel::Timer late;
+    wheel.schedule(late, wheel.now() - 5);
+    auto calls = 0;
+    wheel.advance(0, [&](TimerWheel::Timer &timer) {
+        CPPUNIT_ASSERT_EQUAL(&late, &timer);
+        ++calls;
+    });
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+    CPPUNIT_ASSERT_EQUAL(due.back(), wheel.now());
+}
+
+void
+TestTimerWheel::testCancel()
+{
+    TimerWheel wheel;
+    std::vector<TimerWheel::Timer> timers(3);
+    wheel.schedule(timers[0], 10);
+    wheel.schedule(timers[1], 10);
+    wheel.schedule(timers[2], 5000);
+
+    wheel.cancel(timers[0]);
+    CPPUNIT_ASSERT(!timers[0].scheduled());
+    wheel.cancel(timers[0]); // no-op
+    wheel.schedule(timers[2], 20); // reschedules
+    CPPUNIT_ASSERT_EQUAL(size_t(2), wheel.size());
+
+    const auto firedAt = AdvanceByOne(wheel, timers, 6000);
+    CPPUNIT_ASSERT_EQUAL(Tick(0), firedAt[0]);
+    CPPUNIT_ASSERT_EQUAL(Tick(10), firedAt[1]);
+    CPPUNIT_ASSERT_EQUAL(Tick(20), firedAt[2]);
+}
+
+void
+TestTimerWheel::testEarliest()
+{
+    TimerWheel wheel(1000);
+    CPPUNIT_ASSERT(!wheel.earliest());
+
+    std::vector<TimerWheel::Timer> timers(3);
+    wheel.schedule(timers[0], 900000);
+    wheel.schedule(timers[1], 5000);
+    wheel.schedule(timers[2], 5001);
+    CPPUNIT_ASSERT_EQUAL(static_cast<const TimerWheel::Timer *>(&timers[1]), wheel.earliest());
+
+    wheel.cancel(timers[1]);
+    CPPUNIT_ASSERT_EQUAL(static_cast<const TimerWheel::Timer *>(&timers[2]), wheel.earliest());
+
+    wheel.schedule(timers[1], 1200);
+    CPPUNIT_ASSERT_EQUAL(static_cast<const TimerWheel::Timer *>(&timers[1]), wheel.earliest());
+
+    wheel.advance(5001, [](TimerWheel::Timer &) {});
+    CPPUNIT_ASSERT_EQUAL(static_cast<const TimerWheel::Timer *>(&timers[0]), wheel.earliest());
+}
+
+void
+TestTimerWheel::testDistantTimers()
+{
+    TimerWheel wheel(7);
+    std::vector<TimerWheel::Timer> timers(3);
+    const std::vector<Tick> due = { Tick(1) << 40, (Tick(1) << 62) + 3, ~Tick(0) };
+    for (size_t i = 0; i < due.size(); ++i)
+        wheel.schedule(timers[i], due[i]);
+
+    for (size_t i = 0; i < due.size(); ++i) {
+        // just before the due tick
+        wheel.advance(due[i] - 1, [](TimerWheel::Timer &) {
+            CPPUNIT_FAIL("a timer fired too early");
+        });
+        CPPUNIT_ASSERT_EQUAL(static_cast<const TimerWheel::Timer *>(&timers[i]), wheel.earliest());
+
+        auto fired = 0;
+        wheel.advance(due[i], [&](TimerWheel::Timer &timer) {
+            CPPUNIT_ASSERT_EQUAL(&timers[i], &timer);
+            ++fired;
+        });
+        CPPUNIT_ASSERT_EQUAL(1, fired);
+    }
+    CPPUNIT_ASSERT(wheel.empty());
+}
+
+void
+TestTimerWheel::testSameAsOrderedMap()
+{
+    std::mt19937_64 rng(42);
+    TimerWheel wheel(rng() % 1000000);
+    std::vector<TimerWheel::Timer> timers(500);
+    std::multimap<Tick, size_t> model; // due tick -> timer index
+
+    const auto forget = [&model](const size_t index) {
+        for (auto i = model.begin(); i != model.end(); ++i) {
+            if (i->second == index) {
+                model.erase(i);
+                return;
+            }
+        }
+    };
+
+    for (int step = 0; step < 20000; ++step) {
+        const auto index = rng() % timers.size();
+        switch (rng() % 4) {
+        case 0:
+        case 1: {
+            // mostly near timers, with some distant ones
+            const auto distance = rng() % 8 ? rng() % 5000 : rng() % (Tick(1) << 30);
+            const auto due = wheel.now() + distance;
+            forget(index);
+            wheel.schedule(timers[index], due);
+            model.emplace(due, index);
+            break;
+        }
+        case 2:
+            forget(index);
+            wheel.cancel(timers[index]);
+            break;
+        default: {
+            const auto target = wheel.now() + (rng() % 4 ? rng() % 300 : rng() % 100000);
+            std::vector<size_t> fired;
+            wheel.advance(target, [&](TimerWheel::Timer &timer) {
+                fired.push_back(&timer - timers.data());
+            });
+            std::vector<size_t> expected;
+            while (!model.empty() && model.begin()->first <= target) {
+                expected.push_back(model.begin()->second);
+                model.erase(model.begin());
+            }
+            std::sort(fired.begin(), fired.end());
+            std::sort(expected.begin(), expected.end());
+            CPPUNIT_ASSERT(fired == expected);
+        }
+        }
+
+        CPPUNIT_ASSERT_EQUAL(model.size(), wheel.size());
+        if (!model.empty()) {
+            const auto earliest = wheel.earliest();
+            CPPUNIT_ASSERT(earliest);
+            CPPUNIT_ASSERT_EQUAL(model.begin()->first, earliest->due());
+        }
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "repl/tinylfu/WTinyLfu.h"
+#include "store/FrequencySketch.h"
+#include "unitTestMain.h"
+
+#include <map>
+#include <vector>
+
+class TestTinyLfu : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestTinyLfu);
+    CPPUNIT_TEST(testSketchCounting);
+    CPPUNIT_TEST(testSketchAging);
+    CPPUNIT_TEST(testLruOrder);
+    CPPUNIT_TEST(testScanResistance);
+    CPPUNIT_TEST(testRestore);
+    CPPUNIT_TEST(testWalk);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testSketchCounting();
+    void testSketchAging();
+    void testLruOrder();
+    void testScanResistance();
+    void testRestore();
+    void testWalk();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestTinyLfu );
+
+using Store::FrequencySketch;
+
+/// a fixed-capacity cache of numbered objects using WTinyLfu eviction order
+class Cache
+{
+public:
+    Cache(const size_t aCapacity, const int windowPercent): order(windowPercent), capacity(aCapacity) {}
+
+    /// requests the given object, caching it on misses; \returns whether it was a hit
+    bool request(const uint64_t id)
+    {
+        const auto found = nodes.find(id);
+        if (found != nodes.end()) {
+            order.touch(found->second);
+            return true;
+        }
+
+        order.add(nodes[id], id);
+        while (order.count() > capacity) {
+            const auto victim = order.evict();
+            CPPUNIT_ASSERT(victim);
+            nodes.erase(victim->hash);
+        }
+        return false;
+    }
+
+    bool has(const uint64_t id) const { return nodes.count(id); }
+
+    WTinyLfu order;
+    std::map<uint64_t, WTinyLfu::Node> nodes;
+    const size_t capacity;
+};
+
+void
+TestTinyLfu::testSketchCounting()
+{
+    FrequencySketch sketch(1024);
+    CPPUNIT_ASSERT_EQUAL(size_t(1024), sketch.width());
+    CPPUNIT_ASSERT_EQUAL(size_t(4*1024/2), sketch.memoryUsed()); // 4 rows of 4-bit counters
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0), sketch.frequency(42));
+
+    for (int i = 0; i < 5; ++i)
+        sketch.record(42);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(5), sketch.frequency(42));
+
+    // counters saturate
+    for (int i = 0; i < 20; ++i)
+        sketch.record(43);
+    CPPUNIT_ASSERT_EQUAL(FrequencySketch::MaxFrequency, sketch.frequency(43));
+
+    // rarely recorded hashes have low estimates despite collisions
+    for (uint64_t hash = 1000; hash < 1500; ++hash)
+        sketch.record(hash);
+    int overestimated = 0;
+    for (uint64_t hash = 1000; hash < 1500; ++hash) {
+        const auto frequency = sketch.frequency(hash);
+        CPPUNIT_ASSERT(frequency >= 1); // never underestimates
+        overestimated += frequency > 1;
+    }
+    CPPUNIT_ASSERT(overestimated < 25);
+
+    // growing preserves the history
+    sketch.resize(5000);
+    CPPUNIT_ASSERT_EQUAL(size_t(8192), sketch.width());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(5), sketch.frequency(42));
+    CPPUNIT_ASSERT_EQUAL(FrequencySketch::MaxFrequency, sketch.frequency(43));
+
+    // shrinking forgets the history
+    sketch.resize(100);
+    CPPUNIT_ASSERT_EQUAL(size_t(128), sketch.width());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0), sketch.frequency(42));
+
+    // huge caches get a capped sketch
+    sketch.resize(FrequencySketch::MaxWidth * 8);
+    CPPUNIT_ASSERT_EQUAL(FrequencySketch::MaxWidth, sketch.width());
+    CPPUNIT_ASSERT_EQUAL(size_t(32*1024*1024), sketch.memoryUsed());
+}
+
+void
+TestTinyLfu::testSketchAging()
+{
+    FrequencySketch sketch(16);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(160), sketch.sampleSize());
+
+    for (int i = 0; i < 10; ++i)
+        sketch.record(7);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(10), sketch.frequency(7));
+
+    for (uint64_t i = 0; sketch.agings() == 0; ++i) {
+        CPPUNIT_ASSERT(i < sketch.sampleSize());
+        sketch.record(1000 + i);
+    }
+    CPPUNIT_ASSERT(sketch.frequency(7) <= 5 + 1); // halved (plus collisions)
+
+    // saturated counters, many of them sharing packed words, are halved
+    // without disturbing their neighbors
+    FrequencySketch saturated(1024);
+    const uint64_t hashes = 600; // saturating them does not trigger aging yet
+    for (uint64_t hash = 0; hash < hashes; ++hash) {
+        for (int i = 0; i < FrequencySketch::MaxFrequency; ++i)
+            saturated.record(hash);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), saturated.agings());
+    for (uint64_t hash = 0; hash < hashes; ++hash)
+        CPPUNIT_ASSERT_EQUAL(FrequencySketch::MaxFrequency, saturated.frequency(hash));
+    while (saturated.agings() == 0)
+        saturated.record(1000000);
+    for (uint64_t hash = 0; hash < hashes; ++hash)
+        CPPUNIT_ASSERT_EQUAL(uint8_t(FrequencySketch::MaxFrequency/2), saturated.frequency(hash));
+}
+
+void
+TestTinyLfu::testLruOrder()
+{
+    WTinyLfu order(100);
+    std::vector<WTinyLfu::Node> nodes(5);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        order.add(nodes[i], i);
+    order.touch(nodes[1]);
+    order.requeue(nodes[3]);
+
+    const std::vector<uint64_t> expected = {0, 2, 4, 1, 3};
+    for (const auto hash: expected) {
+        const auto victim = order.evict();
+        CPPUNIT_ASSERT(victim);
+        CPPUNIT_ASSERT_EQUAL(hash, victim->hash);
+    }
+    CPPUNIT_ASSERT(!order.evict());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), order.count());
+}
+
+void
+TestTinyLfu::testScanResistance()
+{
+    const size_t capacity = 100;
+    Cache lru(capacity, 100);
+    Cache tinyLfu(capacity, 1);
+
+    // a popular working set that fits
+    for (int round = 0; round < 5; ++round) {
+        for (uint64_t id = 0; id < 50; ++id) {
+            lru.request(id);
+            tinyLfu.request(id);
+        }
+    }
+
+    // a long scan of objects requested once
+    for (uint64_t id = 1000; id < 3000; ++id) {
+        lru.request(id);
+        tinyLfu.request(id);
+        CPPUNIT_ASSERT(tinyLfu.order.count() <= capacity);
+    }
+
+    int lruSurvivors = 0;
+    int tinyLfuSurvivors = 0;
+    for (uint64_t id = 0; id < 50; ++id) {
+        lruSurvivors += lru.has(id);
+        tinyLfuSurvivors += tinyLfu.has(id);
+    }
+    CPPUNIT_ASSERT_EQUAL(0, lruSurvivors);
+    // most of the popular set survives (sketch collisions inflate some
+    // estimates of the scanned objects)
+    CPPUNIT_ASSERT(tinyLfuSurvivors >= 30);
+}
+
+void
+TestTinyLfu::testRestore()
+{
+    WTinyLfu order(1);
+    std::vector<WTinyLfu::Node> nodes(3);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        order.add(nodes[i], i);
+
+    const auto victim = order.evict();
+    CPPUNIT_ASSERT(victim);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), order.count());
+
+    // the restored entry becomes the most recently used one in its segment
+    order.restore(*victim);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), order.count());
+    const auto nextVictim = order.evict();
+    CPPUNIT_ASSERT(nextVictim);
+    CPPUNIT_ASSERT(nextVictim != victim);
+
+    order.remove(*victim);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), order.count());
+    CPPUNIT_ASSERT_EQUAL(WTinyLfu::sgNone, victim->segment);
+}
+
+void
+TestTinyLfu::testWalk()
+{
+    WTinyLfu order(10);
+    std::vector<WTinyLfu::Node> nodes(50);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        order.add(nodes[i], i);
+    for (size_t i = 0; i < nodes.size(); i += 3)
+        order.touch(nodes[i]);
+    CPPUNIT_ASSERT(order.count(WTinyLfu::sgWindow) > 0);
+    CPPUNIT_ASSERT(order.count(WTinyLfu::sgProbation) > 0);
+    CPPUNIT_ASSERT(order.count(WTinyLfu::sgProtected) > 0);
+
+    std::vector<int> visits(nodes.size());
+    for (auto node = order.walk(nullptr); node; node = order.walk(node))
+        ++visits.at(node->hash);
+    CPPUNIT_ASSERT(visits == std::vector<int>(nodes.size(), 1));
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
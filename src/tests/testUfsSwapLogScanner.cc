@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "defines.h"
+#include "enums.h"
+#include "fs/ufs/SwapLogScanner.h"
+#include "fs/ufs/UFSSwapLogParser.h"
+#include "StoreSwapLogData.h"
+#include "swap_log_op.h"
+#include "unitTestMain.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+class TestUfsSwapLogScanner : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestUfsSwapLogScanner);
+    CPPUNIT_TEST(testDeduplication);
+    CPPUNIT_TEST(testRejections);
+    CPPUNIT_TEST(testFilenoClashes);
+    CPPUNIT_TEST(testCancellations);
+    CPPUNIT_TEST(testSameAsSerialRebuild);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testDeduplication();
+    void testRejections();
+    void testFilenoClashes();
+    void testCancellations();
+    void testSameAsSerialRebuild();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestUfsSwapLogScanner );
+
+using Records = std::vector<StoreSwapLogData>;
+using ParserPointer = std::unique_ptr<Fs::Ufs::UFSSwapLogParser>;
+
+/// index contents: the lastref of each indexed entry, by key number
+using Index = std::map<int, time_t>;
+
+/// a parser for the current swap.state format
+static ParserPointer
+MakeParser()
+{
+    const auto fp = tmpfile();
+    CPPUNIT_ASSERT(fp);
+    StoreSwapLogHeader header;
+    CPPUNIT_ASSERT_EQUAL(size_t(1), fwrite(&header, sizeof(header), 1, fp));
+    rewind(fp);
+    ParserPointer parser(Fs::Ufs::UFSSwapLogParser::GetUFSSwapLogParser(fp));
+    CPPUNIT_ASSERT(parser);
+    return parser;
+}
+
+static StoreSwapLogData
+MakeRecord(const swap_log_op op, const int keyNumber, const time_t lastref, const sfileno fileno)
+{
+    StoreSwapLogData record;
+    record.op = op;
+    record.swap_filen = fileno;
+    record.lastref = lastref;
+    record.swap_file_sz = 1000;
+    memset(record.key, 0, sizeof(record.key));
+    // make keys differ in both 64-bit halves used by the scanner
+    record.key[0] = keyNumber & 0xFF;
+    record.key[1] = keyNumber >> 8;
+    record.key[15] = keyNumber * 7;
+    record.finalize();
+    return record;
+}
+
+/// the key number of a MakeRecord() record
+static int
+KeyNumber(const StoreSwapLogData &record)
+{
+    return record.key[0] | record.key[1] << 8;
+}
+
+/// scans the records and applies survivors to an empty index
+/// \param removals if not nil, gets the number of surviving removals
+static Index
+Scan(const Records &records, const int workers, StoreRebuildData &stats, size_t *removals = nullptr)
+{
+    const auto parser = MakeParser();
+    Fs::Ufs::SwapLogScanner scanner(*parser, reinterpret_cast<const char *>(records.data()), records.size(), workers);
+    scanner.start();
+    scanner.wait();
+    CPPUNIT_ASSERT(scanner.finished());
+    CPPUNIT_ASSERT_EQUAL(records.size(), scanner.scanned());
+    scanner.addStatsTo(stats);
+
+    Index index;
+    std::set<sfileno> filenos;
+    StoreSwapLogData record;
+    size_t survivors = 0;
+    if (removals)
+        *removals = 0;
+    while (scanner.next(record)) {
+        ++survivors;
+        // with no other cache_dirs, removals find nothing to remove
+        CPPUNIT_ASSERT(!index.count(KeyNumber(record)));
+        if (record.op == SWAP_LOG_ADD) {
+            CPPUNIT_ASSERT(filenos.insert(record.swap_filen).second);
+            index[KeyNumber(record)] = record.lastref;
+        } else if (removals) {
+            ++*removals;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(scanner.survivors(), survivors);
+    parser->Close();
+    return index;
+}
+
+/// applies records one by one, like Fs::Ufs::RebuildState::rebuildFromSwapLog()
+static Index
+ApplySerially(const Records &records, StoreRebuildData &stats)
+{
+    Index index;
+    std::map<int, sfileno> indexedFilenos; // by key number
+    std::set<sfileno> usedFilenos; // UFSSwapDir map bits
+    for (const auto &record: records) {
+        if (!record.sane()) {
+            ++stats.invalid;
+            continue;
+        }
+
+        const auto filen = record.swap_filen & 0x00FFFFFF;
+        if (record.op == SWAP_LOG_ADD) {
+            ++stats.scancount;
+            if (filen < 0) { // UFSSwapDir::validFileno(filen, 0)
+                ++stats.invalid;
+                continue;
+            }
+            if (EBIT_TEST(record.flags, KEY_PRIVATE)) {
+                ++stats.badflags;
+                continue;
+            }
+            if (usedFilenos.count(filen)) {
+                ++stats.clashcount;
+                continue;
+            }
+        }
+
+        const auto maxRef = record.op == SWAP_LOG_DEL ? record.lastref + 1 : record.lastref;
+        const auto indexed = index.find(KeyNumber(record));
+        if (indexed != index.end()) {
+            if (indexed->second >= maxRef) {
+                ++stats.clashcount;
+                continue;
+            }
+            ++(record.op == SWAP_LOG_DEL ? stats.cancelcount : stats.dupcount);
+            usedFilenos.erase(indexedFilenos.at(KeyNumber(record)));
+            index.erase(indexed);
+        }
+
+        if (record.op == SWAP_LOG_ADD) {
+            index[KeyNumber(record)] = record.lastref;
+            indexedFilenos[KeyNumber(record)] = filen;
+            usedFilenos.insert(filen);
+        }
+    }
+    return index;
+}
+
+static void
+CheckSameStats(const StoreRebuildData &expected, const StoreRebuildData &actual)
+{
+    CPPUNIT_ASSERT_EQUAL(expected.scancount, actual.scancount);
+    CPPUNIT_ASSERT_EQUAL(expected.clashcount, actual.clashcount);
+    CPPUNIT_ASSERT_EQUAL(expected.dupcount, actual.dupcount);
+    CPPUNIT_ASSERT_EQUAL(expected.cancelcount, actual.cancelcount);
+    CPPUNIT_ASSERT_EQUAL(expected.invalid, actual.invalid);
+    CPPUNIT_ASSERT_EQUAL(expected.badflags, actual.badflags);
+}
+
+void
+TestUfsSwapLogScanner::testDeduplication()
+{
+    const Records records = {
+        MakeRecord(SWAP_LOG_ADD, 1, 10, 1),
+        MakeRecord(SWAP_LOG_ADD, 2, 10, 2),
+        MakeRecord(SWAP_LOG_ADD, 1, 20, 3), // replaces the older entry 1
+        MakeRecord(SWAP_LOG_ADD, 2, 5, 4), // older than the indexed entry 2
+        MakeRecord(SWAP_LOG_ADD, 3, 10, 5),
+        MakeRecord(SWAP_LOG_DEL, 3, 10, 5), // same-age removal
+        MakeRecord(SWAP_LOG_DEL, 4, 10, 6), // nothing to remove
+    };
+
+    StoreRebuildData stats;
+    const auto index = Scan(records, 2, stats);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+    CPPUNIT_ASSERT_EQUAL(time_t(20), index.at(1));
+    CPPUNIT_ASSERT_EQUAL(time_t(10), index.at(2));
+    CPPUNIT_ASSERT_EQUAL(1, stats.dupcount);
+    CPPUNIT_ASSERT_EQUAL(1, stats.clashcount);
+    CPPUNIT_ASSERT_EQUAL(1, stats.cancelcount);
+    CPPUNIT_ASSERT_EQUAL(5, stats.scancount);
+}
+
+void
+TestUfsSwapLogScanner::testRejections()
+{
+    Records records = {
+        MakeRecord(SWAP_LOG_ADD, 1, 10, 1),
+        MakeRecord(SWAP_LOG_ADD, 2, 10, 2),
+        MakeRecord(SWAP_LOG_ADD, 3, 10, 3),
+    };
+    records[1].swap_file_sz = 0; // breaks the checksum
+    EBIT_SET(records[2].flags, KEY_PRIVATE);
+    records[2].finalize();
+
+    StoreRebuildData stats;
+    const auto index = Scan(records, 1, stats);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), index.size());
+    CPPUNIT_ASSERT(index.count(1));
+    CPPUNIT_ASSERT_EQUAL(1, stats.invalid);
+    CPPUNIT_ASSERT_EQUAL(1, stats.badflags);
+}
+
+void
+TestUfsSwapLogScanner::testFilenoClashes()
+{
+    const Records records = {
+        MakeRecord(SWAP_LOG_ADD, 1, 10, 1),
+        MakeRecord(SWAP_LOG_ADD, 2, 10, 1), // entry 1 uses this file
+        MakeRecord(SWAP_LOG_ADD, 3, 10, 2),
+        MakeRecord(SWAP_LOG_ADD, 1, 20, 2), // entry 3 uses this file
+        MakeRecord(SWAP_LOG_ADD, 4, 10, 0x01000003), // dir index bits are ignored
+        MakeRecord(SWAP_LOG_ADD, 5, 10, 3), // entry 4 uses this file
+        MakeRecord(SWAP_LOG_ADD, 3, 20, 4), // frees file 2
+        MakeRecord(SWAP_LOG_ADD, 5, 10, 2),
+    };
+
+    for (const auto workers: {1, 3}) {
+        StoreRebuildData stats;
+        const auto index = Scan(records, workers, stats);
+        CPPUNIT_ASSERT_EQUAL(size_t(4), index.size());
+        // clashing replacements do not replace
+        CPPUNIT_ASSERT_EQUAL(time_t(10), index.at(1));
+        CPPUNIT_ASSERT_EQUAL(time_t(20), index.at(3));
+        CPPUNIT_ASSERT(index.count(4));
+        CPPUNIT_ASSERT(index.count(5));
+        CPPUNIT_ASSERT_EQUAL(3, stats.clashcount);
+        CPPUNIT_ASSERT_EQUAL(1, stats.dupcount);
+    }
+}
+
+void
+TestUfsSwapLogScanner::testCancellations()
+{
+    const Records records = {
+        MakeRecord(SWAP_LOG_ADD, 1, 10, 1),
+        MakeRecord(SWAP_LOG_DEL, 1, 10, 1), // cancels the addition
+        MakeRecord(SWAP_LOG_ADD, 2, 10, 1), // uses the freed file
+        MakeRecord(SWAP_LOG_ADD, 3, 20, 2),
+        MakeRecord(SWAP_LOG_DEL, 3, 10, 2), // older than the indexed entry 3
+    };
+
+    StoreRebuildData stats;
+    size_t removals = 0;
+    const auto index = Scan(records, 2, stats, &removals);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), index.size());
+    CPPUNIT_ASSERT(index.count(2));
+    CPPUNIT_ASSERT(index.count(3));
+    // the cancelling removal survives to evict other cache_dirs entries
+    // that the cancelled addition would have evicted
+    CPPUNIT_ASSERT_EQUAL(size_t(1), removals);
+    CPPUNIT_ASSERT_EQUAL(1, stats.cancelcount);
+    CPPUNIT_ASSERT_EQUAL(1, stats.clashcount);
+}
+
+void
+TestUfsSwapLogScanner::testSameAsSerialRebuild()
+{
+    std::mt19937 rng(1);
+    Records records;
+    for (auto i = 0; i < 20000; ++i) {
+        const auto op = rng() % 4 ? SWAP_LOG_ADD : SWAP_LOG_DEL;
+        // few enough file numbers for frequent clashes, some with dir index bits
+        const auto fileno = static_cast<sfileno>(rng() % 1000) | (rng() % 8 ? 0 : 0x02000000);
+        records.push_back(MakeRecord(op, rng() % 500, rng() % 50, fileno));
+    }
+
+    StoreRebuildData expectedStats;
+    const auto expected = ApplySerially(records, expectedStats);
+
+    for (const auto workers: {1, 3, 8}) {
+        StoreRebuildData stats;
+        const auto actual = Scan(records, workers, stats);
+        CPPUNIT_ASSERT(expected == actual);
+        CheckSameStats(expectedStats, stats);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
@@ -22,7 +22,9 @@
 #include "comm.h"
 #include "comm/Connection.h"
 #include "comm/ConnOpener.h"
+#include "comm/Loops.h"
 #include "comm/Read.h"
+#include "comm/Splice.h"
 #include "comm/Write.h"
 #include "errorpage.h"
 #include "fd.h"
@@ -52,11 +54,15 @@
 #include "tools.h"
 #include "tunnel.h"
 #if USE_DELAY_POOLS
+#include "BandwidthBucket.h"
 #include "DelayId.h"
 #endif
 
 #include <climits>
 #include <cerrno>
+#if HAVE_SPLICE
+#include <fcntl.h>
+#endif
 
 /**
  * TunnelStateData is the state engine performing the tasks for
@@ -86,6 +92,10 @@ public:
     static void ReadServer(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag errcode, int xerrno, void *data);
     static void WriteClientDone(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag flag, int xerrno, void *data);
     static void WriteServerDone(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag flag, int xerrno, void *data);
+#if HAVE_SPLICE
+    static void SpliceReadClient(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag errcode, int xerrno, void *data);
+    static void SpliceReadServer(const Comm::ConnectionPointer &, char *buf, size_t len, Comm::Flag errcode, int xerrno, void *data);
+#endif
 
     bool noConnections() const;
     /// closes both client and server connections
@@ -157,6 +167,41 @@ public:
         void dataSent (size_t amount);
         /// writes 'b' buffer, setting the 'writer' member to 'callback'.
         void write(const char *b, int size, AsyncCall::Pointer &callback, FREE * free_func);
+
+#if HAVE_SPLICE
+        /// creates splicePipe (if needed); \returns whether the pipe is usable
+        bool openSplicePipe();
+
+        /// closes splicePipe descriptors (if any)
+        void closeSplicePipe();
+
+        /// kernel pipe holding bytes read from this connection in splice(2)
+        /// relay mode; {read end, write end}
+        int splicePipe[2] = { -1, -1 };
+
+        /// whether our len bytes are stored in splicePipe rather than buf
+        bool splicing = false;
+
+        /// how many of our len bytes were already spliced to the other side
+        size_t splicedOut = 0;
+
+        /// whether splice(2) relaying was attempted and failed on this connection
+        bool spliceFailed = false;
+
+        /// a cbdata reference to our tunnel while we wait for this connection
+        /// to become writable so that the other connection splicePipe can be
+        /// drained into it (or nil)
+        void *spliceWriteWaiter = nullptr;
+
+        /// whether our connection timeout limits a stalled splice(2) write
+        /// (instead of inactivity)
+        bool spliceWriteTimeout = false;
+#endif
+
+        /// whether activity on the other connection should not extend our
+        /// connection timeout
+        bool keepsTimeout() const;
+
         int len;
         char *buf;
         AsyncCall::Pointer writer; ///< pending Comm::Write callback
@@ -216,6 +261,27 @@ public:
 
     void copyRead(Connection &from, IOCB *completion);
 
+#if HAVE_SPLICE
+    /// whether bytes from one connection may bypass userspace on their way to
+    /// the other; opens from.splicePipe as needed
+    bool canSplice(Connection &from, const Connection &to);
+
+    /// moves available bytes from the now-readable connection into its pipe
+    void noteSpliceReadable(Connection &from, Comm::Flag, int xerrno);
+
+    /// splices pending kernel pipe contents of one connection to the other
+    void spliceWrite(Connection &from, Connection &to);
+
+    /// ends the splice(2) write initiated by copy(), notifying the to.writer callback
+    void finishSpliceWrite(Connection &from, Connection &to, Comm::Flag, int xerrno);
+
+    /// resumes a splice(2) write stalled on the now-writable connection
+    void noteSpliceWritable(Connection &from, Connection &to);
+
+    /// ends a splice(2) write that has not progressed for Config.Timeout.write
+    void noteSpliceWriteTimeout(const Comm::ConnectionPointer &);
+#endif
+
     /// continue to set up connection to a peer, going async for SSL peers
     void connectToPeer(const Comm::ConnectionPointer &);
     void secureConnectionToPeer(const Comm::ConnectionPointer &);
@@ -299,6 +365,11 @@ static CLCB tunnelClientClosed;
 static CTCB tunnelTimeout;
 static EVH tunnelDelayedClientRead;
 static EVH tunnelDelayedServerRead;
+#if HAVE_SPLICE
+static PF tunnelSpliceToClient;
+static PF tunnelSpliceToServer;
+static CTCB tunnelSpliceWriteTimeout;
+#endif
 
 /// TunnelStateData::serverClosed() wrapper
 static void
@@ -446,6 +517,15 @@ TunnelStateData::Connection::~Connection()
     if (readPending)
         eventDelete(readPendingFunc, readPending);
 
+#if HAVE_SPLICE
+    if (spliceWriteWaiter) {
+        if (Comm::IsConnOpen(conn))
+            Comm::SetSelect(conn->fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
+        cbdataReferenceDone(spliceWriteWaiter);
+    }
+    closeSplicePipe();
+#endif
+
     safe_free(buf);
 }
 
@@ -661,7 +741,7 @@ TunnelStateData::keepGoingAfterRead(size_t len, Comm::Flag errcode, int xerrno,
     const CbcPointer<TunnelStateData> safetyLock(this);
 
     /* Bump the source connection read timeout on any activity */
-    if (Comm::IsConnOpen(from.conn)) {
+    if (Comm::IsConnOpen(from.conn) && !from.keepsTimeout()) {
         AsyncCall::Pointer timeoutCall = commCbCall(5, 4, "tunnelTimeout",
                                          CommTimeoutCbPtrFun(tunnelTimeout, this));
         commSetConnTimeout(from.conn, Config.Timeout.read, timeoutCall);
@@ -669,7 +749,7 @@ TunnelStateData::keepGoingAfterRead(size_t len, Comm::Flag errcode, int xerrno,
 
     /* Bump the dest connection read timeout on any activity */
     /* see Bug 3659: tunnels can be weird, with very long one-way transfers */
-    if (Comm::IsConnOpen(to.conn)) {
+    if (Comm::IsConnOpen(to.conn) && !to.keepsTimeout()) {
         AsyncCall::Pointer timeoutCall = commCbCall(5, 4, "tunnelTimeout",
                                          CommTimeoutCbPtrFun(tunnelTimeout, this));
         commSetConnTimeout(to.conn, Config.Timeout.read, timeoutCall);
@@ -698,6 +778,15 @@ TunnelStateData::copy(size_t len, Connection &from, Connection &to, IOCB *comple
     debugs(26, 3, "Schedule Write");
     AsyncCall::Pointer call = commCbCall(5,5, "TunnelBlindCopyWriteHandler",
                                          CommIoCbPtrFun(completion, this));
+#if HAVE_SPLICE
+    if (from.splicing) {
+        assert(len == static_cast<size_t>(from.len));
+        to.writer = call;
+        to.dirty = true;
+        spliceWrite(from, to);
+        return;
+    }
+#endif
     to.write(from.buf, len, call, nullptr);
 }
 
@@ -802,11 +891,29 @@ void
 TunnelStateData::Connection::noteClosure()
 {
     debugs(26, 3, conn);
+#if HAVE_SPLICE
+    // unlike Comm::Write(), comm_close() does not know about our splice(2) writer
+    if (spliceWriteWaiter) {
+        Comm::SetSelect(conn->fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
+        cbdataReferenceDone(spliceWriteWaiter);
+    }
+    spliceWriteTimeout = false;
+#endif
     conn = nullptr;
     closer = nullptr;
     writer = nullptr; // may already be nil
 }
 
+bool
+TunnelStateData::Connection::keepsTimeout() const
+{
+#if HAVE_SPLICE
+    return spliceWriteTimeout;
+#else
+    return false;
+#endif
+}
+
 void
 TunnelStateData::writeClientDone(char *, size_t len, Comm::Flag flag, int xerrno)
 {
@@ -924,6 +1031,15 @@ TunnelStateData::copyRead(Connection &from, IOCB *completion)
         return;
     }
 
+#if HAVE_SPLICE
+    if (canSplice(from, (&from == &client) ? server : client)) {
+        AsyncCall::Pointer call = commCbCall(5,4, "TunnelSpliceReadHandler",
+                                             CommIoCbPtrFun((&from == &client) ? SpliceReadClient : SpliceReadServer, this));
+        Comm::Read(from.conn, call);
+        return;
+    }
+#endif
+
     AsyncCall::Pointer call = commCbCall(5,4, "TunnelBlindCopyReadHandler",
                                          CommIoCbPtrFun(completion, this));
     comm_read(from.conn, from.buf, bw, call);
@@ -957,6 +1073,256 @@ TunnelStateData::copyServerBytes()
         copyRead(server, ReadServer);
 }
 
+#if HAVE_SPLICE
+void
+TunnelStateData::SpliceReadClient(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag errcode, int xerrno, void *data)
+{
+    TunnelStateData *tunnelState = (TunnelStateData *)data;
+    assert(cbdataReferenceValid(tunnelState));
+    tunnelState->noteSpliceReadable(tunnelState->client, errcode, xerrno);
+}
+
+void
+TunnelStateData::SpliceReadServer(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag errcode, int xerrno, void *data)
+{
+    TunnelStateData *tunnelState = (TunnelStateData *)data;
+    assert(cbdataReferenceValid(tunnelState));
+    tunnelState->noteSpliceReadable(tunnelState->server, errcode, xerrno);
+}
+
+bool
+TunnelStateData::Connection::openSplicePipe()
+{
+    if (splicePipe[0] >= 0)
+        return true;
+
+    // leave descriptors for new transactions when we are running low
+    if (fdUsageHigh())
+        return false;
+
+    if (pipe2(splicePipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        const auto xerrno = errno;
+        debugs(26, 2, "cannot create a pipe for " << conn << ": " << xstrerr(xerrno));
+        splicePipe[0] = splicePipe[1] = -1;
+        spliceFailed = true;
+        return false;
+    }
+
+    fd_open(splicePipe[0], FD_PIPE, "tunnel splice pipe read end");
+    fd_open(splicePipe[1], FD_PIPE, "tunnel splice pipe write end");
+    debugs(26, 5, conn << " uses FD " << splicePipe[0] << " and FD " << splicePipe[1]);
+    return true;
+}
+
+void
+TunnelStateData::Connection::closeSplicePipe()
+{
+    for (auto &fd: splicePipe) {
+        if (fd >= 0) {
+            fd_close(fd);
+            close(fd);
+            fd = -1;
+        }
+    }
+    splicing = false;
+    splicedOut = 0;
+}
+
+bool
+TunnelStateData::canSplice(Connection &from, const Connection &to)
+{
+    if (!Config.onoff.tunnel_splice || from.spliceFailed)
+        return false;
+
+    if (!Comm::IsConnOpen(from.conn) || !Comm::IsConnOpen(to.conn))
+        return false;
+
+    if (!Comm::CanSplice(fd_table[from.conn->fd], fd_table[to.conn->fd]))
+        return false;
+
+    return from.openSplicePipe();
+}
+
+/// Reads from the given connection directly into its kernel pipe and then
+/// continues as if Comm had delivered those bytes into from.buf.
+void
+TunnelStateData::noteSpliceReadable(Connection &from, Comm::Flag errcode, int xerrno)
+{
+    assert(from.len == 0);
+    assert(!from.splicing);
+
+    size_t len = 0;
+    if (errcode == Comm::OK) {
+        const auto fd = from.conn->fd;
+        // bytes the delay pools allow now; may differ from copyRead() estimate
+        const auto bw = from.bytesWanted(1, SQUID_TCP_SO_RCVBUF);
+        const auto result = Comm::Splice(fd, from.splicePipe[1], bw);
+        ++statCounter.syscalls.sock.reads;
+        debugs(26, 5, "splice(2) from " << from.conn << " moved " << result.size << " bytes; status " << result.status);
+
+        switch (result.status) {
+        case Comm::SpliceResult::moved:
+            fd_bytes(fd, result.size, IoDirection::Read);
+            len = result.size;
+            from.splicing = (len > 0);
+            break;
+
+        case Comm::SpliceResult::wait:
+            return copyRead(from, (&from == &client) ? ReadClient : ReadServer);
+
+        case Comm::SpliceResult::unsupported:
+            // this socket (or kernel) cannot splice; relay via from.buf instead
+            debugs(26, 3, "splice(2) is not supported for " << from.conn << ": " << xstrerr(result.xerrno));
+            from.spliceFailed = true;
+            from.closeSplicePipe();
+            return copyRead(from, (&from == &client) ? ReadClient : ReadServer);
+
+        case Comm::SpliceResult::failed:
+            errcode = Comm::COMM_ERROR;
+            xerrno = result.xerrno;
+            break;
+        }
+    }
+
+    if (&from == &client)
+        readClient(nullptr, len, errcode, xerrno);
+    else
+        readServer(nullptr, len, errcode, xerrno);
+}
+
+void
+TunnelStateData::spliceWrite(Connection &from, Connection &to)
+{
+    assert(from.splicing);
+    assert(to.writer);
+    assert(!to.spliceWriteWaiter);
+
+    const auto fd = to.conn->fd;
+    auto progressed = false;
+    while (from.splicedOut < static_cast<size_t>(from.len)) {
+        const auto result = Comm::Splice(from.splicePipe[0], fd, from.len - from.splicedOut);
+        ++statCounter.syscalls.sock.writes;
+        debugs(26, 5, "splice(2) to " << to.conn << " moved " << result.size << " bytes; status " << result.status);
+
+        if (result.status == Comm::SpliceResult::moved && result.size > 0) {
+            fd_bytes(fd, result.size, IoDirection::Write);
+            from.splicedOut += result.size;
+            progressed = true;
+            continue;
+        }
+
+        if (result.status == Comm::SpliceResult::wait) {
+            // like Comm::Write(), give up if the write makes no progress
+            // for Config.Timeout.write
+            if (progressed || !to.spliceWriteTimeout) {
+                AsyncCall::Pointer timeoutCall = commCbCall(5, 4, "tunnelSpliceWriteTimeout",
+                                                 CommTimeoutCbPtrFun(tunnelSpliceWriteTimeout, this));
+                commSetConnTimeout(to.conn, Config.Timeout.write, timeoutCall);
+                to.spliceWriteTimeout = true;
+            }
+            to.spliceWriteWaiter = cbdataReference(this);
+            Comm::SetSelect(fd, COMM_SELECT_WRITE, (&to == &client) ? tunnelSpliceToClient : tunnelSpliceToServer, to.spliceWriteWaiter, 0);
+            return;
+        }
+
+        return finishSpliceWrite(from, to, Comm::COMM_ERROR, result.xerrno);
+    }
+
+    finishSpliceWrite(from, to, Comm::OK, 0);
+}
+
+void
+TunnelStateData::finishSpliceWrite(Connection &from, Connection &to, const Comm::Flag flag, const int xerrno)
+{
+    if (to.spliceWriteTimeout) {
+        to.spliceWriteTimeout = false;
+        // restore the inactivity timeout that the stalled write has replaced
+        if (Comm::IsConnOpen(to.conn)) {
+            AsyncCall::Pointer timeoutCall = commCbCall(5, 4, "tunnelTimeout",
+                                             CommTimeoutCbPtrFun(tunnelTimeout, this));
+            commSetConnTimeout(to.conn, Config.Timeout.read, timeoutCall);
+        }
+    }
+
+    auto &params = GetCommParams<CommIoCbParams>(to.writer);
+    params.conn = to.conn;
+    params.size = (flag == Comm::OK) ? from.len : from.splicedOut;
+    params.flag = flag;
+    params.xerrno = xerrno;
+
+    from.splicing = false;
+    from.splicedOut = 0;
+
+    ScheduleCallHere(to.writer);
+}
+
+void
+TunnelStateData::noteSpliceWritable(Connection &from, Connection &to)
+{
+    // the caller has released the to.spliceWriteWaiter reference
+    to.spliceWriteWaiter = nullptr;
+    if (!Comm::IsConnOpen(to.conn) || !to.writer)
+        return;
+
+    const auto savedContext = CodeContext::Current();
+    CodeContext::Reset(codeContext);
+    spliceWrite(from, to);
+    CodeContext::Reset(savedContext);
+}
+
+void
+TunnelStateData::noteSpliceWriteTimeout(const Comm::ConnectionPointer &conn)
+{
+    const auto toClient = (conn == client.conn);
+    auto &to = toClient ? client : server;
+    auto &from = toClient ? server : client;
+    to.spliceWriteTimeout = false;
+
+    if (!to.spliceWriteWaiter) {
+        debugs(26, 3, "no stalled splice(2) write to " << conn);
+        closeConnections();
+        return;
+    }
+
+    debugs(26, 3, "splice(2) write to " << conn << " timed out");
+    Comm::SetSelect(conn->fd, COMM_SELECT_WRITE, nullptr, nullptr, 0);
+    cbdataReferenceDone(to.spliceWriteWaiter);
+    finishSpliceWrite(from, to, Comm::COMM_ERROR, ETIMEDOUT);
+}
+
+/// resumes splicing server bytes once the client connection becomes writable
+static void
+tunnelSpliceToClient(int, void *data)
+{
+    void *cbdata = nullptr;
+    if (cbdataReferenceValidDone(data, &cbdata)) {
+        const auto tunnel = static_cast<TunnelStateData*>(cbdata);
+        tunnel->noteSpliceWritable(tunnel->server, tunnel->client);
+    }
+}
+
+/// resumes splicing client bytes once the server connection becomes writable
+static void
+tunnelSpliceToServer(int, void *data)
+{
+    void *cbdata = nullptr;
+    if (cbdataReferenceValidDone(data, &cbdata)) {
+        const auto tunnel = static_cast<TunnelStateData*>(cbdata);
+        tunnel->noteSpliceWritable(tunnel->client, tunnel->server);
+    }
+}
+
+/// ends a stalled splice(2) write to the timed out connection
+static void
+tunnelSpliceWriteTimeout(const CommTimeoutCbParams &io)
+{
+    const auto tunnel = static_cast<TunnelStateData *>(io.data);
+    debugs(26, 3, io.conn);
+    const CbcPointer<TunnelStateData> safetyLock(tunnel);
+    tunnel->noteSpliceWriteTimeout(io.conn);
+}
+#endif /* HAVE_SPLICE */
+
 /**
  * Set the HTTP status for this request and sets the read handlers for client
  * and server side connections.
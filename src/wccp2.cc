@@ -18,6 +18,7 @@
 #include "comm/Loops.h"
 #include "ConfigParser.h"
 #include "event.h"
+#include "fatal.h"
 #include "ip/Address.h"
 #include "md5.h"
 #include "Parsing.h"
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 1996-2025 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 19    Store Memory Primitives */
+
+/*
+ * Measures mem_hdr::copy() throughput for in-memory objects of various sizes
+ * read by many concurrent store_clients. Readers take turns, each reading
+ * the next chunk at its own offset, mimicking the main loop servicing many
+ * clients of the same hot object. Each object size is read for 1 GB total.
+ *
+ * Usage: mem_hdr_bench [readers [read size]]
+ */
+
+#include "squid.h"
+#include "mem_node.h"
+#include "stmem.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+static void
+benchmark(const int64_t objectSize, const int readers, const size_t readSize)
+{
+    mem_hdr object;
+    std::vector<char> page(SM_PAGE_SIZE, 'x');
+    for (int64_t offset = 0; offset < objectSize; offset += SM_PAGE_SIZE) {
+        const auto len = std::min<int64_t>(SM_PAGE_SIZE, objectSize - offset);
+        assert(object.write(StoreIOBuffer(len, offset, page.data())));
+    }
+
+    // start readers at different offsets so that they do not read in lockstep
+    std::vector<int64_t> offsets(readers);
+    for (int i = 0; i < readers; ++i)
+        offsets[i] = (objectSize / readers) * i;
+
+    // read the same volume for all object sizes to keep timings comparable
+    const uint64_t volume = 1ULL << 30;
+    std::vector<char> buf(readSize);
+    uint64_t copied = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (copied < volume) {
+        for (auto &offset: offsets) {
+            const auto len = std::min<int64_t>(readSize, objectSize - offset);
+            const auto got = object.copy(StoreIOBuffer(len, offset, buf.data()));
+            assert(got == len);
+            copied += got;
+            offset += got;
+            if (offset >= objectSize)
+                offset = 0;
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::setw(4) << (objectSize >> 20) << " MB object, " <<
+              readers << " readers: " <<
+              std::fixed << std::setprecision(1) <<
+              (copied / elapsed.count() / (1 << 20)) << " MB/s, " <<
+              std::setprecision(0) <<
+              (copied / readSize / elapsed.count()) << " copies/s" << std::endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const auto readers = argc > 1 ? atoi(argv[1]) : 100;
+    const auto readSize = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 4096;
+    if (readers <= 0 || !readSize) {
+        std::cerr << "usage: " << argv[0] << " [readers [read size]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for (const auto megabytes: {1, 10, 100})
+        benchmark(static_cast<int64_t>(megabytes) << 20, readers, readSize);
+
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,8 @@
 #include "mem_node.h"
 #include "stmem.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -41,34 +43,44 @@ testLowAndHigh()
 }
 
 static void
-testSplayOfNodes()
+testNodeIndex()
 {
-    Splay<mem_node *> aSplay;
-    mem_node *temp5;
-    temp5 = new mem_node(5);
-    temp5->nodeBuffer.length = 10;
-    aSplay.insert (temp5, mem_hdr::NodeCompare);
-    assert (aSplay.start()->data == temp5);
-    assert (aSplay.finish()->data == temp5);
+    mem_hdr aHeader;
+    char page[SM_PAGE_SIZE];
+    memset(page, 'x', sizeof(page));
+
+    // pages stored front to back are found without a search
+    for (int i = 0; i < 3; ++i)
+        assert (aHeader.write (StoreIOBuffer(SM_PAGE_SIZE, i*SM_PAGE_SIZE, page)));
+    assert (aHeader.size() == 3);
+    assert (aHeader.getBlockContainingLocation(0) == aHeader.getNodes()[0]);
+    assert (aHeader.getBlockContainingLocation(SM_PAGE_SIZE) == aHeader.getNodes()[1]);
+    assert (aHeader.getBlockContainingLocation(3*SM_PAGE_SIZE - 1) == aHeader.getNodes()[2]);
+    assert (!aHeader.getBlockContainingLocation(3*SM_PAGE_SIZE));
 
-    mem_node *temp0;
-    temp0 = new mem_node(0);
-    temp0->nodeBuffer.length = 5;
-    aSplay.insert (temp0, mem_hdr::NodeCompare);
-    assert (aSplay.start()->data == temp0);
-    assert (aSplay.finish()->data == temp5);
+    // a sparse page stored out of order keeps the index ordered
+    const int64_t farOffset = 10*SM_PAGE_SIZE + 5;
+    assert (aHeader.write (StoreIOBuffer(10, farOffset, page)));
+    assert (aHeader.write (StoreIOBuffer(10, 5*SM_PAGE_SIZE, page)));
+    assert (aHeader.size() == 5);
+    assert (aHeader.getNodes()[3]->start() == 5*SM_PAGE_SIZE);
+    assert (aHeader.getNodes()[4]->start() == farOffset);
+    assert (aHeader.getBlockContainingLocation(farOffset + 9) == aHeader.getNodes()[4]);
+    assert (!aHeader.getBlockContainingLocation(farOffset - 1));
+    assert (!aHeader.getBlockContainingLocation(5*SM_PAGE_SIZE + 10));
+    assert (aHeader.endOffset() == farOffset + 10);
 
-    mem_node *temp14;
-    temp14 = new mem_node (14);
-    temp14->nodeBuffer.length = 1;
-    assert (aSplay.find(temp14,mem_hdr::NodeCompare));
-    delete temp14;
+    // reads stop at the first gap
+    char buf[2*SM_PAGE_SIZE];
+    assert (aHeader.copy(StoreIOBuffer(sizeof(buf), SM_PAGE_SIZE/2, buf)) == sizeof(buf));
+    assert (aHeader.copy(StoreIOBuffer(sizeof(buf), 2*SM_PAGE_SIZE, buf)) == SM_PAGE_SIZE);
 
-    mem_node ref13  (13);
-    assert (!aSplay.find(&ref13,mem_hdr::NodeCompare));
-    ref13.nodeBuffer.length = 1;
-    assert (aSplay.find(&ref13,mem_hdr::NodeCompare));
-    aSplay.destroy();
+    // pages are freed from the front, keeping the last one
+    assert (aHeader.freeDataUpto(2*SM_PAGE_SIZE) == 2*SM_PAGE_SIZE);
+    assert (aHeader.size() == 3);
+    assert (aHeader.getBlockContainingLocation(2*SM_PAGE_SIZE) == aHeader.getNodes()[0]);
+    assert (aHeader.freeDataUpto(farOffset + 10) == farOffset);
+    assert (aHeader.size() == 1);
 }
 
 static void
@@ -83,9 +95,9 @@ testHdrVisit()
     safe_free (sampleData);
     std::ostringstream result;
     PointerPrinter<mem_node *> foo(result, "\n");
-    for_each (aHeader.getNodes().end(), aHeader.getNodes().end(), foo);
-    for_each (aHeader.getNodes().begin(), aHeader.getNodes().begin(), foo);
-    for_each (aHeader.getNodes().begin(), aHeader.getNodes().end(), foo);
+    std::for_each (aHeader.getNodes().end(), aHeader.getNodes().end(), foo);
+    std::for_each (aHeader.getNodes().begin(), aHeader.getNodes().begin(), foo);
+    std::for_each (aHeader.getNodes().begin(), aHeader.getNodes().end(), foo);
     std::ostringstream expectedResult;
     expectedResult << "[100,101)" << std::endl << "[102,103)" << std::endl;
     assert (result.str() == expectedResult.str());
@@ -97,7 +109,7 @@ main(int, char *[])
     assert (mem_node::InUseCount() == 0);
     testLowAndHigh();
     assert (mem_node::InUseCount() == 0);
-    testSplayOfNodes();
+    testNodeIndex();
     assert (mem_node::InUseCount() == 0);
     testHdrVisit();
     assert (mem_node::InUseCount() == 0);